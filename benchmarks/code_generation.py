@@ -0,0 +1,78 @@
+#!/usr/bin/env python3
+#
+# Benchmarks the generation of C model code (as used by myokit.Simulation) and
+# OpenCL kernel code (as used by myokit.SimulationOpenCL) for large generated
+# models.
+#
+# Usage:
+#
+#   python3 benchmarks/code_generation.py [repeats]
+#
+# This file is part of Myokit.
+# See http://myokit.org for copyright, sharing, and licensing details.
+#
+import os
+import sys
+
+import myokit
+import myokit.pype
+
+from myokit._sim.cmodel import CModel
+
+from model_dependencies import create_model
+
+
+def cmodel(model):
+    """ Generates C model code, for a clone of ``model``. """
+    return CModel(model.clone(), ['pace'], None).code
+
+
+def opencl_kernel(model):
+    """ Generates an OpenCL kernel, for a clone of ``model``. """
+    model = model.clone()
+    bound = myokit._prepare_bindings(model, {'time': 'time', 'pace': 'pace'})
+    inter_log = [
+        v for v in model.variables(deep=True)
+        if v.is_intermediary() and not v.is_bound()]
+    args = {
+        'model': model,
+        'precision': myokit.DOUBLE_PRECISION,
+        'native_math': True,
+        'bound_variables': bound,
+        'inter_log': inter_log[::4],
+        'diffusion': False,
+        'fields': [],
+        'paced_cells': [],
+        'rl_states': {},
+        'connections': False,
+        'heterogeneous': False,
+        'fiber_tissue': False,
+    }
+    path = os.path.join(myokit.DIR_CFUNC, 'openclsim.cl')
+    return myokit.pype.TemplateEngine().process(path, args)
+
+
+def benchmark(model, repeats):
+    """
+    Returns the time in seconds taken to generate C model code and an OpenCL
+    kernel for the given model.
+    """
+    times = []
+    for f in (cmodel, opencl_kernel):
+        f(model)
+        b = myokit.tools.Benchmarker()
+        for i in range(repeats):
+            f(model)
+        times.append(b.time() / repeats)
+    return times
+
+
+if __name__ == '__main__':
+    repeats = int(sys.argv[1]) if len(sys.argv) > 1 else 5
+
+    print('Code generation, ' + str(repeats) + ' repeats')
+    print('{:>10} {:>12} {:>12}'.format(
+        'variables', 'cmodel (s)', 'kernel (s)'))
+    for n in (500, 2000, 5000):
+        t1, t2 = benchmark(create_model(n), repeats)
+        print('{:>10d} {:>12.4f} {:>12.4f}'.format(n, t1, t2))
@@ -0,0 +1,68 @@
+#!/usr/bin/env python3
+#
+# Benchmarks the conversion of DataBlock2d frames to RGB images.
+#
+# Usage:
+#
+#   python3 benchmarks/datablock_video.py [nframes] [size ...]
+#
+# This file is part of Myokit.
+# See http://myokit.org for copyright, sharing, and licensing details.
+#
+import sys
+
+import numpy as np
+
+import myokit
+
+
+def create_block(nt, n):
+    """
+    Creates a block with ``nt`` frames of ``n`` by ``n`` cells, containing a
+    spiral-like pattern that rotates over time.
+    """
+    y, x = np.mgrid[-1:1:n * 1j, -1:1:n * 1j]
+    angle = np.arctan2(y, x)
+    radius = np.hypot(x, y)
+    block = myokit.DataBlock2d(n, n, np.arange(nt, dtype=float))
+    data = np.empty((nt, n, n))
+    for i in range(nt):
+        data[i] = np.sin(angle + 10 * radius - 0.1 * i)
+    block.set2d('membrane.V', data, copy=False)
+    return block
+
+
+def benchmark(nt, n, colormap='traditional'):
+    """
+    Renders ``nt`` frames of ``n`` by ``n`` cells, and returns a list of tuples
+    ``(method, time in seconds)``.
+    """
+    block = create_block(nt, n)
+    out = np.empty((nt, n, n, 3), dtype=np.uint8)
+    tests = [
+        ('colors', lambda: block.colors('membrane.V', colormap)),
+        ('colors_array', lambda: block.colors_array(
+            'membrane.V', colormap, out=out)),
+        ('iter_colors', lambda: sum(
+            1 for f in block.iter_colors('membrane.V', colormap))),
+        ('images', lambda: block.images('membrane.V', colormap)),
+    ]
+    results = []
+    for name, f in tests:
+        b = myokit.tools.Benchmarker()
+        f()
+        results.append((name, b.time()))
+    return results
+
+
+if __name__ == '__main__':
+    nt = int(sys.argv[1]) if len(sys.argv) > 1 else 100
+    sizes = [int(x) for x in sys.argv[2:]] or [128, 512]
+
+    print('DataBlock2d rendering, ' + str(nt) + ' frames')
+    print('{:>8} {:>16} {:>12} {:>14}'.format(
+        'size', 'method', 'time (s)', 'frames/s'))
+    for n in sizes:
+        for name, t in benchmark(nt, n):
+            print('{:>8d} {:>16} {:>12.3f} {:>14.1f}'.format(
+                n, name, t, nt / t))
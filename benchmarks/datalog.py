@@ -0,0 +1,70 @@
+#!/usr/bin/env python3
+#
+# Benchmarks DataLog and DataBlock1d analysis methods on large multi-cell logs.
+#
+# Usage:
+#
+#   python3 benchmarks/datalog.py [nsamples] [ncells ...]
+#
+# This file is part of Myokit.
+# See http://myokit.org for copyright, sharing, and licensing details.
+#
+import sys
+
+import numpy as np
+
+import myokit
+
+
+def create_log(ncells, nsamples, period=1000):
+    """
+    Creates a log with ``nsamples`` points in time, for a 1d variable with
+    ``ncells`` cells, containing a wave travelling along the cable. Data is
+    stored in :class:`myokit.DataColumn` objects, as in simulation logs.
+    """
+    time = np.arange(nsamples, dtype=float)
+    d = myokit.DataLog(time='engine.time')
+    d['engine.time'] = myokit.DataColumn('d', time)
+    phase = np.mod(time, period)
+    for i in range(ncells):
+        d['membrane.V', i] = myokit.DataColumn('d', np.where(
+            (phase > 10 + 0.1 * i) & (phase < 300 + 0.1 * i), 20.0, -85.0))
+    return d
+
+
+def benchmark(ncells, nsamples):
+    """
+    Runs each method once on a log with ``ncells`` cells and ``nsamples``
+    samples, and returns a list of tuples ``(method, time in seconds)``.
+    """
+    d = create_log(ncells, nsamples)
+    block = d.block1d()
+    period = nsamples / 10
+    times = np.linspace(0, nsamples - 1, nsamples // 2)
+    tests = [
+        ('split_periodic', lambda: d.split_periodic(period, adjust=True)),
+        ('fold', lambda: d.fold(period)),
+        ('itrim', lambda: d.itrim(nsamples // 4, nsamples // 2)),
+        ('integrate', lambda: [
+            d.integrate('membrane.V', i) for i in range(ncells)]),
+        ('interpolate_at', lambda: [
+            d.interpolate_at(k, times) for k in d.keys_like('membrane.V')]),
+        ('DataBlock1d.cv', lambda: block.cv('membrane.V')),
+    ]
+    results = []
+    for name, f in tests:
+        b = myokit.tools.Benchmarker()
+        f()
+        results.append((name, b.time()))
+    return results
+
+
+if __name__ == '__main__':
+    nsamples = int(sys.argv[1]) if len(sys.argv) > 1 else 10000
+    ncells = [int(x) for x in sys.argv[2:]] or [100, 1000, 5000]
+
+    print('DataLog analysis, ' + str(nsamples) + ' samples per cell')
+    print('{:>8} {:>16} {:>12}'.format('ncells', 'method', 'time (s)'))
+    for n in ncells:
+        for name, t in benchmark(n, nsamples):
+            print('{:>8d} {:>16} {:>12.3f}'.format(n, name, t))
@@ -0,0 +1,79 @@
+#!/usr/bin/env python3
+#
+# Benchmarks the evaluation of state derivatives for many points at once,
+# comparing a loop over Model.evaluate_derivatives() with the vectorised
+# function returned by Model.pyfunc_rhs() and with the compiled
+# Simulation.evaluate_derivatives_batch().
+#
+# Usage:
+#
+#   python3 benchmarks/derivatives.py [n_points]
+#
+# This file is part of Myokit.
+# See http://myokit.org for copyright, sharing, and licensing details.
+#
+import os
+import sys
+
+import numpy as np
+
+import myokit
+
+
+def setup(n_points):
+    """
+    Returns the Luo-Rudy 1991 model and an array of ``n_points`` states near
+    its initial state.
+    """
+    path = os.path.join(myokit.DIR_MYOKIT, 'tests', 'data', 'lr-1991.mmt')
+    model = myokit.load_model(path)
+    y0 = np.array(model.initial_values(True))
+    r = np.random.default_rng(1)
+    return model, y0 * r.uniform(0.9, 1.1, (n_points, len(y0)))
+
+
+def run_loop(model, states):
+    """ Evaluates every point in turn, returns the time taken. """
+    b = myokit.tools.Benchmarker()
+    for y in states:
+        model.evaluate_derivatives(y)
+    return b.time()
+
+
+def run_pyfunc(model, states):
+    """ Evaluates all points with pyfunc_rhs, returns the time taken. """
+    f = model.pyfunc_rhs()
+    b = myokit.tools.Benchmarker()
+    f(states)
+    return b.time()
+
+
+def run_native(model, states):
+    """
+    Evaluates all points with the compiled simulation, returns the time taken
+    or ``None`` if the simulation could not be compiled.
+    """
+    try:
+        s = myokit.Simulation(model)
+    except myokit.CompilationError:
+        return None
+    b = myokit.tools.Benchmarker()
+    s.evaluate_derivatives_batch(states)
+    return b.time()
+
+
+if __name__ == '__main__':
+    n = int(sys.argv[1]) if len(sys.argv) > 1 else 1000
+
+    model, states = setup(n)
+    print('Derivatives, ' + str(n) + ' points')
+    print('{:>12} {:>12}'.format('method', 'time (s)'))
+    t = run_loop(model, states)
+    print('{:>12} {:>12.4f}'.format('loop', t))
+    t = run_pyfunc(model, states)
+    print('{:>12} {:>12.4f}'.format('pyfunc_rhs', t))
+    t = run_native(model, states)
+    if t is None:
+        print('{:>12} {:>12}'.format('batch', 'n/a'))
+    else:
+        print('{:>12} {:>12.4f}'.format('batch', t))
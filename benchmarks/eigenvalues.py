@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+#
+# Benchmarks the eigenvalue methods of DataBlock2d on stacks of matrices with
+# a well-separated dominant eigenvalue, as found in Jacobians of cell models.
+#
+# Usage:
+#
+#   python3 benchmarks/eigenvalues.py [ntimes] [size ...]
+#
+# This file is part of Myokit.
+# See http://myokit.org for copyright, sharing, and licensing details.
+#
+import sys
+
+import numpy as np
+
+import myokit
+
+
+def create_block(nt, n, seed=1):
+    """
+    Creates a block with ``nt`` matrices of size ``n`` by ``n``, each with
+    negative real eigenvalues, of which the most negative dominates.
+    """
+    rng = np.random.default_rng(seed)
+    q = rng.normal(size=(n, n)) + n * np.eye(n)
+    qi = np.linalg.inv(q)
+    data = np.empty((nt, n, n))
+    for i in range(nt):
+        e = -rng.uniform(0.1, 100, size=n)
+        e[0] = -1000 * (1 + np.sin(0.01 * i) ** 2)
+        data[i] = (q * e) @ qi
+    block = myokit.DataBlock2d(n, n, np.arange(nt, dtype=float))
+    block.set2d('jacobians', data, copy=False)
+    return block
+
+
+def benchmark(nt, n):
+    """
+    Runs each method once, and returns a list of tuples
+    ``(method, time in seconds)``.
+    """
+    block = create_block(nt, n)
+    tests = [
+        ('eigenvalues', lambda: block.eigenvalues('jacobians')),
+        ('dominant', lambda: block.dominant_eigenvalues('jacobians')),
+        ('dominant (power)', lambda: block.dominant_eigenvalues(
+            'jacobians', power_iteration=True)),
+        ('largest', lambda: block.largest_eigenvalues('jacobians')),
+    ]
+    results = []
+    for name, f in tests:
+        b = myokit.tools.Benchmarker()
+        f()
+        results.append((name, b.time()))
+    return results
+
+
+if __name__ == '__main__':
+    nt = int(sys.argv[1]) if len(sys.argv) > 1 else 10000
+    sizes = [int(x) for x in sys.argv[2:]] or [10, 50]
+
+    print('DataBlock2d eigenvalues, ' + str(nt) + ' time points')
+    print('{:>8} {:>18} {:>12}'.format('size', 'method', 'time (s)'))
+    for n in sizes:
+        for name, t in benchmark(nt, n):
+            print('{:>8d} {:>18} {:>12.3f}'.format(n, name, t))
@@ -0,0 +1,62 @@
+#!/usr/bin/env python3
+#
+# Benchmarks Model.evaluate_derivatives(), which evaluates all equations in a
+# model using a cached compiled function, against evaluating every equation
+# with Expression.eval().
+#
+# Usage:
+#
+#   python3 benchmarks/evaluate_derivatives.py [repeats]
+#
+# This file is part of Myokit.
+# See http://myokit.org for copyright, sharing, and licensing details.
+#
+import os
+import sys
+
+import myokit
+
+from model_dependencies import create_model
+
+
+def benchmark(model, repeats):
+    """
+    Returns the time taken by a first evaluation (which creates the compiled
+    function), and the times taken per evaluation with and without it.
+    """
+    model = model.clone()
+    model.solvable_order()
+
+    b = myokit.tools.Benchmarker()
+    model.evaluate_derivatives()
+    t0 = b.time()
+
+    b.reset()
+    for i in range(repeats):
+        model.evaluate_derivatives()
+    t1 = b.time() / repeats
+
+    model._cached_evaluator = False
+    b.reset()
+    for i in range(repeats):
+        model.evaluate_derivatives()
+    t2 = b.time() / repeats
+    return t0, t1, t2
+
+
+if __name__ == '__main__':
+    repeats = int(sys.argv[1]) if len(sys.argv) > 1 else 10
+
+    models = []
+    for name in ('beeler-1977-model', 'lr-1991', 'clancy-1999-fitting'):
+        path = os.path.join(myokit.DIR_MYOKIT, 'tests', 'data', name + '.mmt')
+        models.append((name, myokit.load_model(path)))
+    for n in (500, 2000):
+        models.append(('generated-' + str(n), create_model(n)))
+
+    print('Model.evaluate_derivatives, ' + str(repeats) + ' repeats')
+    print('{:>20} {:>12} {:>12} {:>12}'.format(
+        'model', 'first (s)', 'cached (s)', 'eval() (s)'))
+    for name, model in models:
+        t0, t1, t2 = benchmark(model, repeats)
+        print('{:>20} {:>12.6f} {:>12.6f} {:>12.6f}'.format(name, t0, t1, t2))
@@ -0,0 +1,81 @@
+#!/usr/bin/env python3
+#
+# Benchmarks hh.AnalyticalSimulation.run_batch, which evaluates a family of
+# step protocols for a population of parameter vectors at once, against
+# calling run() for each combination in turn.
+#
+# Usage:
+#
+#   python3 benchmarks/hh_batch.py [n_params]
+#
+# This file is part of Myokit.
+# See http://myokit.org for copyright, sharing, and licensing details.
+#
+import os
+import sys
+
+import numpy as np
+
+import myokit
+import myokit.lib.hh as hh
+
+
+def setup(n_params):
+    """
+    Returns an HH model of the Luo-Rudy 1991 INa model, a family of activation
+    protocols, an array of ``n_params`` parameter vectors per protocol, the
+    duration of the protocols, and the times to log at.
+    """
+    path = os.path.join(
+        myokit.DIR_MYOKIT, 'tests', 'data', 'lr-1991-fitting.mmt')
+    model = myokit.load_model(path)
+    m = hh.HHModel.from_component(model.get('ina'))
+
+    tpre, tstep = 100, 20
+    voltages = np.arange(-100, 41, 5)
+    protocols = [myokit.pacing.steptrain([v], -80, tpre, tstep)
+                 for v in voltages]
+
+    r = np.random.default_rng(1)
+    parameters = np.array(m.default_parameters())
+    parameters = parameters * r.uniform(0.5, 2, (n_params, len(parameters)))
+
+    times = tpre + np.arange(0, tstep, 0.1)
+    return m, protocols, parameters, tpre + tstep, times
+
+
+def run_loop(m, protocols, parameters, duration, times):
+    """ Runs each combination in turn, returns the time taken. """
+    b = myokit.tools.Benchmarker()
+    for protocol in protocols:
+        s = hh.AnalyticalSimulation(m, protocol)
+        for p in parameters:
+            s.reset()
+            s.set_parameters(p)
+            s.run(duration, log_times=times)
+    return b.time()
+
+
+def run_batch(m, protocols, parameters, duration, times):
+    """ Runs all combinations at once, returns the time taken. """
+    b = myokit.tools.Benchmarker()
+    s = hh.AnalyticalSimulation(m)
+    n = len(parameters)
+    s.run_batch(
+        np.tile(parameters, (len(protocols), 1)), duration, log_times=times,
+        protocols=[p for p in protocols for i in range(n)])
+    return b.time()
+
+
+if __name__ == '__main__':
+    n = int(sys.argv[1]) if len(sys.argv) > 1 else 100
+
+    m, protocols, parameters, duration, times = setup(n)
+    print('hh.AnalyticalSimulation, ' + str(len(protocols)) + ' protocols x '
+          + str(n) + ' parameter vectors, ' + str(len(times))
+          + ' logged times')
+    print('{:>12} {:>12}'.format('method', 'time (s)'))
+    t = run_loop(m, protocols, parameters, duration, times)
+    print('{:>12} {:>12.4f}'.format('run', t))
+    t = run_batch(m, protocols, parameters, duration, times)
+    print('{:>12} {:>12.4f}'.format('run_batch', t))
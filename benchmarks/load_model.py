@@ -0,0 +1,55 @@
+#!/usr/bin/env python3
+#
+# Benchmarks loading mmt models, with and without the parsed-model cache.
+#
+# Usage:
+#
+#   python3 benchmarks/load_model.py [repeats]
+#
+# This file is part of Myokit.
+# See http://myokit.org for copyright, sharing, and licensing details.
+#
+import os
+import sys
+
+import myokit
+
+from myokit.tests import TemporaryDirectory
+
+from model_dependencies import create_model
+
+
+def benchmark(path, cache, repeats):
+    """
+    Returns the time in seconds to load the model at ``path`` without a
+    cache, and from the cache directory ``cache``.
+    """
+    b = myokit.tools.Benchmarker()
+    for i in range(repeats):
+        myokit.load_model(path)
+    t1 = b.time() / repeats
+
+    myokit.load_model(path, cache=cache)
+    b.reset()
+    for i in range(repeats):
+        myokit.load_model(path, cache=cache)
+    t2 = b.time() / repeats
+    return t1, t2
+
+
+if __name__ == '__main__':
+    repeats = int(sys.argv[1]) if len(sys.argv) > 1 else 5
+
+    print('myokit.load_model(), ' + str(repeats) + ' repeats')
+    print('{:>12} {:>10} {:>12} {:>12}'.format(
+        'model', 'variables', 'parse (s)', 'cached (s)'))
+    with TemporaryDirectory() as d:
+        generated = d.path('generated.mmt')
+        myokit.save_model(generated, create_model(5000))
+        data = os.path.join(myokit.DIR_MYOKIT, 'tests', 'data')
+        paths = [os.path.join(data, 'decker-2009.mmt'), generated]
+        for path in paths:
+            n = sum(1 for v in myokit.load_model(path).variables(deep=True))
+            t1, t2 = benchmark(path, d.path('cache'), repeats)
+            name = os.path.splitext(os.path.basename(path))[0]
+            print('{:>12} {:>10d} {:>12.4f} {:>12.4f}'.format(name, n, t1, t2))
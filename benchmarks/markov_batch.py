@@ -0,0 +1,80 @@
+#!/usr/bin/env python3
+#
+# Benchmarks markov.AnalyticalSimulation.run_batch, which evaluates a step
+# protocol for many parameter vectors at once, against calling run() for each
+# parameter vector in turn.
+#
+# Usage:
+#
+#   python3 benchmarks/markov_batch.py [n_params]
+#
+# This file is part of Myokit.
+# See http://myokit.org for copyright, sharing, and licensing details.
+#
+import os
+import sys
+import warnings
+
+import numpy as np
+
+import myokit
+import myokit.lib.markov as markov
+
+
+def setup(n_params):
+    """
+    Returns an analytical simulation of the Clancy 1999 INa model with a step
+    protocol, an array of ``n_params`` parameter vectors, the duration of the
+    protocol, and the times to log at (during the steps only).
+    """
+    path = os.path.join(
+        myokit.DIR_MYOKIT, 'tests', 'data', 'clancy-1999-fitting.mmt')
+    model = myokit.load_model(path)
+    m = markov.LinearModel.from_component(model.get('ina'))
+
+    tpre, tstep = 2800, 15
+    voltages = np.arange(-140, 101, 20)
+    p = myokit.pacing.steptrain(voltages, -80, tpre, tstep)
+    s = markov.AnalyticalSimulation(m, p)
+
+    r = np.random.default_rng(1)
+    parameters = np.array(m.default_parameters())
+    parameters = parameters * r.uniform(0.5, 2, (n_params, len(parameters)))
+
+    times = np.concatenate([
+        tpre + i * (tpre + tstep) + np.arange(0, tstep, 0.1)
+        for i in range(len(voltages))])
+    return s, parameters, p.characteristic_time(), times
+
+
+def run_loop(s, parameters, duration, times):
+    """ Runs each parameter vector in turn, returns the time taken. """
+    b = myokit.tools.Benchmarker()
+    with warnings.catch_warnings():
+        warnings.simplefilter('ignore')
+        for p in parameters:
+            s.reset()
+            s.set_parameters(p)
+            s.run(duration, log_times=times)
+    return b.time()
+
+
+def run_batch(s, parameters, duration, times):
+    """ Runs all parameter vectors at once, returns the time taken. """
+    s.reset()
+    b = myokit.tools.Benchmarker()
+    s.run_batch(parameters, duration, log_times=times)
+    return b.time()
+
+
+if __name__ == '__main__':
+    n = int(sys.argv[1]) if len(sys.argv) > 1 else 1000
+
+    s, parameters, duration, times = setup(n)
+    print('AnalyticalSimulation, ' + str(n) + ' parameter vectors, '
+          + str(len(times)) + ' logged times')
+    print('{:>12} {:>12}'.format('method', 'time (s)'))
+    t = run_loop(s, parameters, duration, times)
+    print('{:>12} {:>12.4f}'.format('run', t))
+    t = run_batch(s, parameters, duration, times)
+    print('{:>12} {:>12.4f}'.format('run_batch', t))
@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+#
+# Benchmarks markov.DiscreteSimulation, comparing the Python implementation of
+# Gillespie's direct method with the compiled back-end, using the exact method
+# and tau-leaping, and running many realisations with run_batch.
+#
+# Usage:
+#
+#   python3 benchmarks/markov_discrete.py [n_channels] [runs]
+#
+# This file is part of Myokit.
+# See http://myokit.org for copyright, sharing, and licensing details.
+#
+import os
+import sys
+
+import numpy as np
+
+import myokit
+import myokit.lib.markov as markov
+
+from myokit._sim import ssa
+
+
+def setup(n_channels):
+    """
+    Returns a discrete simulation of the Clancy 1999 INa model with
+    ``n_channels`` channels and a step protocol, and the protocol duration.
+    """
+    path = os.path.join(
+        myokit.DIR_MYOKIT, 'tests', 'data', 'clancy-1999-fitting.mmt')
+    model = myokit.load_model(path)
+    m = markov.LinearModel.from_component(model.get('ina'))
+    p = myokit.pacing.steptrain(np.arange(-100, 41, 20), -80, 10, 10)
+    return markov.DiscreteSimulation(m, p, n_channels), p.characteristic_time()
+
+
+def run(s, duration, tau=None, python=False):
+    """ Runs a single simulation, returns the time taken. """
+    s.reset()
+    s.set_tau_leaping(tau)
+    instance = ssa.NativeSSA._instance
+    if python:
+        ssa.NativeSSA._instance = False
+    try:
+        b = myokit.tools.Benchmarker()
+        s.run(duration)
+        return b.time()
+    finally:
+        ssa.NativeSSA._instance = instance
+
+
+def run_batch(s, duration, runs, tau=None):
+    """ Runs ``runs`` realisations at once, returns the time taken. """
+    s.reset()
+    s.set_tau_leaping(tau)
+    b = myokit.tools.Benchmarker()
+    s.run_batch(runs, duration, log_interval=0.1)
+    return b.time()
+
+
+if __name__ == '__main__':
+    n = int(sys.argv[1]) if len(sys.argv) > 1 else 10000
+    runs = int(sys.argv[2]) if len(sys.argv) > 2 else 20
+
+    np.random.seed(1)
+    s, duration = setup(n)
+    ssa.NativeSSA._get_instance()
+
+    print('DiscreteSimulation, ' + str(n) + ' channels, '
+          + str(duration) + ' ms')
+    print('{:>20} {:>12}'.format('method', 'time (s)'))
+    t = run(s, duration, python=True)
+    print('{:>20} {:>12.4f}'.format('run (python)', t))
+    t = run(s, duration)
+    print('{:>20} {:>12.4f}'.format('run (compiled)', t))
+    t = run(s, duration, tau=0.01)
+    print('{:>20} {:>12.4f}'.format('run (tau-leaping)', t))
+    t = run_batch(s, duration, runs)
+    print('{:>20} {:>12.4f}'.format('run_batch x' + str(runs), t))
+    t = run_batch(s, duration, runs, tau=0.01)
+    print('{:>20} {:>12.4f}'.format('run_batch, tau', t))
@@ -0,0 +1,62 @@
+#!/usr/bin/env python3
+#
+# Benchmarks the time and memory used by Model.clone(), for models imported
+# from CellML and for a large generated model.
+#
+# Usage:
+#
+#   python3 benchmarks/model_clone.py [repeats]
+#
+# This file is part of Myokit.
+# See http://myokit.org for copyright, sharing, and licensing details.
+#
+import os
+import sys
+import tracemalloc
+
+import myokit
+import myokit.formats
+
+from model_dependencies import create_model
+
+
+DIR = os.path.join(myokit.DIR_MYOKIT, 'tests', 'data', 'formats', 'cellml')
+
+
+def models():
+    """ Yields tuples ``(name, model)``. """
+    importer = myokit.formats.importer('cellml')
+    for name in ('decker-2009', 'corrias'):
+        yield name, importer.model(os.path.join(DIR, name + '.cellml'))
+    yield 'generated', create_model(5000)
+
+
+def benchmark(model, repeats):
+    """
+    Returns the time in seconds taken per clone, and the memory allocated per
+    clone in megabytes.
+    """
+    model.clone()
+    b = myokit.tools.Benchmarker()
+    for i in range(repeats):
+        model.clone()
+    t = b.time() / repeats
+
+    tracemalloc.start()
+    clones = [model.clone() for i in range(repeats)]
+    size = tracemalloc.get_traced_memory()[0] / repeats / 1e6
+    tracemalloc.stop()
+    del clones
+    return t, size
+
+
+if __name__ == '__main__':
+    repeats = int(sys.argv[1]) if len(sys.argv) > 1 else 10
+
+    print('Model.clone(), ' + str(repeats) + ' repeats')
+    print('{:>12} {:>10} {:>12} {:>12}'.format(
+        'model', 'variables', 'time (s)', 'memory (MB)'))
+    for name, model in models():
+        n = sum(1 for v in model.variables(deep=True))
+        t, size = benchmark(model, repeats)
+        print('{:>12} {:>10d} {:>12.4f} {:>12.2f}'.format(name, n, t, size))
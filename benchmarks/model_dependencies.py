@@ -0,0 +1,84 @@
+#!/usr/bin/env python3
+#
+# Benchmarks the dependency analysis methods of Model on a large generated
+# model, with and without cached results.
+#
+# Usage:
+#
+#   python3 benchmarks/model_dependencies.py [nvars]
+#
+# This file is part of Myokit.
+# See http://myokit.org for copyright, sharing, and licensing details.
+#
+import random
+import sys
+
+import myokit
+
+
+def create_model(n, per_component=50, seed=1):
+    """
+    Creates a model with roughly ``n`` variables, grouped into components of
+    ``per_component`` variables, where each variable depends on up to three
+    earlier ones.
+    """
+    r = random.Random(seed)
+    m = myokit.Model()
+    c = m.add_component('engine')
+    t = c.add_variable('time')
+    t.set_rhs(0)
+    t.set_binding('time')
+    variables = []
+    for i in range(n):
+        if i % per_component == 0:
+            c = m.add_component('c' + str(i // per_component))
+        v = c.add_variable('v' + str(i))
+        terms = [myokit.Number(r.uniform(1, 2))]
+        for w in r.sample(variables, min(3, len(variables))):
+            terms.append(myokit.Name(w))
+        rhs = terms[0]
+        for term in terms[1:]:
+            rhs = myokit.Plus(rhs, term)
+        if i % 10 == 0:
+            v.promote(0)
+            rhs = myokit.Minus(rhs, myokit.Name(v))
+        v.set_rhs(rhs)
+        variables.append(v)
+    m.validate()
+    return m
+
+
+def analyse(model):
+    """ Performs the dependency analysis typically done for a simulation. """
+    model.map_shallow_dependencies()
+    model.map_deep_dependencies()
+    model.map_component_io()
+    model.solvable_order()
+
+
+def benchmark(n):
+    """
+    Runs each test once, and returns a list of tuples
+    ``(test, time in seconds)``.
+    """
+    model = create_model(n)
+    tests = [
+        ('analysis', lambda: analyse(model)),
+        ('analysis (cached)', lambda: analyse(model)),
+        ('clone + analysis', lambda: analyse(model.clone())),
+    ]
+    results = []
+    for name, f in tests:
+        b = myokit.tools.Benchmarker()
+        f()
+        results.append((name, b.time()))
+    return results
+
+
+if __name__ == '__main__':
+    n = int(sys.argv[1]) if len(sys.argv) > 1 else 2000
+
+    print('Model dependency analysis, ' + str(n) + ' variables')
+    print('{:>20} {:>12}'.format('test', 'time (s)'))
+    for name, t in benchmark(n):
+        print('{:>20} {:>12.3f}'.format(name, t))
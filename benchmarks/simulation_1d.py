@@ -0,0 +1,48 @@
+#!/usr/bin/env python3
+#
+# Benchmarks Simulation1d for increasing numbers of cells.
+#
+# Usage:
+#
+#   python3 benchmarks/simulation_1d.py [duration] [ncells ...]
+#
+# The number of threads used can be set with the OMP_NUM_THREADS environment
+# variable.
+#
+# This file is part of Myokit.
+# See http://myokit.org for copyright, sharing, and licensing details.
+#
+import os
+import sys
+
+import myokit
+
+DIR_DATA = os.path.join(
+    os.path.dirname(os.path.dirname(os.path.abspath(__file__))),
+    'myokit', 'tests', 'data')
+
+
+def benchmark(ncells, duration=10, step_size=0.005):
+    """
+    Runs a simulation of ``duration`` time units with ``ncells`` cells, and
+    returns the run time in seconds (excluding compilation).
+    """
+    m, p, _ = myokit.load(os.path.join(DIR_DATA, 'lr-1991.mmt'))
+    s = myokit.Simulation1d(m, p, ncells=ncells)
+    s.set_step_size(step_size)
+    b = myokit.tools.Benchmarker()
+    s.run(duration, log=myokit.LOG_NONE)
+    return b.time()
+
+
+if __name__ == '__main__':
+    duration = float(sys.argv[1]) if len(sys.argv) > 1 else 10
+    ncells = [int(x) for x in sys.argv[2:]] or [50, 500, 1000, 2000, 5000]
+
+    print('Simulation1d, ' + str(duration) + ' ms of LR1991')
+    print('OMP_NUM_THREADS=' + os.environ.get('OMP_NUM_THREADS', 'not set'))
+    print('{:>8} {:>12} {:>18}'.format('ncells', 'time (s)', 'cell steps/s'))
+    for n in ncells:
+        t = benchmark(n, duration)
+        r = n * duration / 0.005 / t
+        print('{:>8d} {:>12.3f} {:>18.3e}'.format(n, t, r))
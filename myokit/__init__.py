@@ -500,6 +500,7 @@ from ._progress import (    # noqa
 # Data logging
 from ._datalog import (     # noqa
     ColumnMetaData,
+    DataColumn,
     DataLog,
     _dimco,
     LoggedVariableInfo,
@@ -510,6 +511,7 @@ from ._datablock import (   # noqa
     ColorMap,
     DataBlock1d,
     DataBlock2d,
+    DataBlockWriter,
 )
 
 # Simulations
@@ -533,6 +535,7 @@ from ._sim.opencl import (  # noqa
 from ._sim.cmodel import CModel             # noqa
 from ._sim.cvodessim import Simulation      # noqa
 from ._sim.cable import Simulation1d        # noqa
+from ._sim.cvodessim1d import Simulation1dCVODES  # noqa
 from ._sim.rhs import RhsBenchmarker        # noqa
 from ._sim.jacobian import JacobianTracer, JacobianCalculator   # noqa
 from ._sim.openclsim import SimulationOpenCL                    # noqa
@@ -96,6 +96,7 @@ def main():
     add_block_parser(subparsers)            # Launch the DataBlock viewer
     add_compare_parser(subparsers)          # Compare models
     add_compiler_parser(subparsers)         # Show compiler
+    add_convert_data_parser(subparsers)     # Convert data files to DataLogs
     add_debug_parser(subparsers)            # Debug an RHS equation
     add_eval_parser(subparsers)             # Evaluate an expression
     add_export_parser(subparsers)           # Export an mmt file
@@ -238,6 +239,98 @@ def add_compiler_parser(subparsers):
     parser.set_defaults(func=compiler)
 
 
+#
+# Convert data
+#
+
+def convert_data(sources, target, join, names, no_da, single, recursive,
+                 processes):
+    """
+    Converts electrophysiology data files to DataLogs.
+    """
+    import sys
+    import myokit
+    import myokit.formats
+
+    precision = myokit.SINGLE_PRECISION if single else myokit.DOUBLE_PRECISION
+    try:
+        report = myokit.formats.convert_data(
+            sources, target, join_sweeps=join, use_names=names,
+            include_da=not no_da, precision=precision, recursive=recursive,
+            processes=processes)
+    except (FileNotFoundError, ValueError) as e:
+        print(str(e))
+        sys.exit(1)
+    for source, outputs in report.converted():
+        for path in outputs:
+            print(f'{source} -> {path}')
+    print(report)
+    if report.errors():
+        sys.exit(1)
+
+
+def add_convert_data_parser(subparsers):
+    """
+    Adds a subcommand parser for the ``convert-data`` command.
+    """
+    parser = subparsers.add_parser(
+        'convert-data',
+        description='Converts ABF, WCP, and HEKA PatchMaster files to'
+                    ' DataLogs, stored in an uncompressed binary format that'
+                    ' can be memory-mapped. Files are converted in parallel,'
+                    ' using a pool of worker processes.',
+        help='Converts electrophysiology data files to DataLogs.',
+    )
+    parser.add_argument(
+        'sources',
+        metavar='source',
+        nargs='+',
+        help='The files or directories to convert.',
+    )
+    parser.add_argument(
+        '-o',
+        '--target',
+        metavar='target_dir',
+        default='.',
+        help='The directory to write to (default: current directory).',
+    )
+    parser.add_argument(
+        '--join',
+        action='store_true',
+        help='Join sweeps into a single time series.',
+    )
+    parser.add_argument(
+        '--names',
+        action='store_true',
+        help='Use channel names instead of indices.',
+    )
+    parser.add_argument(
+        '--no-da',
+        action='store_true',
+        help='Don\'t include reconstructed D/A outputs.',
+    )
+    parser.add_argument(
+        '--single',
+        action='store_true',
+        help='Store data in single precision.',
+    )
+    parser.add_argument(
+        '-r',
+        '--recursive',
+        action='store_true',
+        help='Scan subdirectories of source directories.',
+    )
+    parser.add_argument(
+        '-j',
+        '--processes',
+        metavar='n',
+        type=int,
+        default=None,
+        help='The number of worker processes (default: one per CPU).',
+    )
+    parser.set_defaults(func=convert_data)
+
+
 #
 # Debug
 #
@@ -1825,6 +1918,7 @@ def video(src, key, dst, fps, grow, colormap):
     import os
     import sys
     import myokit
+    import numpy as np
 
     # Test if moviepy is installed
     print('Loading moviepy.')
@@ -1925,11 +2019,25 @@ def video(src, key, dst, fps, grow, colormap):
     print('  ny = ' + str(ny))
     print('  nt = ' + str(nt))
 
-    # Create movie
-    print('Converting data into image frames.')
-    frames = data.colors(key, colormap=colormap, multiplier=grow)
-    print('Compiling frames into video clip.')
-    video = mpy.ImageSequenceClip(frames, fps=fps)
+    # Create movie, rendering frames in batches as they are written
+    print('Converting data into video clip.')
+    values = data.get2d(key)
+    lower, upper = np.min(values), np.max(values)
+    state = {'i': -1, 'frames': None, 'frame': None}
+
+    def make_frame(t):
+        i = min(int(t * fps + 1e-9), nt - 1)
+        if state['frames'] is None or i < state['i']:
+            state['frames'] = data.iter_colors(
+                key, colormap=colormap, lower=lower, upper=upper,
+                multiplier=grow)
+            state['i'] = -1
+        while state['i'] < i:
+            state['frame'] = next(state['frames'])
+            state['i'] += 1
+        return state['frame']
+
+    video = mpy.VideoClip(make_frame, duration=nt / fps)
     rate = str(nx * ny * fps * 4)
     video.write_videofile(dst, fps=24, audio=False, codec=codec, bitrate=rate)
 
@@ -467,7 +467,9 @@ def _prepare_bindings(model, labels):
             unused.append(var)
             continue
         # TODO: Remove this line; https://github.com/myokit/myokit/issues/320
-        var.set_rhs(0)
+        # Skipped if already set, to keep any cached dependency analysis.
+        if var.rhs() != myokit.Number(0):
+            var.set_rhs(0)
 
     for var in unused:
         var.set_binding(None)
@@ -0,0 +1,306 @@
+#
+# Chunked, compressed, columnar storage for DataLog and DataBlock objects.
+#
+# This file is part of Myokit.
+# See http://myokit.org for copyright, sharing, and licensing details.
+#
+import bz2
+import collections
+import concurrent.futures
+import json
+import lzma
+import os
+import zlib
+
+import numpy as np
+
+import myokit
+
+# Magic bytes at the start of every chunked file, and format version
+MAGIC = b'MYOKIT-CHUNKED\x00\x00'
+VERSION = 1
+
+# Approximate uncompressed size of a chunk, if no chunk size is given
+DEFAULT_CHUNK_BYTES = 1 << 20
+
+# Supported codecs, as (compress, decompress) functions
+CODECS = {
+    'none': (lambda x: x, lambda x: x),
+    'zlib': (lambda x: zlib.compress(x, 1), zlib.decompress),
+    'lzma': (lambda x: lzma.compress(x, preset=1), lzma.decompress),
+    'bz2': (bz2.compress, bz2.decompress),
+}
+
+# Supported float transforms
+TRANSFORMS = ('none', 'shuffle', 'xor')
+
+# Little-endian data types
+DTYPES = {'d': np.dtype('<f8'), 'f': np.dtype('<f4')}
+
+# Integer types used for XOR-delta transforms
+ITYPES = {8: np.dtype('<u8'), 4: np.dtype('<u4')}
+
+# Encoding used for the index
+ENC = 'utf-8'
+
+
+def _encode(chunk, dtype, codec, transform):
+    """
+    Transforms and compresses a chunk ``(n, ...)`` of data, and returns the
+    resulting bytes.
+    """
+    x = np.ascontiguousarray(chunk, dtype=dtype)
+    if transform == 'xor' and len(x) > 1:
+        # XOR-delta along the time axis
+        x = x.view(ITYPES[dtype.itemsize])
+        x = np.concatenate((x[:1], x[1:] ^ x[:-1]))
+    if transform != 'none':
+        # Byte shuffle: store the first byte of every value, then the second,
+        # etc.
+        x = x.reshape(-1).view(np.uint8).reshape(-1, dtype.itemsize).T
+    return CODECS[codec][0](np.ascontiguousarray(x).tobytes())
+
+
+def _decode(data, shape, dtype, codec, transform):
+    """ Decompresses and inverse-transforms a chunk with the given shape. """
+    x = np.frombuffer(CODECS[codec][1](data), dtype=np.uint8)
+    if len(x) != int(np.prod(shape)) * dtype.itemsize:
+        raise ValueError('Unexpected chunk size.')
+    if transform != 'none':
+        x = np.ascontiguousarray(x.reshape(dtype.itemsize, -1).T)
+    if transform == 'xor':
+        x = x.view(ITYPES[dtype.itemsize]).reshape(shape)
+        x = np.bitwise_xor.accumulate(x, axis=0)
+    return x.view(dtype).reshape(shape)
+
+
+def write(filename, columns, length, info, dtype='d', chunk_size=None,
+          codec='zlib', transform='shuffle', threads=None):
+    """
+    Writes a chunked file.
+
+    Arguments:
+
+    ``filename``
+        The file to write to.
+    ``columns``
+        A list of tuples ``(name, data)``, where each ``data`` is an array
+        with shape ``(length, ...)``.
+    ``length``
+        The number of points in time in each column.
+    ``info``
+        A JSON-serialisable dict with information to store in the index.
+    ``dtype``
+        The data type to store, ``'d'`` or ``'f'``.
+    ``chunk_size``
+        The number of points in time in each chunk, or ``None`` to choose a
+        size so that chunks contain about 1MiB of uncompressed data.
+    ``codec``
+        The compression codec to use, one of ``'zlib'`` (default), ``'lzma'``,
+        ``'bz2'``, or ``'none'``.
+    ``transform``
+        The transform to apply before compression, one of ``'shuffle'`` (byte
+        shuffling, the default), ``'xor'`` (XOR-delta along the time axis,
+        followed by byte shuffling) or ``'none'``.
+    ``threads``
+        The number of threads to compress chunks with, or ``None`` to use one
+        thread per CPU.
+
+    """
+    if codec not in CODECS:
+        raise ValueError(
+            'Unknown codec "' + str(codec) + '", expecting one of '
+            + ', '.join(CODECS) + '.')
+    if transform not in TRANSFORMS:
+        raise ValueError(
+            'Unknown transform "' + str(transform) + '", expecting one of '
+            + ', '.join(TRANSFORMS) + '.')
+    try:
+        npdtype = DTYPES[dtype]
+    except KeyError:
+        raise ValueError('Unknown data type: "' + str(dtype) + '".')
+
+    # Convert columns, determine chunk size
+    length = int(length)
+    columns = [(str(name), np.asarray(data)) for name, data in columns]
+    for name, data in columns:
+        if len(data) != length:
+            raise ValueError(
+                'Column "' + name + '" has length ' + str(len(data))
+                + ', expecting ' + str(length) + '.')
+    if chunk_size is None:
+        row = max([int(np.prod(x.shape[1:])) for _, x in columns] + [1])
+        chunk_size = max(1, DEFAULT_CHUNK_BYTES // (row * npdtype.itemsize))
+    chunk_size = int(chunk_size)
+    if chunk_size < 1:
+        raise ValueError('Chunk size must be at least 1.')
+
+    # Jobs: (column index, first row, last row + 1)
+    jobs = [(i, j, min(j + chunk_size, length))
+            for i in range(len(columns))
+            for j in range(0, length, chunk_size)]
+    chunks = [[] for _ in columns]
+
+    nthreads = myokit.tools.thread_count(threads)
+    with open(filename, 'wb') as f:
+        f.write(MAGIC)
+        f.write(VERSION.to_bytes(4, 'little'))
+        f.write(bytes(4))
+        offset = len(MAGIC) + 8
+
+        def store(i, future):
+            nonlocal offset
+            data = future.result()
+            f.write(data)
+            chunks[i].append([offset, len(data)])
+            offset += len(data)
+
+        # Compress in parallel, keeping a limited number of chunks in memory
+        with concurrent.futures.ThreadPoolExecutor(nthreads) as pool:
+            pending = collections.deque()
+            for i, a, b in jobs:
+                pending.append((i, pool.submit(
+                    _encode, columns[i][1][a:b], npdtype, codec, transform)))
+                if len(pending) >= 2 * nthreads:
+                    store(*pending.popleft())
+            while pending:
+                store(*pending.popleft())
+
+        # Write index, followed by its offset
+        index = {
+            'length': length,
+            'dtype': dtype,
+            'chunk_size': chunk_size,
+            'codec': codec,
+            'transform': transform,
+            'columns': [
+                {'name': name, 'shape': list(data.shape[1:]),
+                 'chunks': chunks[i]}
+                for i, (name, data) in enumerate(columns)],
+            'info': info,
+        }
+        f.write(json.dumps(index).encode(ENC))
+        f.write(offset.to_bytes(8, 'little'))
+
+
+def is_chunked(filename):
+    """ Checks if the given file starts with the chunked file magic bytes. """
+    with open(filename, 'rb') as f:
+        return f.read(len(MAGIC)) == MAGIC
+
+
+class Reader:
+    """
+    Reads data from a chunked file.
+
+    Any errors in the file format are raised as exceptions of type ``error``.
+    """
+    def __init__(self, filename, error):
+        self._filename = filename
+        self._error = error
+
+        size = os.path.getsize(filename)
+        with open(filename, 'rb') as f:
+            if f.read(len(MAGIC)) != MAGIC:
+                raise error('Invalid chunked file format.')
+            version = int.from_bytes(f.read(4), 'little')
+            if version != VERSION:
+                raise error(
+                    'Unsupported chunked file version: ' + str(version) + '.')
+            start = len(MAGIC) + 8
+            if size < start + 8:
+                raise error('Invalid chunked file format.')
+            f.seek(size - 8)
+            offset = int.from_bytes(f.read(8), 'little')
+            if offset < start or offset > size - 8:
+                raise error('Invalid chunked file index offset.')
+            f.seek(offset)
+            try:
+                index = json.loads(f.read(size - 8 - offset).decode(ENC))
+                self.length = int(index['length'])
+                self.chunk_size = int(index['chunk_size'])
+                self.info = index['info']
+                self._dtype = DTYPES[index['dtype']]
+                self._codec = str(index['codec'])
+                self._transform = str(index['transform'])
+                self._columns = collections.OrderedDict()
+                for c in index['columns']:
+                    self._columns[str(c['name'])] = (
+                        tuple(int(x) for x in c['shape']),
+                        [(int(a), int(b)) for a, b in c['chunks']])
+            except (ValueError, KeyError, TypeError):
+                raise error('Invalid chunked file index.')
+        if self._codec not in CODECS:
+            raise error('Unknown codec: "' + self._codec + '".')
+        if self._transform not in TRANSFORMS:
+            raise error('Unknown transform: "' + self._transform + '".')
+        if self.chunk_size < 1 or self.length < 0:
+            raise error('Invalid chunked file index.')
+        nchunks = -(-self.length // self.chunk_size)
+        for shape, chunks in self._columns.values():
+            if len(chunks) != nchunks:
+                raise error('Invalid number of chunks in chunked file.')
+            for a, b in chunks:
+                if a < start or a + b > offset:
+                    raise error('Invalid chunk position in chunked file.')
+
+    def names(self):
+        """ Returns the names of all columns in this file. """
+        return list(self._columns.keys())
+
+    def read(self, names=None, a=0, b=None, threads=None):
+        """
+        Reads the rows ``a`` to ``b`` (exclusive) of the columns in ``names``
+        (or all columns, if ``names`` is ``None``), and returns an ordered
+        dict mapping names to numpy arrays.
+
+        Only the chunks overlapping with the requested rows are read and
+        decompressed, in parallel using ``threads`` threads. Chunks are read in
+        windows of ``threads`` chunks at a time, so that no more than one
+        window of compressed data is held in memory.
+        """
+        if names is None:
+            names = self.names()
+        for name in names:
+            if name not in self._columns:
+                raise KeyError(
+                    'Column not found in chunked file: ' + str(name))
+        b = self.length if b is None else min(int(b), self.length)
+        a = max(0, min(int(a), b))
+        k0 = a // self.chunk_size
+        k1 = -(-b // self.chunk_size)
+        nthreads = myokit.tools.thread_count(threads)
+        dtype = self._dtype.newbyteorder('=')
+
+        out = collections.OrderedDict()
+        with open(self._filename, 'rb') as f:
+            with concurrent.futures.ThreadPoolExecutor(nthreads) as pool:
+                for name in names:
+                    shape, chunks = self._columns[name]
+                    x = np.empty((b - a, ) + shape, dtype=dtype)
+                    for w in range(k0, k1, nthreads):
+                        # Read a window of chunks, and decompress in parallel
+                        window = range(w, min(w + nthreads, k1))
+                        fs = []
+                        for k in window:
+                            f.seek(chunks[k][0])
+                            n = min(self.chunk_size,
+                                    self.length - k * self.chunk_size)
+                            fs.append(pool.submit(
+                                _decode, f.read(chunks[k][1]), (n, ) + shape,
+                                self._dtype, self._codec, self._transform))
+
+                        # Copy the requested rows into the output array
+                        for k, future in zip(window, fs):
+                            try:
+                                part = future.result()
+                            except (ValueError, OSError, EOFError,
+                                    zlib.error, lzma.LZMAError):
+                                raise self._error(
+                                    'Unable to decompress chunk in column "'
+                                    + name + '".')
+                            c = k * self.chunk_size
+                            lo, hi = max(a, c), min(b, c + len(part))
+                            x[lo - a:hi - a] = part[lo - c:hi - c]
+                    out[name] = x
+        return out
@@ -5,6 +5,10 @@
 # See http://myokit.org for copyright, sharing, and licensing details.
 #
 import array
+import bisect
+import collections
+import concurrent.futures
+import json
 import os
 import sys
 
@@ -12,6 +16,8 @@ import myokit
 
 import numpy as np
 
+from myokit import _chunked
+
 
 # Readme file for DataBlock1d binary files
 README_SAVE_1D = """
@@ -83,6 +89,319 @@ header, and little-endian:
 # Encoding used for text portions of zip files
 ENC = 'utf-8'
 
+# Magic bytes, version, and alignment for the frame-based binary format
+FRAMES_MAGIC = b'MYOKIT-FRAMES\x00\x00\x00'
+FRAMES_VERSION = 1
+FRAMES_ALIGN = 64
+
+# Number of bytes to write at once when appending frames
+FRAMES_BATCH_SIZE = 1 << 24
+
+# Number of data points to convert to colors at once when rendering frames
+RENDER_BATCH_SIZE = 1 << 20
+
+# Number of matrix entries to pass to LAPACK at once in eigenvalue methods
+EIGEN_BATCH_SIZE = 1 << 20
+
+# Relative tolerance and maximum number of iterations for power iteration
+POWER_ITERATION_TOL = 1e-10
+POWER_ITERATION_MAX = 100
+
+
+def _save_chunked(filename, kind, time, data0d, datand, info, chunk_size,
+                  codec, transform, threads):
+    """
+    Stores the time, 0d, and nd data of a data block in a chunked file.
+
+    Columns are stored as ``time``, ``0d/name``, and ``nd/name``. The ``info``
+    dict should contain the block dimensions.
+    """
+    columns = [('time', time)]
+    columns.extend([('0d/' + k, v) for k, v in data0d.items()])
+    columns.extend([('nd/' + k, v) for k, v in datand.items()])
+    info['kind'] = kind
+    _chunked.write(
+        os.path.expanduser(filename), columns, len(time), info, 'd',
+        chunk_size, codec, transform, threads)
+
+
+def _load_chunked(filename, kind, names, a, b, threads):
+    """
+    Reads a data block from a chunked file, and returns a tuple
+    ``(info, time, data0d, datand)``.
+    """
+    reader = _chunked.Reader(
+        os.path.expanduser(filename), myokit.DataBlockReadError)
+    info = reader.info
+    if not isinstance(info, dict) or info.get('kind') != kind:
+        raise myokit.DataBlockReadError(
+            'Chunked file does not contain a ' + kind + '.')
+    columns = reader.names()
+    if 'time' not in columns:
+        raise myokit.DataBlockReadError(
+            'Chunked file does not contain a time column.')
+
+    # Select columns
+    if names is None:
+        columns = [c for c in columns if c != 'time']
+    else:
+        selected = []
+        for name in names:
+            for c in ('0d/' + name, 'nd/' + name):
+                if c in columns:
+                    selected.append(c)
+                    break
+            else:
+                raise KeyError('Variable not found in data block: ' + name)
+        columns = selected
+
+    # Select time range
+    time = reader.read(['time'], threads=threads)['time']
+    i = 0 if a is None else int(np.searchsorted(time, a, side='left'))
+    j = len(time) if b is None else int(np.searchsorted(time, b, 'left'))
+    j = max(i, j)
+
+    # Read data
+    data0d, datand = {}, {}
+    for c, v in reader.read(columns, i, j, threads).items():
+        (data0d if c.startswith('0d/') else datand)[c[3:]] = v
+    return info, time[i:j], data0d, datand
+
+
+def _is_frames(filename):
+    """ Returns True if the given file is in the frame-based format. """
+    with open(filename, 'rb') as f:
+        return f.read(len(FRAMES_MAGIC)) == FRAMES_MAGIC
+
+
+def _frames_dtype(head):
+    """
+    Returns the numpy record type for a single frame in the frame-based binary
+    format, as described by the header dict ``head``.
+    """
+    dtype = np.dtype({'d': '<f8', 'f': '<f4'}[head['dtype']])
+    shape = tuple(int(x) for x in head['shape'])
+    names, formats, offsets = [], [], []
+    for name, offset in head['columns']:
+        names.append(str(name))
+        formats.append((dtype, shape) if name.startswith('nd/') else '<f8')
+        offsets.append(int(offset))
+    return np.dtype({
+        'names': names, 'formats': formats, 'offsets': offsets,
+        'itemsize': int(head['record_size'])})
+
+
+def _frames_header(kind, shape, keys0d, keysnd, dtype):
+    """
+    Creates a header for the frame-based binary format.
+
+    Each frame is stored as a record containing the time and all 0d values
+    (as doubles), followed by one aligned array per nd variable (using
+    ``dtype``). The total record size is a multiple of ``FRAMES_ALIGN``.
+    """
+    size = np.dtype({'d': '<f8', 'f': '<f4'}[dtype]).itemsize
+    size *= int(np.prod(shape))
+    columns = [['time', 0]]
+    columns.extend([['0d/' + k, 8 + 8 * i] for i, k in enumerate(keys0d)])
+    offset = 8 + 8 * len(keys0d)
+    for k in keysnd:
+        offset += -offset % FRAMES_ALIGN
+        columns.append(['nd/' + k, offset])
+        offset += size
+    offset += -offset % FRAMES_ALIGN
+    return {
+        'kind': kind,
+        'shape': list(shape),
+        'dtype': dtype,
+        'record_size': offset,
+        'columns': columns,
+    }
+
+
+def _load_frames(filename, kinds, names, a, b, mmap):
+    """
+    Reads a data block of one of the given ``kinds`` from a file in the
+    frame-based binary format, and returns a tuple
+    ``(head, time, data0d, datand)``.
+    """
+    filename = os.path.expanduser(filename)
+    nfile = os.path.getsize(filename)
+    with open(filename, 'rb') as f:
+        if f.read(len(FRAMES_MAGIC)) != FRAMES_MAGIC:
+            raise myokit.DataBlockReadError('Invalid frame file format.')
+        x = f.read(8)
+        if len(x) < 8:
+            raise myokit.DataBlockReadError('Invalid frame file format.')
+        version = int.from_bytes(x[:4], 'little')
+        if version != FRAMES_VERSION:
+            raise myokit.DataBlockReadError(
+                'Unsupported frame file version: ' + str(version) + '.')
+        nhead = int.from_bytes(x[4:], 'little')
+        try:
+            head = json.loads(f.read(nhead).decode(ENC))
+            rtype = _frames_dtype(head)
+        except (ValueError, KeyError, TypeError):
+            raise myokit.DataBlockReadError('Invalid frame file header.')
+    if head['kind'] not in kinds:
+        raise myokit.DataBlockReadError(
+            'Frame file does not contain a ' + kinds[-1] + '.')
+
+    # Select columns
+    columns = [c for c in rtype.names if c != 'time']
+    if names is not None:
+        selected = []
+        for name in names:
+            for c in ('0d/' + name, 'nd/' + name):
+                if c in columns:
+                    selected.append(c)
+                    break
+            else:
+                raise KeyError('Variable not found in data block: ' + name)
+        columns = selected
+
+    # Number of complete frames: an incomplete last frame, e.g. from an
+    # interrupted simulation, is ignored
+    start = len(FRAMES_MAGIC) + 8 + nhead
+    start += -start % FRAMES_ALIGN
+    nt = max(0, nfile - start) // rtype.itemsize
+    if nt == 0:
+        records = np.zeros(0, dtype=rtype)
+    else:
+        records = np.memmap(
+            filename, dtype=rtype, mode='r', offset=start, shape=(nt, ))
+
+    # Select time range, using a binary search that reads only a few frames
+    time = records['time']
+    i = 0 if a is None else bisect.bisect_left(time, a)
+    j = nt if b is None else bisect.bisect_left(time, b)
+    j = max(i, j)
+    records = records[i:j]
+
+    # Create views or read data
+    data0d, datand = {}, {}
+    for c in columns:
+        v = records[c] if mmap else np.array(records[c])
+        (data0d if c.startswith('0d/') else datand)[c[3:]] = v
+    return head, np.array(records['time']), data0d, datand
+
+
+def _log_layout(log):
+    """
+    Checks that a :class:`myokit.DataLog` contains only 0d data and 1d or 2d
+    data of a single size, and returns a tuple ``(time, keys0d, keysnd,
+    size)``, where ``time`` is the time key, ``keys0d`` is a list of other 0d
+    keys, ``keysnd`` maps variable names to lists of keys (ordered by x, then
+    y), and ``size`` is ``(nx, )`` or ``(nx, ny)``.
+    """
+    log.validate()
+    time = log.time_key()
+    if time is None:
+        raise ValueError('No time variable set in data log.')
+    infos = log.variable_info()
+    if time not in infos:
+        raise ValueError('Time variable must be 0-dimensional.')
+
+    size = None
+    keys0d, keysnd = [], {}
+    for name, info in infos.items():
+        d = info.dimension()
+        if d == 0:
+            if name != time:
+                keys0d.append(name)
+            continue
+        if d not in (1, 2):
+            raise ValueError(
+                'The given simulation log should only contain 0d, 1d, or 2d'
+                f' variables. Found <{name}> with d = {d}.')
+        if size is None:
+            size = tuple(info.size())
+        elif tuple(info.size()) != size:
+            raise ValueError(
+                'The given simulation log contains data sets of different'
+                ' sizes.')
+        keysnd[name] = list(info.keys())
+    if size is None:
+        raise ValueError(
+            'The given simulation log does not contain any 1d or 2d data.')
+    return time, keys0d, keysnd, size
+
+
+def _map_matrices(data, func, threads):
+    """
+    Calls ``func`` on batches of the square matrices ``data[t]``, and returns
+    the concatenated results.
+
+    Batches contain at most ``EIGEN_BATCH_SIZE`` matrix entries, so that only
+    a limited part of (memory-mapped) data is read at a time, and are
+    processed in parallel using ``threads`` threads.
+    """
+    nt = len(data)
+    if nt == 0:
+        return np.array([])
+    n = max(1, EIGEN_BATCH_SIZE // max(1, data.shape[1] * data.shape[2]))
+    bounds = [(a, min(a + n, nt)) for a in range(0, nt, n)]
+
+    nthreads = myokit.tools.thread_count(threads)
+    if nthreads == 1 or len(bounds) == 1:
+        return np.concatenate([func(np.asarray(data[a:b])) for a, b in bounds])
+
+    # Process batches in parallel, keeping a limited number in memory
+    results = []
+    with concurrent.futures.ThreadPoolExecutor(nthreads) as pool:
+        pending = collections.deque()
+        for a, b in bounds:
+            pending.append(pool.submit(func, np.asarray(data[a:b])))
+            if len(pending) >= 2 * nthreads:
+                results.append(pending.popleft().result())
+        while pending:
+            results.append(pending.popleft().result())
+    return np.concatenate(results)
+
+
+def _dominant(e):
+    """ Selects the eigenvalue with the largest magnitude from each row. """
+    return e[np.arange(len(e)), np.argmax(np.absolute(e), axis=1)]
+
+
+def _largest(e):
+    """ Selects the eigenvalue with the most positive real part per row. """
+    return e[np.arange(len(e)), np.argmax(np.real(e), axis=1)]
+
+
+def _power_iteration(a):
+    """
+    Estimates the dominant eigenvalue of every matrix ``a[t]`` using power
+    iteration, and falls back to LAPACK for matrices where this does not
+    converge.
+    """
+    # Start from a fixed vector that is unlikely to be orthogonal to the
+    # dominant eigenvector
+    k, n = a.shape[0], a.shape[1]
+    v = np.tile(1 + np.arange(n) / n, (k, 1))
+    v /= np.linalg.norm(v, axis=1)[:, None]
+    lam = np.zeros(k)
+    todo = np.arange(k)
+    for i in range(POWER_ITERATION_MAX):
+        w = np.matmul(a[todo], v[:, :, None])[:, :, 0]
+        x = np.einsum('ij,ij->i', v, w)
+        lam[todo] = x
+        busy = np.linalg.norm(w - x[:, None] * v, axis=1) > (
+            POWER_ITERATION_TOL * np.absolute(x))
+        todo, w = todo[busy], w[busy]
+        if len(todo) == 0:
+            return lam
+        norm = np.linalg.norm(w, axis=1)
+        norm[norm == 0] = 1
+        v = w / norm[:, None]
+
+    # Use LAPACK for the remaining matrices, e.g. if the dominant eigenvalue
+    # is complex, or if two eigenvalues have the same magnitude
+    e = _dominant(np.linalg.eigvals(a[todo]))
+    if np.iscomplexobj(e):
+        lam = lam.astype(complex)
+    lam[todo] = e
+    return lam
+
 
 class DataBlock1d:
     """
@@ -192,46 +511,34 @@ class DataBlock1d:
         ilo = border                # First index
         ihi = self._nx - border     # Last index + 1
 
-        # Indices of cells with AP
-        i1 = None
-        i2 = None
-
-        # Get Vm, reshaped to get each cell's time-series successively.
-        v_series = self._1d[name].reshape(self._nt * self._nx, order='F')
-
-        # Split Vm into a series per cell (returns views!)
-        v_series = np.split(v_series, self._nx)
-
-        # Find first activation time
-        have_crossing = False
-        t = []
-        for i in range(ilo, ihi):
-            v = v_series[i]
-            # Get index of first threshold crossing with positive flank
-            # Don't include crossings at log index 0
-            itime = np.where((v[1:] > -30) & (v[1:] - v[:-1] > 0))[0]
-            if len(itime) == 0 or itime[0] == 0:
-                # No crossing found
-                if have_crossing:
-                    # CV calculation ends here
-                    i2 = i - 1
-                    break
-            else:
-                # Crossing found!
-                if have_crossing:
-                    i2 = i
-                else:
-                    i1 = i
-                    have_crossing = True
-                itime = 1 + itime[0]
-                # Interpolate to get better estimate
-                v0 = v[itime - 1]
-                v1 = v[itime]
-                t0 = self._time[itime - 1]
-                t1 = self._time[itime]
-                t.append(t0 + (threshold - v0) * (t1 - t0) / (v1 - v0))
-        if not have_crossing:
+        # Get Vm for the selected cells, as a 2d array with a column per cell
+        v = self._1d[name][:, ilo:ihi]
+
+        # Find the index of the first threshold crossing with positive flank
+        # in each cell. Don't include crossings at log index 0.
+        up = (v[1:] > threshold) & (v[1:] > v[:-1])
+        itime = 1 + np.argmax(up, axis=0)
+        crossing = np.any(up, axis=0) & (itime > 1)
+
+        # Find first cell with a crossing, and the last cell in the connected
+        # series of cells with a crossing that follows it
+        if not np.any(crossing):
             return 0
+        i1 = int(np.argmax(crossing))
+        i2 = i1 + int(np.argmin(crossing[i1:])) - 1
+        if i2 < i1:
+            i2 = len(crossing) - 1
+
+        # Interpolate to get a better estimate of the activation times
+        cells = np.arange(i1, 1 + i2)
+        itime = itime[cells]
+        v0 = v[itime - 1, cells]
+        v1 = v[itime, cells]
+        t0 = self._time[itime - 1]
+        t1 = self._time[itime]
+        t = t0 + (threshold - v0) * (t1 - t0) / (v1 - v0)
+        i1 += ilo
+        i2 += ilo
 
         # No propagation: all depolarisations at the same time
         if np.all(t == t[0]):
@@ -464,8 +771,16 @@ class DataBlock1d:
         the :class:`myokit.ProgressReporter` interface can be passed in.
         passed in as ``progress``. An optional description of the current
         simulation to use in the ProgressReporter can be passed in as `msg`.
+
+        Files stored with :meth:`save_chunked` or :meth:`save_frames` are also
+        supported, and are loaded with :meth:`load_chunked` or
+        :meth:`load_frames`.
         """
         filename = os.path.expanduser(filename)
+        if _chunked.is_chunked(filename):
+            return DataBlock1d.load_chunked(filename)
+        if _is_frames(filename):
+            return DataBlock1d.load_frames(filename)
 
         # Load compression modules
         import zipfile
@@ -619,6 +934,67 @@ class DataBlock1d:
             if progress:
                 progress.exit()
 
+    @staticmethod
+    def load_chunked(filename, names=None, a=None, b=None, threads=None):
+        """
+        Loads a :class:`DataBlock1d` stored with :meth:`save_chunked`.
+
+        Only the chunks needed to return the requested data are read from
+        disk.
+
+        Arguments:
+
+        ``filename``
+            The file to load.
+        ``names``
+            An optional list of 0d and 1d variable names to load. If not
+            given, all variables are loaded.
+        ``a``
+            An optional time to start loading from. Only points with
+            ``time >= a`` will be loaded.
+        ``b``
+            An optional time to stop loading at. Only points with
+            ``time < b`` will be loaded.
+        ``threads``
+            The number of threads to decompress chunks with, or ``None`` to
+            use one thread per CPU.
+
+        """
+        info, time, data0d, data1d = _load_chunked(
+            filename, 'DataBlock1d', names, a, b, threads)
+        try:
+            block = DataBlock1d(info['nx'], time, copy=False)
+            for k, v in data0d.items():
+                block.set0d(k, v, copy=False)
+            for k, v in data1d.items():
+                block.set1d(k, v, copy=False)
+        except (KeyError, ValueError):
+            raise myokit.DataBlockReadError(
+                'Invalid DataBlock1d data in chunked file.')
+        return block
+
+    @staticmethod
+    def load_frames(filename, names=None, a=None, b=None, mmap=False):
+        """
+        Loads a :class:`DataBlock1d` stored with :meth:`save_frames` or a
+        :class:`DataBlockWriter`.
+
+        See :meth:`DataBlock2d.load_frames` for details of the arguments.
+        """
+        head, time, data0d, data1d = _load_frames(
+            filename, ('DataBlock1d', ), names, a, b, mmap)
+        try:
+            nx, = head['shape']
+            block = DataBlock1d(nx, time, copy=False)
+            for k, v in data0d.items():
+                block.set0d(k, v, copy=False)
+            for k, v in data1d.items():
+                block.set1d(k, v, copy=False)
+        except (KeyError, ValueError):
+            raise myokit.DataBlockReadError(
+                'Invalid DataBlock1d data in frame file.')
+        return block
+
     def remove0d(self, name):
         """Removes the 0d time-series identified by ``name``."""
         del self._0d[name]
@@ -702,6 +1078,33 @@ class DataBlock1d:
             f.writestr(body, body_str)
             f.writestr(read, README_SAVE_1D.encode(ENC))
 
+    def save_chunked(self, filename, chunk_size=None, codec='zlib',
+                     transform='shuffle', threads=None):
+        """
+        Writes this ``DataBlock1d`` to a chunked, compressed, columnar file.
+
+        The time series are split into chunks of ``chunk_size`` points in
+        time, which are compressed independently and in parallel. The
+        resulting file can be read with :meth:`load_chunked`, which can load
+        any subset of variables and any time interval without decompressing
+        the whole file.
+
+        See :meth:`myokit.DataLog.save_chunked` for details of the arguments.
+        """
+        _save_chunked(
+            filename, 'DataBlock1d', self._time, self._0d, self._1d,
+            {'nx': self._nx}, chunk_size, codec, transform, threads)
+
+    def save_frames(self, filename, precision=myokit.DOUBLE_PRECISION):
+        """
+        Writes this ``DataBlock1d`` to an uncompressed binary file, in which
+        the data for each point in time is stored as a single aligned record.
+
+        See :meth:`DataBlock2d.save_frames` for details.
+        """
+        with DataBlockWriter(filename, precision) as w:
+            w.append_block(self)
+
     def set0d(self, name, data, copy=True):
         """
         Adds or updates a zero-dimensional time series ``data`` for the
@@ -838,6 +1241,41 @@ class DataBlock2d:
         # 2d variables
         self._2d = {}
 
+    def _color_args(self, name, colormap, lower, upper):
+        """
+        Returns a tuple ``(color_map, lower, upper)`` for the rendering
+        methods.
+        """
+        data = self._2d[name]
+        color_map = ColorMap.get(colormap)
+        lower = np.min(data) if lower is None else float(lower)
+        upper = np.max(data) if upper is None else float(upper)
+        if upper < lower:
+            upper = lower
+        return color_map, lower, upper
+
+    def _render(self, color_map, frames, lower, upper, multiplier, alpha, rgb,
+                out):
+        """
+        Applies a ``color_map`` to a batch of ``frames``, and writes the result
+        to ``out``, growing every point to a square of ``multiplier`` pixels.
+        """
+        if multiplier == 1:
+            color_map.apply(frames, lower, upper, alpha, rgb, out=out)
+        else:
+            k, ny, nx = frames.shape
+            m = multiplier
+            small = color_map.apply(frames, lower, upper, alpha, rgb)
+            out.reshape((k, ny, m, nx, m, small.shape[-1]))[...] = \
+                small[:, :, None, :, None, :]
+
+    def _render_batch_size(self):
+        """
+        Returns the number of frames to render at once, so that the temporary
+        arrays used by :meth:`ColorMap.apply()` stay small.
+        """
+        return max(1, RENDER_BATCH_SIZE // max(1, self._nx * self._ny))
+
     def colors(self, name, colormap='traditional', lower=None, upper=None,
                multiplier=1):
         """
@@ -862,31 +1300,40 @@ class DataBlock2d:
             ``multiplier`` pixels.
 
         """
-        data = self._2d[name]
-        # Get color map
-        color_map = ColorMap.get(colormap)
-        # Get lower and upper bounds for colormap scaling
-        lower = np.min(data) if lower is None else float(lower)
-        upper = np.max(data) if upper is None else float(upper)
-        # Get multiplier
+        return list(self.colors_array(
+            name, colormap, lower, upper, multiplier))
+
+    def colors_array(self, name, colormap='traditional', lower=None,
+                     upper=None, multiplier=1, out=None):
+        """
+        Converts the 2d series indicated by ``name`` into a single ``uint8``
+        array of shape ``(nt, ny * multiplier, nx * multiplier, 3)``,
+        containing an RGB image for every point in time.
+
+        The arguments ``colormap``, ``lower``, ``upper``, and ``multiplier``
+        are the same as for :meth:`colors()`. A preallocated, C-contiguous
+        ``uint8`` array of the correct shape can be passed in as ``out``.
+
+        Frames are rendered in batches, using a lookup table from
+        :meth:`ColorMap.lut()`.
+        """
+        color_map, lower, upper = self._color_args(
+            name, colormap, lower, upper)
         multiplier = int(multiplier) if multiplier > 1 else 1
-        # Create images
-        frames = []
-        for frame in data:
-            # Convert 2d array into row-strided array
-            frame = frame.reshape(self._ny * self._nx, order='C')
-            # Apply colormap
-            frame = color_map(
-                frame, lower=lower, upper=upper, alpha=False, rgb=True)
-            # Reshape to nx * ny * 3 color array
-            frame = frame.reshape((self._ny, self._nx, 3))
-            # Grow
-            if multiplier > 1:
-                frame = frame.repeat(multiplier, axis=0)
-                frame = frame.repeat(multiplier, axis=1)
-            # Append to list
-            frames.append(frame)
-        return frames
+        shape = (self._nt, self._ny * multiplier, self._nx * multiplier, 3)
+        if out is None:
+            out = np.empty(shape, dtype=np.uint8)
+        elif (out.shape != shape or out.dtype != np.uint8
+                or not out.flags.c_contiguous):
+            raise ValueError(
+                'Output array must be a C-contiguous uint8 array of shape '
+                + str(shape) + '.')
+        data = self._2d[name]
+        n = self._render_batch_size()
+        for i in range(0, self._nt, n):
+            self._render(color_map, data[i:i + n], lower, upper, multiplier,
+                         False, True, out[i:i + n])
+        return out
 
     @staticmethod
     def combine(block1, block2, map2d, map0d=None, pos1=None, pos2=None):
@@ -1015,7 +1462,8 @@ class DataBlock2d:
         # Return new block
         return block
 
-    def dominant_eigenvalues(self, name):
+    def dominant_eigenvalues(self, name, power_iteration=False,
+                             threads=None):
         """
         Takes the 2d data specified by ``name`` and computes the dominant
         eigenvalue for each point in time (this only works for datablocks with
@@ -1024,35 +1472,43 @@ class DataBlock2d:
         The "dominant eigenvalue" is defined as the eigenvalue with the largest
         magnitude (``sqrt(a + bi)``).
 
+        Eigenvalues are calculated for batches of time points at once, using
+        ``threads`` threads (or one per CPU if ``threads=None``).
+
+        If ``power_iteration=True``, the dominant eigenvalues are estimated
+        using power iteration, which is much faster than a full eigenvalue
+        decomposition if the dominant eigenvalue is well separated from the
+        others. Iteration stops when the relative residual is less than
+        ``POWER_ITERATION_TOL``. For matrices where this does not happen within
+        ``POWER_ITERATION_MAX`` iterations (for example because the dominant
+        eigenvalue is complex), the full decomposition is used instead.
+
         The returned data is a 1d numpy array.
         """
         if self._nx != self._ny:
             raise Exception(
                 'Eigenvalues can only be determined for square data blocks.')
-        data = self._2d[name]
-        dominants = []
-        for t in range(self._nt):
-            e = np.linalg.eigvals(data[t])
-            dominants.append(e[np.argmax(np.absolute(e))])
-        return np.array(dominants)
+        if power_iteration:
+            return _map_matrices(self._2d[name], _power_iteration, threads)
+        return _map_matrices(
+            self._2d[name], lambda a: _dominant(np.linalg.eigvals(a)), threads)
 
-    def eigenvalues(self, name):
+    def eigenvalues(self, name, threads=None):
         """
         Takes the 2d data specified as ``name`` and computes the eigenvalues of
         its data matrix at every point in time (this only works for datablocks
         with a square 2d grid).
 
+        Eigenvalues are calculated for batches of time points at once, using
+        ``threads`` threads (or one per CPU if ``threads=None``).
+
         The returned data is a 2d numpy array where the first axis is time and
         the second axis is the index of each eigenvalue.
         """
         if self._nx != self._ny:
             raise Exception(
                 'Eigenvalues can only be determined for square data blocks.')
-        data = self._2d[name]
-        eigenvalues = []
-        for t in range(self._nt):
-            eigenvalues.append(np.linalg.eigvals(data[t]))
-        return np.array(eigenvalues)
+        return _map_matrices(self._2d[name], np.linalg.eigvals, threads)
 
     @staticmethod
     def from_DataLog(log):
@@ -1145,23 +1601,44 @@ class DataBlock2d:
         Converts the 2d series indicated by ``name`` into a list of 1d arrays
         in a row-strided image format ``ARGB32``.
         """
+        color_map, lower, upper = self._color_args(
+            name, colormap, lower, upper)
+        out = np.empty((self._nt, self._ny, self._nx, 4), dtype=np.uint8)
         data = self._2d[name]
-        # Get color map
-        color_map = ColorMap.get(colormap)
+        n = self._render_batch_size()
+        for i in range(0, self._nt, n):
+            self._render(color_map, data[i:i + n], lower, upper, 1, True,
+                         None, out[i:i + n])
+        return list(out.reshape((self._nt, self._ny * self._nx * 4)))
 
-        # Get lower and upper bounds for colormap scaling
-        lower = np.min(data) if lower is None else float(lower)
-        upper = np.max(data) if upper is None else float(upper)
-        if upper < lower:  # pragma: no cover
-            upper = lower
+    def iter_colors(self, name, colormap='traditional', lower=None,
+                    upper=None, multiplier=1):
+        """
+        Returns an iterator over the RGB frames for the 2d series indicated by
+        ``name``, as returned by :meth:`colors()`.
+
+        Frames are rendered in small batches, so that the full movie is never
+        stored in memory. Each frame is a view on a buffer that is reused for
+        the next batch, so frames should be copied if they need to be kept
+        after the iterator is advanced.
 
-        # Create images
-        frames = []
-        for frame in data:
-            # Convert 2d array into row-strided array
-            frame = frame.reshape(self._ny * self._nx, order='C')
-            frames.append(color_map(frame, lower=lower, upper=upper))
-        return frames
+        If ``lower`` or ``upper`` are not given, the minimum and maximum of the
+        full series are used.
+        """
+        color_map, lower, upper = self._color_args(
+            name, colormap, lower, upper)
+        multiplier = int(multiplier) if multiplier > 1 else 1
+        data = self._2d[name]
+        n = min(self._nt, self._render_batch_size())
+        buf = np.empty(
+            (n, self._ny * multiplier, self._nx * multiplier, 3),
+            dtype=np.uint8)
+        for i in range(0, self._nt, n):
+            frames = data[i:i + n]
+            k = len(frames)
+            self._render(color_map, frames, lower, upper, multiplier, False,
+                         True, buf[:k])
+            yield from buf[:k]
 
     def is_square(self):
         """ Returns True if this data block's grid is square. """
@@ -1195,7 +1672,7 @@ class DataBlock2d:
         """
         return iter(self._2d)
 
-    def largest_eigenvalues(self, name):
+    def largest_eigenvalues(self, name, threads=None):
         """
         Takes the 2d data specified by ``name`` and computes the largest
         eigenvalue for each point in time (this only works for datablocks with
@@ -1204,17 +1681,16 @@ class DataBlock2d:
         The "largest eigenvalue" is defined as the eigenvalue with the most
         positive real part. Note that the returned values may be complex.
 
+        Eigenvalues are calculated for batches of time points at once, using
+        ``threads`` threads (or one per CPU if ``threads=None``).
+
         The returned data is a 1d numpy array.
         """
         if self._nx != self._ny:
             raise Exception(
                 'Eigenvalues can only be determined for square data blocks.')
-        data = self._2d[name]
-        largest = []
-        for t in range(self._nt):
-            e = np.linalg.eigvals(data[t])
-            largest.append(e[np.argmax(np.real(e))])
-        return np.array(largest)
+        return _map_matrices(
+            self._2d[name], lambda a: _largest(np.linalg.eigvals(a)), threads)
 
     def len0d(self):
         """
@@ -1240,8 +1716,19 @@ class DataBlock2d:
 
         If the given file contains a :class:`DataBlock1d` this is read and
         converted to a 2d block without warning.
+
+        Files stored with :meth:`save_chunked` or :meth:`save_frames` are also
+        supported, and are loaded with :meth:`load_chunked` or
+        :meth:`load_frames`.
         """
         filename = os.path.expanduser(filename)
+        if _chunked.is_chunked(filename):
+            info = _chunked.Reader(filename, myokit.DataBlockReadError).info
+            if isinstance(info, dict) and info.get('kind') == 'DataBlock1d':
+                return DataBlock1d.load_chunked(filename).block2d()
+            return DataBlock2d.load_chunked(filename)
+        if _is_frames(filename):
+            return DataBlock2d.load_frames(filename)
 
         # Load compression modules
         import zipfile
@@ -1411,6 +1898,97 @@ class DataBlock2d:
             if progress:
                 progress.exit()
 
+    @staticmethod
+    def load_chunked(filename, names=None, a=None, b=None, threads=None):
+        """
+        Loads a :class:`DataBlock2d` stored with :meth:`save_chunked`.
+
+        Only the chunks needed to return the requested data are read from
+        disk.
+
+        Arguments:
+
+        ``filename``
+            The file to load.
+        ``names``
+            An optional list of 0d and 2d variable names to load. If not
+            given, all variables are loaded.
+        ``a``
+            An optional time to start loading from. Only frames with
+            ``time >= a`` will be loaded.
+        ``b``
+            An optional time to stop loading at. Only frames with
+            ``time < b`` will be loaded.
+        ``threads``
+            The number of threads to decompress chunks with, or ``None`` to
+            use one thread per CPU.
+
+        """
+        info, time, data0d, data2d = _load_chunked(
+            filename, 'DataBlock2d', names, a, b, threads)
+        try:
+            block = DataBlock2d(info['nx'], info['ny'], time, copy=False)
+            for k, v in data0d.items():
+                block.set0d(k, v, copy=False)
+            for k, v in data2d.items():
+                block.set2d(k, v, copy=False)
+        except (KeyError, ValueError):
+            raise myokit.DataBlockReadError(
+                'Invalid DataBlock2d data in chunked file.')
+        return block
+
+    @staticmethod
+    def load_frames(filename, names=None, a=None, b=None, mmap=False):
+        """
+        Loads a :class:`DataBlock2d` stored with :meth:`save_frames` or a
+        :class:`DataBlockWriter`.
+
+        Arguments:
+
+        ``filename``
+            The file to load.
+        ``names``
+            An optional list of 0d and 2d variable names to load. If not
+            given, all variables are loaded.
+        ``a``
+            An optional time to start loading from. Only frames with
+            ``time >= a`` will be loaded.
+        ``b``
+            An optional time to stop loading at. Only frames with
+            ``time < b`` will be loaded.
+        ``mmap``
+            Set to ``True`` to return a block containing read-only numpy
+            memory maps instead of arrays. In this case, data is only read
+            from disk when it is accessed, so that blocks larger than the
+            available memory can be used.
+
+        Frames are found using a binary search on the stored times, so that
+        only the frames in the selected time range are read. If the file
+        contains a :class:`DataBlock1d`, it is converted to a 2d block.
+        """
+        head, time, data0d, data2d = _load_frames(
+            filename, ('DataBlock1d', 'DataBlock2d'), names, a, b, mmap)
+        try:
+            if head['kind'] == 'DataBlock1d':
+                # Convert 1d data to 2d, as done by load()
+                nx, = head['shape']
+                block = DataBlock1d(nx, time, copy=False)
+                for k, v in data0d.items():
+                    block.set0d(k, v, copy=False)
+                for k, v in data2d.items():
+                    block.set1d(k, v, copy=False)
+                return block.block2d()
+            ny, nx = head['shape']
+            block = DataBlock2d(nx, ny, time, copy=False)
+            for k, v in data0d.items():
+                block.set0d(k, v, copy=False)
+            for k, v in data2d.items():
+                block.set2d(k, v, copy=False)
+        except (KeyError, ValueError):
+            raise myokit.DataBlockReadError(
+                'Invalid DataBlock2d data in frame file.')
+        return block
+
     def remove0d(self, name):
         """Removes the 0d time-series identified by ``name``."""
         del self._0d[name]
@@ -1498,6 +2076,38 @@ class DataBlock2d:
             f.writestr(body, body_str)
             f.writestr(read, README_SAVE_2D.encode(ENC))
 
+    def save_chunked(self, filename, chunk_size=None, codec='zlib',
+                     transform='shuffle', threads=None):
+        """
+        Writes this ``DataBlock2d`` to a chunked, compressed, columnar file.
+
+        Each 2d time series is split into chunks of ``chunk_size`` frames,
+        which are compressed independently and in parallel. The resulting file
+        can be read with :meth:`load_chunked`, which can load any subset of
+        variables and any time interval without decompressing the whole file.
+
+        See :meth:`myokit.DataLog.save_chunked` for details of the arguments.
+        """
+        _save_chunked(
+            filename, 'DataBlock2d', self._time, self._0d, self._2d,
+            {'nx': self._nx, 'ny': self._ny}, chunk_size, codec, transform,
+            threads)
+
+    def save_frames(self, filename, precision=myokit.DOUBLE_PRECISION):
+        """
+        Writes this ``DataBlock2d`` to an uncompressed binary file, in which
+        the data for each point in time is stored as a single aligned record.
+
+        Files in this format can be extended one frame at a time, using a
+        :class:`DataBlockWriter`, and can be memory-mapped by
+        :meth:`load_frames`.
+
+        Set ``precision`` to ``myokit.SINGLE_PRECISION`` to store 2d data in
+        single precision.
+        """
+        with DataBlockWriter(filename, precision) as w:
+            w.append_block(self)
+
     def save_frame_csv(
             self, filename, name, frame, xname='x', yname='y', zname='value'):
         """
@@ -1628,6 +2238,178 @@ class DataBlock2d:
         return self._2d[variable][:, y, x]
 
 
+class DataBlockWriter:
+    """
+    Writes a :class:`DataBlock1d` or :class:`DataBlock2d` to disk one or more
+    frames at a time, so that blocks that do not fit into memory can be
+    created, for example during a :class:`myokit.SimulationOpenCL` run.
+
+    Data is stored in the frame-based binary format written by
+    :meth:`DataBlock1d.save_frames` and :meth:`DataBlock2d.save_frames`. The
+    file is created when the first frames are appended, at which point the
+    names and dimensions of the stored variables are fixed. Files can be read
+    while they are being written, and any incomplete frame at the end of the
+    file is ignored when loading.
+
+    Arguments:
+
+    ``filename``
+        The file to write to.
+    ``precision``
+        Set to ``myokit.SINGLE_PRECISION`` to store 1d and 2d data in single
+        precision. Time and 0d data are always stored in double precision.
+
+    Writers can be used as context managers, to ensure the file is closed::
+
+        with myokit.DataBlockWriter('block.frames') as w:
+            w.append_log(log)
+
+    """
+    def __init__(self, filename, precision=myokit.DOUBLE_PRECISION):
+        self._filename = os.path.expanduser(filename)
+        self._dtype = 'd' if precision == myokit.DOUBLE_PRECISION else 'f'
+        self._file = None
+        self._head = None
+        self._rtype = None
+        self._length = 0
+        self._last = None
+        self._log_layout = None
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, exc_type, exc_value, traceback):
+        self.close()
+
+    def append(self, time, data0d=None, datand=None):
+        """
+        Appends ``k`` frames to the file.
+
+        Arguments:
+
+        ``time``
+            A sequence of ``k`` non-decreasing times, all greater than or
+            equal to the last time already written.
+        ``data0d``
+            A dict mapping 0d variable names to sequences of ``k`` values.
+        ``datand``
+            A dict mapping 1d or 2d variable names to arrays of shape
+            ``(k, nx)`` or ``(k, ny, nx)``.
+
+        The same variables must be given in every call.
+        """
+        time = np.asarray(time, dtype=float)
+        data0d = {} if data0d is None else data0d
+        datand = {} if datand is None else datand
+        if time.ndim != 1:
+            raise ValueError('Time must be a sequence.')
+        k = len(time)
+        if k and (np.any(np.diff(time) < 0) or (
+                self._last is not None and time[0] < self._last)):
+            raise ValueError('Time must be non-decreasing.')
+
+        # Create file on first call
+        if self._head is None:
+            if datand:
+                shape = np.shape(next(iter(datand.values())))[1:]
+            else:
+                raise ValueError('At least one 1d or 2d variable is needed.')
+            if len(shape) not in (1, 2):
+                raise ValueError('Data must be 1d or 2d.')
+            kind = 'DataBlock1d' if len(shape) == 1 else 'DataBlock2d'
+            self._open(_frames_header(
+                kind, shape, list(data0d), list(datand), self._dtype))
+
+        # Check variables
+        names = ['0d/' + x for x in data0d] + ['nd/' + x for x in datand]
+        if set(names) != set(self._rtype.names[1:]):
+            raise ValueError(
+                'The same variables must be appended in every call.')
+
+        # Write frames in batches
+        n = max(1, FRAMES_BATCH_SIZE // self._rtype.itemsize)
+        for i in range(0, k, n):
+            j = min(i + n, k)
+            records = np.zeros(j - i, dtype=self._rtype)
+            records['time'] = time[i:j]
+            for key, v in data0d.items():
+                records['0d/' + key] = np.asarray(v)[i:j]
+            for key, v in datand.items():
+                records['nd/' + key] = np.asarray(v)[i:j]
+            self._file.write(records)
+        self._length += k
+        if k:
+            self._last = time[-1]
+
+    def append_block(self, block):
+        """
+        Appends all frames from a :class:`DataBlock1d` or
+        :class:`DataBlock2d`.
+        """
+        data0d = {k: block.get0d(k) for k in block.keys0d()}
+        if isinstance(block, DataBlock1d):
+            datand = {k: block.get1d(k) for k in block.keys1d()}
+        else:
+            datand = {k: block.get2d(k) for k in block.keys2d()}
+        self.append(block.time(), data0d, datand)
+
+    def append_log(self, log):
+        """
+        Appends all points from a :class:`myokit.DataLog`, which must contain
+        data in the form required by :meth:`DataBlock1d.from_log` or
+        :meth:`DataBlock2d.from_log`.
+
+        The structure of the log is analysed in the first call, and every log
+        appended after that must contain the same keys.
+        """
+        if self._log_layout is None:
+            self._log_layout = _log_layout(log)
+        time, keys0d, keysnd, shape = self._log_layout
+
+        k = len(log[time])
+        data0d = {key: log[key] for key in keys0d}
+        datand = {}
+        n = int(np.prod(shape))
+        for name, keys in keysnd.items():
+            data = np.empty((k, n))
+            for i, key in enumerate(keys):
+                data[:, i] = log[key]
+            if len(shape) == 2:
+                # Keys are ordered by x, then y
+                data = data.reshape((k, shape[0], shape[1]))
+                data = data.transpose((0, 2, 1))
+            datand[name] = data
+        self.append(log[time], data0d, datand)
+
+    def close(self):
+        """ Closes the file. """
+        if self._file is not None:
+            self._file.close()
+            self._file = None
+
+    def flush(self):
+        """ Flushes any buffered frames to disk. """
+        if self._file is not None:
+            self._file.flush()
+
+    def length(self):
+        """ Returns the number of frames written. """
+        return self._length
+
+    def _open(self, head):
+        """ Creates the file and writes its header. """
+        self._head = head
+        self._rtype = _frames_dtype(head)
+        head = json.dumps(head).encode(ENC)
+        start = len(FRAMES_MAGIC) + 8 + len(head)
+        self._file = open(self._filename, 'wb')
+        self._file.write(FRAMES_MAGIC)
+        self._file.write(FRAMES_VERSION.to_bytes(4, 'little'))
+        self._file.write(len(head).to_bytes(4, 'little'))
+        self._file.write(head)
+        self._file.write(bytes(-start % FRAMES_ALIGN))
+
+
 class ColorMap:
     """
     *Abstract class*
@@ -1665,9 +2447,46 @@ class ColorMap:
     """
     _colormaps = {}
 
+    # Cached lookup tables
+    _luts = {}
+
+    # Default number of entries in lookup tables used by apply()
+    LUT_SIZE = 4096
+
     def __call__(self, floats, lower=None, upper=None, alpha=True, rgb=None):
         raise NotImplementedError
 
+    def apply(self, floats, lower, upper, alpha=False, rgb=True, out=None,
+              size=None):
+        """
+        Applies this colormap to an array of ``floats`` of any shape, using a
+        lookup table, and returns a ``uint8`` array with an extra last axis of
+        length 3 (or 4 if ``alpha=True``).
+
+        Values are normalized using ``lower`` and ``upper``, and then rounded
+        to the nearest of ``size`` entries in the table returned by
+        :meth:`lut()`. If no ``size`` is given, :attr:`LUT_SIZE` is used. For
+        colormaps defined by a table of colors, the table itself is used, so
+        that the results are the same as when calling the colormap.
+
+        The arguments ``alpha`` and ``rgb`` have the same meaning as when
+        calling the colormap. A preallocated array can be passed in as
+        ``out``.
+        """
+        values = getattr(self, '_VALUES', None)
+        if values is None:
+            size = self.LUT_SIZE if size is None else int(size)
+            steps = size - 1
+        else:
+            size = steps = len(values)
+        lut = self.lut(size, alpha, rgb)
+        r = upper - lower
+        f = np.subtract(floats, lower, dtype=float)
+        f *= steps / r if r > 0 else 0
+        np.clip(f, 0, size - 1, out=f)
+        np.rint(f, out=f)
+        return lut.take(f.astype(np.intp), axis=0, out=out, mode='clip')
+
     @staticmethod
     def exists(name):
         """ Returns True if the given name corresponds to a colormap. """
@@ -1723,6 +2542,32 @@ class ColorMap:
         block.set2d('colormap', data, copy=False)
         return block.images('colormap', colormap=name)[0]
 
+    def lut(self, size=256, alpha=False, rgb=True):
+        """
+        Returns a read-only ``uint8`` array of shape ``(size, 3)`` (or
+        ``(size, 4)`` if ``alpha=True``), containing the colors for ``size``
+        equally spaced values from 0 to 1.
+
+        For colormaps defined by a table of colors, entry ``i`` is the color
+        for ``i / size``, so that a table of the same size is returned as is.
+
+        Lookup tables are created on first use, and cached for each colormap.
+        """
+        key = (type(self), size, bool(alpha), rgb)
+        try:
+            return ColorMap._luts[key]
+        except KeyError:
+            pass
+        if hasattr(self, '_VALUES'):
+            x = np.arange(size) / size
+        else:
+            x = np.linspace(0, 1, size)
+        lut = self(x, 0, 1, alpha=alpha, rgb=rgb)
+        lut = lut.reshape((size, 4 if alpha else 3))
+        lut.setflags(write=False)
+        ColorMap._luts[key] = lut
+        return lut
+
     @staticmethod
     def names():
         """
@@ -5,6 +5,10 @@
 # See http://myokit.org for copyright, sharing, and licensing details.
 #
 import array
+import bisect
+import collections
+import concurrent.futures
+import copy
 import json
 import os
 import re
@@ -16,6 +20,8 @@ from collections import OrderedDict
 
 import myokit
 
+from myokit import _chunked
+
 
 # Function to split keys into dimension-key,qname-key pairs
 ID_NAME_PATTERN = re.compile(r'(\d+.)+')
@@ -38,6 +44,15 @@ little-endian.
 # Encoding used for text portions of zip files
 ENC = 'utf-8'
 
+# Uncompressed DataLog binary files: magic bytes, version, and the alignment
+# (in bytes) of the data section and of every column in it
+BIN_MAGIC = b'MYOKIT-DATALOG\x00\x00'
+BIN_VERSION = 1
+BIN_ALIGN = 64
+
+# Approximate number of bytes per block when reading and writing CSV files
+CSV_BLOCK_SIZE = 1 << 22
+
 
 class DataLog(OrderedDict):
     """
@@ -229,11 +244,14 @@ class DataLog(OrderedDict):
         else:
             typecode = 'd'
             for v in self.values():
-                if isinstance(v, array.array):
+                if isinstance(v, (array.array, DataColumn)):
                     typecode = v.typecode
                 break
             for k, v in self.items():
-                log[str(k)] = array.array(typecode, v)
+                if isinstance(v, DataColumn):
+                    log[str(k)] = DataColumn(typecode, v)
+                else:
+                    log[str(k)] = array.array(typecode, v)
 
         # Copy meta data
         log._time = self._time
@@ -274,6 +292,9 @@ class DataLog(OrderedDict):
             if isinstance(v1, np.ndarray) or isinstance(v2, np.ndarray):
                 # Concatenation copies data
                 log[k] = np.concatenate((np.asarray(v1), np.asarray(v2)))
+            elif isinstance(v1, DataColumn):
+                log[k] = v1.copy()
+                log[k].extend(v2)
             else:
                 log[k] = list(v1)   # Copies v1 data
                 log[k].extend(v2)   # Copies v2 data
@@ -303,27 +324,7 @@ class DataLog(OrderedDict):
 
         If no such value exists in the log, ``len(time)`` is returned.
         """
-        times = self[self._time]
-
-        # Border cases
-        n = len(times)
-        if n == 0 or time <= times[0]:
-            return 0
-        if time > times[-1]:
-            return n
-
-        # Find t
-        def find(lo, hi):
-            # lo = first index, hi = last index + 1
-            if (lo + 1 == hi):
-                return lo + 1
-            m = int((lo + hi) / 2)
-            if time > times[m]:
-                return find(m, hi)
-            else:
-                return find(lo, m)
-
-        return find(0, n)
+        return bisect.bisect_left(self[self._time], time)
 
     def fold(self, period, discard_remainder=True):
         """
@@ -339,21 +340,38 @@ class DataLog(OrderedDict):
         """
         # Note: Using closed intervals can lead to logs of unequal length, so
         # it should be disabled here to ensure a valid log
-        logs = self.split_periodic(period, adjust=True, closed_intervals=False)
+        segments = self._periodic_segments(period, closed_intervals=False)
+        lengths = [imax - imin for imin, imax in segments]
+
         # Discard remainder if present
-        if discard_remainder:
-            if len(logs) > 1:
-                n = logs[0].length()
-                if logs[-1].length() < n:
-                    logs = logs[:-1]
+        if discard_remainder and len(segments) > 1:
+            if lengths[-1] < lengths[0]:
+                segments = segments[:-1]
+                lengths = lengths[:-1]
+
+        # Treat each variable as a 2d array, with a row for each period. If
+        # all periods have the same length, this can be done with a single
+        # copy and reshape.
+        n = lengths[0]
+        imin, imax = segments[0][0], segments[-1][1]
+        blocks = []
+        for k, v in self.items():
+            if k == self._time:
+                continue
+            v = np.asarray(v, dtype=float)
+            if all(x == n for x in lengths):
+                blocks.append((k, np.array(v[imin:imax]).reshape(-1, n)))
+            else:
+                blocks.append((k, [np.array(v[a:b]) for a, b in segments]))
+
         # Create new log with folded data
         out = myokit.DataLog()
         out._time = self._time
-        out[self._time] = logs[0][self._time]
-        for i, log in enumerate(logs):
-            for k, v in log.items():
-                if k != self._time:
-                    out[k, i] = v
+        time = np.asarray(self.time(), dtype=float)
+        out[self._time] = np.array(time[imin:segments[0][1]])
+        for i in range(len(segments)):
+            for k, v in blocks:
+                out[k, i] = v[i]
         return out
 
     def __getitem__(self, key):
@@ -412,87 +430,107 @@ class DataLog(OrderedDict):
         """
         Returns the value for variable ``name`` at a given ``time``, determined
         using linear interpolation between the nearest matching times.
+
+        If ``time`` is a sequence of times, a numpy array is returned with the
+        value at each time.
         """
-        t = self[self._time]
-        v = self[name]
+        if np.ndim(time) == 0:
+            t = self[self._time]
+            v = self[name]
 
-        # Don't extrapolate
-        if time < t[0] or time > t[-1]:
+            # Don't extrapolate
+            if time < t[0] or time > t[-1]:
+                raise ValueError(
+                    'Requested time is outside of logged range, would require'
+                    ' extrapolation.')
+
+            # Get first time *after or at* requested time
+            i1 = self.find_after(time)
+
+            # Return directly, if possible
+            if t[i1] == time:
+                return v[i1]
+
+            # Interpolate
+            i0 = i1 - 1
+            return v[i0] + (time - t[i0]) * (v[i1] - v[i0]) / (t[i1] - t[i0])
+
+        # Multiple times: use vectorised search and interpolation
+        t = np.asarray(self[self._time], dtype=float)
+        v = np.asarray(self[name], dtype=float)
+        x = np.asarray(time, dtype=float)
+        if len(x) == 0:
+            return np.array([])
+        if np.min(x) < t[0] or np.max(x) > t[-1]:
             raise ValueError(
                 'Requested time is outside of logged range, would require'
                 ' extrapolation.')
+        i1 = np.searchsorted(t, x, side='left')
+        i0 = np.maximum(i1 - 1, 0)
+        with np.errstate(divide='ignore', invalid='ignore'):
+            y = v[i0] + (x - t[i0]) * (v[i1] - v[i0]) / (t[i1] - t[i0])
+        return np.where(t[i1] == x, v[i1], y)
 
-        # Get first time *after or at* requested time
-        i1 = self.find_after(time)
-
-        # Return directly, if possible
-        if t[i1] == time:
-            return v[i1]
-
-        # Interpolate
-        i0 = i1 - 1
-        return v[i0] + (time - t[i0]) * (v[i1] - v[i0]) / (t[i1] - t[i0])
-
-    def isplit(self, i):
+    def isplit(self, i, view=False):
         """
         Returns two logs, where the first contains all this log's entries up to
         index ``i``, and the second contains all entries starting from ``i``
         and higher.
+
+        By default, the data is copied. If ``view=True``, columns stored as
+        :class:`DataColumn` objects are not copied, but returned as read-only
+        numpy views.
         """
         log1 = DataLog()
         log2 = DataLog()
         log1._time = self._time
         log2._time = self._time
         for k, v in self.items():
-            if isinstance(v, np.ndarray):
-                log1[k] = np.array(v[:i], copy=True, dtype=float)
-                log2[k] = np.array(v[i:], copy=True, dtype=float)
-            else:
-                log1[k] = v[:i]
-                log2[k] = v[i:]
+            log1[k] = _slice_column(v, slice(None, i), view)
+            log2[k] = _slice_column(v, slice(i, None), view)
         return log1, log2
 
-    def itrim(self, a, b):
+    def itrim(self, a, b, view=False):
         """
         Returns a copy of this log, with all entries trimmed to the region
         between indices ``a`` and ``b`` (similar to performing ``x = x[a:b]``
         on a list).
+
+        If ``view=True``, columns stored as :class:`DataColumn` objects are not
+        copied, but returned as read-only numpy views.
         """
         log = DataLog()
         log._time = self._time
         for k, v in self.items():
-            if isinstance(v, np.ndarray):
-                log[k] = np.array(v[a:b], copy=True, dtype=float)
-            else:
-                log[k] = v[a:b]
+            log[k] = _slice_column(v, slice(a, b), view)
         return log
 
-    def itrim_left(self, i):
+    def itrim_left(self, i, view=False):
         """
         Returns a copy of this log, with all entries before index ``i``
         removed (similar to performing ``x = x[i:]`` on a list).
+
+        If ``view=True``, columns stored as :class:`DataColumn` objects are not
+        copied, but returned as read-only numpy views.
         """
         log = DataLog()
         log._time = self._time
         for k, v in self.items():
-            if isinstance(v, np.ndarray):
-                log[k] = np.array(v[i:], copy=True, dtype=float)
-            else:
-                log[k] = v[i:]
+            log[k] = _slice_column(v, slice(i, None), view)
         return log
 
-    def itrim_right(self, i):
+    def itrim_right(self, i, view=False):
         """
         Returns a copy of this log, with all entries starting from index ``i``
         removed (similar to performing ``x = x[:i]`` on a list).
+
+        If ``view=True``, columns stored as :class:`DataColumn` objects are not
+        copied, but returned as read-only numpy views.
         """
         log = DataLog()
         log._time = self._time
         for k, v in self.items():
-            if isinstance(v, np.ndarray):
-                log[k] = np.array(v[:i], copy=True, dtype=float)
-            else:
-                log[k] = v[:i]
+            log[k] = _slice_column(v, slice(None, i), view)
         return log
 
     def keys_like(self, query):
@@ -518,7 +556,7 @@ class DataLog(OrderedDict):
         return len(next(iter(self.values())))
 
     @staticmethod
-    def load(filename, progress=None, msg='Loading DataLog'):
+    def load(filename, progress=None, msg='Loading DataLog', mmap=False):
         """
         Loads a :class:`DataLog` from the binary format used by myokit.
 
@@ -531,10 +569,28 @@ class DataLog(OrderedDict):
         the :class:`myokit.ProgressReporter` interface can be passed in.
         passed in as ``progress``. An optional description of the current
         simulation to use in the ProgressReporter can be passed in as `msg`.
+
+        For files stored with ``save(filename, compressed=False)``, the
+        argument ``mmap=True`` can be used to return a log containing
+        read-only numpy memory maps instead of arrays. In this case no data is
+        read when the log is loaded, and only the parts of the file that are
+        accessed are read into memory. For compressed files, the ``mmap``
+        argument is ignored.
+
+        Files stored with :meth:`save_chunked` are also supported, and are
+        loaded with :meth:`load_chunked`.
         """
         # Check filename
         filename = os.path.expanduser(filename)
 
+        # Check for uncompressed or chunked format
+        with open(filename, 'rb') as f:
+            magic = f.read(len(BIN_MAGIC))
+        if magic == BIN_MAGIC:
+            return DataLog._load_uncompressed(filename, progress, msg, mmap)
+        if magic == _chunked.MAGIC:
+            return DataLog.load_chunked(filename)
+
         # Load compression modules
         import zipfile
         try:
@@ -662,7 +718,170 @@ class DataLog(OrderedDict):
         return log
 
     @staticmethod
-    def load_csv(filename, precision=myokit.DOUBLE_PRECISION):
+    def load_chunked(filename, keys=None, a=None, b=None, threads=None):
+        """
+        Loads a :class:`DataLog` stored with :meth:`save_chunked`.
+
+        Only the chunks needed to return the requested data are read from
+        disk, so that parts of very large logs can be loaded quickly.
+
+        Arguments:
+
+        ``filename``
+            The file to load.
+        ``keys``
+            An optional list of keys to load. If not given, all keys are
+            loaded. If the log has a time key, it is always loaded.
+        ``a``
+            An optional time to start loading from. Only points with
+            ``time >= a`` will be loaded. Requires a time key to be set.
+        ``b``
+            An optional time to stop loading at. Only points with
+            ``time < b`` will be loaded. Requires a time key to be set.
+        ``threads``
+            The number of threads to decompress chunks with, or ``None`` to
+            use one thread per CPU.
+
+        The returned log contains numpy arrays.
+        """
+        filename = os.path.expanduser(filename)
+        reader = _chunked.Reader(filename, myokit.DataLogReadError)
+        info = reader.info
+        if not isinstance(info, dict) or info.get('kind') != 'DataLog':
+            raise myokit.DataLogReadError(
+                'Chunked file does not contain a DataLog.')
+        time = info.get('time', None)
+        names = reader.names()
+
+        # Select keys
+        if keys is not None:
+            keys = [str(k) for k in keys]
+            if time in names and time not in keys:
+                keys.insert(0, time)
+            for k in keys:
+                if k not in names:
+                    raise KeyError('Key not found in log: ' + k)
+            keys = [k for k in names if k in keys]
+
+        # Select time range
+        i, j = 0, reader.length
+        if a is not None or b is not None:
+            if time not in names:
+                raise ValueError(
+                    'A time key is required to load a time interval.')
+            t = reader.read([time], threads=threads)[time]
+            if a is not None:
+                i = int(np.searchsorted(t, a, side='left'))
+            if b is not None:
+                j = max(i, int(np.searchsorted(t, b, side='left')))
+
+        # Create log
+        log = DataLog()
+        log._time = time
+        for k, v in reader.read(keys, i, j, threads).items():
+            log[k] = v
+
+        # Add meta data
+        meta = info.get('meta', None)
+        if meta is not None:
+            # Only use column meta data for loaded keys, without modifying the
+            # reader's copy
+            meta = copy.deepcopy(meta)
+            meta['tableSchema']['columns'] = [
+                c for c in meta['tableSchema']['columns']
+                if c.get('titles') in log]
+            DataLog._load_meta_json(meta, log)
+        return log
+
+    @staticmethod
+    def _load_uncompressed(filename, progress, msg, mmap):
+        """
+        Loads a :class:`DataLog` stored in the uncompressed binary format.
+        """
+        # Read and check header
+        nfile = os.path.getsize(filename)
+        with open(filename, 'rb') as f:
+            f.seek(len(BIN_MAGIC))
+            x = f.read(8)
+            if len(x) < 8:
+                raise myokit.DataLogReadError('Invalid log file format.')
+            version = int.from_bytes(x[:4], 'little')
+            if version != BIN_VERSION:
+                raise myokit.DataLogReadError(
+                    'Unsupported log file version: ' + str(version) + '.')
+            nhead = int.from_bytes(x[4:], 'little')
+            try:
+                head = json.loads(f.read(nhead).decode(ENC))
+                n = int(head['length'])
+                data_type = str(head['dtype'])
+                time = head['time']
+                fields = [(str(k), int(i)) for k, i in head['columns']]
+                meta = head['meta']
+            except (ValueError, KeyError, TypeError):
+                raise myokit.DataLogReadError('Invalid log file header.')
+
+        # Get data type and size
+        if n < 0:
+            raise myokit.DataLogReadError(
+                'Invalid data size: ' + str(n) + '.')
+        try:
+            dtype = np.dtype({'d': '<f8', 'f': '<f4'}[data_type])
+        except KeyError:
+            raise myokit.DataLogReadError(
+                'Invalid data type: "' + data_type + '".')
+        size = n * dtype.itemsize
+
+        # Start of data section
+        start = len(BIN_MAGIC) + 8 + nhead
+        start += -start % BIN_ALIGN
+        for key, offset in fields:
+            if offset < 0 or start + offset + size > nfile:
+                raise myokit.DataLogReadError(
+                    'Header indicates larger data size than found in body.')
+
+        # Create log with empty fields, then read meta data
+        log = DataLog()
+        if time:
+            log._time = time
+        for key, offset in fields:
+            log[key] = tuple()
+        if meta is not None:
+            DataLog._load_meta_json(meta, log)
+
+        # Create memory map
+        if mmap:
+            if size > 0:
+                mm = np.memmap(filename, dtype=np.uint8, mode='r')
+            for key, offset in fields:
+                if size > 0:
+                    a = start + offset
+                    log[key] = mm[a:a + size].view(dtype)
+                else:
+                    log[key] = np.array([], dtype=dtype)
+            return log
+
+        # Read data
+        fraction = 1 / max(1, len(fields))
+        try:
+            if progress:
+                progress.enter(msg)
+            with open(filename, 'rb') as f:
+                for k, (key, offset) in enumerate(fields):
+                    if progress and not progress.update(k * fraction):
+                        return
+                    f.seek(start + offset)
+                    ar = array.array(data_type)
+                    ar.frombytes(f.read(size))
+                    if sys.byteorder == 'big':  # pragma: no cover
+                        ar.byteswap()
+                    log[key] = ar
+        finally:
+            if progress:
+                progress.exit()
+        return log
+
+    @staticmethod
+    def load_csv(filename, precision=myokit.DOUBLE_PRECISION, threads=None):
         """
         Loads a CSV file from disk and returns it as a :class:`DataLog`.
 
@@ -677,7 +896,14 @@ class DataLog(OrderedDict):
         increasing variable. In the case of a tie the first strictly increasing
         variable is used. This means logs stored with :meth:`save_csv` can
         safely be read.
+
+        The file is read in blocks, which are parsed in parallel by a compiled
+        module using ``threads`` threads (or one thread per CPU if ``threads``
+        is ``None``). If the module can't be compiled, a slower Python parser
+        is used instead.
         """
+        from myokit._sim import csvio
+
         log = DataLog()
         # Check filename
         filename = os.path.expanduser(filename)
@@ -691,141 +917,91 @@ class DataLog(OrderedDict):
                 'Syntax error on line ' + str(line) + ', character '
                 + str(1 + char) + ': ' + msg)
 
-        quote = '"'
-        delim = ','
-        with open(filename, 'r', newline=None) as f:
-            # Read header
-            keys = []   # The log keys, in order of appearance
-
-            # Read first line
-            line = f.readline()
+        # Parse with native module, or fall back to Python
+        parse = csvio.NativeCSV.parse
+        if csvio.NativeCSV._get_instance() is None:  # pragma: no cover
+            parse = csvio.parse_rows
 
-            # Ignore comments
-            while line.lstrip()[:1] == '#':
-                line = f.readline()
+        with open(filename, 'rb') as f:
+            # Read lines, with universal newlines, until the header is found
+            buf = b''
+            pos = 0
+            eof = False
+            while True:
+                i = _find_eol(buf, pos)
+                while (i < 0 or i == len(buf) - 1) and not eof:
+                    block = f.read(CSV_BLOCK_SIZE)
+                    eof = not block
+                    buf = buf[pos:] + block
+                    pos = 0
+                    i = _find_eol(buf, pos)
+                if i < 0:
+                    line = buf[pos:]
+                    pos = len(buf)
+                else:
+                    line = buf[pos:i]
+                    pos = i + (2 if buf[i:i + 2] == b'\r\n' else 1)
+                line = line.decode(ENC)
 
-            # Stop on EOF (indicated by blank line without line ending)
-            if line == '':
-                return log
+                # Ignore comments
+                if line.lstrip()[:1] != '#':
+                    break
 
-            # Trim end of line
-            line = line.rstrip(' \r\n\f;')
+                # Stop on EOF
+                if pos >= len(buf) and eof:
+                    return log
 
-            # Get enumerated iterator over characters
-            line = enumerate(line)
-            try:
-                i, c = next(line)
-            except StopIteration:
-                # Empty line
+            # Read header
+            keys = _parse_csv_header(line.rstrip(' \r\n\f;'), e)
+            if not keys:
                 return log
 
-            # Whitespace characters to ignore
-            whitespace = ' \f\t'
-
-            # Start parsing header fields
-            run1 = True
-            while run1:
-                text = []
-
-                # Skip whitespace
-                # (Note: rtrim above and check below mean this will never
-                #  raise a StopIteration)
-                while c in whitespace:
-                    i, c = next(line)
-
-                # Read!
-                if c == quote:
-
-                    # Read quoted field + delimiter
-                    run2 = True
-                    while run2:
-                        try:
-                            i, c = next(line)
-                        except StopIteration:
-                            e(1, i, 'Unexpected end-of-line inside quoted'
-                                ' string.')
-
-                        if c == quote:
-                            try:
-                                i, c = next(line)
-                                if c == quote:
-                                    text.append(quote)
-                                elif c == delim or c in whitespace:
-                                    run2 = False
-                                else:
-                                    e(1, i, 'Expecting double quote, delimiter'
-                                        ' or end-of-line. Found "' + c + '".')
-                            except StopIteration:
-                                run1 = run2 = False
-                        else:
-                            text.append(c)
-                else:
-
-                    # Read unquoted field + delimiter
-                    while run1 and c != delim:
-                        try:
-                            text.append(c)
-                            i, c = next(line)
-                        except StopIteration:
-                            run1 = False
-
-                # Append new field to list
-                key = ''.join(text)
-                if key == '':
-                    e(1, i, 'Empty field in header.')
-                keys.append(key)
-
-                # Read next character
-                try:
-                    i, c = next(line)
-                except StopIteration:
-                    run1 = False
-
-            if c == delim:
-                e(1, i, 'Empty field in header.')
-
             # Create data structure
             m = len(keys)
-            lists = []
+            columns = []
             for key in keys:
                 x = array.array(typecode)
-                lists.append(x)
+                columns.append(x)
                 log[key] = x
 
-            # Read remaining data
+            # Parse remaining data in blocks of complete lines, keeping a
+            # limited number of blocks in memory
             n = 0
-            while True:
-                row = f.readline()
-
-                # Stop if a blank line is returned: indicates EOF!
-                # (Empty line in file still has line ending)
-                if row == '':
-                    break
-
-                # Strip leading and/or trailing whitespace
-                row = row.lstrip().rstrip(' \r\n\f;')
-
-                # Skip blank lines
-                if row == '':
-                    continue
-
-                # Ignore lines commented with #
-                if row[:1] == '#':
-                    continue
-
-                # Split row into cells
-                row = row.split(delim)
-                n += 1
-                if len(row) != m:
-                    e(
-                        n, 0, 'Wrong number of columns found in row '
-                        + str(n) + '. Expecting ' + str(m) + ', found '
-                        + str(len(row)) + '.')
-                try:
-                    for k, v in enumerate(row):
-                        lists[k].append(float(v))
-                except ValueError:
-                    e(n, 0, 'Unable to convert found data to floats.')
+            nthreads = myokit.tools.thread_count(threads)
+
+            def store(future):
+                nonlocal n
+                values, error, found = future.result()
+                for x, v in zip(columns, values):
+                    x.frombytes(np.asarray(v, dtype=typecode).tobytes())
+                n += len(values[0])
+                if error == csvio.CSV_WRONG_COLUMNS:
+                    e(n + 1, 0, 'Wrong number of columns found in row '
+                      + str(n + 1) + '. Expecting ' + str(m) + ', found '
+                      + str(found) + '.')
+                elif error == csvio.CSV_NOT_A_FLOAT:
+                    e(n + 1, 0, 'Unable to convert found data to floats.')
+
+            rest = buf[pos:]
+            with concurrent.futures.ThreadPoolExecutor(nthreads) as pool:
+                pending = collections.deque()
+                while True:
+                    block = b'' if eof else f.read(CSV_BLOCK_SIZE)
+                    eof = not block
+                    data = rest + block
+                    if eof:
+                        rest = b''
+                    else:
+                        i = 1 + max(data.rfind(b'\n'), data.rfind(b'\r'))
+                        data, rest = data[:i], data[i:]
+                    if data:
+                        pending.append(pool.submit(parse, data, m))
+                        if len(pending) >= 2 * nthreads:
+                            store(pending.popleft())
+                    if eof:
+                        break
+                while pending:
+                    store(pending.popleft())
 
             # Guess time variable
             for key in keys:
@@ -1009,7 +1185,8 @@ class DataLog(OrderedDict):
                 out[key] = s(rtime)
         return out
 
-    def save(self, filename, precision=myokit.DOUBLE_PRECISION):
+    def save(self, filename, precision=myokit.DOUBLE_PRECISION,
+             compressed=True):
         """
         Writes this ``DataLog`` to a binary file.
 
@@ -1024,12 +1201,29 @@ class DataLog(OrderedDict):
 
         The optional argument ``precision`` allows logs to be stored in single
         precision format, which saves space.
+
+        If ``compressed=False`` is set, the log is instead stored in an
+        uncompressed binary format, which can be loaded very quickly, or
+        memory-mapped using ``DataLog.load(filename, mmap=True)``. Files in
+        this format start with the bytes ``MYOKIT-DATALOG\\x00\\x00``,
+        followed by a 4-byte format version number and the 4-byte size of a
+        header, both stored as little-endian unsigned integers. The header is
+        a UTF-8 encoded JSON object with the array length, the data type
+        (``"d"`` or ``"f"``), the time key, the meta data, and a list of
+        ``[key, offset]`` pairs for every column. The data section starts at
+        the first multiple of 64 bytes after the header, and each column
+        starts at its offset (also a multiple of 64 bytes) from the start of
+        the data section. All data is stored little-endian.
         """
         self.validate()
 
         # Check filename
         filename = os.path.expanduser(filename)
 
+        # Store in uncompressed format
+        if not compressed:
+            return self._save_uncompressed(filename, precision)
+
         # Load compression modules
         import zipfile
         try:
@@ -1086,9 +1280,96 @@ class DataLog(OrderedDict):
             if meta_json is not None:
                 f.writestr(meta, json.dumps(meta_json, indent=2).encode(enc))
 
+    def _save_uncompressed(self, filename, precision):
+        """
+        Writes this ``DataLog`` to a file in the uncompressed binary format.
+        """
+        # Data type
+        dtype = 'd' if precision == myokit.DOUBLE_PRECISION else 'f'
+        npdtype = np.dtype('<f8' if dtype == 'd' else '<f4')
+
+        # Determine column offsets, relative to the start of the data section
+        n = self.length()
+        size = n * npdtype.itemsize
+        stride = size + (-size % BIN_ALIGN)
+        columns = [[k, i * stride] for i, k in enumerate(self.keys())]
+
+        # Create header
+        head = {
+            'length': n,
+            'dtype': dtype,
+            'time': self._time if self._time else None,
+            'columns': columns,
+            'meta': self._save_meta_json(filename),
+        }
+        head = json.dumps(head).encode(ENC)
+        start = len(BIN_MAGIC) + 8 + len(head)
+
+        # Write
+        with open(filename, 'wb') as f:
+            f.write(BIN_MAGIC)
+            f.write(BIN_VERSION.to_bytes(4, 'little'))
+            f.write(len(head).to_bytes(4, 'little'))
+            f.write(head)
+            f.write(bytes(-start % BIN_ALIGN))
+            padding = bytes(stride - size)
+            for v in self.values():
+                # Write directly from the array's buffer, without a copy if
+                # the data already has the right type
+                f.write(np.ascontiguousarray(v, dtype=npdtype))
+                f.write(padding)
+
+    def save_chunked(self, filename, precision=myokit.DOUBLE_PRECISION,
+                     chunk_size=None, codec='zlib', transform='shuffle',
+                     threads=None):
+        """
+        Writes this ``DataLog`` to a chunked, compressed, columnar file.
+
+        Each column is split into chunks of ``chunk_size`` points, which are
+        compressed independently and in parallel. An index at the end of the
+        file allows :meth:`load_chunked` to read any subset of keys and any
+        time interval without decompressing the whole file.
+
+        Arguments:
+
+        ``filename``
+            The file to write to.
+        ``precision``
+            Set to ``myokit.SINGLE_PRECISION`` to store data in single
+            precision.
+        ``chunk_size``
+            The number of points in each chunk, or ``None`` to use chunks of
+            about 1MiB of uncompressed data.
+        ``codec``
+            The compression codec, one of ``'zlib'`` (default), ``'lzma'``,
+            ``'bz2'``, or ``'none'``.
+        ``transform``
+            A transform to apply to each chunk before compression, which can
+            make floating point data easier to compress. Options are
+            ``'shuffle'`` (the default) to group the first bytes of every
+            value, then the second bytes, etc.; ``'xor'`` to replace every
+            value (except the first in each chunk) by its bitwise XOR with the
+            previous value before shuffling; or ``'none'``.
+        ``threads``
+            The number of threads to compress chunks with, or ``None`` to use
+            one thread per CPU.
+
+        """
+        self.validate()
+        filename = os.path.expanduser(filename)
+        info = {
+            'kind': 'DataLog',
+            'time': self._time if self._time else None,
+            'meta': self._save_meta_json(filename),
+        }
+        dtype = 'd' if precision == myokit.DOUBLE_PRECISION else 'f'
+        _chunked.write(
+            filename, list(self.items()), self.length(), info, dtype,
+            chunk_size, codec, transform, threads)
+
     def save_csv(
             self, filename, precision=myokit.DOUBLE_PRECISION, order=None,
-            delimiter=',', header=True, meta=False):
+            delimiter=',', header=True, meta=False, threads=None):
         """
         Writes this ``DataLog`` to a CSV file, following the syntax
         outlined in RFC 4180, and with a header indicating the field names.
@@ -1129,6 +1410,10 @@ class DataLog(OrderedDict):
         ``meta``
             Set this to ``True`` to store any meta data in a csv-on-the-web
             JSON file named ``filename + '-metadata.json'``.
+        ``threads``
+            The number of threads to format the data with, or ``None`` to use
+            one thread per CPU. Data is formatted and written in blocks, by a
+            compiled module if available.
 
         *A note about locale settings*: On Windows systems with a locale
         setting that uses the comma as a decimal separator, importing CSV files
@@ -1137,6 +1422,8 @@ class DataLog(OrderedDict):
         separator or (2) Use the import wizard under Data > Get External Data
         to manually specify the correct separator and delimiter.
         """
+        from myokit._sim import csvio
+
         self.validate()
 
         # Check filename
@@ -1145,10 +1432,13 @@ class DataLog(OrderedDict):
         # Set precision
         if precision is None:
             fmat = lambda x: str(x)
+            mode = csvio.CSV_REPR
         elif precision == myokit.DOUBLE_PRECISION:
             fmat = lambda x: myokit.SFDOUBLE.format(x)
+            mode = csvio.CSV_DOUBLE
         elif precision == myokit.SINGLE_PRECISION:
             fmat = lambda x: myokit.SFSINGLE.format(x)
+            mode = csvio.CSV_SINGLE
         else:
             raise ValueError('Precision level not supported.')
 
@@ -1196,13 +1486,33 @@ class DataLog(OrderedDict):
                     line.append(quote + key.replace(quote, escape) + quote)
                 f.write((delimiter.join(line) + eol).encode('ascii'))
 
-            # Write data
-            data = [iter(x) for x in data]
-            for i in range(0, n):
-                line = []
-                for d in data:
-                    line.append(fmat(next(d)))
-                f.write((delimiter.join(line) + eol).encode('ascii'))
+            # Write data in blocks of rows, which are formatted in parallel by
+            # the native module. Python's formatting is used if the module is
+            # not available, or if str() is used on data that isn't stored as
+            # doubles (e.g. integers, which str() formats without a point).
+            native = csvio.NativeCSV._get_instance() is not None
+            if mode == csvio.CSV_REPR:
+                native = native and all(
+                    np.asarray(x).dtype == np.float64 for x in data)
+            if native:
+                data = [np.ascontiguousarray(x, dtype=float) for x in data]
+                args = (mode, delimiter.encode('ascii'), eol.encode('ascii'))
+                fmt = lambda a, b: csvio.NativeCSV.format(data, a, b, *args)
+            else:
+                data = [list(x) for x in data]
+                fmt = lambda a, b: _format_csv_rows(
+                    data, a, b, fmat, delimiter, eol)
+
+            rows = max(1, CSV_BLOCK_SIZE // (32 * max(1, len(data))))
+            nthreads = myokit.tools.thread_count(threads)
+            with concurrent.futures.ThreadPoolExecutor(nthreads) as pool:
+                pending = collections.deque()
+                for a in range(0, n, rows):
+                    pending.append(pool.submit(fmt, a, min(n, a + rows)))
+                    if len(pending) >= 2 * nthreads:
+                        f.write(pending.popleft().result())
+                while pending:
+                    f.write(pending.popleft().result())
 
         # Write meta data file
         if meta:
@@ -1242,6 +1552,45 @@ class DataLog(OrderedDict):
 
         return meta
 
+    def _periodic_segments(self, period, closed_intervals):
+        """
+        Returns a list of tuples ``(imin, imax)`` with the start and end
+        (exclusive) index of every period, as used by :meth:`split_periodic`.
+        """
+        # Validate log before starting
+        self.validate()
+
+        # Check time variable
+        time = np.asarray(self.time(), dtype=float)
+        if len(time) < 1:
+            raise RuntimeError('DataLog entries have zero length.')
+
+        # Check period
+        period = float(period)
+        if period <= 0:
+            raise ValueError('Period must be greater than zero')
+
+        # Get start, end, etc
+        tmin = 0    # time[0]
+        tmax = time[-1]
+        nlogs = int(np.ceil((tmax - tmin) / period))
+        if nlogs < 2:
+            return [(0, len(time))]
+
+        # Find split points
+        tstarts = tmin + np.arange(nlogs + 1) * period
+        istarts = np.searchsorted(time, tstarts[:-1], side='left')
+        imaxs = np.append(istarts[1:], len(time))
+
+        # Include right endpoints if needed
+        if closed_intervals:
+            imaxs[:-1] += time[istarts[1:]] == tstarts[1:-1]
+        elif time[-1] >= tstarts[-1]:
+            # Not including right endpoints? Then may need to omit last point
+            imaxs[-1] -= 1
+
+        return [(int(a), int(b)) for a, b in zip(istarts, imaxs)]
+
     def set_time_key(self, key):
         """
         Sets the key under which the time data is stored.
@@ -1285,89 +1634,39 @@ class DataLog(OrderedDict):
         return half-closed endpoints (containing only the left point), set
         ``closed_intervals`` to ``False``.
         """
-        # Validate log before starting
-        self.validate()
-
-        # Check time variable
-        time = self.time()
-        if len(time) < 1:
-            raise RuntimeError('DataLog entries have zero length.')
-
-        # Check period
-        period = float(period)
-        if period <= 0:
-            raise ValueError('Period must be greater than zero')
-
-        # Get start, end, etc
-        tmin = 0    # time[0]
-        tmax = time[len(time) - 1]
-        nlogs = int(np.ceil((tmax - tmin) / period))
+        # Get start and end index of each period
+        segments = self._periodic_segments(period, closed_intervals)
 
         # No splitting needed? Return clone!
-        if nlogs < 2:
+        if len(segments) < 2:
             return [self.clone()]
 
-        # Find split points
-        tstarts = tmin + np.arange(nlogs) * period
-        istarts = [0] * nlogs
-        k = 0
-        for i, t in enumerate(time):
-            while k < nlogs and t >= tstarts[k]:
-                istarts[k] = i
-                k += 1
-
-        # Create logs
+        # Convert columns to numpy once, then copy out each period
+        columns = []
+        for k, v in self.items():
+            if isinstance(v, (np.ndarray, DataColumn)):
+                v = np.asarray(v, dtype=float)
+            columns.append((k, v))
         logs = []
-        for i in range(0, nlogs - 1):
+        for imin, imax in segments:
             log = DataLog()
             log._time = self._time
-
-            # Get indices
-            imin = istarts[i]
-            imax = istarts[i + 1]
-
-            # Include right point endpoint if needed
-            if closed_intervals and time[imax] == tstarts[i + 1]:
-                imax += 1
-
-            # Select sections of log and append
-            for k, v in self.items():
-                d = self[k][imin:imax]
+            for k, v in columns:
+                d = v[imin:imax]
                 # NumPy? Then copy data
                 if isinstance(d, np.ndarray):
-                    d = np.array(d, copy=True, dtype=float)
+                    d = np.array(d, copy=True)
                 log[k] = d
             logs.append(log)
 
-        # Last log
-        log = DataLog()
-        log._time = self._time
-        imin = istarts[-1]
-        imax = len(time)
-
-        # Not including right endpoints? Then may be required to omit last pt
-        if not closed_intervals and time[-1] >= tmin + nlogs * period:
-            imax -= 1
-
-        # Select sections of log and append
-        for k, v in self.items():
-            d = self[k][imin:imax]
-            # NumPy? Then copy data
-            if isinstance(d, np.ndarray):
-                d = np.array(d, copy=True, dtype=float)
-            log[k] = d
-        logs.append(log)
-
         # Adjust
         if adjust:
-            if isinstance(time, np.ndarray):
-                # Fast method for numpy arrays
-                for k, log in enumerate(logs):
-                    log[self._time] -= k * period
-            else:
-                for k, log in enumerate(logs):
-                    tlist = log[self._time]
-                    tdiff = k * period
+            for k, log in enumerate(logs):
+                tdiff = k * period
+                tlist = log[self._time]
+                if isinstance(tlist, np.ndarray):
+                    tlist -= tdiff
+                else:
                     for i in range(len(tlist)):
                         tlist[i] -= tdiff
 
@@ -1410,8 +1709,10 @@ class DataLog(OrderedDict):
         self.validate()
         log = self.itrim(self.find_after(a), self.find_after(b))
         if adjust and self._time in log:
-            if isinstance(log[self._time], np.ndarray):
-                log[self._time] -= a
+            if isinstance(log[self._time], DataColumn):
+                np.asarray(log[self._time])[:] -= a
+            elif isinstance(log[self._time], np.ndarray):
+                log[self._time] = log[self._time] - a
             else:
                 log[self._time] = [x - a for x in log[self._time]]
         return log
@@ -1427,8 +1728,10 @@ class DataLog(OrderedDict):
         self.validate()
         log = self.itrim_left(self.find_after(value))
         if adjust and self._time in log:
-            if isinstance(log[self._time], np.ndarray):
-                log[self._time] -= value
+            if isinstance(log[self._time], DataColumn):
+                np.asarray(log[self._time])[:] -= value
+            elif isinstance(log[self._time], np.ndarray):
+                log[self._time] = log[self._time] - value
             else:
                 log[self._time] = [x - value for x in log[self._time]]
         return log
@@ -1567,6 +1870,135 @@ class DataLog(OrderedDict):
         return infos
 
 
+class DataColumn:
+    """
+    A typed, contiguous column of floating point numbers, used by simulations
+    to store logged data in a :class:`DataLog`.
+
+    Values are stored in a numpy buffer that grows geometrically, so that
+    appending a value takes amortised constant time. New values are first
+    collected in a small ``array.array`` and only copied into the buffer when
+    the column is read, so that simulations can log with a single call to a
+    built-in ``append`` method.
+
+    Reading a column does not copy its data: ``np.asarray(column)`` and slices
+    such as ``column[a:b]`` return numpy views of the buffer. Unlike views of
+    an ``array.array``, these do not prevent further values from being
+    appended: if the buffer needs to grow, the existing views keep pointing
+    at the old (still valid) data.
+
+    Indexing with an integer, iterating, comparing with ``==``, and methods
+    such as ``append``, ``extend`` and ``tolist`` work as they do for lists
+    and arrays.
+
+    Arguments:
+
+    ``typecode``
+        The data type, either ``'d'`` (double precision, the default) or
+        ``'f'`` (single precision).
+    ``values``
+        An optional sequence of initial values.
+
+    """
+    def __init__(self, typecode='d', values=None):
+        if typecode not in ('d', 'f'):
+            raise ValueError('Typecode must be "d" or "f".')
+        self.typecode = typecode
+        self._dtype = np.dtype(typecode)
+        self._data = np.empty(0, dtype=self._dtype)
+        self._n = 0
+
+        # Values are appended to a "tail" array, so that append is a built-in
+        # method and simulations can log without calling any Python code.
+        self._tail = array.array(typecode)
+        self.append = self._tail.append
+
+        if values is not None:
+            self.extend(values)
+
+    def __array__(self, dtype=None, copy=None):
+        x = self._view()
+        if dtype is not None:
+            x = x.astype(dtype, copy=False)
+        return x.copy() if copy else x
+
+    def clear(self):
+        """
+        Removes all values from this column. Existing views are not affected.
+        """
+        del self._tail[:]
+        self._data = np.empty(0, dtype=self._dtype)
+        self._n = 0
+
+    def copy(self):
+        """ Returns a copy of this column. """
+        return DataColumn(self.typecode, self._view())
+
+    def __eq__(self, other):
+        if not isinstance(
+                other, (DataColumn, array.array, list, tuple, np.ndarray)):
+            return NotImplemented
+        return len(self) == len(other) and bool(
+            np.all(self._view() == np.asarray(other)))
+
+    __hash__ = None
+
+    def extend(self, values):
+        """ Appends all values in the given sequence to this column. """
+        if not hasattr(values, '__len__'):
+            values = list(values)
+        values = np.asarray(values, dtype=self._dtype).reshape(-1)
+        n = len(self._view())
+        self._reserve(n + len(values))
+        self._data[n:n + len(values)] = values
+        self._n += len(values)
+
+    def __getitem__(self, key):
+        x = self._view()[key]
+        return float(x) if np.ndim(x) == 0 else x
+
+    def __iter__(self):
+        return iter(self.tolist())
+
+    def __len__(self):
+        return self._n + len(self._tail)
+
+    def __reduce__(self):
+        return (DataColumn, (self.typecode, np.array(self._view())))
+
+    def __repr__(self):
+        return 'DataColumn(' + repr(self.typecode) + ', ' + repr(
+            self.tolist()) + ')'
+
+    def _reserve(self, size):
+        """ Ensures the buffer can hold at least ``size`` values. """
+        if size > len(self._data):
+            data = np.empty(max(size, 2 * len(self._data), 16), self._dtype)
+            data[:self._n] = self._data[:self._n]
+            self._data = data
+
+    def __setitem__(self, key, value):
+        self._view()[key] = value
+
+    def tolist(self):
+        """ Returns a list containing this column's values. """
+        return self._view().tolist()
+
+    def _view(self):
+        """
+        Moves any values from the tail into the buffer, and returns a view of
+        the buffer's used part.
+        """
+        m = len(self._tail)
+        if m:
+            self._reserve(self._n + m)
+            self._data[self._n:self._n + m] = np.frombuffer(
+                self._tail, dtype=self._dtype)
+            self._n += m
+            del self._tail[:]
+        return self._data[:self._n]
+
+
 class LoggedVariableInfo:
     """
     Contains information about the log entries for each variable. These objects
@@ -1899,7 +2331,7 @@ def prepare_log(
                 name = s.qname()
                 for c in dcombos:
                     key = c + name
-                    log[key] = array.array(typecode)
+                    log[key] = DataColumn(typecode)
                     add_meta(log, key, s)
             flag -= myokit.LOG_STATE
 
@@ -1913,12 +2345,12 @@ def prepare_log(
             for label, var in model.bindings():
                 name = var.qname()
                 if name in global_vars:
-                    log[name] = array.array(typecode)
+                    log[name] = DataColumn(typecode)
                     add_meta(log, name, var)
                 else:
                     for c in dcombos:
                         key = c + name
-                        log[key] = array.array(typecode)
+                        log[key] = DataColumn(typecode)
                         add_meta(log, key, var)
             flag -= myokit.LOG_BOUND
 
@@ -1933,12 +2365,12 @@ def prepare_log(
             for var in model.variables(inter=True, deep=True):
                 name = var.qname()
                 if name in global_vars:
-                    log[name] = array.array(typecode)
+                    log[name] = DataColumn(typecode)
                     add_meta(log, name, var)
                 else:
                     for c in dcombos:
                         key = c + name
-                        log[key] = array.array(typecode)
+                        log[key] = DataColumn(typecode)
                         add_meta(log, key, var)
             flag -= myokit.LOG_INTER
 
@@ -1953,7 +2385,7 @@ def prepare_log(
                 name = var.qname()
                 for c in dcombos:
                     key = f'dot({c}{name})'
-                    log[key] = array.array(typecode)
+                    log[key] = DataColumn(typecode)
                     add_meta(log, key, var, time_unit)
             flag -= myokit.LOG_DERIV
 
@@ -2124,19 +2556,19 @@ def prepare_log(
                 raise ValueError(f'Invalid index <{kdims}> in list.')
 
             key = kdims + kname if not deriv else f'dot({kdims}{kname})'
-            log[key] = array.array(typecode)
+            log[key] = DataColumn(typecode)
             add_meta(log, key, var, time_unit if deriv else None)
 
         else:
 
             if kname in global_vars:
                 key = kname if not deriv else f'dot({kname})'
-                log[key] = array.array(typecode)
+                log[key] = DataColumn(typecode)
                 add_meta(log, key, var, time_unit if deriv else None)
             else:
                 for c in dcombos:
                     key = c + kname if not deriv else f'dot({c}{kname})'
-                    log[key] = array.array(typecode)
+                    log[key] = DataColumn(typecode)
                     add_meta(log, key, var, time_unit if deriv else None)
 
     # Set time variable
@@ -2148,6 +2580,135 @@ def prepare_log(
     return log
 
 
+def _find_eol(data, pos):
+    """
+    Returns the index of the first ``\\r`` or ``\\n`` in the bytes ``data``,
+    starting from ``pos``, or ``-1`` if there are none.
+    """
+    i = data.find(b'\n', pos)
+    j = data.find(b'\r', pos, None if i < 0 else i)
+    return i if j < 0 else j
+
+
+def _format_csv_rows(columns, a, b, fmat, delimiter, eol):
+    """
+    Python version of :meth:`myokit._sim.csvio.NativeCSV.format`, used if the
+    native module is not available.
+    """
+    lines = []
+    for i in range(a, b):
+        lines.append(delimiter.join([fmat(x[i]) for x in columns]) + eol)
+    return ''.join(lines).encode('ascii')
+
+
+def _parse_csv_header(line, e):
+    """
+    Parses the header ``line`` of a CSV file and returns a list of keys.
+
+    Errors are raised by calling ``e(line, char, msg)``.
+    """
+    quote = '"'
+    delim = ','
+    keys = []   # The log keys, in order of appearance
+
+    # Get enumerated iterator over characters
+    line = enumerate(line)
+    try:
+        i, c = next(line)
+    except StopIteration:
+        # Empty line
+        return keys
+
+    # Whitespace characters to ignore
+    whitespace = ' \f\t'
+
+    # Start parsing header fields
+    run1 = True
+    while run1:
+        text = []
+
+        # Skip whitespace
+        # (Note: rtrim above and check below mean this will never
+        #  raise a StopIteration)
+        while c in whitespace:
+            i, c = next(line)
+
+        # Read!
+        if c == quote:
+
+            # Read quoted field + delimiter
+            run2 = True
+            while run2:
+                try:
+                    i, c = next(line)
+                except StopIteration:
+                    e(1, i, 'Unexpected end-of-line inside quoted'
+                        ' string.')
+
+                if c == quote:
+                    try:
+                        i, c = next(line)
+                        if c == quote:
+                            text.append(quote)
+                        elif c == delim or c in whitespace:
+                            run2 = False
+                        else:
+                            e(1, i, 'Expecting double quote, delimiter'
+                                ' or end-of-line. Found "' + c + '".')
+                    except StopIteration:
+                        run1 = run2 = False
+                else:
+                    text.append(c)
+        else:
+
+            # Read unquoted field + delimiter
+            while run1 and c != delim:
+                try:
+                    text.append(c)
+                    i, c = next(line)
+                except StopIteration:
+                    run1 = False
+
+        # Append new field to list
+        key = ''.join(text)
+        if key == '':
+            e(1, i, 'Empty field in header.')
+        keys.append(key)
+
+        # Read next character
+        try:
+            i, c = next(line)
+        except StopIteration:
+            run1 = False
+
+    if c == delim:
+        e(1, i, 'Empty field in header.')
+
+    return keys
+
+
+def _readonly(x):
+    """ Returns a read-only view of the numpy array ``x``. """
+    x = x.view()
+    x.flags.writeable = False
+    return x
+
+
+def _slice_column(x, key, view=False):
+    """
+    Returns the part ``x[key]`` of a log column ``x``, as a copy of the same
+    type, or as a read-only view if ``x`` is a :class:`DataColumn` and
+    ``view=True``.
+    """
+    if isinstance(x, DataColumn):
+        if view:
+            return _readonly(x[key])
+        return DataColumn(x.typecode, x[key])
+    elif isinstance(x, np.ndarray):
+        return np.array(x[key], copy=True, dtype=float)
+    return x[key]
+
+
 def _dimco(*dims):
     """
     Generates all the combinations of a certain set of integer dimensions. For
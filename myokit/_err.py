@@ -438,7 +438,8 @@ class UnusedVariableError(IntegrityError):
     *Extends:* :class:`myokit.IntegrityError`
     """
     def __init__(self, var):
-        msg = 'Unused variable: <' + var.qname() + '>.'
+        self._variable = var.qname()
+        msg = 'Unused variable: <' + self._variable + '>.'
         tok = var.lhs()._token
         super().__init__(msg, tok)
 
@@ -1128,10 +1128,10 @@ class Name(LhsExpression):
     def rhs(self):
         """See :meth:`LhsExpression.rhs()`."""
         if self._proper:
+            # Note: For any non-state variable, lhs() is a Name equal to self
             if self._value.is_state():
                 return self._value.initial_value()
-            elif self._value.lhs() == self:
-                return self._value.rhs()
+            return self._value.rhs()
         return None
 
     def _tree_str(self, b, n):
@@ -13,6 +13,8 @@ import sys
 
 import myokit
 
+from myokit import _model_cache
+
 
 def _examplify(filename):
     """
@@ -41,18 +43,47 @@ def load(filename):
         f.close()
 
 
-def load_model(filename):
+def load_model(filename, cache=False):
     """
     Loads the model section from an ``mmt`` file.
 
     Raises a :class:`SectionNotFoundError` if no model section is found.
+
+    Parsed models can be stored in a binary cache by setting ``cache=True``,
+    or by passing the path to a cache directory as ``cache``. Cache entries
+    are identified by a hash of the file contents, so that if a file has been
+    loaded before, parsing and validation can be skipped. Models loaded from
+    the cache contain no parse information (see
+    :meth:`myokit.Model.has_parse_info()`).
     """
     filename = _examplify(filename)
     with open(filename, 'r') as f:
-        section = myokit.split(f)[0]
-        if not section.strip():
-            raise myokit.SectionNotFoundError('Model section not found.')
-        return myokit.parse(section.splitlines())[0]
+        text = f.read()
+
+    # Try loading from cache
+    if cache:
+        path = _model_cache.cache_path(
+            text, None if cache is True else os.path.expanduser(cache))
+        model = _model_cache.load(path)
+        if model is not None:
+            return model
+
+    # Split off the model section. Without protocol or script headers, the
+    # whole file is the model section, and the extra pass can be skipped.
+    headers = ('[[protocol]]', '[[script]]')
+    if any(line.strip() in headers for line in text.split('\n')):
+        section = myokit.split(io.StringIO(text))[0]
+    else:
+        section = text
+    if not section.strip():
+        raise myokit.SectionNotFoundError('Model section not found.')
+
+    # Parse, and store in cache
+    with _model_cache.gc_paused():
+        model = myokit.parse(section.splitlines())[0]
+    if cache:
+        _model_cache.save(path, model)
+    return model
 
 
 def load_protocol(filename):
@@ -43,6 +43,41 @@ def check_name(name):
     return name
 
 
+def _clone_expression(e, lhs_map):
+    """
+    Clones an expression ``e`` for use in a cloned model, replacing references
+    using the dict ``lhs_map``.
+
+    Because expressions are immutable, any sub-expressions that don't contain
+    references are shared with the original, instead of copied.
+    """
+    if not e._references:
+        return e
+    if isinstance(e, myokit.LhsExpression):
+        try:
+            return lhs_map[e]
+        except KeyError:
+            if isinstance(e, myokit.Name):
+                return e.clone()
+    return type(e)(*[_clone_expression(x, lhs_map) for x in e._operands])
+
+
+def _copy_dependencies(deps):
+    """
+    Returns a copy of a cached dependency map ``{lhs: set(lhs)}``, that can be
+    modified without affecting the cache.
+    """
+    return {lhs: set(x) for lhs, x in deps.items()}
+
+
+def _copy_equations(order):
+    """
+    Returns a copy of a cached solvable order ``{name: EquationList}``, that
+    can be modified without affecting the cache.
+    """
+    return OrderedDict((k, EquationList(v)) for k, v in order.items())
+
+
 class MetaDataContainer(dict):
     """
     Dictionary that stores string meta-data.
@@ -575,10 +610,14 @@ class VarOwner(ModelPart, VarProvider):
             par = par.parent()
 
         # Scenario 3: One of this VarOwner's descendants already has that name.
-        for var in self.variables(deep=True):
-            if var.name() == name:
-                # Return False, unless the variable is whitelisted
-                return var in variable_whitelist
+        # Only owners with child variables are searched, using dict lookups.
+        owners = [self]
+        while owners:
+            owner = owners.pop()
+            var = owner._variables.get(name)
+            if var is not None and var not in variable_whitelist:
+                return False
+            owners.extend(v for v in owner._variables.values() if v._variables)
 
         # It's free!
         return True
@@ -853,6 +892,12 @@ class Model(ObjectWithMetaData, VarProvider):
         # Validation status: True, False or None (not tested)
         self._valid = None
 
+        # Cached results of dependency analysis, see _reset_cache()
+        self._cache = {}
+
+        # Cached function to evaluate the model equations, see _evaluator()
+        self._cached_evaluator = None
+
         # Name meta property
         if name:
             self.meta['name'] = str(name)
@@ -874,7 +919,7 @@ class Model(ObjectWithMetaData, VarProvider):
         try:
             self._components[name] = comp = Component(self, name)
         finally:
-            self._valid = None
+            self._reset_validation()
         return comp
 
     def add_component_allow_renaming(self, name):
@@ -1115,14 +1160,16 @@ class Model(ObjectWithMetaData, VarProvider):
             clone.get(v.qname()).promote()
 
         # Create mapping of old var references to new references
+        # Existing lhs objects are reused, as their hashes are already cached
         var_map = {}
         lhs_map = {}
         for v in self.variables(deep=True):
             var_map[v] = w = clone.get(v.qname())
-            lhs_map[myokit.Name(v)] = myokit.Name(w)
-        for v in self.states():
-            lhs_map[myokit.Derivative(myokit.Name(v))] = myokit.Derivative(
-                myokit.Name(clone.get(v.qname())))
+            if v._is_state:
+                lhs_map[v._lhs] = w._lhs
+                lhs_map[v._lhs._op] = w._lhs._op
+            else:
+                lhs_map[v._lhs] = w._lhs
 
         # Clone component/variable contents (equations, references)
         for k, c in self._components.items():
@@ -1136,7 +1183,21 @@ class Model(ObjectWithMetaData, VarProvider):
         # Copy initial state expressions
         for k, v in enumerate(self._state_vars):
             clone.get(v.qname()).set_initial_value(
-                self._state_init[k].clone(subst=lhs_map))
+                _clone_expression(self._state_init[k], lhs_map))
+
+        # Share cached dependency analysis
+        for key, value in self._cache.items():
+            if key[0] == 'solvable':
+                order = clone._cache[key] = OrderedDict()
+                for name, eqs in value.items():
+                    order[name] = eq_list = EquationList()
+                    for eq in eqs:
+                        lhs = lhs_map[eq.lhs]
+                        eq_list.append(Equation(lhs, lhs.var().rhs()))
+            else:
+                clone._cache[key] = {
+                    lhs_map[lhs]: set(lhs_map[x] for x in deps)
+                    for lhs, deps in value.items()}
 
         # Return
         return clone
@@ -1381,6 +1442,7 @@ class Model(ObjectWithMetaData, VarProvider):
         values = {}
 
         # Insert new state (if required)
+        new_state = None
         if state is not None:
             new_state = self.map_to_state(state)
             for state, value in zip(self._state_vars, new_state):
@@ -1397,6 +1459,22 @@ class Model(ObjectWithMetaData, VarProvider):
         # Get solvable order
         order = self.solvable_order()
 
+        # Evaluate using a compiled function, if possible. If this fails, all
+        # equations are evaluated again below, to obtain a detailed error
+        # message or NaNs for the variables that could not be evaluated.
+        if precision == myokit.DOUBLE_PRECISION:
+            f = self._evaluator()
+            if f is not None:
+                try:
+                    with numpy.errstate(all='raise'):
+                        if new_state is None:
+                            new_state = [
+                                x.eval(values) for x in self._state_init]
+                        return f([float(x) for x in new_state],
+                                 {} if inputs is None else inputs)
+                except Exception:
+                    pass
+
         # Evaluate all variables in solvable order
         if ignore_errors:
             for group in order.values():
@@ -1420,6 +1498,176 @@ class Model(ObjectWithMetaData, VarProvider):
         # Return calculated state
         return [values[state.lhs()] for state in self._state_vars]
 
+    def _evaluator(self):
+        """
+        Returns a function ``f(state, inputs)`` that evaluates the state
+        derivatives for a list of floats ``state`` and a dict ``inputs``, or
+        ``None`` if no such function can be created for this model.
+
+        The function performs the same operations as evaluating every equation
+        with :meth:`Expression.eval()` in solvable order, but uses a single
+        compiled code object for the whole model. It is created on first use,
+        and discarded whenever the model's cached dependency analysis is reset.
+        """
+        if self._cached_evaluator is None:
+            try:
+                self._cached_evaluator = self._create_evaluator()
+            except Exception:
+                # E.g. unsupported expressions, or expressions too deeply
+                # nested for the Python compiler
+                self._cached_evaluator = False
+        return self._cached_evaluator or None
+
+    def _create_evaluator(self):
+        """ Creates and returns the function used by :meth:`_evaluator()`. """
+        # Local names for states and equations
+        names = {}
+        for i, var in enumerate(self._state_vars):
+            names[myokit.Name(var)] = '_s' + str(i)
+        eqs = [eq for group in self.solvable_order().values() for eq in group]
+        for i, eq in enumerate(eqs):
+            names[eq.lhs] = '_e' + str(i)
+
+        # Use numpy functions, as in Expression.eval(). Values are converted to
+        # floats after every equation, as when passed in via ``subst``.
+        from myokit.formats.python import NumPyExpressionWriter
+        w = NumPyExpressionWriter()
+        w.set_lhs_function(lambda lhs: names[lhs])
+
+        # Create function
+        f = ['def evaluate(_state, _inputs):']
+        for i, var in enumerate(self._state_vars):
+            f.append('_s' + str(i) + ' = _state[' + str(i) + ']')
+        for eq in eqs:
+            rhs = 'float(' + w.ex(eq.rhs) + ')'
+            label = eq.lhs.var().binding()
+            if label is not None:
+                rhs = ('float(_inputs[' + repr(label) + ']) if '
+                       + repr(label) + ' in _inputs else ' + rhs)
+            f.append(names[eq.lhs] + ' = ' + rhs)
+        f.append('return [' + ', '.join(
+            names[var.lhs()] for var in self._state_vars) + ']')
+        f = f[:1] + ['    ' + x for x in f[1:]]
+
+        local = {}
+        exec('\n'.join(f), {
+            'numpy': numpy,
+            'abs': numpy.abs,
+            'inf': float('inf'),
+            'nan': float('nan'),
+        }, local)
+        return local['evaluate']
+
+    def pyfunc_rhs(self):
+        """
+        Returns a function that evaluates the state derivatives for arrays of
+        states and inputs at once, using numpy.
+
+        The returned function has the signature::
+
+            f(states, inputs=None) --> derivatives
+
+        where ``states`` is an array of shape ``(..., n_states)``, for example
+        ``(n_points, n_states)``, and ``inputs`` is an optional dictionary
+        mapping binding labels (e.g. ``time`` or ``pace``) to scalars or to
+        arrays that broadcast against ``states.shape[:-1]``. As in
+        :meth:`evaluate_derivatives()`, bound variables that are not set in
+        ``inputs`` are evaluated using their equations. The derivatives are
+        returned in an array with the broadcast shape of the states and
+        inputs, followed by an axis of length ``n_states``.
+
+        The function is generated from the model equations at the time this
+        method is called, and evaluates every variable once for all points.
+        Subexpressions that occur in more than one place are evaluated only
+        once. Invalid operations result in ``NaN`` values and numpy warnings,
+        instead of exceptions.
+        """
+        from myokit.formats.python import NumPyExpressionWriter
+
+        # Local names for variables, derivatives, and shared subexpressions
+        names = {}
+        for i, var in enumerate(self.variables(deep=True)):
+            names[var] = '_v' + str(i)
+
+        def name(lhs):
+            var = lhs.var()
+            if isinstance(var, str):
+                return var
+            return ('_d' if lhs.is_derivative() else '') + names[var]
+
+        w = NumPyExpressionWriter()
+        w.set_lhs_function(name)
+
+        # Count occurrences of non-trivial subexpressions. Subexpressions of an
+        # expression that has been seen before are not counted again.
+        eqs = [eq for group in self.solvable_order().values() for eq in group]
+        counts = {}
+
+        def count(e):
+            if isinstance(e, (myokit.LhsExpression, myokit.Number)):
+                return
+            n = counts[e] = counts.get(e, 0) + 1
+            if n == 1:
+                for x in e:
+                    count(x)
+
+        for eq in eqs:
+            count(eq.rhs)
+
+        # Assign shared subexpressions to local variables, innermost first,
+        # just before the first equation that uses them
+        shared = {}
+        f = []
+
+        def share(e):
+            if isinstance(e, (myokit.LhsExpression, myokit.Number)):
+                return
+            if e in shared or e.is_literal():
+                return
+            for x in e:
+                share(x)
+            if counts.get(e, 0) > 1:
+                temp = '_c' + str(len(shared))
+                f.append(temp + ' = ' + w.ex(e.clone(subst=shared)))
+                shared[e] = myokit.Name(temp)
+
+        # Create function
+        n = len(self._state_vars)
+        labels = [label for label, var in self.bindings()]
+        f.append('def rhs(_states, _inputs=None):')
+        f.append('_states = numpy.asarray(_states, dtype=float)')
+        f.append('if _states.shape[-1:] != (' + str(n) + ', ):')
+        f.append('    raise ValueError(')
+        f.append("        'The last axis of the states array must have length "
+                 + str(n) + ".')")
+        f.append('_inputs = {} if _inputs is None else _inputs')
+        for i, var in enumerate(self._state_vars):
+            f.append(names[var] + ' = _states[..., ' + str(i) + ']')
+        for eq in eqs:
+            label = eq.lhs.var().binding()
+            if label is not None:
+                f.append('if ' + repr(label) + ' in _inputs:')
+                f.append('    ' + name(eq.lhs) + ' = numpy.asarray(_inputs['
+                         + repr(label) + '], dtype=float)')
+                f.append('else:')
+                f.append('    ' + name(eq.lhs) + ' = ' + w.ex(eq.rhs))
+            else:
+                share(eq.rhs)
+                f.append(name(eq.lhs) + ' = ' + w.ex(eq.rhs.clone(
+                    subst=shared)))
+        f.append('_shape = numpy.broadcast_shapes(_states.shape[:-1], *['
+                 'numpy.shape(_inputs[x]) for x in ' + repr(labels)
+                 + ' if x in _inputs])')
+        f.append('_out = numpy.empty(_shape + (' + str(n) + ', ))')
+        for i, var in enumerate(self._state_vars):
+            f.append('_out[..., ' + str(i) + '] = ' + name(var.lhs()))
+        f.append('return _out')
+        f = f[:1] + ['    ' + x for x in f[1:]]
+
+        local = {}
+        exec('\n'.join(f), {'numpy': numpy}, local)
+        return local['rhs']
+
     def eval_state_derivatives(
             self, state=None, inputs=None, precision=myokit.DOUBLE_PRECISION,
             ignore_errors=False):
@@ -2420,7 +2668,17 @@ class Model(ObjectWithMetaData, VarProvider):
         this will also filter out all dependencies on constants, since a
         constant's dependencies (an empty set) can be said to be included in
         all other sets.
+
+        Results are cached until the model is changed.
         """
+        # Return cached result, if available
+        key = ('deep', bool(collapse), bool(omit_states),
+               bool(filter_encompassed))
+        try:
+            return _copy_dependencies(self._cache[key])
+        except KeyError:
+            pass
+
         # Get map of shallow dependencies
         shallow = self.map_shallow_dependencies(omit_states=omit_states)
 
@@ -2513,8 +2771,9 @@ class Model(ObjectWithMetaData, VarProvider):
                 for y in tofilter:
                     xdeps.remove(y)
 
-        # Return
-        return deep
+        # Cache and return
+        self._cache[key] = deep
+        return _copy_dependencies(deep)
 
     def map_shallow_dependencies(
             self, collapse=False, omit_states=True, omit_constants=False):
@@ -2552,7 +2811,17 @@ class Model(ObjectWithMetaData, VarProvider):
         omitted. This behavior can be changed by setting ``omit_states`` to
         ``False``. Dependencies on constants are included by default, but this
         can be changed by setting ``omit_constants`` to ``True``.
+
+        Results are cached until the model is changed.
         """
+        # Return cached result, if available
+        key = ('shallow', bool(collapse), bool(omit_states),
+               bool(omit_constants))
+        try:
+            return _copy_dependencies(self._cache[key])
+        except KeyError:
+            pass
+
         # Find dependencies for every stored equation
         out = {}
         inc = not omit_states
@@ -2596,8 +2865,9 @@ class Model(ObjectWithMetaData, VarProvider):
             for var in self.states():
                 out[myokit.Name(var)] = set()
 
-        # Return
-        return out
+        # Cache and return
+        self._cache[key] = out
+        return _copy_dependencies(out)
 
     def map_to_state(self, state):
         """
@@ -2750,6 +3020,7 @@ class Model(ObjectWithMetaData, VarProvider):
         self._state_init = current
         for k, v in enumerate(state):
             v._index = k
+        self._reset_cache(states=True)
 
     def remove_component(self, component):
         """
@@ -2766,7 +3037,7 @@ class Model(ObjectWithMetaData, VarProvider):
             # Delete component from list
             del self._components[component.qname()]
         finally:
-            self._valid = None
+            self._reset_validation()
 
     def remove_derivative_references(self):
         """
@@ -2871,11 +3142,35 @@ class Model(ObjectWithMetaData, VarProvider):
         for k, v in enumerate(self._state_vars):
             v._index = k
 
-    def _reset_validation(self):
+    def _reset_cache(self, states=False):
+        """
+        Removes cached results of dependency analysis, as used by e.g.
+        :meth:`map_shallow_dependencies`, :meth:`map_deep_dependencies`, and
+        :meth:`solvable_order`.
+
+        If ``states=True``, only results that list state variables (and so
+        depend on their order) are removed.
+        """
+        if states:
+            self._cache = {
+                k: v for k, v in self._cache.items()
+                if k[0] == 'solvable' or k[2]}
+        else:
+            # Create a new dict instead of clearing, as clones may share
+            self._cache = {}
+        self._cached_evaluator = None
+
+    def _reset_validation(self, cache=True):
         """
         Will reset the model's validation status to not validated.
+
+        Unless ``cache=False``, this also removes any cached results of
+        dependency analysis.
         """
         self._valid = None
+        if cache:
+            self._cache = {}
+            self._cached_evaluator = None
 
     def _resolve(self, name):
         """ See :meth:`VarProvider._resolve(). """
@@ -2949,7 +3244,7 @@ class Model(ObjectWithMetaData, VarProvider):
 
             # Set all at once, and reset validation status
             self._state_init = expr
-            self._valid = None
+            self._reset_validation(cache=False)
 
     def set_name(self, name=None):
         """
@@ -3112,8 +3407,14 @@ class Model(ObjectWithMetaData, VarProvider):
         that contain fully separable components (that is, if the model contains
         only components that depend on each other non-cyclically) this list
         will be empty.
+
+        Results are cached until the model is changed.
         """
-        # TODO: Cache this!
+        # Return cached result, if available
+        try:
+            return _copy_equations(self._cache[('solvable', )])
+        except KeyError:
+            pass
 
         # Get components in solvable order
         # Any components with interdependencies will _not_ be added to this
@@ -3185,6 +3486,13 @@ class Model(ObjectWithMetaData, VarProvider):
         # empty.
         deps = self.map_shallow_dependencies()
 
+        # Map each lhs to the lhs expressions that depend on it, so that solved
+        # variables can be removed without scanning the full dependency map
+        users = {}
+        for lhs, dps in deps.items():
+            for dep in dps:
+                users.setdefault(dep, []).append(lhs)
+
         # To get nicer output, nested variables are grouped with their parent.
         # Note: This isn't necessary for solvability, but makes for much more
         # readable exported code.
@@ -3262,9 +3570,10 @@ class Model(ObjectWithMetaData, VarProvider):
                     # Remove lhs from dependency map
                     del deps[lhs]
                     # Remove dependency on lhs from dependency lists in map
-                    for dps in deps.values():
-                        if lhs in dps:
-                            dps.remove(lhs)
+                    for user in users.get(lhs, ()):
+                        dps = deps.get(user)
+                        if dps is not None:
+                            dps.discard(lhs)
 
         # Get remaining, unsolved equations as {lhs: eq} map.
         unsolved = OrderedDict()
@@ -3293,17 +3602,19 @@ class Model(ObjectWithMetaData, VarProvider):
                 # Remove lhs from dependency map
                 del deps[lhs]
                 # Remove dependency on lhs from dependency lists in map
-                for dps in deps.values():
-                    if lhs in dps:
-                        dps.remove(lhs)
+                for user in users.get(lhs, ()):
+                    dps = deps.get(user)
+                    if dps is not None:
+                        dps.discard(lhs)
 
         # Any unsolved equations left? Then the equations can't be ordered!
         # In normal use, this should have been picked up already in validation.
         if unsolved:
             raise RuntimeError('Equation ordering failed.')
 
-        # Return
-        return out
+        # Cache and return
+        self._cache[('solvable', )] = out
+        return _copy_equations(out)
 
     def state(self):
         """
@@ -3983,7 +4294,10 @@ class Variable(VarOwner):
         variable and the hierarchy of nested variables, but doesn't fill in the
         details.
         """
-        v = parent.add_variable(self.name())
+        # Names in the original are known to be valid, so add_variable()'s
+        # checks can be skipped.
+        v = parent._variables[self._name] = Variable(parent, self._name)
+        v._reset_cache()
         self._clone_modelpart_data(v)
         for k in self.variables():
             k._clone1(v)
@@ -4012,7 +4326,7 @@ class Variable(VarOwner):
         # Cached references are set by set_rhs
         # Set RHS
         if self._rhs:
-            v.set_rhs(self._rhs.clone(subst=lhs_map))
+            v.set_rhs(_clone_expression(self._rhs, lhs_map))
 
         # Clone child variables
         for k in self.variables():
@@ -4799,8 +5113,8 @@ class Variable(VarOwner):
         try:
             model._state_init[self._index] = value
         finally:
-            # Reset model validation, but not the variable cache
-            model._reset_validation()
+            # Reset model validation, but not the variable or model cache
+            model._reset_validation(cache=False)
 
     def set_label(self, label=None):
         """
@@ -0,0 +1,264 @@
+#
+# Binary cache of parsed models, used by myokit.load_model().
+#
+# This file is part of Myokit.
+# See http://myokit.org for copyright, sharing, and licensing details.
+#
+import contextlib
+import gc
+import hashlib
+import inspect
+import marshal
+import os
+import tempfile
+
+import myokit
+
+# Magic bytes at the start of every cache file, and format version
+MAGIC = b'MYOKIT-MODEL\x00\x00\x00\x00'
+VERSION = 1
+
+# Default cache directory
+DIR_CACHE = os.path.join(myokit.DIR_USER, 'model-cache')
+
+# Expression types, by name
+_TYPES = {
+    name: cls for name, cls in vars(myokit._expressions).items()
+    if inspect.isclass(cls) and issubclass(cls, myokit.Expression)}
+
+# Expression tags for numbers and names
+_NUMBER = 0
+_NAME = 1
+_STRING_NAME = 2
+
+
+def cache_path(source, directory=None):
+    """
+    Returns the path of the cache file for an ``mmt`` model section
+    ``source``, stored in the given ``directory`` (or the default directory).
+
+    The file name is a hash of the source, the cache format, and the Myokit
+    version, so that changing any of these results in a new cache entry.
+    """
+    h = hashlib.sha256()
+    h.update(b'%s %d %d %s\n' % (
+        MAGIC, VERSION, marshal.version, myokit.__version__.encode()))
+    h.update(source.encode('utf-8'))
+    return os.path.join(directory or DIR_CACHE, h.hexdigest() + '.mmc')
+
+
+@contextlib.contextmanager
+def gc_paused():
+    """
+    Context manager that disables garbage collection while building a model.
+
+    Creating a model allocates many small objects, which triggers collection
+    passes that traverse the growing model repeatedly but find nothing to
+    free. For large models, these passes can take up a large part of the run
+    time.
+    """
+    enabled = gc.isenabled()
+    gc.disable()
+    try:
+        yield
+    finally:
+        if enabled:
+            gc.enable()
+
+
+def load(path):
+    """
+    Reads a cached model from ``path``, and returns it, or returns ``None`` if
+    the file does not exist or can't be read.
+    """
+    try:
+        with open(path, 'rb') as f:
+            data = f.read()
+        if data[:len(MAGIC)] != MAGIC:
+            return None
+        with gc_paused():
+            return _decode_model(marshal.loads(data[len(MAGIC):]))
+    except Exception:
+        return None
+
+
+def save(path, model):
+    """
+    Stores a parsed, validated ``model`` at ``path``.
+
+    The file is written to a temporary file first and then moved into place,
+    so that processes reading the cache concurrently never see partial files.
+    Errors writing to the cache are ignored.
+    """
+    data = MAGIC + marshal.dumps(_encode_model(model))
+    directory = os.path.dirname(path)
+    try:
+        os.makedirs(directory, exist_ok=True)
+        fd, temp = tempfile.mkstemp(dir=directory, suffix='.tmp')
+        try:
+            with os.fdopen(fd, 'wb') as f:
+                f.write(data)
+            os.replace(temp, path)
+        except BaseException:
+            os.remove(temp)
+            raise
+    except OSError:     # pragma: no cover
+        pass
+
+
+def _encode_unit(unit):
+    """ Encodes a unit as a tuple of builtins. """
+    if unit is None:
+        return None
+    return (tuple(unit._x), unit._m)
+
+
+def _encode_expression(e):
+    """ Encodes an expression as nested tuples of builtins. """
+    if isinstance(e, myokit.Number):
+        return (_NUMBER, e._value, _encode_unit(e._unit))
+    elif isinstance(e, myokit.Name):
+        if e._proper:
+            return (_NAME, e._value.qname())
+        return (_STRING_NAME, str(e._value))
+    return (type(e).__name__, ) + tuple(
+        _encode_expression(x) for x in e._operands)
+
+
+def _encode_variables(owner):
+    """ Encodes the variables in a component or variable. """
+    out = []
+    for v in owner.variables():
+        out.append((
+            v._name,
+            dict(v.meta),
+            _encode_unit(v._unit),
+            v._label,
+            v._binding,
+            None if v._rhs is None else _encode_expression(v._rhs),
+            _encode_variables(v),
+        ))
+    return out
+
+
+def _encode_model(model):
+    """ Encodes a validated model as nested tuples and dicts of builtins. """
+    functions = []
+    for f in model._user_functions.values():
+        functions.append((
+            f._name,
+            [str(x._value) for x in f._arguments],
+            _encode_expression(f._template),
+        ))
+    components = []
+    for c in model.components():
+        components.append((
+            c._name,
+            dict(c.meta),
+            [(a, v.qname()) for a, v in c._alias_map.items()],
+            _encode_variables(c),
+        ))
+    states = []
+    for v, e in zip(model._state_vars, model._state_init):
+        states.append((v.qname(), _encode_expression(e)))
+    warnings = []
+    for w in model._warnings:
+        if isinstance(w, myokit.UnusedVariableError):
+            warnings.append(w._variable)
+    return {
+        'meta': dict(model.meta),
+        'functions': functions,
+        'components': components,
+        'states': states,
+        'warnings': warnings,
+    }
+
+
+def _decode_model(data):
+    """
+    Creates a model from the output of :meth:`_encode_model`, without parsing
+    or validating it.
+    """
+    model = myokit.Model()
+    model.meta.update(data['meta'])
+
+    # Shared units, numbers and names
+    units = {None: None}
+    numbers = {}
+    names = {}
+    variables = {}
+
+    def unit(x):
+        try:
+            return units[x]
+        except KeyError:
+            u = units[x] = myokit.Unit(list(x[0]), x[1])
+            return u
+
+    def expression(x):
+        tag = x[0]
+        if tag == _NUMBER:
+            # Use repr as key, to distinguish 0 from -0
+            key = (repr(x[1]), x[2])
+            try:
+                return numbers[key]
+            except KeyError:
+                n = numbers[key] = myokit.Number(x[1], unit(x[2]))
+                return n
+        elif tag == _NAME:
+            try:
+                return names[x[1]]
+            except KeyError:
+                n = names[x[1]] = myokit.Name(variables[x[1]])
+                return n
+        elif tag == _STRING_NAME:
+            return myokit.Name(x[1])
+        return _TYPES[tag](*[expression(y) for y in x[1:]])
+
+    # User functions
+    for name, args, template in data['functions']:
+        model.add_function(name, args, expression(template))
+
+    # Create components and variables, store equations to set later. As the
+    # model was validated before caching, add_variable()'s checks are skipped.
+    equations = []
+
+    def add_variables(parent, encoded):
+        for name, meta, u, label, binding, rhs, kids in encoded:
+            v = parent._variables[name] = myokit.Variable(parent, name)
+            v._reset_cache()
+            v.meta.update(meta)
+            v._unit = unit(u)
+            variables[v.qname()] = v
+            if label is not None:
+                v.set_label(label)
+            if binding is not None:
+                v.set_binding(binding)
+            if rhs is not None:
+                equations.append((v, rhs))
+            add_variables(v, kids)
+
+    aliases = []
+    for name, meta, alias_map, encoded in data['components']:
+        c = model.add_component(name)
+        c.meta.update(meta)
+        add_variables(c, encoded)
+        aliases.append((c, alias_map))
+    for c, alias_map in aliases:
+        for name, qname in alias_map:
+            c.add_alias(name, variables[qname])
+
+    # Create states, then set equations and initial values
+    for qname, e in data['states']:
+        variables[qname].promote(0)
+    for v, rhs in equations:
+        v.set_rhs(expression(rhs))
+    for qname, e in data['states']:
+        variables[qname].set_initial_value(expression(e))
+
+    # Restore the results of validation
+    model.create_unique_names()
+    model._warnings = [
+        myokit.UnusedVariableError(variables[q]) for q in data['warnings']]
+    model._valid = True
+    return model
@@ -1321,13 +1321,16 @@ class Tokenizer:
         Advances to the next token.
         """
         self._next = self._peek
-        for c in self._catchers.values():
-            c.append(self._next[1])
+        catchers = self._catchers
+        if catchers:
+            for c in catchers.values():
+                c.append(self._next[1])
         try:
             self._peek = next(self._tokenizer)
             while self._peek[0] == WHITESPACE:
-                for c in self._catchers.values():
-                    c.append(self._peek[1])
+                if catchers:
+                    for c in catchers.values():
+                        c.append(self._peek[1])
                 self._peek = next(self._tokenizer)
         except StopIteration:
             self._has_last_value = True
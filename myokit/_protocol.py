@@ -384,15 +384,28 @@ class Protocol:
         protocol a point ``(b, 0)`` will be included in the output (protocol
         steps are defined as half-open, so include their starting point but not
         their end point).
+
+        Where possible, the points are calculated using a compiled C module.
         """
         # Test the input
         a, b = float(a), float(b)
         if b < a:
             raise ValueError('The argument `b` cannot be smaller than `a`')
+        if a < 0:
+            raise ValueError('New time cannot be before the current time.')
 
         # Create a simulation log
         log = myokit.DataLog()
         log.set_time_key('time')
+
+        # Use native implementation, if available
+        from myokit._sim.pacing import NativePacing
+        x = NativePacing.interval(self, a, b, for_drawing)
+        if x is not None:
+            log['time'], log['pace'] = x
+            return log
+
+        # Python implementation
         log['time'] = time = []
         log['pace'] = pace = []
 
@@ -421,7 +434,8 @@ class Protocol:
         ``pace`` representing the value of the pacing stimulus at each point.
 
         The time entries ``times`` must be an non-descreasing series of
-        non-negative points.
+        non-negative points. If ``times`` is a numpy array, the ``pace`` entry
+        will also be a numpy array.
         """
         log = myokit.DataLog()
         log.set_time_key('time')
@@ -509,18 +523,24 @@ class Protocol:
         Returns a list containing the value of the pacing variable at each time
         listed in ``times``.
 
+        If ``times`` is a numpy array, a numpy array will be returned instead
+        of a list. Where possible, the values are calculated in a single call
+        to a compiled C module.
+
         Arguments:
 
         ``times``
             A (non-decreasing) sequence of (non-negative) points in time.
 
         """
+        as_array = isinstance(times, np.ndarray)
+
         # Times empty? Then return empty list
         if len(times) == 0:
-            return []
+            return np.array([]) if as_array else []
 
         # Test time values are non-negative and non-decreasing
-        times = np.asarray(times)
+        times = np.asarray(times, dtype=float)
         if np.any(times[1:] < times[:-1]):
             raise ValueError(
                 'The argument `times` must contain a'
@@ -529,8 +549,8 @@ class Protocol:
             raise ValueError('Times cannot be negative.')
 
         # Create a pacing system, calculate the values, and return
-        p = PacingSystem(self)
-        return [p.advance(t) for t in times]
+        values = PacingSystem(self).advance(times)
+        return values if as_array else list(values)
 
 
 class ProtocolEvent:
@@ -745,6 +765,11 @@ class PacingSystem:
     >>> time = np.linspace(0, 1000, 10001)
     >>> pace = np.array([s.advance(t) for t in time])
 
+    Or, more efficiently, by passing in all times at once:
+
+    >>> s = myokit.PacingSystem(p)
+    >>> pace = s.advance(time)
+
     """
     def __init__(self, protocol, initial_time=0):
         # The initial and current time and pacing level
@@ -774,7 +799,15 @@ class PacingSystem:
         Advances the time in the pacing system to ``new_time``.
 
         Returns the current value of the pacing variable.
+
+        If ``new_time`` is a non-decreasing sequence of times (e.g. a numpy
+        array), the system is advanced to each time in turn, and a numpy array
+        containing the value of the pacing variable at every time is returned.
         """
+        # Advance to multiple times
+        if np.ndim(new_time) > 0:
+            return self._advance_multiple(new_time)
+
         # Check new_time isn't in the past
         new_time = float(new_time)
         if new_time < self._time:
@@ -814,6 +847,7 @@ class PacingSystem:
                     self._tdown = x._start
 
             # Next stopping time
+            e = self._protocol._head
             self._tnext = float('inf')
             if self._fire and self._tnext > self._tdown:
                 self._tnext = self._tdown
@@ -822,6 +856,38 @@ class PacingSystem:
 
         return self._pace
 
+    def _advance_multiple(self, times):
+        """
+        Advances to each time in a non-decreasing sequence ``times`` and
+        returns a numpy array containing the pacing values.
+        """
+        times = np.asarray(times, dtype=float)
+        if len(times) == 0:
+            return np.array([])
+        if np.any(times[1:] < times[:-1]):
+            raise ValueError(
+                'The argument `new_time` must contain a non-decreasing'
+                ' sequence of time points.')
+        if times[0] < self._time:
+            raise ValueError('New time cannot be before the current time.')
+
+        # Calculate the values with a native pacing system, started at the
+        # current time. The events still scheduled in self._protocol describe
+        # the future completely, except for the currently active event, which
+        # has already been removed and is added as a one-off event. This way
+        # the cost of each call does not depend on the time already elapsed.
+        from myokit._sim.pacing import NativePacing
+        protocol = self._protocol.clone()
+        if self._fire is not None:
+            protocol.add(myokit.ProtocolEvent(
+                self._pace, self._time, self._tdown - self._time))
+        values = NativePacing.levels(protocol, times, self._time)
+        if values is None:  # pragma: no cover
+            values = np.array([self.advance(t) for t in times])
+        else:
+            self.advance(times[-1])
+        return values
+
     def next_time(self):
         """ Returns the next time the pacing system will halt at. """
         return self._tnext
@@ -911,7 +977,14 @@ class TimeSeriesProtocol:
         return TimeSeriesProtocol(self._times, self._values, self._method)
 
     def pace(self, t):
-        """ Returns the value of the pacing variable at time ``t``. """
+        """
+        Returns the value of the pacing variable at time ``t``.
+
+        If ``t`` is a sequence of times (e.g. a numpy array), a numpy array
+        with the value at each time is returned.
+        """
+        if np.ndim(t) > 0:
+            return self._pace_multiple(np.asarray(t, dtype=float))
         if t < self._times[0]:
             return self._values[0]
         if t > self._times[-1]:
@@ -923,6 +996,26 @@ class TimeSeriesProtocol:
             self._values[i + 1] - self._values[i]
         ) / (self._times[i + 1] - self._times[i])
 
+    def _pace_multiple(self, t):
+        """ Vectorised version of :meth:`pace`. """
+        times = np.asarray(self._times)
+        values = np.asarray(self._values)
+        n = len(times)
+
+        # Find i such that times[i] <= t < times[i + 1], as with bisect_right
+        i = np.searchsorted(times, t, side='right') - 1
+        if n > 1:
+            j = np.clip(i, 0, n - 2)
+            v = values[j] + (t - times[j]) * (
+                values[j + 1] - values[j]) / (times[j + 1] - times[j])
+        else:
+            v = np.repeat(values[0], len(t))
+
+        # Outside the series, or at its final point
+        v = np.where(i < 0, values[0], v)
+        v = np.where(i >= n - 1, values[-1], v)
+        return v
+
     def times(self):
         """ Returns a list of the times in this protocol. """
         return self._times
@@ -33,32 +33,66 @@ bound_variables = myokit._prepare_bindings(model, {
 })
 
 # Define var/lhs function
-def v(var, pre='cell->'):
+def v(var, i='icell'):
     """
     Accepts a variable or a left-hand-side expression and returns its C
     representation.
+
+    States, derivatives, intermediary variables, and the variables bound to
+    pace and diffusion current are stored in per-variable arrays, indexed by
+    ``i``. Constants are stored in arrays that contain either a single value
+    shared by all cells, or a value for each cell (if set with a field), and
+    are indexed with ``CS_x * i``, where ``CS_x`` is 0 or 1.
     """
     if isinstance(var, myokit.Derivative):
         # Explicitly asked for derivative
-        return pre + 'D_' + var.var().uname()
+        return 'D_' + var.var().uname() + '[' + i + ']'
     if isinstance(var, myokit.Name):
         var = var.var()
     if var.is_state():
-        return pre + 'S_' + var.uname()
+        return 'S_' + var.uname() + '[' + i + ']'
     elif var.is_constant():
-        return pre + 'C_' + var.uname()
+        j = i if i.isidentifier() or i.isdigit() else '(' + i + ')'
+        return 'C_' + var.uname() + '[CS_' + var.uname() + ' * ' + j + ']'
+    elif bound_variables.get(var) == 'engine_time':
+        return 'engine_time'
     else:
-        return pre + 'I_' + var.uname()
+        return 'I_' + var.uname() + '[' + i + ']'
 w.set_lhs_function(v)
 
 # Get membrane potential
-vm = v(vmvar, pre='')
+vm = lambda i: v(vmvar, i)
 
 # Tab
 tab = '    '
 
 # Get equations
 equations = model.solvable_order()
+
+# Get arrays to store per cell
+states = list(model.states())
+inters = [x for x in model.variables(deep=True, state=False, const=False)
+          if bound_variables.get(x) != 'engine_time']
+const_eqs = [eq for eqs in equations.values()
+             for eq in eqs.equations(const=True)]
+
+# Intermediary variables are calculated into local variables, and only copied
+# into their arrays on steps where they might be logged. Variables used in
+# Rush-Larsen updates are always stored.
+stored = set(bound_variables)
+for inf, tau in rl_states.values():
+    stored.add(inf)
+    stored.add(tau)
+local = [x for x in inters if x not in stored]
+local_set = set(local)
+def vl(var):
+    if isinstance(var, myokit.Name):
+        var = var.var()
+    if var in local_set:
+        return 'L_' + var.uname()
+    return v(var)
+wl = ansic.AnsiCExpressionWriter()
+wl.set_lhs_function(vl)
 ?>
 #define PY_SSIZE_T_CLEAN
 #include <Python.h>
@@ -82,27 +116,42 @@ double engine_time = 0;
 double engine_pace = 0;
 
 /*
- * Cell component
+ * Constants. Each constant C_x points to either a single value shared by all
+ * cells (if CS_x is 0), or to an array with a value for each cell (if CS_x is
+ * 1). Constants are only stored per cell if they are set with a field, or
+ * depend on a constant that is.
+ */
+<?
+for eq in const_eqs:
+    x = eq.lhs.var().uname()
+    print('double* C_' + x + ';')
+    print('int CS_' + x + ';')
+?>
+
+/*
+ * Per-cell variables, stored as one array per variable ("structure of
+ * arrays"). This lets the loops over cells be vectorised and split over
+ * multiple threads.
  */
 #define N_STATE <?=model.count_states()?>
-typedef struct Cell {
+#define N_CELL_ARRAYS <?= 2 * len(states) + len(inters) ?>
 <?
-print(tab + '/* Bound variables */')
-for var in model.variables(bound=True, deep=True):
-    print(tab + 'double ' + v(var, pre='') + ';')
-print(tab + '/* State variables */')
-for var in model.states():
-    print(tab + 'double ' + v(var, pre='') + ';')
-print(tab + '/* State derivatives */')
-for var in model.states():
-    print(tab + 'double ' + v(var.lhs(), pre='') + ';')
-print(tab + '/* Intermediary variables */')
-for var in model.variables(inter=True, bound=False, deep=True):
-    print(tab + 'double ' + v(var, pre='') + ';')
-print(tab + '/* Constants */')
-for var in model.variables(const=True, bound=False, deep=True):
-    print(tab + 'double ' + v(var, pre='') + ';')
-?>} Cell;
+print('/* State variables */')
+for var in states:
+    print('double* S_' + var.uname() + ';')
+print('/* State derivatives */')
+for var in states:
+    print('double* D_' + var.uname() + ';')
+print('/* Intermediary and bound variables */')
+for var in inters:
+    print('double* I_' + var.uname() + ';')
+?>
+
+/*
+ * Cells are only split over threads if there are enough of them to make this
+ * worthwhile.
+ */
+#define OMP_MIN_CELLS 64
 
 /*
  * Add a variable to the logging lists. Returns 1 if successful
@@ -126,7 +175,8 @@ static int log_add(PyObject* data, PyObject** logs, double** vars, int i, char*
 /* Input arguments */
 int ncells;             /* Number of cells */
 int npaced;             /* Number of cells receiving stimulus */
-double g;               /* Conductance */
+PyObject* conductances; /* The conductance of each junction between cells */
+int diffusion_scheme;   /* 0 for explicit, 1 for backward Euler, 2 for Crank-Nicolson */
 double tmin;            /* The initial simulation time */
 double tmax;            /* The final simulation time */
 double default_dt;      /* The default step size */
@@ -135,9 +185,17 @@ PyObject* state_out;    /* The final states */
 PyObject *protocol;     /* The pacing protocol */
 PyObject *log_dict;     /* The log dict */
 double log_interval;    /* The log interval (0 to disable) */
+PyObject *fields;       /* A dict mapping constant names to per-cell values */
 
 /* Cells */
-Cell *cells;            /* All used cells */
+double *cell_data;      /* Memory for all per-cell arrays */
+double *const_data;     /* Memory for all constants */
+double *gj;             /* The conductance of each junction between cells */
+double *dvdi;           /* Derivative of dot(V) w.r.t. the diffusion current, per cell (0 if explicit) */
+
+/* Implicit diffusion */
+double *thomas_c;       /* Modified upper diagonal used in the Thomas algorithm */
+double *thomas_d;       /* Modified right-hand side used in the Thomas algorithm */
 
 /* Running */
 int running = 0;        /* Running yes/no */
@@ -165,44 +223,67 @@ PyObject *flt;              /* PyFloat, various uses */
 PyObject *ret;              /* PyFloat, used as return value from python calls */
 PyObject *list_update_str;  /* PyUnicode, ssed to call "append" method */
 
+/*
+ * Calculates the derivatives and intermediary variables of all cells, using
+ * the current values of the states and bound variables.
+ *
+ * If ``store`` is non-zero, all intermediary variables are stored so that they
+ * can be logged.
+ */
+static void
+derivatives(int store)
+{
+    int icell;
+
+    #ifdef _OPENMP
+    #pragma omp parallel for schedule(static) if(ncells >= OMP_MIN_CELLS)
+    #endif
+    for (icell=0; icell<ncells; icell++) {
+<?
+for var in local:
+    print(tab*2 + 'double ' + vl(var) + ';')
+for label, eqs in equations.items():
+    for eq in eqs.equations(const=False, bound=False):
+        print(tab*2 + wl.eq(eq) + ';')
+if local:
+    print(tab*2 + 'if (store) {')
+    for var in local:
+        print(tab*3 + v(var) + ' = ' + vl(var) + ';')
+    print(tab*2 + '}')
+?>
+    }
+}
+
 /*
  * Given a current state, this method calculates all diffusion currents, sets
  * the time and pacing variables and calculates all derivatives.
+ *
+ * If ``store`` is non-zero, all intermediary variables are stored so that they
+ * can be logged.
  */
 static void
-rhs()
+rhs(int store)
 {
     int icell;
-    Cell* cell;
-    double diffusion_current = 0.0;  // Diffusion current
 
 <?
 var = model.binding('diffusion_current')
 if var is not None:
     print(tab*1 + '/*')
-    print(tab*1 + ' * Set diffusion currents')
+    print(tab*1 + ' * Set diffusion currents, using the conductance of each junction')
     print(tab*1 + ' */')
     print(tab*1 + 'if (ncells > 1) {')
-    print(tab*2 + 'Cell *clast, *cnext;')
-    print(tab*2 + 'cell = clast = cnext = cells;')
-    print(tab*2 + 'cnext++;')
-    print(tab*2 + '')
     print(tab*2 + '/* First cell */')
-    print(tab*2 + 'diffusion_current = g * (cell->' + vm + ' - cnext->' + vm + ');')
-    print(tab*2 + v(var) + ' = diffusion_current;')
-    print(tab*2 + 'cnext++;')
-    print(tab*2 + 'cell++;')
+    print(tab*2 + v(var, '0') + ' = gj[0] * (' + vm('0') + ' - ' + vm('1') + ');')
     print(tab*2 + '/* Doubly-connected cells */')
-    print(tab*2 + 'for(icell=2; icell<ncells; icell++) {')
-    print(tab*3 + 'diffusion_current = g * (2.0*cell-> ' + vm + ' - clast-> ' + vm + ' - cnext->' + vm + ');')
-    print(tab*3 + v(var) + ' = diffusion_current;')
-    print(tab*3 + 'clast++;')
-    print(tab*3 + 'cnext++;')
-    print(tab*3 + 'cell++;')
+    print(tab*2 + '#ifdef _OPENMP')
+    print(tab*2 + '#pragma omp parallel for schedule(static) if(ncells >= OMP_MIN_CELLS)')
+    print(tab*2 + '#endif')
+    print(tab*2 + 'for (icell=1; icell<ncells-1; icell++) {')
+    print(tab*3 + v(var) + ' = gj[icell-1] * (' + vm('icell') + ' - ' + vm('icell-1') + ') + gj[icell] * (' + vm('icell') + ' - ' + vm('icell+1') + ');')
     print(tab*2 + '}')
     print(tab*2 + '/* Last cell */')
-    print(tab*2 + 'diffusion_current = g * (cell->' + vm + ' - clast->' + vm + ');')
-    print(tab*2 + v(var) + ' = diffusion_current;')
+    print(tab*2 + v(var, 'ncells-1') + ' = gj[ncells-2] * (' + vm('ncells-1') + ' - ' + vm('ncells-2') + ');')
     print(tab*1 + '}')
 
 var = model.binding('pace')
@@ -210,28 +291,83 @@ if var is not None:
     print(tab*1 + '/*')
     print(tab*1 + ' * Set pacing current')
     print(tab*1 + ' */')
-    print(tab*1 + 'cell = cells;')
-    print(tab*1 + 'for(icell=0; icell<npaced; icell++) {')
+    print(tab*1 + 'for (icell=0; icell<npaced; icell++) {')
     print(tab*2 + v(var) + ' = engine_pace;')
-    print(tab*2 + 'cell++;')
     print(tab*1 + '}')
 
 ?>
 
     /*
-     * Set time, calculate derivatives
+     * Calculate derivatives
      */
-    cell = cells;
-    for(icell=0; icell<ncells; icell++) {
+    derivatives(store);
+}
+
+/*
+ * Solves the diffusion part of the cable equation for the membrane potential,
+ * using a backward Euler or Crank-Nicolson step of size ``h``.
+ *
+ * The diffusion current in cell i is
+ *
+ *   I_i = g_{i-1} (V_i - V_{i-1}) + g_i (V_i - V_{i+1}),
+ *
+ * where g_i is the conductance of the junction between cells i and i + 1 (and
+ * terms for missing neighbours are omitted), and the diffusion part of the
+ * equation is dV_i/dt = dvdi_i * I_i. With r_i = -h * dvdi_i, a backward Euler
+ * step requires solving the tridiagonal system
+ *
+ *   V_{n+1} + r I(V_{n+1}) = V_n,
+ *
+ * and a Crank-Nicolson step requires solving
+ *
+ *   V_{n+1} + r/2 I(V_{n+1}) = V_n - r/2 I(V_n).
+ *
+ * Both are solved with the Thomas algorithm, in O(ncells) operations.
+ */
+static void
+diffusion_step(double h)
+{
+    int icell;
+    double r, gl, gr, m, i_diff;
+
+    if (ncells < 2) return;
 <?
-var = model.time()
-print(tab*2 + v(var) + ' = engine_time;')
-for label, eqs in equations.items():
-    for eq in eqs.equations(const=False, bound=False):
-        print(tab*2 + w.eq(eq) + ';')
+if model.binding('diffusion_current') is not None:
+    print(tab + '/* Set right-hand side */')
+    print(tab + 'if (diffusion_scheme == 2) {')
+    print(tab*2 + 'h *= 0.5;')
+    print(tab*2 + 'for (icell=0; icell<ncells; icell++) {')
+    print(tab*3 + 'i_diff = 0;')
+    print(tab*3 + 'if (icell > 0) i_diff += gj[icell-1] * (' + vm('icell') + ' - ' + vm('icell-1') + ');')
+    print(tab*3 + 'if (icell < ncells - 1) i_diff += gj[icell] * (' + vm('icell') + ' - ' + vm('icell+1') + ');')
+    print(tab*3 + 'thomas_d[icell] = ' + vm('icell') + ' + h * dvdi[icell] * i_diff;')
+    print(tab*2 + '}')
+    print(tab + '} else {')
+    print(tab*2 + 'for (icell=0; icell<ncells; icell++) {')
+    print(tab*3 + 'thomas_d[icell] = ' + vm('icell') + ';')
+    print(tab*2 + '}')
+    print(tab + '}')
+    print()
+    print(tab + '/* Forward sweep: row i has diagonal 1 + r_i (g_{i-1} + g_i) and off-diagonals -r_i g_{i-1} and -r_i g_i */')
+    print(tab + 'r = -h * dvdi[0];')
+    print(tab + 'm = 1.0 + r * gj[0];')
+    print(tab + 'thomas_c[0] = -r * gj[0] / m;')
+    print(tab + 'thomas_d[0] = thomas_d[0] / m;')
+    print(tab + 'for (icell=1; icell<ncells; icell++) {')
+    print(tab*2 + 'r = -h * dvdi[icell];')
+    print(tab*2 + 'gl = gj[icell-1];')
+    print(tab*2 + 'gr = (icell == ncells - 1) ? 0.0 : gj[icell];')
+    print(tab*2 + 'm = 1.0 + r * (gl + gr) + r * gl * thomas_c[icell-1];')
+    print(tab*2 + 'thomas_c[icell] = -r * gr / m;')
+    print(tab*2 + 'thomas_d[icell] = (thomas_d[icell] + r * gl * thomas_d[icell-1]) / m;')
+    print(tab + '}')
+    print()
+    print(tab + '/* Back substitution */')
+    print(tab + vm('ncells-1') + ' = thomas_d[ncells-1];')
+    print(tab + 'for (icell=ncells-2; icell>=0; icell--) {')
+    print(tab*2 + vm('icell') + ' = thomas_d[icell] - thomas_c[icell] * ' + vm('icell+1') + ';')
+    print(tab + '}')
 ?>
-        cell++;
-    }
 }
 
 /*
@@ -256,7 +392,12 @@ sim_clean()
         /* Free allocated space */
         free(logs); logs = NULL;
         free(vars); vars = NULL;
-        free(cells); cells = NULL;
+        free(cell_data); cell_data = NULL;
+        free(const_data); const_data = NULL;
+        free(gj); gj = NULL;
+        free(dvdi); dvdi = NULL;
+        free(thomas_c); thomas_c = NULL;
+        free(thomas_d); thomas_d = NULL;
 
         /* Free pacing system memory */
         ESys_Destroy(pacing); pacing = NULL;
@@ -289,8 +430,8 @@ sim_init(PyObject *self, PyObject *args)
     #endif
 
     int icell;
-    Cell* cell;
     int i_state;
+    size_t n_const;
     char log_var_name[1000];
     ESys_Flag flag_pacing;
 
@@ -304,13 +445,19 @@ sim_init(PyObject *self, PyObject *args)
     list_update_str = NULL;
     logs = NULL;
     vars = NULL;
-    cells = NULL;
+    cell_data = NULL;
+    const_data = NULL;
+    gj = NULL;
+    dvdi = NULL;
+    thomas_c = NULL;
+    thomas_d = NULL;
     pacing = NULL;
 
     /* Check input arguments (borrowed references) */
-    if (!PyArg_ParseTuple(args, "iddddOOOiOd",
+    if (!PyArg_ParseTuple(args, "iOidddOOOiOdO",
             &ncells,
-            &g,
+            &conductances,
+            &diffusion_scheme,
             &tmin,
             &tmax,
             &default_dt,
@@ -319,7 +466,8 @@ sim_init(PyObject *self, PyObject *args)
             &protocol,
             &npaced,
             &log_dict,
-            &log_interval)) {
+            &log_interval,
+            &fields)) {
         PyErr_SetString(PyExc_Exception, "Incorrect input arguments.");
         /* Nothing allocated yet, no pyobjects _created_, return directly */
         return 0;
@@ -334,12 +482,59 @@ sim_init(PyObject *self, PyObject *args)
      *
      */
 
-    /* Create cell structs */
-    cells = (Cell*)malloc(ncells*sizeof(Cell));
-    if (cells == 0) {
+    /* Create per-cell arrays */
+    if (ncells < 1) {
         PyErr_SetString(PyExc_Exception, "Number of cells must be greater than zero.");
         return sim_clean();
     }
+    cell_data = (double*)malloc((size_t)N_CELL_ARRAYS * (size_t)ncells * sizeof(double));
+    if (cell_data == 0) {
+        PyErr_SetString(PyExc_MemoryError, "Unable to allocate memory for cell variables.");
+        return sim_clean();
+    }
+<?
+i = 0
+for pre, varlist in (('S_', states), ('D_', states), ('I_', inters)):
+    for var in varlist:
+        print(tab + pre + var.uname() + ' = cell_data + ' + str(i) + ' * ncells;')
+        i += 1
+?>
+
+    /* Set junction conductances */
+    if (!PyList_Check(conductances) || PyList_Size(conductances) != ncells - 1) {
+        PyErr_SetString(PyExc_Exception, "'conductances' must be a list of size ncells - 1.");
+        return sim_clean();
+    }
+    gj = (double*)malloc((size_t)ncells * sizeof(double));
+    if (gj == 0) {
+        PyErr_SetString(PyExc_MemoryError, "Unable to allocate memory for conductances.");
+        return sim_clean();
+    }
+    for (icell=0; icell<ncells-1; icell++) {
+        flt = PyList_GetItem(conductances, icell);  /* Borrowed reference */
+        if (!PyFloat_Check(flt)) {
+            PyErr_Format(PyExc_Exception, "Item %d in conductances is not a float.", icell);
+            return sim_clean();
+        }
+        gj[icell] = PyFloat_AsDouble(flt);
+    }
+
+    /* Create arrays for implicit diffusion. For explicit diffusion, dvdi is
+       left at zero so that the diffusion current isn't subtracted in the
+       update. */
+    dvdi = (double*)calloc((size_t)ncells, sizeof(double));
+    if (dvdi == 0) {
+        PyErr_SetString(PyExc_MemoryError, "Unable to allocate memory for cell variables.");
+        return sim_clean();
+    }
+    if (diffusion_scheme != 0) {
+        thomas_c = (double*)malloc((size_t)ncells * sizeof(double));
+        thomas_d = (double*)malloc((size_t)ncells * sizeof(double));
+        if (thomas_c == 0 || thomas_d == 0) {
+            PyErr_SetString(PyExc_MemoryError, "Unable to allocate memory for implicit diffusion.");
+            return sim_clean();
+        }
+    }
 
     /* Check number of paced cells */
     if (npaced > ncells) {
@@ -386,24 +581,22 @@ sim_init(PyObject *self, PyObject *args)
     vars = (double**)malloc(sizeof(double*)*nvars); /* Pointers to variables to log */
 
     ivars = 0;
-    cell = cells;
 <?
 
 # Time and pace are set globally, use only the value from the first cell
 var_time = model.time()
-print(tab + 'ivars += log_add(log_dict, logs, vars, ivars, "' + var_time.qname() + '", &' + v(var_time) + ');')
+print(tab + 'ivars += log_add(log_dict, logs, vars, ivars, "' + var_time.qname() + '", &' + v(var_time, '0') + ');')
 var_pace = model.binding('pace')
 if var_pace is not None:
-    print(tab + 'ivars += log_add(log_dict, logs, vars, ivars, "' + var_pace.qname() + '", &' + v(var_pace) + ');')
+    print(tab + 'ivars += log_add(log_dict, logs, vars, ivars, "' + var_pace.qname() + '", &' + v(var_pace, '0') + ');')
 
 # Add remaining variables
-print(tab + 'for(icell=0; icell<ncells; icell++) {')
+print(tab + 'for (icell=0; icell<ncells; icell++) {')
 for var in model.variables(deep=True, const=False):
     if var in (var_time, var_pace):
         continue
     print(tab * 2 + 'sprintf(log_var_name, "%d.' + var.qname() + '", icell);')
     print(tab * 2 + 'ivars += log_add(log_dict, logs, vars, ivars, log_var_name, &' + v(var) + ');')
-print(tab * 2 + 'cell++;')
 print(tab + '}')
 
 ?>
@@ -426,19 +619,59 @@ print(tab + '}')
     /* Set simulation starting time */
     engine_time = tmin;
 
-    /* Initialize cells: set constants, calculated constants, initial values,
-       zeros for pacing and stimulus */
-    cell = cells;
-    for(icell=0; icell<ncells; icell++) {
-        /* Literal values & calculated constants */
+    /* Constants: check fields, and see which constants are stored per cell */
+    if (!PyDict_Check(fields)) {
+        PyErr_SetString(PyExc_Exception, "'fields' must be a dict.");
+        return sim_clean();
+    }
+    n_const = 0;
+<?
+for eq in const_eqs:
+    x = eq.lhs.var()
+    deps = [ref.var().uname() for ref in eq.rhs.references()]
+    print(tab + 'flt = PyDict_GetItemString(fields, "' + x.qname() + '");  /* Borrowed reference */')
+    print(tab + 'if (flt != NULL && (!PyList_Check(flt) || PyList_Size(flt) != ncells)) {')
+    print(tab*2 + 'PyErr_SetString(PyExc_Exception, "Field for ' + x.qname() + ' must be a list of size ncells.");')
+    print(tab*2 + 'return sim_clean();')
+    print(tab + '}')
+    print(tab + 'CS_' + x.uname() + ' = (flt != NULL' + ''.join(' || CS_' + d for d in deps) + ');')
+    print(tab + 'n_const += CS_' + x.uname() + ' ? (size_t)ncells : 1;')
+?>
+    const_data = (double*)malloc(n_const * sizeof(double));
+    if (const_data == 0) {
+        PyErr_SetString(PyExc_MemoryError, "Unable to allocate memory for constants.");
+        return sim_clean();
+    }
+    n_const = 0;
+<?
+for eq in const_eqs:
+    x = eq.lhs.var().uname()
+    print(tab + 'C_' + x + ' = const_data + n_const;')
+    print(tab + 'n_const += CS_' + x + ' ? (size_t)ncells : 1;')
+?>
+
+    /* Literal values & calculated constants, using fields where set */
 <?
-for label, eqs in equations.items():
-    for eq in eqs.equations(const=True):
-        print(tab*2 + w.eq(eq) + ';')
+for eq in const_eqs:
+    x = eq.lhs.var()
+    print(tab + 'flt = PyDict_GetItemString(fields, "' + x.qname() + '");')
+    print(tab + 'if (flt != NULL) {')
+    print(tab*2 + 'for (icell=0; icell<ncells; icell++) {')
+    print(tab*3 + v(x) + ' = PyFloat_AsDouble(PyList_GetItem(flt, icell));')
+    print(tab*2 + '}')
+    print(tab + '} else {')
+    print(tab*2 + 'for (icell=0; icell<(CS_' + x.uname() + ' ? ncells : 1); icell++) {')
+    print(tab*3 + w.eq(eq) + ';')
+    print(tab*2 + '}')
+    print(tab + '}')
 ?>
+    flt = NULL;
+
+    /* Initialize cells: set initial values, zeros for pacing and stimulus */
+    for (icell=0; icell<ncells; icell++) {
         /* Initial values */
 <?
-for var in model.states():
+for var in states:
     print(tab*2 + v(var) + ' = PyFloat_AsDouble(PyList_GetItem(state_in, icell * N_STATE + ' + str(var.index()) + '));')
 ?>
         /* Zeros for pacing and diffusion current */
@@ -450,11 +683,29 @@ var = model.binding('diffusion_current')
 if var is not None:
     print(tab*2 + v(var) + ' = 0;')
 ?>
-        cell++;
     }
 
+<?
+var = model.binding('diffusion_current')
+if var is not None:
+    print(tab + '/* Determine the derivative of dot(V) w.r.t. the diffusion current in')
+    print(tab + '   each cell, assuming a linear relationship */')
+    print(tab + 'if (diffusion_scheme != 0) {')
+    print(tab*2 + 'derivatives(0);')
+    print(tab*2 + 'for (icell=0; icell<ncells; icell++) {')
+    print(tab*3 + 'dvdi[icell] = ' + v(vmvar.lhs()) + ';')
+    print(tab*3 + v(var) + ' = 1;')
+    print(tab*2 + '}')
+    print(tab*2 + 'derivatives(0);')
+    print(tab*2 + 'for (icell=0; icell<ncells; icell++) {')
+    print(tab*3 + 'dvdi[icell] = ' + v(vmvar.lhs()) + ' - dvdi[icell];')
+    print(tab*3 + v(var) + ' = 0;')
+    print(tab*2 + '}')
+    print(tab + '}')
+    print()
+?>
     /* Calculate rhs at initial time */
-    rhs();
+    rhs(1);
 
     /* Set first point to step to */
     istep = 1;
@@ -475,7 +726,6 @@ sim_step(PyObject *self, PyObject *args)
 {
     ESys_Flag flag_pacing;
     int icell;
-    Cell* cell;
     int steps_taken = 0;
     double d;
 
@@ -527,22 +777,32 @@ sim_step(PyObject *self, PyObject *args)
         engine_pace = ESys_GetLevel(pacing, NULL);
 
         /* Move to next time (3) Update the states */
-        cell = cells;
-        for(icell=0; icell<ncells; icell++) {
 <?
-for var in model.states():
+var_diff = model.binding('diffusion_current')
+?>
+        #ifdef _OPENMP
+        #pragma omp parallel for schedule(static) if(ncells >= OMP_MIN_CELLS)
+        #endif
+        for (icell=0; icell<ncells; icell++) {
+<?
+for var in states:
     if var in rl_states:
         inf, tau = rl_states[var]
         inf, tau, var = v(inf), v(tau), v(var)
         print(tab*3 + var + ' = ' + inf + ' - (' + inf + ' - ' + var + ') * exp(-dt / ' + tau + ');')
+    elif var == vmvar and var_diff is not None:
+        # Subtract diffusion current (dvdi is 0 for explicit diffusion)
+        print(tab*3 + v(var) + ' += dt * (' + v(var.lhs()) + ' - dvdi[icell] * ' + v(var_diff) + ');')
     else:
         print(tab*3 + v(var) + ' += dt * ' + v(var.lhs()) + ';')
 ?>
-            cell++;
         }
 
+        /* Move to next time (3b) Solve the diffusion part implicitly */
+        if (diffusion_scheme != 0) diffusion_step(dt);
+
         /* Move to next time (4) Calculate the new derivatives, intermediaries etc. */
-        rhs();
+        rhs(nvars > 0 && engine_time >= tlog);
 
         /*
          * Are we done?
@@ -575,13 +835,11 @@ for var in model.states():
     #ifdef MYOKIT_DEBUG_MESSAGES
     printf("Setting final state.\n");
     #endif
-    cell = cells;
-    for(icell=0; icell<ncells; icell++) {
+    for (icell=0; icell<ncells; icell++) {
 <?
-for var in model.states():
+for var in states:
     print(tab*2 + 'PyList_SetItem(state_out, icell * N_STATE + ' + str(var.index()) + ', PyFloat_FromDouble(' + v(var) + '));')
 ?>
-        cell++;
     }
 
     #ifdef MYOKIT_DEBUG_MESSAGES
@@ -7,6 +7,8 @@
 import os
 import platform
 
+import numpy as np
+
 import myokit
 
 # Location of source file
@@ -76,7 +78,14 @@ class Simulation1d(myokit.CModule):
 
         i = sum[g * (V - V_j)]
 
-    Where the sum is taken over all neighboring cells j (see [1]).
+    Where the sum is taken over all neighboring cells j (see [1]). A different
+    conductance can be set for every junction between cells with
+    :meth:`set_conductance_field`.
+
+    Heterogeneous cables can be simulated by setting a different value of a
+    model constant in every cell, using :meth:`set_field`. Fields and
+    conductances are passed to the simulation at the start of every run, so
+    that changing them does not require the simulation to be recompiled.
 
     The resulting ODE system is solved using a forward Euler (FE) method with
     fixed step sizes. Smaller step sizes lead to more accurate results, and it
@@ -86,6 +95,16 @@ class Simulation1d(myokit.CModule):
     often increases stability (allowing for larger step sizes) but can reduce
     accuracy (see [3]) so that care must be taken when using this method.
 
+    On Linux, the simulation is compiled with OpenMP support if available, so
+    that cells are updated in parallel for long cables. The number of threads
+    used can be set with the ``OMP_NUM_THREADS`` environment variable.
+
+    By default, the diffusion currents are calculated explicitly, from the
+    membrane potentials at the start of each step. For high conductances this
+    requires very small step sizes to remain stable. Alternatively, the
+    diffusion part of the equations can be solved (semi-)implicitly, using
+    operator splitting, see :meth:`set_diffusion_scheme`.
+
     [1] Myokit: A simple interface to cardiac cellular electrophysiology.
     Clerx, Collins, de Lange, Volders (2016) Progress in Biophysics and
     Molecular Biology.
@@ -150,8 +169,16 @@ class Simulation1d(myokit.CModule):
         self.set_paced_cells()
 
         # Set conductance
+        self._conductance_field = None
         self.set_conductance()
 
+        # Fields: maps variable qnames onto lists of per-cell values
+        self._fields = {}
+
+        # Set diffusion scheme
+        self._dvdi = None
+        self.set_diffusion_scheme()
+
         # Set step size
         self.set_step_size()
 
@@ -201,12 +228,30 @@ class Simulation1d(myokit.CModule):
         # Create simulation
         libd = None
         incd = [myokit.DIR_CFUNC]
-        self._sim = self._compile(module_name, fname, args, libs, libd, incd)
+
+        # Try compiling with OpenMP support, so that the cells can be updated
+        # in parallel. If this fails (e.g. because the compiler doesn't
+        # support it), fall back to a serial build.
+        self._sim = None
+        if platform.system() == 'Linux':  # pragma: no macos cover
+            flags = ['-fopenmp']
+            try:
+                self._sim = self._compile(
+                    module_name, fname, args, libs, libd, list(incd),
+                    carg=flags, larg=flags)
+            except myokit.CompilationError:  # pragma: no cover
+                pass
+        if self._sim is None:  # pragma: no linux cover
+            self._sim = self._compile(
+                module_name, fname, args, libs, libd, incd)
 
     def conductance(self):
         """
-        Returns the current conductance.
+        Returns the current conductance, or ``None`` if conductances were set
+        with :meth:`set_conductance_field`.
         """
+        if self._conductance_field is not None:
+            return None
         return self._conductance
 
     def default_state(self, icell=None):
@@ -224,6 +269,13 @@ class Simulation1d(myokit.CModule):
             offset = icell * self._nstate
             return self._default_state[offset:offset + self._nstate]
 
+    def diffusion_scheme(self):
+        """
+        Returns the method used to calculate the diffusion currents, see
+        :meth:`set_diffusion_scheme`.
+        """
+        return self._scheme_name
+
     def paced_cells(self):
         """
         Returns the number of cells that will receive a stimulus from the
@@ -362,9 +414,14 @@ class Simulation1d(myokit.CModule):
             # Initialize
             state_in = self._state
             state_out = list(state_in)
+            if self._conductance_field is None:
+                g = [self._conductance] * (self._ncells - 1)
+            else:
+                g = list(self._conductance_field)
             self._sim.sim_init(
                 self._ncells,
-                self._conductance,
+                g,
+                self._scheme,
                 tmin,
                 tmax,
                 self._step_size,
@@ -373,7 +430,8 @@ class Simulation1d(myokit.CModule):
                 self._protocol,
                 min(self._npaced, self._ncells),
                 log,
-                log_interval)
+                log_interval,
+                self._fields)
             t = tmin
             try:
                 if progress:
@@ -417,14 +475,110 @@ class Simulation1d(myokit.CModule):
         elif n == self._nstate * self._ncells:
             return list(state)
 
+    def remove_field(self, var):
+        """
+        Removes any field set for the given variable.
+
+        If no field is set for ``var``, this method does nothing.
+        """
+        if isinstance(var, myokit.Variable):
+            var = var.qname()
+        self._fields.pop(self._model.get(var).qname(), None)
+
     def set_conductance(self, g=10):
         """
         Changes the cell-to-cell conductance.
+
+        Calling ``set_conductance`` will delete any conductances previously set
+        with :meth:`set_conductance_field`.
         """
         g = float(g)
         if g < 0:
             raise ValueError('Conductance cannot be negative.')
         self._conductance = g
+        self._conductance_field = None
+
+    def set_conductance_field(self, g):
+        """
+        Sets a different conductance for every junction between two cells.
+
+        The argument ``g`` must be a sequence of ``ncells - 1`` non-negative
+        floats, where ``g[i]`` is the conductance between cells ``i`` and
+        ``i + 1``.
+
+        Calling ``set_conductance_field`` will delete any conductance
+        previously set with :meth:`set_conductance`.
+        """
+        try:
+            g = np.array([float(x) for x in g])
+        except (TypeError, ValueError):
+            raise ValueError(
+                'The argument `g` must be a sequence of numbers.')
+        if g.shape != (self._ncells - 1, ):
+            raise ValueError(
+                'The argument `g` must have length ' + str(self._ncells - 1)
+                + '.')
+        if np.any(g < 0):
+            raise ValueError(
+                'The argument `g` can not contain negative values.')
+        self._conductance_field = [float(x) for x in g]
+
+    def set_diffusion_scheme(self, scheme='explicit'):
+        """
+        Sets the method used to calculate the diffusion currents.
+
+        ``scheme``
+            One of ``'explicit'`` (default), ``'backward-euler'``, or
+            ``'crank-nicolson'``.
+
+        With the explicit scheme, the diffusion currents are calculated from
+        the membrane potentials at the start of each step, and then used to
+        update all states with a forward Euler step.
+
+        The other two schemes use operator splitting: each step first updates
+        all states using forward Euler (or Rush-Larsen) *without* the
+        diffusion current, and then solves the diffusion part of the equation
+        for the membrane potential with an implicit backward Euler or
+        Crank-Nicolson step. This requires solving a tridiagonal system, which
+        is done in ``O(ncells)`` operations using the Thomas algorithm. The
+        resulting method is stable for any conductance, allowing larger step
+        sizes (e.g. 0.02 to 0.05 ms instead of 0.005 ms for typical cardiac
+        cell models).
+
+        The implicit schemes require the derivative of the membrane potential
+        to depend linearly on the diffusion current, e.g.
+        ``dot(V) = -(i_ion + i_diff) / C`` where ``C`` is a constant.
+        """
+        schemes = {
+            'explicit': 0,
+            'backward-euler': 1,
+            'crank-nicolson': 2,
+        }
+        try:
+            code = schemes[scheme]
+        except KeyError:
+            raise ValueError(
+                'Unknown diffusion scheme "' + str(scheme) + '", expecting'
+                ' one of ' + ', '.join(schemes.keys()) + '.')
+
+        # Check that dV/di_diff is constant (using the default constants, the
+        # per-cell values are determined by the simulation itself)
+        if code > 0 and self._dvdi is None:
+            i = self._vm.index()
+            state = self._model.initial_values(True)
+            d = [self._model.evaluate_derivatives(
+                state, {'pace': 0, 'diffusion_current': x})[i]
+                for x in (0, 1, 2)]
+            dvdi = d[1] - d[0]
+            if dvdi == 0 or not myokit.float.close(dvdi, d[2] - d[1]):
+                raise ValueError(
+                    'Implicit diffusion schemes require the derivative of'
+                    ' the membrane potential to depend linearly on the'
+                    ' diffusion current.')
+            self._dvdi = dvdi
+
+        self._scheme_name = scheme
+        self._scheme = code
 
     def set_default_state(self, state, icell=None):
         """
@@ -446,6 +600,44 @@ class Simulation1d(myokit.CModule):
         self._default_state = self._set_state(
             state, icell, self._default_state)
 
+    def set_field(self, var, values):
+        """
+        Replaces a model constant with a field, containing a value for each
+        cell.
+
+        The argument ``var`` must specify a constant from the simulation's
+        model, and ``values`` must be a sequence of ``ncells`` floats. If a
+        field is set for a constant that other constants depend on, these will
+        also be calculated separately for each cell. If a field is added for a
+        variable already associated with a field, the old data will be
+        overwritten.
+
+        The fields are stored as arrays indexed by cell, and only constants
+        that vary between cells use per-cell storage.
+        """
+        # Check variable
+        if isinstance(var, myokit.Variable):
+            var = var.qname()
+        var = self._model.get(var)
+        if var.is_bound():
+            raise ValueError('Bound values cannot be replaced by fields.')
+        if not var.is_constant():
+            raise ValueError('Only constants can be used for fields.')
+
+        # Check values
+        try:
+            values = np.array([float(x) for x in values])
+        except (TypeError, ValueError):
+            raise ValueError(
+                'The argument `values` must be a sequence of numbers.')
+        if values.shape != (self._ncells, ):
+            raise ValueError(
+                'The argument `values` must have length ' + str(self._ncells)
+                + '.')
+
+        # Add field
+        self._fields[var.qname()] = [float(x) for x in values]
+
     def set_paced_cells(self, n=5):
         """
         Sets the number of cells that will receive a stimulus from the pacing
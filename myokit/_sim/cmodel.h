@@ -30,6 +30,12 @@ import myokit
 # Tab
 tab = '    '
 
+def print_equations(eqs):
+    """ Prints a list of equations, using a single call to print. """
+    lines = [tab + w.eq(eq) + ';' for eq in eqs]
+    if lines:
+        print('\n'.join(lines))
+
 ?>/*
 This file defines a plain C Model object and interface.
 
@@ -506,8 +512,7 @@ Model_EvaluateLiteralDerivedVariables(Model model)
     if (model == NULL) return Model_INVALID_MODEL;
 
 <?
-for eq in literal_derived.values():
-    print(tab + w.eq(eq) + ';')
+print_equations(literal_derived.values())
 ?>
     return Model_OK;
 }
@@ -529,8 +534,7 @@ Model_EvaluateParameterDerivedVariables(Model model)
     if (model == NULL) return Model_INVALID_MODEL;
 
 <?
-for eq in parameter_derived.values():
-    print(tab + w.eq(eq) + ';')
+print_equations(parameter_derived.values())
 ?>
     return Model_OK;
 }
@@ -810,19 +814,11 @@ Model_EvaluateDerivatives(Model model)
 
 <?
 for label, eqs in equations.items():
-    need_label = True
-    for eq in eqs.equations(const=False, bound=False):
-        var = eq.lhs.var()
-
-        # Print label for component
-        if need_label:
-            print(tab + '/* ' + label + ' */')
-            need_label = False
-
-        # Print equation
-        print(tab + w.eq(eq) + ';')
-
-    if not need_label:
+    eqs = list(eqs.equations(const=False, bound=False))
+    if eqs:
+        # Print label for component, followed by its equations
+        print(tab + '/* ' + label + ' */')
+        print_equations(eqs)
         print(tab)
 ?>
     #ifdef Model_CACHING
@@ -903,10 +899,9 @@ Model_EvaluateSensitivityOutputs(Model model)
 
 <?
 for eqs in s_output_equations:
-    for i, eq in enumerate(eqs):
-        if i == 0:
-            print(tab + '/* Sensitivity w.r.t. ' + eq.lhs.independent_expression().code() + ' */')
-        print(tab + w.eq(eq) + ';')
+    if eqs:
+        print(tab + '/* Sensitivity w.r.t. ' + eqs[0].lhs.independent_expression().code() + ' */')
+        print_equations(eqs)
     print('')
 ?>
     #ifdef Model_CACHING
@@ -1260,8 +1255,7 @@ for i, expr in enumerate(s_independents):
 
     /* Literal values */
 <?
-for eq in literals.values():
-    print(tab + w.eq(eq) + ';')
+print_equations(literals.values())
 ?>
     flag = Model_EvaluateLiteralDerivedVariables(model);
     if (flag != Model_OK) {
@@ -1271,8 +1265,7 @@ for eq in literals.values():
 
     /* Parameter values */
 <?
-for eq in parameters.values():
-    print(tab + w.eq(eq) + ';')
+print_equations(parameters.values())
 ?>
     flag = Model_EvaluateParameterDerivedVariables(model);
     if (flag != Model_OK) {
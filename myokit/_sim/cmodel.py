@@ -315,8 +315,19 @@ class CModel:
         """
         Creates a variable/expression naming function and an expression writer.
         """
+        # Names returned by v(), which is called for every reference in every
+        # equation, and several times more for every variable.
+        names = {}
 
         def v(var):
+            """ Returns the name for ``var`` created by ``_v()``. """
+            try:
+                return names[var]
+            except KeyError:
+                name = names[var] = _v(var)
+                return name
+
+        def _v(var):
             """
             Returns a readable variable name to use in code (which will be
             mapped to a model entry by a C define).
@@ -0,0 +1,398 @@
+<?
+# csvio.c
+#
+# A pype template for a model-independent module that parses and formats the
+# numerical part of CSV files, for use by myokit.DataLog.
+#
+# Required variables
+# -----------------------------------------------------------------------------
+# module_name A module name
+# -----------------------------------------------------------------------------
+#
+# This file is part of Myokit.
+# See http://myokit.org for copyright, sharing, and licensing details.
+#
+?>
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <locale.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef __APPLE__
+#include <xlocale.h>
+#endif
+
+/*
+ * Parsing and formatting is done in the "C" locale, so that the decimal
+ * separator is always a point, regardless of the locale of the process. The
+ * locale is switched per thread, so that other threads are unaffected.
+ */
+#ifdef _WIN32
+
+typedef int CSV_Locale;
+
+static void csv_locale_init(void) {}
+
+static CSV_Locale
+csv_locale_enter(void)
+{
+    CSV_Locale old = _configthreadlocale(_ENABLE_PER_THREAD_LOCALE);
+    setlocale(LC_NUMERIC, "C");
+    return old;
+}
+
+static void
+csv_locale_exit(CSV_Locale old)
+{
+    _configthreadlocale(old);
+}
+
+#else
+
+typedef locale_t CSV_Locale;
+static locale_t c_locale = (locale_t)0;
+
+static void
+csv_locale_init(void)
+{
+    /* If this fails, c_locale stays 0 and uselocale() does nothing */
+    c_locale = newlocale(LC_ALL_MASK, "C", (locale_t)0);
+}
+
+static CSV_Locale
+csv_locale_enter(void)
+{
+    return uselocale(c_locale);
+}
+
+static void
+csv_locale_exit(CSV_Locale old)
+{
+    uselocale(old);
+}
+
+#endif
+
+/* Error codes returned by parse */
+#define CSV_OK 0
+#define CSV_WRONG_COLUMNS 1
+#define CSV_NOT_A_FLOAT 2
+#define CSV_TOO_MANY_ROWS 3
+
+/* ASCII whitespace, as stripped by Python's str.lstrip() and float() */
+#define IS_SPACE(c) ((c) == ' ' || (c) == '\t' || (c) == '\n' || (c) == '\r' || (c) == '\f' || (c) == '\v')
+
+/* End of line characters (universal newlines) */
+#define IS_EOL(c) ((c) == '\n' || (c) == '\r')
+
+/*
+ * Parses a single value from the field [a, b), which must be non-empty.
+ * Returns 0 if successful, -1 if not.
+ */
+static int
+parse_value(const char* a, const char* b, double* value)
+{
+    char* end;
+    const char* c;
+
+    /* Strip whitespace, as Python's float() does */
+    while (a < b && IS_SPACE(*a)) a++;
+    while (b > a && IS_SPACE(*(b - 1))) b--;
+    if (a == b) return -1;
+
+    /* Reject hexadecimal numbers and "nan(...)", which Python doesn't read */
+    for (c = a; c < b; c++) {
+        if (*c == 'x' || *c == 'X' || *c == '(') return -1;
+    }
+
+    /* Every field ends in a delimiter, end-of-line or null, so strtod will
+       never read beyond b (a number can not contain these characters). */
+    *value = strtod(a, &end);
+    return (end == b) ? 0 : -1;
+}
+
+/*
+ * Parses the data rows of a CSV file, following the same rules as the Python
+ * implementation in myokit._sim.csvio.parse_rows(), but accepting only ASCII
+ * whitespace and numbers in the format read by strtod.
+ *
+ * Arguments:
+ *  data  : A bytes object containing one or more complete lines
+ *  start : The position in data to start parsing at
+ *  ncols : The expected number of columns
+ *  out   : A writable buffer of doubles, with space for ncols * cap values
+ *  cap   : The maximum number of rows in the data. Values for column i are
+ *          stored at out[i * cap + row].
+ *  nrows : The number of rows already stored in out
+ *
+ * Returns a tuple (nrows, error, found, a, b), where nrows is the total number
+ * of rows stored, error is an error code (0 if no errors occurred), and found
+ * is the number of columns found in the last row. If an error occurred, it
+ * occurred in the row with index nrows, which is stored at data[a:b].
+ *
+ * The GIL is released while parsing, so that multiple chunks of data can be
+ * parsed in parallel using Python threads.
+ */
+static PyObject*
+parse_rows(PyObject *self, PyObject *args)
+{
+    const char *data, *p, *end, *line, *eol, *f;
+    Py_ssize_t size, start, ncols, cap, nrows, found, i, ea, eb;
+    Py_buffer out;
+    double* x;
+    int error;
+    CSV_Locale old;
+
+    if (!PyArg_ParseTuple(args, "y#nnw*nn", &data, &size, &start, &ncols, &out, &cap, &nrows)) {
+        return 0;
+    }
+    if (ncols < 1 || cap < 0 || out.len < (Py_ssize_t)sizeof(double) * ncols * cap) {
+        PyBuffer_Release(&out);
+        PyErr_SetString(PyExc_ValueError, "Output buffer too small.");
+        return 0;
+    }
+    if (start < 0 || start > size || nrows < 0 || nrows > cap) {
+        PyBuffer_Release(&out);
+        PyErr_SetString(PyExc_ValueError, "Invalid start position or number of rows.");
+        return 0;
+    }
+    x = (double*)out.buf;
+    error = CSV_OK;
+    found = ncols;
+    ea = eb = size;
+
+    Py_BEGIN_ALLOW_THREADS
+    old = csv_locale_enter();
+
+    p = data + start;
+    end = data + size;
+    while (p < end) {
+        /* Find next line, strip leading whitespace */
+        ea = p - data;
+        line = p;
+        while (line < end && IS_SPACE(*line)) line++;
+        eol = line;
+        while (eol < end && !IS_EOL(*eol)) eol++;
+        p = eol;
+        eb = p - data;
+
+        /* Strip trailing ' \r\n\f;' */
+        while (eol > line && (*(eol - 1) == ' ' || *(eol - 1) == '\f' || *(eol - 1) == ';')) eol--;
+
+        /* Skip blank lines and comments */
+        if (line == eol || *line == '#') continue;
+
+        /* Check number of columns */
+        found = 1;
+        for (f = line; f < eol; f++) {
+            if (*f == ',') found++;
+        }
+        if (found != ncols) {
+            error = CSV_WRONG_COLUMNS;
+            break;
+        }
+        if (nrows >= cap) {
+            /* Can't happen if cap is at least the number of lines */
+            error = CSV_TOO_MANY_ROWS;
+            break;
+        }
+
+        /* Parse values */
+        f = line;
+        for (i = 0; i < ncols; i++) {
+            const char* g = f;
+            while (g < eol && *g != ',') g++;
+            if (parse_value(f, g, x + i * cap + nrows)) {
+                error = CSV_NOT_A_FLOAT;
+                break;
+            }
+            f = g + 1;
+        }
+        if (error != CSV_OK) break;
+        nrows++;
+    }
+
+    csv_locale_exit(old);
+    Py_END_ALLOW_THREADS
+
+    PyBuffer_Release(&out);
+    return Py_BuildValue("(ninnn)", nrows, error, found, ea, eb);
+}
+
+/* Formatting modes */
+#define CSV_REPR 0
+#define CSV_DOUBLE 1
+#define CSV_SINGLE 2
+
+/* Maximum number of characters needed to format a single value */
+#define CSV_MAX_VALUE 32
+
+/*
+ * Formats a single value using snprintf, in the same way as Python formats
+ * using '{:< 1.17e}' (double) or '{:< 1.9e}' (single).
+ *
+ * Returns the number of characters written.
+ */
+static int
+format_value(char* buf, double x, int mode)
+{
+    if (isnan(x)) {
+        /* Python ignores the sign of nan */
+        memcpy(buf, " nan", 4);
+        return 4;
+    }
+    return snprintf(buf, CSV_MAX_VALUE, (mode == CSV_DOUBLE) ? "% .17e" : "% .9e", x);
+}
+
+/*
+ * Formats rows a to b (exclusive) of a list of columns as CSV text, and
+ * returns the result as a bytes object.
+ *
+ * Arguments:
+ *  columns   : A tuple of contiguous buffers of doubles
+ *  a, b      : The rows to format
+ *  mode      : 0 to use Python's repr() (the shortest string that converts
+ *              back to the same number), 1 for double precision scientific
+ *              notation, 2 for single precision.
+ *  delimiter : A bytes object containing the delimiter
+ *  eol       : A bytes object containing the line ending
+ *
+ * In modes 1 and 2 the GIL is released while formatting, so that multiple
+ * blocks of rows can be formatted in parallel using Python threads. In mode 0,
+ * Python's own float formatting is used, which requires the GIL.
+ */
+static PyObject*
+format_rows(PyObject *self, PyObject *args)
+{
+    PyObject *columns, *result;
+    Py_ssize_t a, b, ncols, i, j, k, n;
+    const char *delim, *eol;
+    Py_ssize_t ndelim, neol;
+    int mode;
+    Py_buffer* bufs;
+    char *text, *s, *r;
+    CSV_Locale old;
+
+    if (!PyArg_ParseTuple(args, "O!nniy#y#", &PyTuple_Type, &columns, &a, &b, &mode, &delim, &ndelim, &eol, &neol)) {
+        return 0;
+    }
+    if (mode < CSV_REPR || mode > CSV_SINGLE) {
+        PyErr_SetString(PyExc_ValueError, "Unknown formatting mode.");
+        return 0;
+    }
+    ncols = PyTuple_Size(columns);
+    if (a < 0 || b < a) {
+        PyErr_SetString(PyExc_ValueError, "Invalid row range.");
+        return 0;
+    }
+
+    /* Get buffers */
+    bufs = (Py_buffer*)PyMem_Malloc((size_t)(ncols > 0 ? ncols : 1) * sizeof(Py_buffer));
+    if (bufs == NULL) return PyErr_NoMemory();
+    for (i = 0; i < ncols; i++) {
+        if (PyObject_GetBuffer(PyTuple_GetItem(columns, i), bufs + i, PyBUF_C_CONTIGUOUS) != 0) {
+            for (j = 0; j < i; j++) PyBuffer_Release(bufs + j);
+            PyMem_Free(bufs);
+            return 0;
+        }
+        if (bufs[i].len < b * (Py_ssize_t)sizeof(double)) {
+            for (j = 0; j <= i; j++) PyBuffer_Release(bufs + j);
+            PyMem_Free(bufs);
+            PyErr_SetString(PyExc_ValueError, "Column buffer too small.");
+            return 0;
+        }
+    }
+
+    /* Allocate text buffer */
+    n = (b - a) * (ncols * (CSV_MAX_VALUE + ndelim) + neol);
+    text = (char*)PyMem_RawMalloc((size_t)(n > 0 ? n : 1));
+    if (text == NULL) {
+        for (i = 0; i < ncols; i++) PyBuffer_Release(bufs + i);
+        PyMem_Free(bufs);
+        return PyErr_NoMemory();
+    }
+
+    s = text;
+    if (mode == CSV_REPR) {
+        for (k = a; k < b; k++) {
+            for (i = 0; i < ncols; i++) {
+                if (i > 0) { memcpy(s, delim, ndelim); s += ndelim; }
+                r = PyOS_double_to_string(((double*)bufs[i].buf)[k], 'r', 0, Py_DTSF_ADD_DOT_0, NULL);
+                if (r == NULL) {
+                    PyMem_RawFree(text);
+                    for (j = 0; j < ncols; j++) PyBuffer_Release(bufs + j);
+                    PyMem_Free(bufs);
+                    return 0;
+                }
+                j = (Py_ssize_t)strlen(r);
+                memcpy(s, r, j);
+                s += j;
+                PyMem_Free(r);
+            }
+            memcpy(s, eol, neol);
+            s += neol;
+        }
+    } else {
+        Py_BEGIN_ALLOW_THREADS
+        old = csv_locale_enter();
+        for (k = a; k < b; k++) {
+            for (i = 0; i < ncols; i++) {
+                if (i > 0) { memcpy(s, delim, ndelim); s += ndelim; }
+                s += format_value(s, ((double*)bufs[i].buf)[k], mode);
+            }
+            memcpy(s, eol, neol);
+            s += neol;
+        }
+        csv_locale_exit(old);
+        Py_END_ALLOW_THREADS
+    }
+
+    result = PyBytes_FromStringAndSize(text, s - text);
+    PyMem_RawFree(text);
+    for (i = 0; i < ncols; i++) PyBuffer_Release(bufs + i);
+    PyMem_Free(bufs);
+    return result;
+}
+
+/*
+ * Methods in this module
+ */
+static PyMethodDef SimMethods[] = {
+    {"parse_rows", parse_rows, METH_VARARGS, "Parse rows of CSV data."},
+    {"format_rows", format_rows, METH_VARARGS, "Format rows of data as CSV."},
+    {NULL},
+};
+
+/*
+ * Module definition
+ */
+#if PY_MAJOR_VERSION >= 3
+
+    static struct PyModuleDef moduledef = {
+        PyModuleDef_HEAD_INIT,
+        "<?= module_name ?>",       /* m_name */
+        "Generated CSV module",     /* m_doc */
+        -1,                         /* m_size */
+        SimMethods,                 /* m_methods */
+        NULL,                       /* m_reload */
+        NULL,                       /* m_traverse */
+        NULL,                       /* m_clear */
+        NULL,                       /* m_free */
+    };
+
+    PyMODINIT_FUNC PyInit_<?=module_name?>(void) {
+        csv_locale_init();
+        return PyModule_Create(&moduledef);
+    }
+
+#else
+
+    PyMODINIT_FUNC
+    init<?=module_name?>(void) {
+        csv_locale_init();
+        (void) Py_InitModule("<?= module_name ?>", SimMethods);
+    }
+
+#endif
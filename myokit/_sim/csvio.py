@@ -0,0 +1,169 @@
+#
+# Native CSV parsing and formatting
+#
+# This file is part of Myokit.
+# See http://myokit.org for copyright, sharing, and licensing details.
+#
+import array
+import os
+import re
+
+import numpy as np
+
+import myokit
+
+# Path to C Source for the CSV module
+SOURCE_FILE = 'csvio.c'
+
+# Error codes returned by parse_rows
+CSV_OK = 0
+CSV_WRONG_COLUMNS = 1
+CSV_NOT_A_FLOAT = 2
+
+# Formatting modes
+CSV_REPR = 0
+CSV_DOUBLE = 1
+CSV_SINGLE = 2
+
+
+class NativeCSV(myokit.CModule):
+    """
+    Parses and formats the numerical part of CSV files for
+    :meth:`myokit.DataLog.load_csv()` and :meth:`myokit.DataLog.save_csv()`.
+
+    The module does not depend on any model, so it is compiled only once and
+    then shared. If compilation fails, the methods of this class return
+    ``None`` and callers should fall back to a Python implementation.
+    """
+    # Unique id for this object
+    _index = 0
+
+    # Cached back-end object if compiled, False if compilation failed
+    _instance = None
+
+    # Cached compilation error messages
+    _message = None
+
+    def __init__(self):
+        super().__init__()
+        # Create and cache back-end
+        NativeCSV._index += 1
+
+        # Define libraries
+        libd = list()
+        incd = list()
+        incd.append(myokit.DIR_CFUNC)
+        libs = []
+
+        # Create back-end
+        mname = 'myokit_csvio_' + str(NativeCSV._index)
+        mname += '_' + str(myokit.pid_hash())
+        fname = os.path.join(myokit.DIR_CFUNC, SOURCE_FILE)
+        args = {'module_name': mname}
+        try:
+            NativeCSV._instance = self._compile(
+                mname, fname, args, libs, libd, incd)
+        except myokit.CompilationError as e:  # pragma: no cover
+            NativeCSV._instance = False
+            NativeCSV._message = str(e)
+
+    @staticmethod
+    def _get_instance():
+        """
+        Returns a cached back-end, creates and returns a new back-end, or
+        returns ``None`` if the back-end could not be compiled.
+        """
+        if NativeCSV._instance is None:
+            NativeCSV()
+        if NativeCSV._instance is False:  # pragma: no cover
+            return None
+        return NativeCSV._instance
+
+    @staticmethod
+    def parse(data, ncols):
+        """
+        Parses the CSV rows in the bytes object ``data``, which must contain
+        only complete lines with ``ncols`` comma-separated values each. Blank
+        lines and lines starting with ``#`` are skipped.
+
+        Returns a tuple ``(values, error, found)``, where ``values`` is a numpy
+        array of shape ``(ncols, nrows)`` containing the values parsed before
+        any error occurred, ``error`` is one of ``CSV_OK``,
+        ``CSV_WRONG_COLUMNS`` or ``CSV_NOT_A_FLOAT``, and ``found`` is the
+        number of columns in the last row read.
+
+        The native parser only handles ASCII whitespace and numbers in the
+        format read by C's ``strtod``. Rows it can't parse are passed to
+        :meth:`parse_rows`, so that the same rows are accepted as in Python
+        (including e.g. ``1_000``, or numbers surrounded by non-ASCII
+        whitespace).
+
+        Returns ``None`` if the native back-end is not available.
+        """
+        mod = NativeCSV._get_instance()
+        if mod is None:  # pragma: no cover
+            return None
+        cap = 1 + data.count(b'\n') + data.count(b'\r')
+        values = np.empty((ncols, cap))
+        nrows = pos = 0
+        while True:
+            nrows, error, found, a, pos = mod.parse_rows(
+                data, pos, ncols, values, cap, nrows)
+            if error == CSV_OK:
+                break
+            row, error, found = parse_rows(data[a:pos], ncols)
+            if error != CSV_OK:
+                break
+            if len(row[0]):
+                values[:, nrows] = [x[0] for x in row]
+                nrows += 1
+        return values[:, :nrows], error, found
+
+    @staticmethod
+    def format(columns, a, b, mode, delimiter, eol):
+        """
+        Formats rows ``a`` to ``b`` (exclusive) of the given ``columns``, which
+        must be contiguous numpy arrays of doubles, as CSV text.
+
+        Values are separated by the bytes ``delimiter`` and rows are ended by
+        the bytes ``eol``. The ``mode`` determines the number format, and can
+        be ``CSV_REPR`` (Python's ``repr``), ``CSV_DOUBLE`` or ``CSV_SINGLE``
+        (the formats ``myokit.SFDOUBLE`` and ``myokit.SFSINGLE``).
+
+        Returns a bytes object, or ``None`` if the native back-end is not
+        available.
+        """
+        mod = NativeCSV._get_instance()
+        if mod is None:  # pragma: no cover
+            return None
+        return mod.format_rows(tuple(columns), a, b, mode, delimiter, eol)
+
+
+def parse_rows(data, ncols):
+    """
+    Python version of :meth:`NativeCSV.parse`, used for rows the native module
+    can't parse, or if the native module is not available.
+
+    Returns a tuple ``(values, error, found)``, where ``values`` is a list of
+    ``ncols`` arrays.
+    """
+    values = [array.array('d') for i in range(ncols)]
+    for row in re.split('\r\n|\r|\n', data.decode('utf-8')):
+        # Strip leading and/or trailing whitespace
+        row = row.lstrip().rstrip(' \r\n\f;')
+
+        # Skip blank lines and lines commented with #
+        if row == '' or row[:1] == '#':
+            continue
+
+        # Split row into cells
+        row = row.split(',')
+        if len(row) != ncols:
+            return values, CSV_WRONG_COLUMNS, len(row)
+        try:
+            row = [float(v) for v in row]
+        except ValueError:
+            return values, CSV_NOT_A_FLOAT, ncols
+        for x, v in zip(values, row):
+            x.append(v)
+    return values, CSV_OK, ncols
@@ -1995,6 +1995,188 @@ error:
     }
 }
 
+/*
+ * Evaluates the state derivatives at a batch of points, given as arrays of
+ * doubles, without creating Python objects for each point.
+ */
+PyObject*
+sim_evaluate_derivatives_batch(PyObject *self, PyObject *args)
+{
+    /* Declare variables here for C89 compatibility */
+    int i;
+    int success;
+    int n_bound;
+    int n_pacing;
+    Py_ssize_t k, n_points;
+    Py_buffer bound_in;
+    Py_buffer states_in;
+    Py_buffer deriv_out;
+    PyObject *literals;
+    PyObject *parameters;
+    PyObject *val;
+    const double *bound;
+    const double *x;
+    double *dx;
+    realtype *pacing_values;
+    realtype *state;
+    Model model;
+    Model_Flag flag_model;
+
+    /* Check input arguments     0123456789ABCDEF*/
+    if (!PyArg_ParseTuple(args, "iy*OOy*w*",
+            &n_pacing,          /* 0. Int: number of pacing values */
+            &bound_in,          /* 1. Buffer: time, realtime, evaluations and
+                                      pacing values, for each point */
+            &literals,          /* 2. List: literal constant values */
+            &parameters,        /* 3. List: parameter values */
+            &states_in,         /* 4. Buffer: state, for each point */
+            &deriv_out          /* 5. Buffer: store derivatives here */
+    )) {
+        PyErr_SetString(PyExc_Exception, "Incorrect input arguments in sim_evaluate_derivatives_batch.");
+        /* Nothing allocated yet, no pyobjects _created_, return directly */
+        return 0;
+    }
+
+    /* From this point on, no more direct returning: use goto error */
+    success = 0;
+    model = NULL;
+    pacing_values = NULL;
+    state = NULL;
+
+    /* Check lists are sequences */
+    if (!PyList_Check(literals)) {
+        PyErr_SetString(PyExc_TypeError, "Literals argument must be a list.");
+        goto error;
+    }
+    if (!PyList_Check(parameters)) {
+        PyErr_SetString(PyExc_TypeError, "Parameters argument must be a list.");
+        goto error;
+    }
+
+    /* Create model */
+    model = Model_Create(&flag_model);
+    if (flag_model != Model_OK) {
+        Model_SetPyErr(flag_model);
+        goto error;
+    }
+
+    /* Check list sizes */
+    if (PyList_Size(literals) != model->n_literals) {
+        PyErr_Format(PyExc_ValueError, "Expected %d literal values, got %zd.", model->n_literals, PyList_Size(literals));
+        goto error;
+    }
+    if (PyList_Size(parameters) != model->n_parameters) {
+        PyErr_Format(PyExc_ValueError, "Expected %d parameter values, got %zd.", model->n_parameters, PyList_Size(parameters));
+        goto error;
+    }
+
+    /* Check buffer sizes */
+    n_bound = 3 + n_pacing;
+    n_points = states_in.len / (Py_ssize_t)(sizeof(double) * (model->n_states > 0 ? model->n_states : 1));
+    if (n_pacing < 0
+            || states_in.len != n_points * model->n_states * (Py_ssize_t)sizeof(double)
+            || bound_in.len != n_points * n_bound * (Py_ssize_t)sizeof(double)
+            || deriv_out.len != states_in.len) {
+        PyErr_SetString(PyExc_ValueError, "Incorrect buffer sizes in sim_evaluate_derivatives_batch.");
+        goto error;
+    }
+
+    /* Set up pacing (but without protocols) */
+    flag_model = Model_SetupPacing(model, n_pacing);
+    if (flag_model != Model_OK) {
+        Model_SetPyErr(flag_model);
+        goto error;
+    }
+
+    /* Set literal values */
+    for (i=0; i<model->n_literals; i++) {
+        val = PyList_GetItem(literals, i);    /* Don't decref */
+        if (!PyFloat_Check(val)) {
+            PyErr_Format(PyExc_TypeError, "Item %d in literal vector is not a float.", i);
+            goto error;
+        }
+        model->literals[i] = PyFloat_AsDouble(val);
+    }
+
+    /* Evaluate literal-derived variables */
+    Model_EvaluateLiteralDerivedVariables(model);
+
+    /* Set parameter values */
+    for (i=0; i<model->n_parameters; i++) {
+        val = PyList_GetItem(parameters, i);    /* Don't decref */
+        if (!PyFloat_Check(val)) {
+            PyErr_Format(PyExc_TypeError, "Item %d in parameter vector is not a float.", i);
+            goto error;
+        }
+        model->parameters[i] = PyFloat_AsDouble(val);
+    }
+
+    /* Evaluate parameter-derived variables */
+    Model_EvaluateParameterDerivedVariables(model);
+
+    /* Allocate space for a single point */
+    pacing_values = (realtype*)malloc((size_t)(n_pacing > 0 ? n_pacing : 1) * sizeof(realtype));
+    state = (realtype*)malloc((size_t)(model->n_states > 0 ? model->n_states : 1) * sizeof(realtype));
+    if (pacing_values == NULL || state == NULL) {
+        PyErr_SetString(PyExc_Exception, "Unable to allocate space to store pacing values and state.");
+        goto error;
+    }
+
+    /* Evaluate derivatives at every point, without holding the GIL. Errors
+       are raised after the GIL has been reacquired. */
+    flag_model = Model_OK;
+    bound = (const double*)bound_in.buf;
+    x = (const double*)states_in.buf;
+    dx = (double*)deriv_out.buf;
+    Py_BEGIN_ALLOW_THREADS
+    for (k=0; k<n_points; k++) {
+        for (i=0; i<n_pacing; i++) {
+            pacing_values[i] = (realtype)bound[3 + i];
+        }
+        Model_SetBoundVariables(
+            model,
+            (realtype)bound[0],
+            pacing_values,
+            (realtype)bound[1],
+            (realtype)bound[2]);
+        for (i=0; i<model->n_states; i++) {
+            state[i] = (realtype)x[i];
+        }
+        Model_SetStates(model, state);
+        flag_model = Model_EvaluateDerivatives(model);
+        if (flag_model != Model_OK) break;
+        for (i=0; i<model->n_states; i++) {
+            dx[i] = (double)model->derivatives[i];
+        }
+        bound += n_bound;
+        x += model->n_states;
+        dx += model->n_states;
+    }
+    Py_END_ALLOW_THREADS
+    if (flag_model != Model_OK) {
+        Model_SetPyErr(flag_model);
+        goto error;
+    }
+
+    /* Finished succesfully, free memory and return */
+    success = 1;
+error:
+    /* Free model space */
+    Model_Destroy(model);
+    free(pacing_values);
+    free(state);
+    PyBuffer_Release(&bound_in);
+    PyBuffer_Release(&states_in);
+    PyBuffer_Release(&deriv_out);
+
+    /* Return */
+    if (success) {
+        Py_RETURN_NONE;
+    } else {
+        return 0;
+    }
+}
+
 /*
  * Change the tolerance settings
  */
@@ -2070,6 +2252,7 @@ PyMethodDef SimMethods[] = {
     {"sim_step", sim_step, METH_VARARGS, "Perform the next step in the simulation."},
     {"sim_clean", py_sim_clean, METH_VARARGS, "Clean up after an aborted simulation."},
     {"evaluate_derivatives", sim_evaluate_derivatives, METH_VARARGS, "Evaluate the state derivatives."},
+    {"evaluate_derivatives_batch", sim_evaluate_derivatives_batch, METH_VARARGS, "Evaluate the state derivatives at a batch of points."},
     {"set_tolerance", sim_set_tolerance, METH_VARARGS, "Set the absolute and relative solver tolerance."},
     {"set_max_step_size", sim_set_max_step_size, METH_VARARGS, "Set the maximum solver step size (0 for none)."},
     {"set_min_step_size", sim_set_min_step_size, METH_VARARGS, "Set the minimum solver step size (0 for none)."},
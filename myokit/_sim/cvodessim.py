@@ -11,6 +11,8 @@ import tempfile
 
 from collections import OrderedDict
 
+import numpy as np
+
 import myokit
 
 # Location of C template
@@ -505,6 +507,57 @@ class Simulation(myokit.CModule):
         )
         return dy
 
+    def evaluate_derivatives_batch(self, states, inputs=None):
+        """
+        Evaluates and returns the state derivatives for a whole array of
+        ``states`` at once, using the compiled model.
+
+        The ``states`` must be given as an array of shape
+        ``(n_points, n_states)``. An optional dict ``inputs`` can be used to
+        set the values of time and other inputs (e.g. pacing values), either
+        to a single value for all points, or to an array of ``n_points``
+        values. As in :meth:`evaluate_derivatives()`, inputs that are not set
+        are 0, and any variables changed with ``set_constant`` use their new
+        values.
+
+        Returns an array of shape ``(n_points, n_states)``.
+        """
+        # Get states
+        states = np.ascontiguousarray(states, dtype=float)
+        if states.ndim != 2 or states.shape[1] != len(self._state):
+            raise ValueError(
+                'States must be given as an array of shape (n_points, '
+                + str(len(self._state)) + ').')
+        n = len(states)
+
+        # Get inputs: time, realtime, evaluations, and pacing values
+        bound = np.zeros((n, 3 + len(self._pacing_labels)))
+        if inputs is not None:
+            columns = ['time', 'realtime', 'evaluations']
+            columns += self._pacing_labels
+            for k, v in inputs.items():
+                try:
+                    ki = columns.index(k)
+                except ValueError:
+                    raise ValueError(f'Unknown binding or pacing label `{k}`.')
+                bound[:, ki] = v
+
+        # Literals and parameters: Can be changed with set_constant
+        literals = list(self._literals.values())
+        parameters = list(self._parameters.values())
+
+        # Evaluate and return
+        derivatives = np.empty(states.shape)
+        self._sim.evaluate_derivatives_batch(
+            len(self._pacing_labels),   # 0. Number of pacing values
+            bound,                      # 1. Bound variable values
+            literals,                   # 2. Literals
+            parameters,                 # 3. Parameters
+            states,                     # 4. States
+            derivatives,                # 5. Derivatives (out)
+        )
+        return derivatives
+
     def last_number_of_evaluations(self):
         """
         Returns the number of rhs evaluations performed by the solver during
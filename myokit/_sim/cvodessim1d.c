@@ -0,0 +1,840 @@
+<?
+# cvodessim1d.c
+#
+# A pype template for a 1d cable simulation using CVODES, with an adaptive
+# step size and a banded Jacobian.
+#
+# Each cell is represented by its own CModel, and the states of all cells are
+# stored in a single CVODES state vector, with the states of each cell stored
+# contiguously. Because cells are only coupled to their nearest neighbours via
+# the membrane potential, the system Jacobian is banded with an upper and lower
+# half-bandwidth equal to the number of states per cell.
+#
+# Note: For compatibility with older Python versions on windows, we need to
+# stick to a slightly outdated C standard (i.e. C90).
+#
+# Required variables
+# -----------------------------------------------------------------------------
+# module_name     A module name
+# model_code      Code for a CModel, with pacing labels "pace" and
+#                 "diffusion_current"
+# -----------------------------------------------------------------------------
+#
+# This file is part of Myokit.
+# See http://myokit.org for copyright, sharing, and licensing details.
+#
+import myokit
+?>
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <stdio.h>
+
+#include <sundials/sundials_config.h>
+#ifndef SUNDIALS_VERSION_MAJOR
+    #define SUNDIALS_VERSION_MAJOR 2
+#endif
+#include <sundials/sundials_types.h>
+#if SUNDIALS_VERSION_MAJOR >= 7
+    #define realtype sunrealtype
+    #define RCONST SUN_RCONST
+#endif
+#include <nvector/nvector_serial.h>
+#include <cvodes/cvodes.h>
+#if SUNDIALS_VERSION_MAJOR >= 3
+    #include <sunmatrix/sunmatrix_band.h>
+    #include <sunlinsol/sunlinsol_band.h>
+#else
+    #include <cvodes/cvodes_band.h>
+#endif
+#if SUNDIALS_VERSION_MAJOR < 6
+    #include <cvodes/cvodes_direct.h>
+#endif
+
+<?
+if myokit.DEBUG_SM:
+    print('// Show debug output')
+    print('#ifndef MYOKIT_DEBUG_MESSAGES')
+    print('#define MYOKIT_DEBUG_MESSAGES')
+    print('#endif')
+?>
+
+#include "pacing.h"
+
+<?= model_code ?>
+
+/*
+ * Check flags set by a generic sundials function, set python error.
+ *  sundials_flag: The value to check
+ *  funcname: The name of the function that returned the flag
+ */
+int
+check_sundials_flag(int flag, const char *funcname)
+{
+    if (flag < 0) {
+        PyErr_Format(PyExc_Exception, "Function %s failed with flag = %d", funcname, flag);
+        return 1;
+    }
+    return 0;
+}
+
+/*
+ * Check flags set by CVode(), set python error.
+ *  flag: The value to check
+ */
+int
+check_cvode_flag(int flag)
+{
+    if (flag < 0) {
+        switch (flag) {
+        case CV_TOO_MUCH_WORK:
+            PyErr_SetString(PyExc_Exception, "Function CVode() failed with flag CV_TOO_MUCH_WORK: The solver took mxstep internal steps but could not reach tout.");
+            break;
+        case CV_TOO_MUCH_ACC:
+            PyErr_SetString(PyExc_Exception, "Function CVode() failed with flag CV_TOO_MUCH_ACC: The solver could not satisfy the accuracy demanded by the user for some internal step.");
+            break;
+        case CV_ERR_FAILURE:
+            PyErr_SetString(PyExc_ArithmeticError, "Function CVode() failed with flag CV_ERR_FAILURE: Error test failures occurred too many times during one internal time step or minimum step size was reached.");
+            break;
+        case CV_CONV_FAILURE:
+            PyErr_SetString(PyExc_ArithmeticError, "Function CVode() failed with flag CV_CONV_FAILURE: Convergence test failures occurred too many times during one internal time step or minimum step size was reached.");
+            break;
+        default:
+            PyErr_Format(PyExc_ArithmeticError, "Function CVode() failed with flag = %d", flag);
+        }
+        return 1;
+    }
+    return 0;
+}
+
+#if SUNDIALS_VERSION_MAJOR >= 7
+/*
+ * Check sundials error code (Sundials 7 and above)
+ *  sunerr   : The SunErroCode to check
+ *  funcname : The name of the function that returned the flag
+ */
+int
+check_sundials_error(SUNErrCode code, const char *funcname)
+{
+    const char* msg;
+    if (code) {
+        msg = SUNGetErrMsg(code);
+        PyErr_Format(PyExc_Exception, "%s() failed with message = %s", funcname, msg);
+        return 1;
+    }
+    return 0;
+}
+#endif
+
+/*
+ * Error and warning message handler for CVODES.
+ * Error messages are already set via check_cvode_flag & co, so this method
+ * suppresses error messages.
+ * Warnings are passed to Python's warning system, where they can be
+ * caught or suppressed using the warnings module.
+ */
+#if SUNDIALS_VERSION_MAJOR >= 7
+void
+ErrorHandler(int line, const char* function, const char* file, const char* msg,
+             SUNErrCode error_code, void* err_user_data, SUNContext context)
+{
+    if (error_code) {
+        PyErr_WarnFormat(PyExc_RuntimeWarning, 1, "CVODES: %s", msg);
+    }
+}
+#else
+void
+ErrorHandler(int error_code, const char *module, const char *function,
+             char *msg, void *eh_data)
+{
+    if (error_code > 0) {
+        PyErr_WarnFormat(PyExc_RuntimeWarning, 1, "CVODES: %s", msg);
+    }
+}
+#endif
+
+/*
+ * Initialisation status.
+ * Proper sequence is init(), repeated step() calls till finished, then clean.
+ */
+int initialized = 0;
+
+/*
+ * Cells
+ */
+int ncells;         /* The number of cells */
+int npaced;         /* The number of paced cells */
+int n_state;        /* The number of states per cell */
+int ivm;            /* The index of the membrane potential in each cell */
+double g;           /* The cell-to-cell conductance */
+Model* models;      /* One model object per cell */
+realtype* bound;    /* Pacing values (pace, diffusion current) for each cell */
+
+/*
+ * Pacing
+ */
+ESys pacing;        /* Event-based pacing system */
+PyObject* protocol; /* The protocol used to create the pacing system */
+double pace;        /* The current pacing level */
+
+/*
+ * CVODE Memory
+ */
+void *cvode_mem;                    /* The memory used by the solver */
+#if SUNDIALS_VERSION_MAJOR >= 3
+SUNMatrix sunband_matrix;           /* Band matrix for linear solves */
+SUNLinearSolver sunband_solver;     /* Linear solver object */
+#endif
+#if SUNDIALS_VERSION_MAJOR >= 6
+SUNContext sundials_context;        /* A sundials context to run in */
+#endif
+
+/*
+ * Solver settings
+ */
+double abs_tol;     /* The absolute tolerance */
+double rel_tol;     /* The relative tolerance */
+double dt_max;      /* The maximum step size (0.0 for none) */
+
+/*
+ * Solver stats
+ */
+long evaluations;   /* Number of evaluations since sim init */
+long steps;         /* Number of steps since sim init */
+
+/*
+ * State vectors
+ */
+N_Vector y;     /* The current position y */
+N_Vector z;     /* Interpolated position, used for logging */
+
+/*
+ * State communication
+ */
+PyObject* state_in;     /* List: The initial state */
+PyObject* state_out;    /* List: The final state */
+
+/*
+ * Timing
+ */
+double t;       /* Current simulation time */
+double tnext;   /* Next simulation halting point */
+double tmin;    /* The initial simulation time */
+double tmax;    /* The final simulation time */
+
+/*
+ * Logging
+ */
+PyObject* cell_logs;    /* A list with a dict of logs for each cell */
+PyObject* log_time;     /* A list to log the time in, or None */
+PyObject* log_pace;     /* A list to log the pacing level in, or None */
+double tlog;            /* Next time to log */
+double log_interval;    /* The periodic logging interval */
+unsigned long ilog;     /* Index of next logging point */
+PyObject* list_update_str;  /* The string "append" */
+
+/*
+ * Calculates the diffusion current for every cell, and then evaluates the
+ * derivatives of each cell using its own CModel.
+ *
+ * Unlike rhs(), this does not update the evaluation count, so that it can be
+ * used to update the models for logging.
+ *
+ *  realtype t      Current time
+ *  N_Vector y      The current state values
+ *  N_Vector ydot   Space to store the calculated derivatives in, or NULL
+ */
+void
+evaluate(realtype t, N_Vector y, N_Vector ydot)
+{
+    int icell, i;
+    realtype *ys, *ydots, *b;
+    realtype vm;
+
+    ys = N_VGetArrayPointer(y);
+    ydots = (ydot == NULL) ? NULL : N_VGetArrayPointer(ydot);
+
+    for (icell=0; icell<ncells; icell++) {
+
+        /* Pacing and diffusion current */
+        b = bound + 2 * icell;
+        vm = ys[icell * n_state + ivm];
+        b[0] = (icell < npaced) ? pace : 0;
+        b[1] = 0;
+        if (icell > 0) {
+            b[1] += g * (vm - ys[(icell - 1) * n_state + ivm]);
+        }
+        if (icell < ncells - 1) {
+            b[1] += g * (vm - ys[(icell + 1) * n_state + ivm]);
+        }
+
+        /* Evaluate cell model */
+        Model_SetBoundVariables(models[icell], (realtype)t, b, 0, (realtype)evaluations);
+        Model_SetStates(models[icell], ys + icell * n_state);
+        Model_EvaluateDerivatives(models[icell]);
+
+        if (ydots != NULL) {
+            for (i=0; i<n_state; i++) {
+                ydots[icell * n_state + i] = models[icell]->derivatives[i];
+            }
+        }
+    }
+}
+
+/*
+ * Right-hand-side function of the cable ODE, called by CVODES.
+ *
+ *  realtype t      Current time
+ *  N_Vector y      The current state values
+ *  N_Vector ydot   Space to store the calculated derivatives in
+ *  void* user_data Unused
+ */
+int
+rhs(realtype t, N_Vector y, N_Vector ydot, void *user_data)
+{
+    evaluations++;
+    evaluate(t, y, ydot);
+    return 0;
+}
+
+/*
+ * Logs the current state of all cells, assuming evaluate() was just called.
+ */
+int
+log_point(double tl)
+{
+    int icell;
+    Model_Flag flag_model;
+    PyObject *val, *ret;
+
+    if (log_time != Py_None) {
+        val = PyFloat_FromDouble(tl);
+        ret = PyObject_CallMethodObjArgs(log_time, list_update_str, val, NULL);
+        Py_DECREF(val);
+        if (ret == NULL) return 1;
+        Py_DECREF(ret);
+    }
+    if (log_pace != Py_None) {
+        val = PyFloat_FromDouble(pace);
+        ret = PyObject_CallMethodObjArgs(log_pace, list_update_str, val, NULL);
+        Py_DECREF(val);
+        if (ret == NULL) return 1;
+        Py_DECREF(ret);
+    }
+    for (icell=0; icell<ncells; icell++) {
+        flag_model = Model_Log(models[icell]);
+        if (flag_model != Model_OK) { Model_SetPyErr(flag_model); return 1; }
+    }
+    return 0;
+}
+
+/*
+ * Cleans up after a simulation
+ */
+PyObject*
+sim_clean(void)
+{
+    int icell;
+
+    if (initialized) {
+        #ifdef MYOKIT_DEBUG_MESSAGES
+        printf("CM Cleaning up.\n");
+        #endif
+
+        /* CVode arrays */
+        if (y != NULL) { N_VDestroy_Serial(y); y = NULL; }
+        if (z != NULL) { N_VDestroy_Serial(z); z = NULL; }
+
+        /* Sundials objects */
+        CVodeFree(&cvode_mem); cvode_mem = NULL;
+        #if SUNDIALS_VERSION_MAJOR >= 3
+        SUNLinSolFree(sunband_solver); sunband_solver = NULL;
+        SUNMatDestroy(sunband_matrix); sunband_matrix = NULL;
+        #endif
+        #if SUNDIALS_VERSION_MAJOR >= 6
+        SUNContext_Free(&sundials_context); sundials_context = NULL;
+        #endif
+
+        /* Pacing system */
+        ESys_Destroy(pacing); pacing = NULL;
+
+        /* Cell models */
+        if (models != NULL) {
+            for (icell=0; icell<ncells; icell++) {
+                Model_Destroy(models[icell]);
+            }
+            free(models); models = NULL;
+        }
+        free(bound); bound = NULL;
+
+        /* Logging */
+        Py_XDECREF(list_update_str); list_update_str = NULL;
+
+        /* Deinitialisation complete */
+        initialized = 0;
+    }
+
+    /* Return 0, allowing the construct
+        PyErr_SetString(PyExc_Exception, "Oh noes!");
+        return sim_clean()
+       to terminate a python function. */
+    return 0;
+}
+
+/*
+ * Version of sim_clean to be called from Python
+ */
+PyObject*
+py_sim_clean(PyObject *self, PyObject *args)
+{
+    sim_clean();
+    Py_RETURN_NONE;
+}
+
+/*
+ * Initialize a run.
+ * Called by the Python code's run(), followed by several calls to sim_step().
+ */
+PyObject*
+sim_init(PyObject *self, PyObject *args)
+{
+    int flag_cvode;
+    Model_Flag flag_model;
+    ESys_Flag flag_pacing;
+    #if SUNDIALS_VERSION_MAJOR >= 7
+    SUNErrCode sunerr;
+    #endif
+    int icell, i, n;
+    PyObject *val;
+
+    /* Check if already initialized */
+    if (initialized) {
+        PyErr_SetString(PyExc_Exception, "Simulation already initialized.");
+        return 0;
+    }
+
+    /* Check for double precision */
+    #ifndef SUNDIALS_DOUBLE_PRECISION
+    PyErr_SetString(PyExc_Exception, "Sundials must be compiled with double precision.");
+    return 0;
+    #endif
+
+    /* Set all global pointers to null */
+    models = NULL;
+    bound = NULL;
+    pacing = NULL;
+    y = NULL;
+    z = NULL;
+    list_update_str = NULL;
+    cvode_mem = NULL;
+    #if SUNDIALS_VERSION_MAJOR >= 3
+    sunband_matrix = NULL;
+    sunband_solver = NULL;
+    #endif
+    #if SUNDIALS_VERSION_MAJOR >= 6
+    sundials_context = NULL;
+    #endif
+
+    /* Check input arguments     0123456789012345 */
+    if (!PyArg_ParseTuple(args, "idiiddOOOOOOdddd",
+            &ncells,            /*  0. Int: number of cells */
+            &g,                 /*  1. Float: cell-to-cell conductance */
+            &ivm,               /*  2. Int: index of membrane potential */
+            &npaced,            /*  3. Int: number of paced cells */
+            &tmin,              /*  4. Float: initial time */
+            &tmax,              /*  5. Float: final time */
+            &state_in,          /*  6. List: initial state */
+            &state_out,         /*  7. List: final state */
+            &protocol,          /*  8. Protocol or None */
+            &cell_logs,         /*  9. List: dict of logs for each cell */
+            &log_time,          /* 10. List to log time in, or None */
+            &log_pace,          /* 11. List to log pace in, or None */
+            &log_interval,      /* 12. Float: log interval */
+            &abs_tol,           /* 13. Float: absolute tolerance */
+            &rel_tol,           /* 14. Float: relative tolerance */
+            &dt_max             /* 15. Float: maximum step size, or 0 */
+    )) {
+        PyErr_SetString(PyExc_Exception, "Incorrect input arguments.");
+        return 0;
+    }
+
+    /* Now officialy initialized */
+    initialized = 1;
+
+    /*************************************************************************
+     *
+     * From this point on, no more direct returning! Use sim_clean()
+     *
+     */
+
+    /* Set simulation starting time */
+    t = tmin;
+
+    /* Reset solver stats */
+    steps = 0;
+    evaluations = 0;
+
+    /* Check cell arguments */
+    if (ncells < 1) {
+        PyErr_SetString(PyExc_ValueError, "Number of cells must be greater than zero.");
+        return sim_clean();
+    }
+    if (npaced > ncells) {
+        PyErr_SetString(PyExc_ValueError, "'npaced' cannot exceed ncells.");
+        return sim_clean();
+    }
+
+    /*
+     * Create cell models
+     */
+    models = (Model*)malloc((size_t)ncells * sizeof(Model));
+    if (models == NULL) {
+        PyErr_SetString(PyExc_MemoryError, "Unable to allocate space for cell models.");
+        return sim_clean();
+    }
+    for (icell=0; icell<ncells; icell++) {
+        models[icell] = NULL;
+    }
+    for (icell=0; icell<ncells; icell++) {
+        models[icell] = Model_Create(&flag_model);
+        if (flag_model != Model_OK) { Model_SetPyErr(flag_model); return sim_clean(); }
+        flag_model = Model_SetupPacing(models[icell], 2);
+        if (flag_model != Model_OK) { Model_SetPyErr(flag_model); return sim_clean(); }
+    }
+    n_state = models[0]->n_states;
+    if (ivm < 0 || ivm >= n_state) {
+        PyErr_SetString(PyExc_ValueError, "Invalid membrane potential index.");
+        return sim_clean();
+    }
+    bound = (realtype*)malloc(2 * (size_t)ncells * sizeof(realtype));
+    if (bound == NULL) {
+        PyErr_SetString(PyExc_MemoryError, "Unable to allocate space for pacing values.");
+        return sim_clean();
+    }
+    n = ncells * n_state;
+
+    /*
+     * Create sundials context
+     */
+    #if SUNDIALS_VERSION_MAJOR >= 7
+    sunerr = SUNContext_Create(SUN_COMM_NULL, &sundials_context);
+    if (check_sundials_error(sunerr, "SUNContext_Create")) return sim_clean();
+    #elif SUNDIALS_VERSION_MAJOR >= 6
+    flag_cvode = SUNContext_Create(NULL, &sundials_context);
+    if (check_sundials_flag(flag_cvode, "SUNContext_Create")) return sim_clean();
+    #endif
+
+    /*
+     * Create state vectors
+     */
+    #if SUNDIALS_VERSION_MAJOR >= 6
+    y = N_VNew_Serial(n, sundials_context);
+    z = N_VNew_Serial(n, sundials_context);
+    #else
+    y = N_VNew_Serial(n);
+    z = N_VNew_Serial(n);
+    #endif
+    if (y == NULL || z == NULL) {
+        PyErr_SetString(PyExc_MemoryError, "Unable to allocate space for state vectors.");
+        return sim_clean();
+    }
+
+    /* Set initial state values */
+    if (!PyList_Check(state_in) || PyList_Size(state_in) != n) {
+        PyErr_SetString(PyExc_ValueError, "'state_in' must be a list of size ncells * n_states.");
+        return sim_clean();
+    }
+    if (!PyList_Check(state_out) || PyList_Size(state_out) != n) {
+        PyErr_SetString(PyExc_ValueError, "'state_out' must be a list of size ncells * n_states.");
+        return sim_clean();
+    }
+    for (i=0; i<n; i++) {
+        val = PyList_GetItem(state_in, i);    /* Borrowed reference */
+        if (!PyFloat_Check(val)) {
+            PyErr_Format(PyExc_ValueError, "Item %d in state vector is not a float.", i);
+            return sim_clean();
+        }
+        NV_Ith_S(y, i) = PyFloat_AsDouble(val);
+    }
+
+    /*
+     * Set up pacing
+     */
+    pacing = ESys_Create(tmin, &flag_pacing);
+    if (flag_pacing != ESys_OK) { ESys_SetPyErr(flag_pacing); return sim_clean(); }
+    flag_pacing = ESys_Populate(pacing, protocol);
+    if (flag_pacing != ESys_OK) { ESys_SetPyErr(flag_pacing); return sim_clean(); }
+    flag_pacing = ESys_AdvanceTime(pacing, tmin);
+    if (flag_pacing != ESys_OK) { ESys_SetPyErr(flag_pacing); return sim_clean(); }
+    tnext = fmin(tmax, ESys_GetNextTime(pacing, NULL));
+    pace = ESys_GetLevel(pacing, NULL);
+
+    /*
+     * Create solver, using backwards differentiation and newton iterations
+     */
+    #if SUNDIALS_VERSION_MAJOR >= 6
+    cvode_mem = CVodeCreate(CV_BDF, sundials_context);
+    #elif SUNDIALS_VERSION_MAJOR >= 4
+    cvode_mem = CVodeCreate(CV_BDF);
+    #else
+    cvode_mem = CVodeCreate(CV_BDF, CV_NEWTON);
+    #endif
+    if (cvode_mem == NULL) {
+        PyErr_SetString(PyExc_Exception, "Unable to allocate CVODE memory.");
+        return sim_clean();
+    }
+
+    /* Set error and warning-message handler */
+    #if SUNDIALS_VERSION_MAJOR >= 7
+    sunerr = SUNContext_PushErrHandler(sundials_context, ErrorHandler, NULL);
+    if (check_sundials_error(sunerr, "SUNContext_PushErrHandler")) return sim_clean();
+    #else
+    flag_cvode = CVodeSetErrHandlerFn(cvode_mem, ErrorHandler, NULL);
+    if (check_sundials_flag(flag_cvode, "CVodeSetErrHandlerFn")) return sim_clean();
+    #endif
+
+    /* Initialize solver memory, specify the rhs */
+    flag_cvode = CVodeInit(cvode_mem, rhs, t, y);
+    if (check_sundials_flag(flag_cvode, "CVodeInit")) return sim_clean();
+
+    /* Set absolute and relative tolerances */
+    flag_cvode = CVodeSStolerances(cvode_mem, RCONST(rel_tol), RCONST(abs_tol));
+    if (check_sundials_flag(flag_cvode, "CVodeSStolerances")) return sim_clean();
+
+    /* Set a maximum step size (or 0.0 for none) */
+    flag_cvode = CVodeSetMaxStep(cvode_mem, dt_max < 0 ? 0.0 : dt_max);
+    if (check_sundials_flag(flag_cvode, "CVodeSetMaxStep")) return sim_clean();
+
+    /*
+     * Attach a banded linear solver. Each cell's states are stored
+     * contiguously, and cells are only coupled to their direct neighbours via
+     * the membrane potential, so all non-zero Jacobian entries lie within
+     * n_state places of the diagonal. CVODES approximates the band using
+     * difference quotients, which needs 2 * n_state + 1 rhs evaluations,
+     * independent of the number of cells.
+     */
+    #if SUNDIALS_VERSION_MAJOR >= 6
+        sunband_matrix = SUNBandMatrix(n, n_state, n_state, sundials_context);
+        if (sunband_matrix == NULL) {
+            PyErr_SetString(PyExc_MemoryError, "Unable to allocate space for band matrix.");
+            return sim_clean();
+        }
+        sunband_solver = SUNLinSol_Band(y, sunband_matrix, sundials_context);
+        if (sunband_solver == NULL) {
+            PyErr_SetString(PyExc_MemoryError, "Unable to allocate space for band solver.");
+            return sim_clean();
+        }
+        flag_cvode = CVodeSetLinearSolver(cvode_mem, sunband_solver, sunband_matrix);
+        if (check_sundials_flag(flag_cvode, "CVodeSetLinearSolver")) return sim_clean();
+    #elif SUNDIALS_VERSION_MAJOR >= 4
+        sunband_matrix = SUNBandMatrix(n, n_state, n_state);
+        if (sunband_matrix == NULL) {
+            PyErr_SetString(PyExc_MemoryError, "Unable to allocate space for band matrix.");
+            return sim_clean();
+        }
+        sunband_solver = SUNLinSol_Band(y, sunband_matrix);
+        if (sunband_solver == NULL) {
+            PyErr_SetString(PyExc_MemoryError, "Unable to allocate space for band solver.");
+            return sim_clean();
+        }
+        flag_cvode = CVodeSetLinearSolver(cvode_mem, sunband_solver, sunband_matrix);
+        if (check_sundials_flag(flag_cvode, "CVodeSetLinearSolver")) return sim_clean();
+    #elif SUNDIALS_VERSION_MAJOR >= 3
+        /* Sundials 3 requires the storage upper bandwidth to be set */
+        sunband_matrix = SUNBandMatrix(n, n_state, n_state, (n - 1 < 2 * n_state) ? n - 1 : 2 * n_state);
+        if (sunband_matrix == NULL) {
+            PyErr_SetString(PyExc_MemoryError, "Unable to allocate space for band matrix.");
+            return sim_clean();
+        }
+        sunband_solver = SUNBandLinearSolver(y, sunband_matrix);
+        if (sunband_solver == NULL) {
+            PyErr_SetString(PyExc_MemoryError, "Unable to allocate space for band solver.");
+            return sim_clean();
+        }
+        flag_cvode = CVDlsSetLinearSolver(cvode_mem, sunband_solver, sunband_matrix);
+        if (check_sundials_flag(flag_cvode, "CVDlsSetLinearSolver")) return sim_clean();
+    #else
+        flag_cvode = CVBand(cvode_mem, n, n_state, n_state);
+        if (check_sundials_flag(flag_cvode, "CVBand")) return sim_clean();
+    #endif
+
+    /*
+     * Set up logging
+     */
+    if (log_interval <= 0) {
+        PyErr_SetString(PyExc_ValueError, "Log interval must be greater than zero.");
+        return sim_clean();
+    }
+    if (tmax + log_interval == tmax) {
+        PyErr_SetString(PyExc_ValueError, "Log interval is too small compared to tmax; issue with numerical precision: float(tmax + log_interval) = float(tmax).");
+        return sim_clean();
+    }
+    if (!PyList_Check(cell_logs) || PyList_Size(cell_logs) != ncells) {
+        PyErr_SetString(PyExc_ValueError, "'cell_logs' must be a list of size ncells.");
+        return sim_clean();
+    }
+    for (icell=0; icell<ncells; icell++) {
+        flag_model = Model_InitializeLogging(models[icell], PyList_GetItem(cell_logs, icell));
+        if (flag_model != Model_OK) { Model_SetPyErr(flag_model); return sim_clean(); }
+    }
+    list_update_str = PyUnicode_FromString("append");
+    ilog = 0;
+    tlog = tmin;
+
+    /* Evaluate the models at the initial time, so that all models are set */
+    evaluate(t, y, NULL);
+
+    Py_RETURN_NONE;
+}
+
+/*
+ * Takes the next steps in a simulation run
+ */
+PyObject*
+sim_step(PyObject *self, PyObject *args)
+{
+    ESys_Flag flag_pacing;
+    int flag_cvode;
+    int flag_reinit;
+    int steps_taken;
+    int i;
+
+    steps_taken = 0;
+    while(1) {
+
+        /* Take a single ODE step */
+        flag_reinit = 0;
+        flag_cvode = CVode(cvode_mem, tnext, y, &t, CV_ONE_STEP);
+        if (check_cvode_flag(flag_cvode)) return sim_clean();
+        steps++;
+
+        /* Next event time exceeded? Then go back to time=tnext */
+        if (t > tnext) {
+            flag_cvode = CVodeGetDky(cvode_mem, tnext, 0, y);
+            if (check_sundials_flag(flag_cvode, "CVodeGetDky")) return sim_clean();
+            t = tnext;
+            flag_reinit = 1;
+        }
+
+        /* Log interpolated points, using half-open intervals. The states are
+           interpolated by CVODES, and the models are then updated to obtain
+           any logged intermediary variables. These updates are not counted
+           as evaluations. */
+        while (t > tlog) {
+            flag_cvode = CVodeGetDky(cvode_mem, tlog, 0, z);
+            if (check_sundials_flag(flag_cvode, "CVodeGetDky")) return sim_clean();
+            evaluate(tlog, z, NULL);
+            if (log_point(tlog)) return sim_clean();
+
+            ilog++;
+            if (ilog == 0) {
+                PyErr_SetString(PyExc_OverflowError, "Overflow in logged step count: Simulation too long!");
+                return sim_clean();
+            }
+            tlog = tmin + (double)ilog * log_interval;
+        }
+
+        /*
+         * Event-based pacing
+         *
+         * At this point we have logged everything _before_ time t, so it
+         * is safe to update the pacing mechanism to time t.
+         */
+        flag_pacing = ESys_AdvanceTime(pacing, t);
+        if (flag_pacing != ESys_OK) { ESys_SetPyErr(flag_pacing); return sim_clean(); }
+        tnext = fmin(tmax, ESys_GetNextTime(pacing, NULL));
+        pace = ESys_GetLevel(pacing, NULL);
+
+        /* Reinitialize CVODE after a discontinuity */
+        if (flag_reinit) {
+            flag_cvode = CVodeReInit(cvode_mem, t, y);
+            if (check_sundials_flag(flag_cvode, "CVodeReInit")) return sim_clean();
+        }
+
+        /* Check if we're finished */
+        if (ESys_eq(t, tmax)) t = tmax;
+        if (t >= tmax) break;
+
+        /* Perform any Python signal handling */
+        if (PyErr_CheckSignals() != 0) {
+            /* Exception (e.g. timeout or keyboard interrupt) occurred?
+               Then cancel everything! */
+            return sim_clean();
+        }
+
+        /* Report back to python after every x steps */
+        steps_taken++;
+        if (steps_taken >= 100) {
+            return PyFloat_FromDouble(t);
+        }
+    }
+
+    /* Set final state */
+    for (i=0; i<ncells * n_state; i++) {
+        PyList_SetItem(state_out, i, PyFloat_FromDouble(NV_Ith_S(y, i)));
+        /* PyList_SetItem steals a reference: no need to decref the PyFloat */
+    }
+
+    /* Finished: clean up and return final time */
+    sim_clean();
+    return PyFloat_FromDouble(t);
+}
+
+/*
+ * Returns the number of steps taken in the last simulation
+ */
+PyObject*
+sim_steps(PyObject *self, PyObject *args)
+{
+    return PyLong_FromLong(steps);
+}
+
+/*
+ * Returns the number of rhs evaluations performed during the last simulation
+ */
+PyObject*
+sim_evals(PyObject *self, PyObject *args)
+{
+    return PyLong_FromLong(evaluations);
+}
+
+/*
+ * Methods in this module
+ */
+PyMethodDef SimMethods[] = {
+    {"sim_init", sim_init, METH_VARARGS, "Initialize the simulation."},
+    {"sim_step", sim_step, METH_VARARGS, "Perform the next step in the simulation."},
+    {"sim_clean", py_sim_clean, METH_VARARGS, "Clean up after an aborted simulation."},
+    {"number_of_steps", sim_steps, METH_VARARGS, "Returns the number of steps taken in the last simulation."},
+    {"number_of_evaluations", sim_evals, METH_VARARGS, "Returns the number of rhs evaluations performed during the last simulation."},
+    {NULL},
+};
+
+/*
+ * Module definition
+ */
+#if PY_MAJOR_VERSION >= 3
+
+struct PyModuleDef moduledef = {
+    PyModuleDef_HEAD_INIT,
+    "<?= module_name ?>",       /* m_name */
+    "Generated CVODES cable module",   /* m_doc */
+    -1,                         /* m_size */
+    SimMethods,                 /* m_methods */
+    NULL,                       /* m_reload */
+    NULL,                       /* m_traverse */
+    NULL,                       /* m_clear */
+    NULL,                       /* m_free */
+};
+
+PyMODINIT_FUNC PyInit_<?=module_name?>(void) {
+    return PyModule_Create(&moduledef);
+}
+
+#else
+
+PyMODINIT_FUNC
+init<?=module_name?>(void) {
+    (void) Py_InitModule("<?= module_name ?>", SimMethods);
+}
+
+#endif
@@ -0,0 +1,475 @@
+#
+# Cable simulation using CVODES with a banded Jacobian
+#
+# This file is part of Myokit.
+# See http://myokit.org for copyright, sharing, and licensing details.
+#
+import os
+import platform
+
+import myokit
+
+# Location of source file
+SOURCE_FILE = 'cvodessim1d.c'
+
+
+class Simulation1dCVODES(myokit.CModule):
+    """
+    Can run 1d cable simulations based on a :class:`model <Model>`, using an
+    adaptive step size solver.
+
+    ``model``
+        The model to simulate with. This model will be cloned when the
+        simulation is created so that no changes to the given model will be
+        made.
+    ``protocol``
+        An optional pacing protocol, used to stimulate a number of cells at the
+        start of the cable.
+    ``ncells``
+        The number of cells in the cable
+
+    This class provides the same interface as :class:`Simulation1d`, and uses
+    the same inputs variables can bind to (``time``, ``pace``, and
+    ``diffusion_current``) and the same ``membrane_potential`` label.
+
+    Instead of fixed-step forward Euler, the coupled system of all cells is
+    solved with the CVODES BDF method [1], using adaptive step sizes and
+    tolerances set with :meth:`set_tolerance`. Each cell is evaluated with the
+    same generated model code as :class:`myokit.Simulation`. The states of each
+    cell are stored contiguously, and cells are only coupled to their direct
+    neighbours (via the membrane potential), so that the system Jacobian is a
+    band matrix with an upper and lower half-bandwidth equal to the number of
+    states per cell. This allows the Newton iterations to use a banded linear
+    solver, so that the cost of each step scales linearly with the number of
+    cells. This makes the simulation well suited for stiff models and high
+    conductances, where fixed-step methods require very small steps, but for
+    non-stiff models or very long cables :class:`Simulation1d` may be faster.
+
+    Unlike :class:`Simulation1d`, the simulation logs interpolated values at
+    exact multiples of ``log_interval``.
+
+    [1] SUNDIALS: Suite of nonlinear and differential/algebraic equation
+    solvers. Hindmarsh, Brown, Woodward, et al. (2005) ACM Transactions on
+    Mathematical Software.
+    """
+    _index = 0      # Unique id for generated module
+
+    def __init__(self, model, protocol=None, ncells=50):
+        super().__init__()
+
+        # Require a valid model
+        model.validate()
+
+        # Set protocol
+        self.set_protocol(protocol)
+
+        # Set number of cells
+        ncells = int(ncells)
+        if ncells < 1:
+            raise ValueError('The number of cells must be at least 1.')
+        self._ncells = ncells
+
+        # Clone model, get membrane potential variable
+        self._model = model.clone()
+        del model
+        self._vm = self._model.label('membrane_potential')
+        if self._vm is None:
+            raise ValueError(
+                'This simulation requires the membrane potential'
+                ' variable to be labelled as "membrane_potential".')
+        if not self._vm.is_state():
+            raise ValueError('The membrane potential must be a state.')
+
+        # Check for binding to diffusion_current
+        if self._model.binding('diffusion_current') is None:
+            raise ValueError(
+                'This simulation requires a variable to be bound to'
+                ' "diffusion_current" to pass current from one cell to the'
+                ' next')
+
+        # Set number of cells paced
+        self.set_paced_cells()
+
+        # Set conductance
+        self.set_conductance()
+
+        # Set default solver settings
+        self.set_tolerance()
+        self.set_max_step_size()
+
+        # Set remaining properties
+        self._time = 0
+        self._nstate = self._model.count_states()
+        self._ivm = self._vm.index()
+
+        # Set state and default state
+        self._state = self._model.initial_values(True) * ncells
+        self._default_state = list(self._state)
+
+        # Generate C model code, with the diffusion current as second pacing
+        # variable. Note that this updates the bindings in self._model.
+        cmodel = myokit.CModel(
+            self._model, ['pace', 'diffusion_current'], None)
+
+        # Unique simulation id
+        Simulation1dCVODES._index += 1
+        module_name = 'myokit_sim1dcvodes_' + str(Simulation1dCVODES._index)
+        module_name += '_' + str(myokit.pid_hash())
+
+        # Arguments
+        args = {
+            'module_name': module_name,
+            'model_code': cmodel.code,
+        }
+        fname = os.path.join(myokit.DIR_CFUNC, SOURCE_FILE)
+
+        # Define libraries
+        libs = [
+            'sundials_cvodes',
+            'sundials_nvecserial',
+        ]
+        if platform.system() != 'Windows':  # pragma: no windows cover
+            libs.append('m')
+
+        # Define library paths
+        libd = list(myokit.SUNDIALS_LIB)
+        incd = list(myokit.SUNDIALS_INC)
+        incd.append(myokit.DIR_CFUNC)
+
+        # Create simulation
+        self._sim = self._compile(module_name, fname, args, libs, libd, incd)
+
+    def conductance(self):
+        """
+        Returns the current conductance.
+        """
+        return self._conductance
+
+    def default_state(self, icell=None):
+        """
+        Returns the default simulation state as a list of ``len(state) *
+        ncells`` floating point values. If the optional argument ``icell`` is
+        set to a valid cell index only the state of that cell is returned.
+        """
+        if icell is None:
+            return list(self._default_state)
+        else:
+            icell = int(icell)
+            if icell < 0 or icell >= self._ncells:
+                raise ValueError('Given cell index out of range.')
+            offset = icell * self._nstate
+            return self._default_state[offset:offset + self._nstate]
+
+    def last_number_of_evaluations(self):
+        """
+        Returns the number of rhs evaluations performed by the solver during
+        the last simulation, where each evaluation updates all cells.
+
+        Logged points are obtained by interpolating the states, after which
+        the cell models are updated to calculate any logged intermediary
+        variables. These updates are not included in the count.
+        """
+        return self._sim.number_of_evaluations()
+
+    def last_number_of_steps(self):
+        """
+        Returns the number of steps taken by the solver during the last
+        simulation.
+        """
+        return self._sim.number_of_steps()
+
+    def paced_cells(self):
+        """
+        Returns the number of cells that will receive a stimulus from the
+        pacing protocol.
+        """
+        return self._npaced
+
+    def pre(self, duration, progress=None,
+            msg='Pre-pacing Simulation1dCVODES'):
+        """
+        This method can be used to perform an unlogged simulation, typically to
+        pre-pace to a (semi-)stable orbit.
+
+        After running this method
+
+        - The simulation time is **not** affected
+        - The current state and the default state are updated to the final
+          state reached in the simulation.
+
+        Calls to :meth:`reset` after using :meth:`pre` will revert the
+        simulation to this new default state.
+
+        To obtain feedback on the simulation progress, an object implementing
+        the :class:`myokit.ProgressReporter` interface can be passed in.
+        passed in as ``progress``. An optional description of the current
+        simulation to use in the ProgressReporter can be passed in as `msg`.
+        """
+        self._run(duration, myokit.LOG_NONE, 1, progress, msg)
+        self._default_state = list(self._state)
+
+    def reset(self):
+        """
+        Resets the simulation:
+
+        - The time variable is set to 0
+        - The state is set to the default state
+
+        """
+        self._time = 0
+        self._state = list(self._default_state)
+
+    def run(
+            self, duration, log=None, log_interval=1.0, progress=None,
+            msg='Running Simulation1dCVODES'):
+        """
+        Runs a simulation and returns the logged results. Running a simulation
+        has the following effects:
+
+        - The internal state is updated to the last state in the simulation.
+        - The simulation's time variable is updated to reflect the time
+          elapsed during the simulation.
+
+        The number of time units to simulate can be set with ``duration``.
+
+        The variables to log can be indicated using the ``log`` argument, as
+        described in :meth:`Simulation1d.run`. Variables bound to ``time`` or
+        ``pace`` are logged globally, all others are logged per cell, using
+        keys prefixed with the cell index (e.g. ``0.membrane.V``).
+
+        A log entry is created every ``log_interval`` time units, using
+        interpolation to obtain values in between solver steps.
+
+        To obtain feedback on the simulation progress, an object implementing
+        the :class:`myokit.ProgressReporter` interface can be passed in.
+        passed in as ``progress``. An optional description of the current
+        simulation to use in the ProgressReporter can be passed in as `msg`.
+        """
+        r = self._run(duration, log, log_interval, progress, msg)
+        self._time += duration
+        return r
+
+    def _run(self, duration, log, log_interval, progress, msg):
+        # Simulation times
+        if duration < 0:
+            raise ValueError('Simulation time can\'t be negative.')
+        tmin = self._time
+        tmax = tmin + duration
+
+        # Gather global variables in model
+        time = self._model.time()
+        pace = self._model.binding('pace')
+        global_vars = [time.qname()]
+        if pace is not None:
+            global_vars.append(pace.qname())
+
+        # Parse log argument
+        allowed = myokit.LOG_STATE + myokit.LOG_BOUND + myokit.LOG_INTER
+        log = myokit.prepare_log(
+            log,
+            self._model,
+            dims=(self._ncells,),
+            global_vars=global_vars,
+            if_empty=myokit.LOG_STATE + myokit.LOG_BOUND,
+            allowed_classes=allowed,
+        )
+
+        # Split log into global lists and a dict of lists per cell
+        log_time = log.get(time.qname(), None)
+        log_pace = None if pace is None else log.get(pace.qname(), None)
+        cell_logs = [{} for i in range(self._ncells)]
+        for key, value in log.items():
+            if key in global_vars:
+                continue
+            icell, qname = key.split('.', 1)
+            cell_logs[int(icell)][qname] = value
+
+        # Logging period
+        log_interval = float(log_interval)
+        if log_interval <= 0:
+            raise ValueError('Log interval must be greater than zero.')
+
+        # Get progress indication function (if any)
+        if progress is None:
+            progress = myokit._simulation_progress
+        if progress:
+            if not isinstance(progress, myokit.ProgressReporter):
+                raise ValueError(
+                    'The argument "progress" must be either a subclass of'
+                    ' myokit.ProgressReporter or None.')
+
+        # Run simulation
+        if duration > 0:
+            # Initialize
+            state_in = self._state
+            state_out = list(state_in)
+            self._sim.sim_init(
+                self._ncells,
+                self._conductance,
+                self._ivm,
+                min(self._npaced, self._ncells),
+                tmin,
+                tmax,
+                state_in,
+                state_out,
+                self._protocol,
+                cell_logs,
+                log_time,
+                log_pace,
+                log_interval,
+                self._tolerance[0],
+                self._tolerance[1],
+                self._dtmax,
+            )
+            t = tmin
+            try:
+                if progress:
+                    # Loop with feedback
+                    with progress.job(msg):
+                        r = 1.0 / duration if duration != 0 else 1
+                        while t < tmax:
+                            t = self._sim.sim_step()
+                            if not progress.update(min((t - tmin) * r, 1)):
+                                raise myokit.SimulationCancelledError()
+                else:
+                    # Loop without feedback
+                    while t < tmax:
+                        t = self._sim.sim_step()
+            finally:
+                # Clean even after keyboardinterrupt or exception
+                self._sim.sim_clean()
+
+            # Update state
+            self._state = state_out
+
+        # Return log
+        return log
+
+    def _set_state(self, state, icell, update):
+        """
+        Handles set_state and set_default_state.
+        """
+        n = len(state)
+        if n == self._nstate:
+            if icell is None:
+                return [float(x) for x in state] * self._ncells
+            else:
+                icell = int(icell)
+                if icell < 0 or icell >= self._ncells:
+                    raise ValueError('Given cell index out of range.')
+                offset = icell * self._nstate
+                update = list(update)
+                update[offset:offset + self._nstate] = [
+                    float(x) for x in state]
+                return update
+        elif n == self._nstate * self._ncells:
+            return [float(x) for x in state]
+        raise ValueError(
+            'Wrong size state vector, expecting (1 or ' + str(self._ncells)
+            + ') * ' + str(self._nstate) + ' values.')
+
+    def set_conductance(self, g=10):
+        """
+        Changes the cell-to-cell conductance.
+        """
+        g = float(g)
+        if g < 0:
+            raise ValueError('Conductance cannot be negative.')
+        self._conductance = g
+
+    def set_default_state(self, state, icell=None):
+        """
+        Changes this simulation's default state.
+
+        This can be used in the same ways as :meth:`set_state`.
+        """
+        self._default_state = self._set_state(
+            state, icell, self._default_state)
+
+    def set_max_step_size(self, dtmax=None):
+        """
+        Sets a maximum step size. To let the solver pick any step size it likes
+        use ``dtmax = None``.
+        """
+        dtmax = 0 if dtmax is None else float(dtmax)
+        self._dtmax = max(0, dtmax)
+
+    def set_paced_cells(self, n=5):
+        """
+        Sets the number of cells that will receive a stimulus from the pacing
+        protocol.
+        """
+        n = int(n)
+        if n < 0:
+            raise ValueError(
+                'The number of cells to stimulate cannot be negative.')
+        self._npaced = n
+
+    def set_protocol(self, protocol=None):
+        """
+        Changes the pacing protocol used by this simulation.
+        """
+        if protocol is None:
+            self._protocol = None
+        else:
+            self._protocol = protocol.clone()
+
+    def set_state(self, state, icell=None):
+        """
+        Changes the state of this simulation's model.
+
+        This can be used in three different ways:
+
+        1. When called with an argument ``state`` of size ``nstates`` and
+           ``icell=None`` the given state will be set as the new state of all
+           cells in the simulation.
+        2. Called with an argument ``state`` of size ``nstates`` and
+           ``icell`` equal to a valid cell index, this method will update only
+           the selected cell's state.
+        3. Finally, when called with a ``state`` of size ``nstates * ncells``
+           the method will treat ``state`` as a concatenation of state vectors
+           for each cell.
+
+        """
+        self._state = self._set_state(state, icell, self._state)
+
+    def set_time(self, time=0):
+        """
+        Sets the current simulation time.
+        """
+        self._time = float(time)
+
+    def set_tolerance(self, abs_tol=1e-6, rel_tol=1e-4):
+        """
+        Sets the solver tolerances. Absolute tolerance is set using
+        ``abs_tol``, relative tolerance using ``rel_tol``. For more information
+        on these values, see the Sundials CVODES documentation.
+        """
+        abs_tol = float(abs_tol)
+        if abs_tol <= 0:
+            raise ValueError('Absolute tolerance must be positive float.')
+        rel_tol = float(rel_tol)
+        if rel_tol <= 0:
+            raise ValueError('Relative tolerance must be positive float.')
+        self._tolerance = (abs_tol, rel_tol)
+
+    def state(self, icell=None):
+        """
+        Returns the current simulation state as a list of ``len(state) *
+        ncells`` floating point values. If the optional argument ``icell`` is
+        set to a valid cell index only the state of that cell is returned.
+        """
+        if icell is None:
+            return list(self._state)
+        else:
+            icell = int(icell)
+            if icell < 0 or icell >= self._ncells:
+                raise ValueError('Given cell index out of range.')
+            offset = icell * self._nstate
+            return self._state[offset:offset + self._nstate]
+
+    def time(self):
+        """
+        Returns the current simulation time.
+        """
+        return self._time
@@ -51,15 +51,10 @@ comp_in, comp_out = model.map_component_io(
 # Bound variables will be passed in to every function as needed, so they can be
 # removed from the lists
 def clear_io_list(comp_list):
+    remove = set([var.lhs() for var in bound_variables])
+    remove.update([var.lhs() for var in inter_log])
     for comp, clist in comp_list.items():
-        for var in bound_variables:
-            lhs = var.lhs()
-            while lhs in clist:
-                clist.remove(lhs)
-        for var in inter_log:
-            lhs = var.lhs()
-            while lhs in clist:
-                clist.remove(lhs)
+        clist[:] = [lhs for lhs in clist if lhs not in remove]
 clear_io_list(comp_in)
 clear_io_list(comp_out)
 
@@ -82,7 +77,8 @@ inter_log_lhs = set([x.lhs() for x in inter_log])
 w = opencl.OpenCLExpressionWriter(precision=precision, native_math=native_math)
 
 # Define var/lhs function
-ptrs = []
+ptrs = set()
+ptr_vars = set()
 def set_pointers(names=None):
     """
     Tells the expression writer to write the given variable names (given as
@@ -91,10 +87,12 @@ def set_pointers(names=None):
     Calling set_pointers a second time clears the first list. Calling with
     ``names=None`` unsets all pointers.
     """
-    global ptrs
-    ptrs = []
+    global ptrs, ptr_vars
+    ptrs = set()
+    ptr_vars = set()
     if names is not None:
-        ptrs = list(names)
+        ptrs = set(names)
+        ptr_vars = set([x.var() for x in ptrs if isinstance(x, myokit.Name)])
 
 def v(var):
     """
@@ -109,7 +107,7 @@ def v(var):
         var = var.var()
     if var in bound_variables:
         return bound_variables[var]
-    pre = '*V_' if myokit.Name(var) in ptrs else 'V_'
+    pre = '*V_' if var in ptr_vars else 'V_'
     return pre + var.uname()
 w.set_lhs_function(v)
 
@@ -228,22 +226,22 @@ for comp, ilist in comp_in.items():
     args.extend(['__private Real *' + v(lhs) for lhs in olist])
     set_pointers(olist)
     name = 'calc_' + comp.name()
-    print('void ' + name + '(' + ', '.join(args) + ')')
-    print('{')
+    lines = ['void ' + name + '(' + ', '.join(args) + ')', '{']
 
-    # Equations
+    # Equations, collected in a list and printed at once
+    declared = set(ilist)
+    declared.update(olist)
+    declared.update(inter_log_lhs)
     for eq in equations[comp.name()].equations(const=False):
         var = eq.lhs.var()
-        if var in rl_states:
+        if var in rl_states or var in bound_variables:
             continue
-        pre = tab
-        if not (eq.lhs in ilist or eq.lhs in olist or eq.lhs in inter_log_lhs):
-            pre += 'Real '
-        if var not in bound_variables:
-            print(pre + w.eq(eq) + ';')
+        pre = tab if eq.lhs in declared else tab + 'Real '
+        lines.append(pre + w.eq(eq) + ';')
 
-    print('}')
-    print('')
+    lines.append('}')
+    lines.append('')
+    print('\n'.join(lines))
     set_pointers(None)
 
 if diffusion and paced_cells:
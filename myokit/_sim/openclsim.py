@@ -943,7 +943,7 @@ class SimulationOpenCL(myokit.CModule):
         self._state = list(self._default_state)
 
     def run(self, duration, log=None, log_interval=1.0, report_nan=True,
-            progress=None, msg='Running SimulationOpenCL'):
+            progress=None, msg='Running SimulationOpenCL', writer=None):
         """
         Runs a simulation and returns the logged results. Running a simulation
         has the following effects:
@@ -1008,12 +1008,24 @@ class SimulationOpenCL(myokit.CModule):
         the :class:`myokit.ProgressReporter` interface can be passed in.
         passed in as ``progress``. An optional description of the current
         simulation to use in the ProgressReporter can be passed in as `msg`.
-         """
-        r = self._run(duration, log, log_interval, report_nan, progress, msg)
+
+        To store the results of long simulations on large grids, a
+        :class:`myokit.DataBlockWriter` can be passed in as ``writer``. In this
+        case, logged data is appended to the writer's file during the
+        simulation and then removed from the log, so that the returned log
+        has the logged keys but contains no data. The logged variables must
+        include the time variable and be suitable for conversion to a
+        :class:`myokit.DataBlock1d` or :class:`myokit.DataBlock2d`. Because
+        the full log is not available, ``find_nan`` is not used to pinpoint
+        numerical errors when a writer is given.
+        """
+        r = self._run(
+            duration, log, log_interval, report_nan, progress, msg, writer)
         self._time += duration
         return r
 
-    def _run(self, duration, log, log_interval, report_nan, progress, msg):
+    def _run(self, duration, log, log_interval, report_nan, progress, msg,
+             writer=None):
         # Simulation times
         if duration < 0:
             raise ValueError('Simulation time can\'t be negative.')
@@ -1095,6 +1107,22 @@ class SimulationOpenCL(myokit.CModule):
                     'The argument "progress" must be either a subclass of'
                     ' myokit.ProgressReporter or None.')
 
+        # Move logged data to writer, if given
+        found_nan = False
+
+        def flush():
+            nonlocal found_nan
+            if log.length() == 0:
+                return
+            if report_nan and not found_nan:
+                found_nan = log.has_nan()
+            writer.append_log(log)
+            for v in log.values():
+                if hasattr(v, 'clear'):
+                    v.clear()
+                else:
+                    del v[:]
+
         # Run simulation
         arithmetic_error = False
         if duration > 0:
@@ -1132,22 +1160,34 @@ class SimulationOpenCL(myokit.CModule):
                         r = 1.0 / duration if duration != 0 else 1
                         while t < tmax:
                             t = self._sim.sim_step()
+                            if writer is not None:
+                                flush()
                             if not progress.update(min((t - tmin) * r, 1)):
                                 raise myokit.SimulationCancelledError()
                 else:
                     # Loop without feedback
                     while t < tmax:
                         t = self._sim.sim_step()
+                        if writer is not None:
+                            flush()
             except ArithmeticError:
                 arithmetic_error = True
             finally:
                 # Clean even after KeyboardInterrupt or other Exception
                 self._sim.sim_clean()
+                if writer is not None:
+                    flush()
+                    writer.flush()
             # Update state
             self._state = state_out
 
         # Check for NaN
-        if report_nan and (arithmetic_error or log.has_nan()):
+        if writer is not None:
+            if report_nan and (arithmetic_error or found_nan):
+                raise myokit.SimulationError(
+                    'Numerical error found in simulation logs. Run without'
+                    ' a writer to pinpoint its source.')
+        elif report_nan and (arithmetic_error or log.has_nan()):
             txt = ['Numerical error found in simulation logs.']
             try:
                 # NaN encountered, show how it happened
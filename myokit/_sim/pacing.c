@@ -0,0 +1,206 @@
+<?
+# pacing.c
+#
+# A pype template for a model-independent module that evaluates pacing
+# protocols, using the pacing systems in pacing.h.
+#
+# Required variables
+# -----------------------------------------------------------------------------
+# module_name A module name
+# -----------------------------------------------------------------------------
+#
+# This file is part of Myokit.
+# See http://myokit.org for copyright, sharing, and licensing details.
+#
+?>
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <math.h>
+#include "pacing.h"
+
+/*
+ * Creates, populates, and initialises an event-based pacing system.
+ *
+ * Returns NULL and sets a Python exception if anything goes wrong.
+ */
+static ESys
+create_esys(PyObject* protocol, double initial_time)
+{
+    ESys_Flag flag;
+    ESys sys;
+
+    sys = ESys_Create(initial_time, &flag);
+    if (flag != ESys_OK) { ESys_SetPyErr(flag); return NULL; }
+    flag = ESys_Populate(sys, protocol);
+    if (flag == ESys_OK) {
+        flag = ESys_AdvanceTime(sys, initial_time);
+    }
+    if (flag != ESys_OK) {
+        ESys_SetPyErr(flag);
+        ESys_Destroy(sys);
+        return NULL;
+    }
+    return sys;
+}
+
+/*
+ * Evaluates a myokit.Protocol at a non-decreasing sequence of times.
+ *
+ * Arguments:
+ *  protocol     : A myokit.Protocol
+ *  initial_time : The time to start the pacing system at
+ *  times        : A contiguous buffer of n doubles (e.g. a numpy array)
+ *  levels       : A writable contiguous buffer of n doubles, to store the
+ *                 pacing levels in.
+ */
+static PyObject*
+event_levels(PyObject *self, PyObject *args)
+{
+    PyObject* protocol;
+    double initial_time;
+    Py_buffer times, levels;
+    Py_ssize_t i, n;
+    double *t, *v;
+    ESys sys;
+    ESys_Flag flag;
+
+    if (!PyArg_ParseTuple(args, "Ody*w*", &protocol, &initial_time, &times, &levels)) {
+        return 0;
+    }
+    if (times.len != levels.len || times.len % (Py_ssize_t)sizeof(double) != 0) {
+        PyBuffer_Release(&times);
+        PyBuffer_Release(&levels);
+        PyErr_SetString(PyExc_ValueError, "Times and levels must be buffers of doubles of equal size.");
+        return 0;
+    }
+
+    sys = create_esys(protocol, initial_time);
+    if (sys == NULL) {
+        PyBuffer_Release(&times);
+        PyBuffer_Release(&levels);
+        return 0;
+    }
+
+    n = times.len / (Py_ssize_t)sizeof(double);
+    t = (double*)times.buf;
+    v = (double*)levels.buf;
+    flag = ESys_OK;
+    for (i=0; i<n; i++) {
+        flag = ESys_AdvanceTime(sys, t[i]);
+        if (flag != ESys_OK) break;
+        v[i] = sys->level;
+    }
+
+    ESys_Destroy(sys);
+    PyBuffer_Release(&times);
+    PyBuffer_Release(&levels);
+    if (flag != ESys_OK) {
+        ESys_SetPyErr(flag);
+        return 0;
+    }
+    Py_RETURN_NONE;
+}
+
+/*
+ * Returns a tuple of lists (time, pace) containing the end points of the
+ * interval [a, b] and every time in between at which the pacing level
+ * changes. If for_drawing is non-zero, each time the level changes will be
+ * listed twice: once with the old and once with the new level.
+ */
+static PyObject*
+event_interval(PyObject *self, PyObject *args)
+{
+    PyObject* protocol;
+    double a, b, t, v, w;
+    int for_drawing;
+    PyObject *time_list, *pace_list, *item;
+    ESys sys;
+    ESys_Flag flag;
+
+    if (!PyArg_ParseTuple(args, "Oddi", &protocol, &a, &b, &for_drawing)) {
+        return 0;
+    }
+
+    // Start at time 0, as in myokit.PacingSystem
+    sys = create_esys(protocol, 0);
+    if (sys == NULL) return 0;
+
+    time_list = PyList_New(0);
+    pace_list = PyList_New(0);
+    if (time_list == NULL || pace_list == NULL) goto error;
+
+    #define APPEND(list, x) \
+        item = PyFloat_FromDouble(x); \
+        if (item == NULL || PyList_Append(list, item) != 0) { Py_XDECREF(item); goto error; } \
+        Py_DECREF(item);
+
+    t = a;
+    flag = ESys_AdvanceTime(sys, t);
+    if (flag != ESys_OK) { ESys_SetPyErr(flag); goto error; }
+    v = sys->level;
+    APPEND(time_list, t);
+    APPEND(pace_list, v);
+    while (t < b) {
+        t = (sys->tnext < b) ? sys->tnext : b;
+        flag = ESys_AdvanceTime(sys, t);
+        if (flag != ESys_OK) { ESys_SetPyErr(flag); goto error; }
+        w = sys->level;
+        if (for_drawing && v != w) {
+            APPEND(time_list, t);
+            APPEND(pace_list, v);
+        }
+        v = w;
+        APPEND(time_list, t);
+        APPEND(pace_list, v);
+    }
+
+    #undef APPEND
+
+    ESys_Destroy(sys);
+    return Py_BuildValue("(NN)", time_list, pace_list);
+
+error:
+    ESys_Destroy(sys);
+    Py_XDECREF(time_list);
+    Py_XDECREF(pace_list);
+    return 0;
+}
+
+/*
+ * Methods in this module
+ */
+static PyMethodDef SimMethods[] = {
+    {"event_levels", event_levels, METH_VARARGS, "Evaluate a protocol at a sequence of times."},
+    {"event_interval", event_interval, METH_VARARGS, "Return the times at which a protocol changes in an interval."},
+    {NULL},
+};
+
+/*
+ * Module definition
+ */
+#if PY_MAJOR_VERSION >= 3
+
+    static struct PyModuleDef moduledef = {
+        PyModuleDef_HEAD_INIT,
+        "<?= module_name ?>",       /* m_name */
+        "Generated pacing module",  /* m_doc */
+        -1,                         /* m_size */
+        SimMethods,                 /* m_methods */
+        NULL,                       /* m_reload */
+        NULL,                       /* m_traverse */
+        NULL,                       /* m_clear */
+        NULL,                       /* m_free */
+    };
+
+    PyMODINIT_FUNC PyInit_<?=module_name?>(void) {
+        return PyModule_Create(&moduledef);
+    }
+
+#else
+
+    PyMODINIT_FUNC
+    init<?=module_name?>(void) {
+        (void) Py_InitModule("<?= module_name ?>", SimMethods);
+    }
+
+#endif
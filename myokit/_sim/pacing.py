@@ -0,0 +1,103 @@
+#
+# Native protocol evaluation
+#
+# This file is part of Myokit.
+# See http://myokit.org for copyright, sharing, and licensing details.
+#
+import os
+
+import numpy as np
+
+import myokit
+
+# Path to C Source for the pacing module
+SOURCE_FILE = 'pacing.c'
+
+
+class NativePacing(myokit.CModule):
+    """
+    Evaluates :class:`myokit.Protocol` objects using the C implementation in
+    ``pacing.h``.
+
+    The module does not depend on any model, so it is compiled only once and
+    then shared by all protocols. If compilation fails, the methods of this
+    class return ``None`` and callers should fall back to a Python
+    implementation.
+    """
+    # Unique id for this object
+    _index = 0
+
+    # Cached back-end object if compiled, False if compilation failed
+    _instance = None
+
+    # Cached compilation error messages
+    _message = None
+
+    def __init__(self):
+        super().__init__()
+        # Create and cache back-end
+        NativePacing._index += 1
+
+        # Define libraries
+        libd = list()
+        incd = list()
+        incd.append(myokit.DIR_CFUNC)
+        libs = []
+
+        # Create back-end
+        mname = 'myokit_pacing_' + str(NativePacing._index)
+        mname += '_' + str(myokit.pid_hash())
+        fname = os.path.join(myokit.DIR_CFUNC, SOURCE_FILE)
+        args = {'module_name': mname}
+        try:
+            NativePacing._instance = self._compile(
+                mname, fname, args, libs, libd, incd)
+        except myokit.CompilationError as e:  # pragma: no cover
+            NativePacing._instance = False
+            NativePacing._message = str(e)
+
+    @staticmethod
+    def _get_instance():
+        """
+        Returns a cached back-end, creates and returns a new back-end, or
+        returns ``None`` if the back-end could not be compiled.
+        """
+        if NativePacing._instance is None:
+            NativePacing()
+        if NativePacing._instance is False:  # pragma: no cover
+            return None
+        return NativePacing._instance
+
+    @staticmethod
+    def levels(protocol, times, initial_time=0):
+        """
+        Returns a numpy array with the value of the pacing variable for the
+        given ``protocol`` at every time in ``times``, which must be a
+        non-decreasing sequence of times, none of which are before
+        ``initial_time``.
+
+        Returns ``None`` if the native back-end is not available.
+        """
+        sys = NativePacing._get_instance()
+        if sys is None:  # pragma: no cover
+            return None
+        times = np.ascontiguousarray(times, dtype=float)
+        levels = np.empty(times.shape)
+        sys.event_levels(protocol, float(initial_time), times, levels)
+        return levels
+
+    @staticmethod
+    def interval(protocol, a, b, for_drawing=False):
+        """
+        Returns a tuple ``(times, levels)`` of lists containing the points
+        ``a`` and ``b`` and every time in between where the value of the
+        pacing variable for the given ``protocol`` changes (see
+        :meth:`myokit.Protocol.log_for_interval`).
+
+        Returns ``None`` if the native back-end is not available.
+        """
+        sys = NativePacing._get_instance()
+        if sys is None:  # pragma: no cover
+            return None
+        return sys.event_interval(
+            protocol, float(a), float(b), 1 if for_drawing else 0)
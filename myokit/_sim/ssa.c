@@ -0,0 +1,506 @@
+<?
+# ssa.c
+#
+# A pype template for a model-independent module that runs stochastic
+# simulations of discrete Markov models, for use by
+# myokit.lib.markov.DiscreteSimulation.
+#
+# Required variables
+# -----------------------------------------------------------------------------
+# module_name A module name
+# -----------------------------------------------------------------------------
+#
+# This file is part of Myokit.
+# See http://myokit.org for copyright, sharing, and licensing details.
+#
+?>
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Number of exact SSA events after which the propensity tree is rebuilt, to
+ * stop rounding errors from accumulating.
+ */
+#define SSA_REBUILD 4096
+
+/*
+ * Random number generation, using xoshiro256** by Blackman and Vigna. The
+ * generator state is stored in a buffer owned by the caller, so that separate
+ * realisations can use separate streams.
+ */
+static inline uint64_t
+rng_rotl(const uint64_t x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+static uint64_t
+rng_next(uint64_t* s)
+{
+    const uint64_t result = rng_rotl(s[1] * 5, 7) * 9;
+    const uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rng_rotl(s[3], 45);
+    return result;
+}
+
+/* Returns a uniformly distributed number in [0, 1) */
+static double
+rng_uniform(uint64_t* s)
+{
+    return (double)(rng_next(s) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/* Returns an exponentially distributed number with rate 1 */
+static double
+rng_exponential(uint64_t* s)
+{
+    return -log(1.0 - rng_uniform(s));
+}
+
+/* Returns a normally distributed number with mean 0 and variance 1 */
+static double
+rng_normal(uint64_t* s)
+{
+    double u, v, r;
+    do {
+        u = 2.0 * rng_uniform(s) - 1.0;
+        v = 2.0 * rng_uniform(s) - 1.0;
+        r = u * u + v * v;
+    } while (r >= 1.0 || r == 0.0);
+    return u * sqrt(-2.0 * log(r) / r);
+}
+
+/*
+ * Returns a binomially distributed number of successes in n trials with
+ * success probability p.
+ *
+ * For small expected counts this uses inversion, which is exact. For large
+ * counts, where tau-leaping is approximate anyway, a normal approximation
+ * clamped to [0, n] is used.
+ */
+static int64_t
+rng_binomial(uint64_t* s, int64_t n, double p)
+{
+    double q, r, f, u;
+    int64_t k, x;
+    int flip;
+
+    if (n <= 0 || p <= 0) return 0;
+    if (p >= 1) return n;
+    flip = p > 0.5;
+    if (flip) p = 1.0 - p;
+
+    if (n * p < 30.0) {
+        q = 1.0 - p;
+        r = p / q;
+        f = pow(q, (double)n);
+        u = rng_uniform(s);
+        x = 0;
+        while (u > f && x < n) {
+            u -= f;
+            f *= r * (double)(n - x) / (double)(x + 1);
+            x++;
+            if (f <= 0) break;
+        }
+    } else {
+        k = (int64_t)floor(n * p + sqrt(n * p * (1.0 - p)) * rng_normal(s) + 0.5);
+        x = k < 0 ? 0 : (k > n ? n : k);
+    }
+    return flip ? n - x : x;
+}
+
+/*
+ * Fenwick tree over transition propensities, used to select a transition in
+ * O(log m) time and update it after a transition in O(log m) time.
+ */
+static void
+tree_build(double* tree, const double* a, Py_ssize_t m)
+{
+    Py_ssize_t i, j;
+    tree[0] = 0;
+    for (i = 1; i <= m; i++) tree[i] = a[i - 1];
+    for (i = 1; i <= m; i++) {
+        j = i + (i & -i);
+        if (j <= m) tree[j] += tree[i];
+    }
+}
+
+static void
+tree_add(double* tree, Py_ssize_t m, Py_ssize_t k, double d)
+{
+    for (k++; k <= m; k += k & -k) tree[k] += d;
+}
+
+/* Returns the smallest k such that a[0] + ... + a[k] > x */
+static Py_ssize_t
+tree_find(const double* tree, Py_ssize_t m, Py_ssize_t top, double x)
+{
+    Py_ssize_t pos = 0, step;
+    for (step = top; step > 0; step >>= 1) {
+        if (pos + step <= m && tree[pos + step] <= x) {
+            pos += step;
+            x -= tree[pos];
+        }
+    }
+    return pos;
+}
+
+/*
+ * Growing list of logged events, allocated without holding the GIL.
+ */
+typedef struct {
+    double* times;
+    int64_t* states;
+    Py_ssize_t n;
+    Py_ssize_t cap;
+    Py_ssize_t ns;
+    int failed;
+} Events;
+
+static void
+events_add(Events* e, double t, const int64_t* state)
+{
+    double* times;
+    int64_t* states;
+    Py_ssize_t cap;
+
+    if (e->failed) return;
+    if (e->n == e->cap) {
+        cap = e->cap < 64 ? 64 : 2 * e->cap;
+        times = (double*)PyMem_RawRealloc(e->times, (size_t)cap * sizeof(double));
+        if (times == NULL) { e->failed = 1; return; }
+        e->times = times;
+        states = (int64_t*)PyMem_RawRealloc(e->states, (size_t)(cap * e->ns) * sizeof(int64_t));
+        if (states == NULL) { e->failed = 1; return; }
+        e->states = states;
+        e->cap = cap;
+    }
+    e->times[e->n] = t;
+    memcpy(e->states + e->n * e->ns, state, (size_t)e->ns * sizeof(int64_t));
+    e->n++;
+}
+
+/*
+ * Writes the current state for all log times before t_next, starting at log
+ * point il, and returns the index of the next log point.
+ */
+static Py_ssize_t
+log_until(double t_next, const int64_t* state, Py_ssize_t ns,
+          const double* log_times, int64_t* log_out, Py_ssize_t nlog,
+          Py_ssize_t il)
+{
+    while (il < nlog && log_times[il] < t_next) {
+        memcpy(log_out + il * ns, state, (size_t)ns * sizeof(int64_t));
+        il++;
+    }
+    return il;
+}
+
+/*
+ * Runs a stochastic simulation over a sequence of steps with constant rates.
+ *
+ * Arguments:
+ *  state     Writable int64 buffer with the channel count in each state.
+ *  si, sj    int64 buffers with the source and target state of each of the m
+ *            transitions.
+ *  times     Double buffer with the nsteps + 1 step boundaries.
+ *  rates     Double buffer with the m transition rates for each step.
+ *  rng       Writable buffer with the 4 uint64 of the generator state.
+ *  log_times Double buffer with non-decreasing times to log the state at.
+ *  log_out   Writable int64 buffer to log the state at every log time in.
+ *  events    Set to 1 to return a tuple (times, states) of bytes objects with
+ *            the time and state at the start of every step and after every
+ *            transition (or leap), or 0 to return None.
+ *  tau       The time between leaps for tau-leaping, or 0 to use Gillespie's
+ *            exact direct method.
+ *
+ * On return, the state and generator state are updated. Log times before the
+ * first step get the initial state, and log times after the last step get the
+ * final state.
+ *
+ * The GIL is released while simulating, so that multiple realisations can be
+ * run in parallel using Python threads.
+ */
+static PyObject*
+ssa_run(PyObject *self, PyObject *args)
+{
+    Py_buffer b_state, b_si, b_sj, b_times, b_rates, b_rng, b_ltimes, b_lout;
+    int with_events;
+    double tau;
+    Py_ssize_t ns, m, nsteps, nlog, i, j, k, q, il, top, since;
+    int64_t *state, *si, *sj, *lout, *leaps, *out_start, *out_index, count, n, left;
+    const double *times, *rates, *ltimes, *r;
+    uint64_t* rng;
+    double *a, *tree, *out_rate;
+    double t, t1, total, x, h, rsum;
+    Events ev;
+    PyObject *ret, *bt, *bs;
+    int error;
+
+    if (!PyArg_ParseTuple(args, "w*y*y*y*y*w*y*w*id",
+            &b_state, &b_si, &b_sj, &b_times, &b_rates, &b_rng, &b_ltimes, &b_lout,
+            &with_events, &tau)) {
+        return 0;
+    }
+
+    ns = b_state.len / (Py_ssize_t)sizeof(int64_t);
+    m = b_si.len / (Py_ssize_t)sizeof(int64_t);
+    nsteps = b_times.len / (Py_ssize_t)sizeof(double) - 1;
+    nlog = b_ltimes.len / (Py_ssize_t)sizeof(double);
+    state = (int64_t*)b_state.buf;
+    si = (int64_t*)b_si.buf;
+    sj = (int64_t*)b_sj.buf;
+    times = (const double*)b_times.buf;
+    rates = (const double*)b_rates.buf;
+    rng = (uint64_t*)b_rng.buf;
+    ltimes = (const double*)b_ltimes.buf;
+    lout = (int64_t*)b_lout.buf;
+
+    /* Check arguments */
+    error = 0;
+    if (b_sj.len != b_si.len || nsteps < 0 || b_rng.len < 4 * (Py_ssize_t)sizeof(uint64_t)
+            || b_rates.len < nsteps * m * (Py_ssize_t)sizeof(double)
+            || b_lout.len < nlog * ns * (Py_ssize_t)sizeof(int64_t)) {
+        error = 1;
+    }
+    for (k = 0; k < m && !error; k++) {
+        if (si[k] < 0 || si[k] >= ns || sj[k] < 0 || sj[k] >= ns) error = 1;
+    }
+    if (error) {
+        PyBuffer_Release(&b_state);
+        PyBuffer_Release(&b_si);
+        PyBuffer_Release(&b_sj);
+        PyBuffer_Release(&b_times);
+        PyBuffer_Release(&b_rates);
+        PyBuffer_Release(&b_rng);
+        PyBuffer_Release(&b_ltimes);
+        PyBuffer_Release(&b_lout);
+        PyErr_SetString(PyExc_ValueError, "Invalid buffer sizes or transitions.");
+        return 0;
+    }
+
+    /* Allocate work space */
+    a = (double*)PyMem_RawMalloc((size_t)(2 * m + 2) * sizeof(double));
+    leaps = (int64_t*)PyMem_RawMalloc((size_t)(ns + 1) * sizeof(int64_t));
+    out_start = (int64_t*)PyMem_RawMalloc((size_t)(ns + 1) * sizeof(int64_t));
+    out_index = (int64_t*)PyMem_RawMalloc((size_t)(m + 1) * sizeof(int64_t));
+    out_rate = (double*)PyMem_RawMalloc((size_t)(ns + 1) * sizeof(double));
+    tree = a == NULL ? NULL : a + m + 1;
+    ev.times = NULL;
+    ev.states = NULL;
+    ev.n = ev.cap = 0;
+    ev.ns = ns;
+    ev.failed = 0;
+    ret = NULL;
+    if (a == NULL || leaps == NULL || out_start == NULL || out_index == NULL || out_rate == NULL) {
+        PyErr_NoMemory();
+        goto cleanup;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+
+    /* Outgoing transitions of each state, in compressed row format */
+    for (i = 0; i <= ns; i++) out_start[i] = 0;
+    for (k = 0; k < m; k++) out_start[si[k] + 1]++;
+    for (i = 0; i < ns; i++) out_start[i + 1] += out_start[i];
+    for (i = 0; i < ns; i++) leaps[i] = out_start[i];
+    for (k = 0; k < m; k++) out_index[leaps[si[k]]++] = k;
+
+    /* Largest power of two not exceeding m */
+    for (top = 1; top * 2 <= m; top *= 2);
+
+    il = 0;
+    for (q = 0; q < nsteps; q++) {
+        t = times[q];
+        t1 = times[q + 1];
+        if (!(t < t1)) continue;
+        r = rates + q * m;
+        if (with_events) events_add(&ev, t, state);
+
+        if (tau > 0) {
+            /* Tau-leaping: per source state, the number of channels leaving
+               in a leap is binomial, and is split over the outgoing
+               transitions with conditional binomials. */
+            for (i = 0; i < ns; i++) {
+                out_rate[i] = 0;
+                for (k = out_start[i]; k < out_start[i + 1]; k++) out_rate[i] += r[out_index[k]];
+            }
+            while (t < t1) {
+                h = t1 - t;
+                if (tau < h) h = tau;
+                il = log_until(t + h, state, ns, ltimes, lout, nlog, il);
+                for (i = 0; i < ns; i++) leaps[i] = 0;
+                for (i = 0; i < ns; i++) {
+                    if (state[i] <= 0 || out_rate[i] <= 0) continue;
+                    left = rng_binomial(rng, state[i], -expm1(-out_rate[i] * h));
+                    rsum = out_rate[i];
+                    for (k = out_start[i]; k < out_start[i + 1] && left > 0; k++) {
+                        x = r[out_index[k]];
+                        n = (k == out_start[i + 1] - 1) ? left : rng_binomial(rng, left, x / rsum);
+                        rsum -= x;
+                        leaps[i] -= n;
+                        leaps[sj[out_index[k]]] += n;
+                        left -= n;
+                    }
+                }
+                for (i = 0; i < ns; i++) state[i] += leaps[i];
+                t += h;
+                if (with_events && t < t1) events_add(&ev, t, state);
+            }
+        } else {
+            /* Direct method, with a Fenwick tree over the propensities. */
+            since = SSA_REBUILD;
+            total = 0;
+            while (1) {
+                if (since >= SSA_REBUILD) {
+                    total = 0;
+                    for (k = 0; k < m; k++) {
+                        a[k] = r[k] * (double)state[si[k]];
+                        total += a[k];
+                    }
+                    tree_build(tree, a, m);
+                    since = 0;
+                }
+                if (!(total > 0)) break;
+                h = rng_exponential(rng) / total;
+                if (!(t + h < t1)) break;
+                t += h;
+                il = log_until(t, state, ns, ltimes, lout, nlog, il);
+
+                /* Select a transition */
+                k = tree_find(tree, m, top, rng_uniform(rng) * total);
+                if (k >= m || !(a[k] > 0)) {
+                    /* Rounding error: fall back to a linear scan */
+                    x = rng_uniform(rng) * total;
+                    rsum = 0;
+                    i = -1;
+                    for (k = 0; k < m; k++) {
+                        if (a[k] > 0) {
+                            i = k;
+                            rsum += a[k];
+                            if (rsum > x) break;
+                        }
+                    }
+                    if (i < 0) break;
+                    k = i;
+                }
+
+                /* Perform the transition */
+                state[si[k]]--;
+                state[sj[k]]++;
+                if (with_events) events_add(&ev, t, state);
+
+                /* Update propensities of transitions out of affected states */
+                for (i = 0; i < 2; i++) {
+                    n = i == 0 ? si[k] : sj[k];
+                    for (count = out_start[n]; count < out_start[n + 1]; count++) {
+                        j = (Py_ssize_t)out_index[count];
+                        x = r[j] * (double)state[n];
+                        tree_add(tree, m, j, x - a[j]);
+                        total += x - a[j];
+                        a[j] = x;
+                    }
+                }
+                since++;
+            }
+
+            /* As in the Python implementation, the remaining time until the
+               end of the step is covered by a single "brute-force" step, in
+               which each transition happens with probability a_k * h, using
+               the propensities at the start of this final step. */
+            il = log_until(t1, state, ns, ltimes, lout, nlog, il);
+            h = t1 - t;
+            for (k = 0; k < m; k++) a[k] = r[k] * (double)state[si[k]] * h;
+            for (k = 0; k < m; k++) {
+                if (rng_uniform(rng) < a[k] && state[si[k]] > 0) {
+                    state[si[k]]--;
+                    state[sj[k]]++;
+                }
+            }
+        }
+        il = log_until(t1, state, ns, ltimes, lout, nlog, il);
+    }
+    il = log_until(HUGE_VAL, state, ns, ltimes, lout, nlog, il);
+
+    Py_END_ALLOW_THREADS
+
+    if (ev.failed) {
+        PyErr_NoMemory();
+        goto cleanup;
+    }
+    if (with_events) {
+        bt = PyBytes_FromStringAndSize((const char*)ev.times, ev.n * (Py_ssize_t)sizeof(double));
+        bs = PyBytes_FromStringAndSize((const char*)ev.states, ev.n * ns * (Py_ssize_t)sizeof(int64_t));
+        if (bt != NULL && bs != NULL) ret = PyTuple_Pack(2, bt, bs);
+        Py_XDECREF(bt);
+        Py_XDECREF(bs);
+    } else {
+        Py_INCREF(Py_None);
+        ret = Py_None;
+    }
+
+cleanup:
+    PyMem_RawFree(a);
+    PyMem_RawFree(leaps);
+    PyMem_RawFree(out_start);
+    PyMem_RawFree(out_index);
+    PyMem_RawFree(out_rate);
+    PyMem_RawFree(ev.times);
+    PyMem_RawFree(ev.states);
+    PyBuffer_Release(&b_state);
+    PyBuffer_Release(&b_si);
+    PyBuffer_Release(&b_sj);
+    PyBuffer_Release(&b_times);
+    PyBuffer_Release(&b_rates);
+    PyBuffer_Release(&b_rng);
+    PyBuffer_Release(&b_ltimes);
+    PyBuffer_Release(&b_lout);
+    return ret;
+}
+
+/*
+ * Methods in this module
+ */
+static PyMethodDef SimMethods[] = {
+    {"run", ssa_run, METH_VARARGS, "Run a stochastic simulation."},
+    {NULL},
+};
+
+/*
+ * Module definition
+ */
+#if PY_MAJOR_VERSION >= 3
+
+    static struct PyModuleDef moduledef = {
+        PyModuleDef_HEAD_INIT,
+        "<?= module_name ?>",       /* m_name */
+        "Generated SSA module",     /* m_doc */
+        -1,                         /* m_size */
+        SimMethods,                 /* m_methods */
+        NULL,                       /* m_reload */
+        NULL,                       /* m_traverse */
+        NULL,                       /* m_clear */
+        NULL,                       /* m_free */
+    };
+
+    PyMODINIT_FUNC PyInit_<?=module_name?>(void) {
+        return PyModule_Create(&moduledef);
+    }
+
+#else
+
+    PyMODINIT_FUNC
+    init<?=module_name?>(void) {
+        (void) Py_InitModule("<?= module_name ?>", SimMethods);
+    }
+
+#endif
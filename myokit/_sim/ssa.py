@@ -0,0 +1,143 @@
+#
+# Native stochastic simulation of discrete Markov models
+#
+# This file is part of Myokit.
+# See http://myokit.org for copyright, sharing, and licensing details.
+#
+import os
+
+import numpy as np
+
+import myokit
+
+# Path to C Source for the SSA module
+SOURCE_FILE = 'ssa.c'
+
+
+class NativeSSA(myokit.CModule):
+    """
+    Runs stochastic simulations of discrete Markov models for
+    :class:`myokit.lib.markov.DiscreteSimulation`, using Gillespie's direct
+    method or tau-leaping.
+
+    The module does not depend on any model: transition rates are passed in
+    for each step of a protocol. As a result, it is compiled only once and then
+    shared. If compilation fails, the methods of this class return ``None``
+    and callers should fall back to a Python implementation.
+    """
+    # Unique id for this object
+    _index = 0
+
+    # Cached back-end object if compiled, False if compilation failed
+    _instance = None
+
+    # Cached compilation error messages
+    _message = None
+
+    def __init__(self):
+        super().__init__()
+        # Create and cache back-end
+        NativeSSA._index += 1
+
+        # Define libraries
+        libd = list()
+        incd = list()
+        incd.append(myokit.DIR_CFUNC)
+        libs = []
+
+        # Create back-end
+        mname = 'myokit_ssa_' + str(NativeSSA._index)
+        mname += '_' + str(myokit.pid_hash())
+        fname = os.path.join(myokit.DIR_CFUNC, SOURCE_FILE)
+        args = {'module_name': mname}
+        try:
+            NativeSSA._instance = self._compile(
+                mname, fname, args, libs, libd, incd)
+        except myokit.CompilationError as e:  # pragma: no cover
+            NativeSSA._instance = False
+            NativeSSA._message = str(e)
+
+    @staticmethod
+    def _get_instance():
+        """
+        Returns a cached back-end, creates and returns a new back-end, or
+        returns ``None`` if the back-end could not be compiled.
+        """
+        if NativeSSA._instance is None:
+            NativeSSA()
+        if NativeSSA._instance is False:  # pragma: no cover
+            return None
+        return NativeSSA._instance
+
+    @staticmethod
+    def seeds(n):
+        """
+        Returns an array of shape ``(n, 4)`` containing the states for ``n``
+        independent random number generators.
+
+        The seeds are derived from numpy's global random number generator, so
+        that ``numpy.random.seed()`` can be used to make results reproducible.
+        """
+        entropy = np.random.randint(0, 2**63 - 1, size=2, dtype=np.int64)
+        return np.array([
+            s.generate_state(4, np.uint64)
+            for s in np.random.SeedSequence(entropy.tolist()).spawn(n)])
+
+    @staticmethod
+    def run(state, transitions, times, rates, rng, log_times=None,
+            events=False, tau=0):
+        """
+        Runs a stochastic simulation.
+
+        Arguments:
+
+        ``state``
+            A contiguous ``int64`` array with the number of channels in each
+            state. This is updated during the simulation.
+        ``transitions``
+            A contiguous ``int64`` array of shape ``(2, m)`` with the source
+            and target state of each of the ``m`` transitions.
+        ``times``
+            An array with the ``nsteps + 1`` boundaries of the protocol steps.
+        ``rates``
+            An array of shape ``(nsteps, m)`` with the transition rates during
+            every step.
+        ``rng``
+            A ``uint64`` array of length 4 with the generator state, as
+            returned by :meth:`seeds`. This is updated during the simulation.
+        ``log_times``
+            An optional array of non-decreasing times to log the state at.
+        ``events``
+            Set to ``True`` to log the time and state at the start of every
+            step and after every transition.
+        ``tau``
+            The time between leaps for tau-leaping, or 0 to use the exact
+            direct method.
+
+        Returns a tuple ``(logged, times, states)`` where ``logged`` is an
+        array of shape ``(len(log_times), len(state))`` with the state at every
+        log time (or ``None``), and ``times`` and ``states`` are arrays with
+        the event times and the states after each event (or ``None``).
+
+        Returns ``None`` if the native back-end is not available.
+        """
+        mod = NativeSSA._get_instance()
+        if mod is None:  # pragma: no cover
+            return None
+        n = len(state)
+        times = np.ascontiguousarray(times, dtype=float)
+        rates = np.ascontiguousarray(rates, dtype=float)
+        if log_times is None:
+            ltimes = np.zeros(0)
+        else:
+            ltimes = np.ascontiguousarray(log_times, dtype=float)
+        logged = np.zeros((len(ltimes), n), dtype=np.int64)
+        ev = mod.run(
+            state, transitions[0], transitions[1], times, rates, rng, ltimes,
+            logged, 1 if events else 0, float(tau))
+        if log_times is None:
+            logged = None
+        if ev is None:
+            return logged, None, None
+        return (logged, np.frombuffer(ev[0]),
+                np.frombuffer(ev[1], dtype=np.int64).reshape((-1, n)))
@@ -189,10 +189,11 @@ class ExpressionWriter:
 
     def ex(self, e):
         """ Converts a :class:`myokit.Expression` to a string. """
-        t = type(e)
-        if t not in self._op_map:   # pragma: no cover
-            raise ValueError('Unknown expression type: ' + str(t))
-        return self._op_map[t](e)
+        try:
+            f = self._op_map[type(e)]
+        except KeyError:    # pragma: no cover
+            raise ValueError('Unknown expression type: ' + str(type(e)))
+        return f(e)
 
     def _ex_name(self, e):
         raise NotImplementedError
@@ -888,3 +889,9 @@ class SweepSource:
         """ Returns the time unit used in this source. """
         raise NotImplementedError
 
+
+# Batch conversion of data files
+from ._convert import (  # noqa
+    ConversionReport,
+    convert_data,
+)
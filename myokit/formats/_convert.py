@@ -0,0 +1,271 @@
+#
+# Batch conversion of electrophysiology files to DataLogs.
+#
+# This file is part of Myokit.
+# See http://myokit.org for copyright, sharing, and licensing details.
+#
+import concurrent.futures
+import os
+
+import myokit
+
+# Extensions of the data formats that can be converted
+DATA_EXTENSIONS = ('.abf', '.dat', '.wcp')
+
+# Extension used for converted files
+OUTPUT_EXTENSION = '.bin'
+
+
+def _is_patchmaster(path):
+    """
+    Returns ``True`` if the file at ``path`` starts with the signature of a
+    HEKA PatchMaster file.
+    """
+    with open(path, 'rb') as f:
+        return f.read(3) == b'DAT'
+
+
+def _sweep_sources(path):
+    """
+    Opens the file at ``path`` and returns a tuple ``(handle, sources)``,
+    where ``handle`` is an object to close after use (or ``None``), and
+    ``sources`` is a list of tuples ``(suffix, source)`` for every
+    :class:`SweepSource` in the file.
+    """
+    ext = os.path.splitext(path)[1].lower()
+    if ext == '.abf':
+        from myokit.formats.axon import AbfFile
+        return None, [('', AbfFile(path))]
+    elif ext == '.wcp':
+        from myokit.formats.wcp import WcpFile
+        return None, [('', WcpFile(path))]
+    elif ext == '.dat':
+        # PatchMaster files contain several series, each a SweepSource. Other
+        # programs also use the .dat extension, so check the signature first.
+        if not _is_patchmaster(path):
+            raise ValueError(f'Not a HEKA PatchMaster file: {path}')
+        from myokit.formats.heka import PatchMasterFile
+        f = PatchMasterFile(path)
+        sources = []
+        for i, group in enumerate(f):
+            for j, series in enumerate(group.complete_series()):
+                sources.append((f'-{i}-{j}', series))
+        return f, sources
+    raise ValueError(f'Unsupported data file: {path}')
+
+
+def _convert_file(source, target, join_sweeps, use_names, include_da,
+                  precision):
+    """
+    Converts a single file, and returns a tuple ``(outputs, error)`` where
+    ``outputs`` is a list of files written, and ``error`` is ``None`` or a
+    string describing an error.
+
+    This function is run in worker processes by :meth:`convert_data`.
+    """
+    outputs = []
+    handle = None
+    try:
+        handle, sources = _sweep_sources(source)
+        for suffix, s in sources:
+            log = s.log(join_sweeps=join_sweeps, use_names=use_names,
+                        include_da=include_da)
+            path = target + suffix + OUTPUT_EXTENSION
+            log.save(path, precision=precision, compressed=False)
+            outputs.append(path)
+            del log
+    except Exception as e:
+        return outputs, f'{type(e).__name__}: {e}'
+    finally:
+        if handle is not None:
+            handle.close()
+    return outputs, None
+
+
+def _find_data_files(sources, target, recursive):
+    """
+    Returns a list of tuples ``(source, target)``, where ``source`` is the path
+    to a data file and ``target`` is the path to write to, without the output
+    extension.
+
+    Targets keep the source file's extension, so that e.g. ``a.abf`` and
+    ``a.wcp`` are written to different files. A ``ValueError`` is raised if
+    two sources would still be written to the same target.
+    """
+    jobs = []
+    for path in sources:
+        path = os.path.expanduser(str(path))
+        if os.path.isdir(path):
+            for root, dirs, files in os.walk(path):
+                dirs.sort()
+                if not recursive:
+                    dirs.clear()
+                rel = os.path.relpath(root, path)
+                for name in sorted(files):
+                    ext = os.path.splitext(name)[1].lower()
+                    if ext not in DATA_EXTENSIONS:
+                        continue
+                    source = os.path.join(root, name)
+                    if ext == '.dat' and not _is_patchmaster(source):
+                        continue
+                    jobs.append((
+                        source,
+                        os.path.normpath(os.path.join(target, rel, name))))
+        elif os.path.isfile(path):
+            jobs.append((path, os.path.join(target, os.path.basename(path))))
+        else:
+            raise FileNotFoundError(f'File or directory not found: {path}')
+
+    # Check for sources with the same target
+    targets = {}
+    for source, t in jobs:
+        key = os.path.normcase(os.path.abspath(t))
+        if key in targets:
+            raise ValueError(
+                f'Sources {targets[key]} and {source} would both be written'
+                f' to {t + OUTPUT_EXTENSION}.')
+        targets[key] = source
+    return jobs
+
+
+def convert_data(sources, target, join_sweeps=False, use_names=False,
+                 include_da=True, precision=myokit.DOUBLE_PRECISION,
+                 recursive=False, processes=None):
+    """
+    Converts ABF (``.abf``), WinWCP (``.wcp``), and HEKA PatchMaster
+    (``.dat``) files to :class:`myokit.DataLog` files, using a pool of worker
+    processes.
+
+    Each source file is opened as a :class:`SweepSource`, converted with
+    :meth:`SweepSource.log()`, and stored in the uncompressed binary format
+    written by ``DataLog.save(filename, compressed=False)``, so that the
+    results can be memory-mapped with ``DataLog.load(filename, mmap=True)``.
+    Output files are named after the source file, including its extension,
+    followed by ``.bin``, e.g. ``cell1.abf.bin``. A ``ValueError`` is raised
+    if two sources would be written to the same output file.
+
+    PatchMaster files contain several series, each of which is stored in a
+    separate file, with the index of the group and the index of the series
+    among the group's complete series appended to its name (see
+    :meth:`myokit.formats.heka.Group.complete_series`). Series that were
+    aborted before all sweeps were recorded are skipped. Files with a ``.dat``
+    extension that don't start with a PatchMaster signature are skipped when
+    scanning directories, and reported as errors when given explicitly.
+
+    Arguments:
+
+    ``sources``
+        A list of files and/or directories to convert. Directories are
+        scanned for files with a supported extension.
+    ``target``
+        The directory to write the converted files to. For sources found in
+        directories, the relative path from the source directory is kept.
+    ``join_sweeps``, ``use_names``, ``include_da``
+        Passed to :meth:`SweepSource.log()`.
+    ``precision``
+        Set to ``myokit.SINGLE_PRECISION`` to store data in single precision.
+    ``recursive``
+        Set to ``True`` to scan the subdirectories of source directories.
+    ``processes``
+        The number of worker processes to use, or ``None`` to use one process
+        per CPU. If set to 1, all files are converted in the current process.
+
+    Returns a :class:`ConversionReport`.
+    """
+    jobs = _find_data_files(sources, target, recursive)
+    for d in sorted(set(os.path.dirname(t) for s, t in jobs)):
+        os.makedirs(d, exist_ok=True)
+
+    if processes is None:
+        processes = os.cpu_count() or 1
+    processes = max(1, int(processes))
+
+    args = (join_sweeps, use_names, include_da, precision)
+    report = ConversionReport()
+    b = myokit.tools.Benchmarker()
+    if processes == 1 or len(jobs) < 2:
+        for source, t in jobs:
+            report._add(source, *_convert_file(source, t, *args))
+    else:
+        with concurrent.futures.ProcessPoolExecutor(
+                min(processes, len(jobs))) as pool:
+            futures = [
+                pool.submit(_convert_file, source, t, *args)
+                for source, t in jobs]
+            for (source, t), future in zip(jobs, futures):
+                report._add(source, *future.result())
+    report._time = b.time()
+    return report
+
+
+class ConversionReport:
+    """
+    Describes the results of a call to :meth:`convert_data`.
+
+    The string representation of a report lists any errors, followed by the
+    number of files converted and the throughput in files and megabytes (of
+    source data) per second.
+    """
+    def __init__(self):
+        self._converted = []
+        self._errors = []
+        self._bytes_read = 0
+        self._bytes_written = 0
+        self._time = 0
+
+    def _add(self, source, outputs, error):
+        """ Adds the result of converting a single file. """
+        size = os.path.getsize(source)
+        if error is None:
+            self._converted.append((source, outputs))
+            self._bytes_read += size
+        else:
+            self._errors.append((source, error))
+        for path in outputs:
+            self._bytes_written += os.path.getsize(path)
+
+    def __str__(self):
+        out = [f'Error converting {s}: {e}' for s, e in self._errors]
+        n = len(self._converted)
+        out.append(
+            f'Converted {n} file{"" if n == 1 else "s"}'
+            f' ({self._bytes_read / 1e6:.1f} MB) in {self._time:.2f} s:'
+            f' {self.files_per_second():.1f} files/s,'
+            f' {self.megabytes_per_second():.1f} MB/s.')
+        return '\n'.join(out)
+
+    def bytes_read(self):
+        """ Returns the total size of all successfully converted sources. """
+        return self._bytes_read
+
+    def bytes_written(self):
+        """ Returns the total size of all files written. """
+        return self._bytes_written
+
+    def converted(self):
+        """
+        Returns a list of tuples ``(source, outputs)`` for every file that was
+        converted, where ``outputs`` is a list of the files written.
+        """
+        return list(self._converted)
+
+    def errors(self):
+        """
+        Returns a list of tuples ``(source, message)`` for every file that
+        could not be converted.
+        """
+        return list(self._errors)
+
+    def files_per_second(self):
+        """ Returns the number of files converted per second. """
+        return len(self._converted) / self._time if self._time > 0 else 0
+
+    def megabytes_per_second(self):
+        """
+        Returns the number of megabytes of source data converted per second.
+        """
+        return self._bytes_read / 1e6 / self._time if self._time > 0 else 0
+
+    def time(self):
+        """ Returns the total time taken, in seconds. """
+        return self._time
@@ -209,15 +209,18 @@ class AbfFile(myokit.formats.SweepSource):
     - The publicly available information on the ABF format is not great, so
       there will be several other issues and shortcomings.
 
-    When an :class:`AbfFile` is created, the file at ``filepath`` is read in
-    its entirety and the file handle is closed. No try-catch or ``with``
-    statements are required.
+    When an :class:`AbfFile` is created, the file's header and protocol are
+    read, and its data section is memory-mapped. Recorded data is only read
+    from disk (and converted from integers to floating point) when a channel's
+    values are requested, so that a single channel or sweep can be obtained
+    from a large file without loading it in its entirety. To process all data
+    with bounded memory, use :meth:`iter_blocks` or :meth:`Channel.blocks`.
+    No try-catch or ``with`` statements are required.
 
     Arguments:
 
     ``filepath``
-        The path to load the data from. Data will be read into memory
-        immediately upon construction.
+        The path to load the data from.
     ``is_protocol_file``
         If set to ``True``, no attempt to read A/D data will be made and only
         D/A "protocol" information will be read. If left at its default value
@@ -865,19 +868,12 @@ class AbfFile(myokit.formats.SweepSource):
                 if f != 0:
                     size /= f
 
-            # Get a memory map to the relevant part of the data
+            # Get a memory map to the relevant part of the data. This is not
+            # copied or converted here: integer data is scaled to floating
+            # point only when a channel's values are accessed.
             part = data[pos: pos + size]
             pos += size
-            part = part.reshape(
-                (part.size // self._n_adc, self._n_adc)).astype('f')
-
-            # If needed, reformat the integers
-            if h['nDataFormat'] == 0:
-                # Data given as integers? Convert to floating point
-
-                for i in range(self._n_adc):
-                    part[:, i] *= self._adc_factors[i]
-                    part[:, i] += self._adc_offsets[i]
+            part = part.reshape((part.size // self._n_adc, self._n_adc))
 
             # Get start in other modes
             if self._mode != ACMODE_EPISODIC_STIMULATION:  # pragma: no cover
@@ -888,7 +884,10 @@ class AbfFile(myokit.formats.SweepSource):
             sweep = self._sweeps[i_sweep]
             for i in range(self._n_adc):
                 c = Channel(self)
-                c._data = part[:, i]    # Actually store the data
+                c._data = part[:, i]    # Store a view of the raw data
+                if h['nDataFormat'] == 0:
+                    c._factor = self._adc_factors[i]
+                    c._offset = self._adc_offsets[i]
                 c._rate = rate
                 c._start = start
                 c._is_reconstruction = False
@@ -1045,6 +1044,36 @@ class AbfFile(myokit.formats.SweepSource):
             return (np.concatenate(time), np.concatenate(data))
         return time, data
 
+    def iter_blocks(self, channels=None, block_size=None):
+        """
+        Iterates over the recorded (A/D) data in this file with bounded memory
+        use, yielding tuples ``(sweep, times, values)``.
+
+        Each sweep is split into blocks of at most ``block_size`` samples
+        (default ``2**20``), and for each block the index of the ``sweep``, a
+        numpy array of ``times``, and a list of ``values`` arrays (one for each
+        channel) are returned.
+
+        The channels to include can be set with ``channels``, a list of
+        integer indices or channel names. By default all A/D channels are
+        returned.
+        """
+        if channels is None:
+            channels = range(self._n_adc)
+        channels = [self._channel_id(c) for c in channels]
+        b = int(block_size or STREAM_BLOCK_SIZE)
+        if b < 1:
+            raise ValueError('Block size must be at least 1.')
+        for i_sweep, sweep in enumerate(self._sweeps):
+            if not channels:
+                continue
+            cs = [sweep[c] for c in channels]
+            n = len(cs[0]._data)
+            for i in range(0, n, b):
+                j = min(i + b, n)
+                yield i_sweep, cs[0]._times(i, j), [
+                    c._values(i, j) for c in cs]
+
     def channel_count(self):
         # Docstring in SweepSource
         return self._n_adc
@@ -1427,9 +1456,15 @@ class Channel:
         # The units this channel's data is in
         self._unit = None
 
-        # The raw data points
+        # The raw data points. For recorded integer data this is a view of a
+        # memory map of the file, which is scaled on access.
         self._data = None
 
+        # Factor and offset to convert integer data to floating point, or
+        # None if the data is not stored as integers
+        self._factor = None
+        self._offset = None
+
         # Sampling rate in Hz
         self._rate = None
 
@@ -1458,6 +1493,38 @@ class Channel:
             f'Channel({self._index} "{self._name}"); {len(self._data)} points'
             f' sampled at {self._rate}Hz, starts at t={self._start}.')
 
+    def _times(self, a, b):
+        """ Returns the times for samples ``a`` to ``b`` (exclusive). """
+        # Same arithmetic as np.arange, so that blocks match times()
+        f = 1 / self._rate
+        delta = (self._start + f) - self._start
+        return self._start + np.arange(a, b) * delta
+
+    def _values(self, a, b):
+        """ Returns the values for samples ``a`` to ``b`` (exclusive). """
+        x = np.array(self._data[a:b])
+        if self._factor is not None:
+            x = x.astype('f')
+            x *= self._factor
+            x += self._offset
+        return x
+
+    def blocks(self, block_size=None):
+        """
+        Iterates over this channel's data in blocks of at most ``block_size``
+        samples (default ``2**20``), yielding tuples ``(times, values)``.
+
+        Only a single block is read from disk and converted at a time, so this
+        can be used to process very long recordings with bounded memory.
+        """
+        n = len(self._data)
+        b = int(block_size or STREAM_BLOCK_SIZE)
+        if b < 1:
+            raise ValueError('Block size must be at least 1.')
+        for i in range(0, n, b):
+            j = min(i + b, n)
+            yield self._times(i, j), self._values(i, j)
+
     def times(self):
         """ Returns a copy of the values on the time axis. """
         n = len(self._data)
@@ -1469,8 +1536,13 @@ class Channel:
         return self._unit
 
     def values(self):
-        """ Returns a copy of the values on the data axis. """
-        return np.copy(self._data)
+        """
+        Returns a copy of the values on the data axis.
+
+        For channels recorded as integers, the data is read from disk and
+        converted to floating point each time this method is called.
+        """
+        return self._values(0, len(self._data))
 
 
 def dict_to_string(out, name, d, tab=''):
@@ -1510,6 +1582,9 @@ def list_to_string(out, name, d, tab=''):
 # Size of block alignment in ABF Files
 BLOCKSIZE = 512
 
+# Default number of samples per block when streaming data
+STREAM_BLOCK_SIZE = 1 << 20
+
 
 # A mu, sometimes found in unit strings
 MU = '\u00b5'
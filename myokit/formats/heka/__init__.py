@@ -24,6 +24,7 @@ from ._patchmaster import ( # noqa
     StimulusFile,
     Sweep,
     Trace,
+    TreeIndex,
     TreeNode,
 )
 from ._importer import PatchMasterImporter
@@ -34,6 +34,7 @@ import enum
 import os
 import struct
 import warnings
+import zipfile
 
 import numpy as np
 
@@ -120,10 +121,18 @@ class PatchMasterFile:
                 for series in group.complete_series():
                     log = series.log()
 
+    When a file is opened, only the positions of the records in each tree are
+    read. Group, series, sweep, and trace objects are created when they are
+    first accessed. If ``cache_index`` is set to ``True``, the record
+    positions are stored in a file next to the data file (see
+    :meth:`index_path`), so that the file can be reopened without indexing it
+    again. A cached index is ignored if the data file's size or modification
+    time has changed.
     """
-    def __init__(self, filepath):
+    def __init__(self, filepath, cache_index=False):
         warnings.warn(
-            'PatchMaster file reading is new: There are no unit tests yet.')
+            'PatchMaster file reading is new: It has only been tested with a'
+            ' small number of files.')
 
         # The path to the file and its basename
         self._filepath = os.path.abspath(filepath)
@@ -209,23 +218,36 @@ class PatchMasterFile:
                     ' more than once: ' + ext)
             self._items[ext] = (start, size)
 
-        # Read amplifier tree
+        # Index the trees, or load a cached index
+        trees = ('.amp', '.pgf', '.pul')
+        indices = self._load_index(trees) if cache_index else None
+        if indices is None:
+            indices = {}
+            for ext in trees:
+                if self._items[ext] is not None:
+                    f.seek(self._items[ext][0])
+                    indices[ext] = TreeIndex.create(f, self._items[ext][1])
+            if cache_index:
+                self._save_index(indices)
+
+        # Create tree roots. Any other nodes are created when first accessed.
         self._amp_tree = None
         if self._items['.amp'] is not None:
             f.seek(self._items['.amp'][0])
             self._amp_tree = TreeNode.read(
-                self, f, (AmplifierFile, AmplifierSeries, AmplifierStateRecord)
-            )
+                self, f,
+                (AmplifierFile, AmplifierSeries, AmplifierStateRecord),
+                indices['.amp'])
 
-        # Read stimulus tree
         f.seek(self._items['.pgf'][0])
         self._stimulus_tree = TreeNode.read(
-            self, f, (StimulusFile, Stimulus, StimulusChannel, Segment))
+            self, f, (StimulusFile, Stimulus, StimulusChannel, Segment),
+            indices['.pgf'])
 
-        # Read pulsed tree
         f.seek(self._items['.pul'][0])
         self._pulsed_tree = TreeNode.read(
-            self, f, (PulsedFile, Group, Series, Sweep, Trace))
+            self, f, (PulsedFile, Group, Series, Sweep, Trace),
+            indices['.pul'])
 
     def __enter__(self):
         return self
@@ -233,9 +255,15 @@ class PatchMasterFile:
     def __exit__(self, type, value, tb):
         self._handle.close()
 
+    def __getitem__(self, key):
+        return self._pulsed_tree[key]
+
     def __iter__(self):
         return iter(self._pulsed_tree)
 
+    def __len__(self):
+        return len(self._pulsed_tree)
+
     def amplifier_tree(self):
         """
         Returns this file's amplifier tree (an :class:`AmplifierFile` object),
@@ -255,11 +283,57 @@ class PatchMasterFile:
 
     def group(self, label):
         """ Returns the first :class`Group` matching the given ``label``. """
-        for g in self:
-            if g.label() == label:
-                return g
+        # Search labels in the index, so that only one group is created
+        labels = self._pulsed_tree._children.records(
+            [('label', 4, 'S32')])['label']
+        for i, x in enumerate(labels):
+            if _decode(x) == label:
+                return self._pulsed_tree[i]
         raise KeyError(f'Group not found: {label}')
 
+    def index_path(self):
+        """
+        Returns the path used to cache this file's index, if ``cache_index``
+        is set.
+        """
+        return self._filepath + '.myokit-index.npz'
+
+    def _load_index(self, trees):
+        """
+        Loads and returns a cached dict of :class:`TreeIndex` objects, or
+        returns ``None`` if no valid cached index is found.
+        """
+        path = self.index_path()
+        if not os.path.isfile(path):
+            return None
+        stat = os.stat(self._filepath)
+        try:
+            with np.load(path, allow_pickle=False) as d:
+                meta = d['meta']
+                if (meta[0] != _INDEX_VERSION or meta[1] != stat.st_size
+                        or meta[2] != stat.st_mtime_ns):
+                    return None
+                indices = {}
+                for ext in trees:
+                    if self._items[ext] is not None:
+                        indices[ext] = TreeIndex.from_arrays(d, ext)
+                return indices
+        except (OSError, ValueError, KeyError, zipfile.BadZipFile):
+            return None
+
+    def _save_index(self, indices):
+        """ Stores a dict of :class:`TreeIndex` objects in the index file. """
+        stat = os.stat(self._filepath)
+        arrays = {'meta': np.array(
+            [_INDEX_VERSION, stat.st_size, stat.st_mtime_ns], dtype=np.int64)}
+        for ext, index in indices.items():
+            arrays.update(index.arrays(ext))
+        try:
+            with open(self.index_path(), 'wb') as f:
+                np.savez(f, **arrays)
+        except OSError as e:
+            warnings.warn(f'Unable to store PatchMaster index: {e}')
+
     def path(self):
         """ Returns the path to this PatchMaster file. """
         return self._filepath
@@ -336,8 +410,11 @@ class TreeNode:
     calling the constructor with a ``parent`` but no children. (2) Calling the
     method :meth:`_read_properties` which should read record properties from
     the open file handle and update the ``TreeNode`` accordingly. (3) Calling
-    the method :meth:`_read_finalize`, which can handl any actions that require
-    children to have been added.
+    the method :meth:`_read_finalize`, which can handle any actions that
+    require access to the node's children.
+
+    Nodes are created on demand, using a :class:`TreeIndex`: the children of a
+    node are only read from disk when they are first accessed.
     """
     def __init__(self, parent):
         self._parent = parent
@@ -361,9 +438,10 @@ class TreeNode:
         return self._parent
 
     @staticmethod
-    def read(pfile, handle, levels):
+    def read(pfile, handle, levels, index=None):
         """
-        Reads a full HEKA "Tree" structure.
+        Reads a HEKA "Tree" structure, and returns a TreeNode representing the
+        tree's root. Other nodes are created when they are first accessed.
 
         Arguments:
 
@@ -373,88 +451,244 @@ class TreeNode:
             An file handle, open at the tree root.
         ``levels``
             The classes to use for each tree level.
+        ``index``
+            An optional :class:`TreeIndex` for this tree. If not given, the
+            tree will be indexed first.
+
+        """
+        if index is None:
+            index = TreeIndex.create(handle)
+        if len(index.sizes) != len(levels):
+            raise ValueError(
+                'Unexpected number of levels found in tree: expected'
+                f' ({len(levels)}), found ({len(index.sizes)}).')
+        reader = EndianAwareReader(handle, index.is_little_endian)
+        return index.node(pfile, handle, reader, levels, 0, 0)
 
-        Returns a TreeNode representing the tree's root.
+    def _read_properties(self, handle, reader):
         """
+        Reads information from the file ``handle``, open at this node's record
+        start, and sets any properties not relating to the node's children.
+
+        For arguments meanings, see :meth:`_read`.
+        """
+        pass
+
+    def _read_finalize(self):
+        """
+        Performs any initialization actions that require children to have
+        already been set.
+        """
+        pass
+
+
+class TreeIndex:
+    """
+    An index of the records in a HEKA "Tree" structure, used to create
+    :class:`TreeNode` objects on demand.
+
+    For each tree level, the index stores the file position of every record
+    (in depth-first order), and the number of children of each record. The
+    children of each record form a contiguous range in the next level.
+
+    Indices are created with :meth:`create`, which reads only the record
+    sizes and child counts, and does not interpret any record contents.
+    """
+    def __init__(self, is_little_endian, sizes, offsets, counts):
+        self.is_little_endian = bool(is_little_endian)
+        self.sizes = tuple(int(x) for x in sizes)
+        self.offsets = [np.asarray(x, dtype=np.int64) for x in offsets]
+        self.counts = [np.asarray(x, dtype=np.int64) for x in counts]
+        if not (len(self.sizes) == len(self.offsets) == len(self.counts)):
+            raise ValueError('Invalid tree index.')
+        for o, c in zip(self.offsets, self.counts):
+            if len(o) != len(c):
+                raise ValueError('Invalid tree index.')
+        for c, o in zip(self.counts[:-1], self.offsets[1:]):
+            if np.sum(c) != len(o):
+                raise ValueError('Invalid tree index.')
+
+        # Index of each record's first child in the next level
+        self.firsts = [np.cumsum(c) - c for c in self.counts]
+
+    def arrays(self, prefix):
+        """
+        Returns a dict of numpy arrays representing this index, with keys
+        starting with ``prefix``.
+        """
+        d = {
+            f'{prefix}.endian': np.array([self.is_little_endian]),
+            f'{prefix}.sizes': np.array(self.sizes, dtype=np.int64),
+        }
+        for i, (o, c) in enumerate(zip(self.offsets, self.counts)):
+            d[f'{prefix}.offsets.{i}'] = o
+            d[f'{prefix}.counts.{i}'] = c
+        return d
+
+    @staticmethod
+    def create(handle, size=None):
+        """
+        Creates an index for the tree at the current position of ``handle``,
+        reading at most ``size`` bytes.
+        """
+        start = handle.tell()
+        data = handle.read(-1 if size is None else size)
+
         # Get endianness
-        m = handle.read(4).decode(_ENC)
+        m = data[:4].decode(_ENC)
         if m == 'Tree':
-            is_little_endian = False
+            e = '>'
         elif m == 'eerT':
-            is_little_endian = True
+            e = '<'
         else:
             raise ValueError(   # pragma: no-cover
                 'Invalid or unsupported file: Unable to read tree.')
-        reader = EndianAwareReader(handle, is_little_endian)
+        count = struct.Struct(e + 'i').unpack_from
 
-        # Number of levels in this tree
-        n = reader.read1('i')
-        sizes = reader.read(n * 'i')
-        if n != len(levels):
+        try:
+            # Number of levels in this tree, and record size per level
+            n = count(data, 4)[0]
+            sizes = struct.unpack_from(f'{e}{n}i', data, 8)
+            offsets = [[] for i in range(n)]
+            counts = [[] for i in range(n)]
+
+            # Records at the deepest level have no children, so that they can
+            # be indexed in blocks
+            leaf = n - 1
+            leaf_step = sizes[leaf] + 4
+            leaf_dtype = np.dtype(e + 'i4')
+
+            def visit(depth, pos):
+                offsets[depth].append(pos)
+                pos += sizes[depth]
+                k = count(data, pos)[0]
+                pos += 4
+                counts[depth].append(k)
+                if depth + 1 == leaf:
+                    if k > 0:
+                        kids = np.ndarray(
+                            (k, ), leaf_dtype, data, pos + sizes[leaf],
+                            (leaf_step, ))
+                        if np.any(kids):
+                            raise ValueError(
+                                'Invalid or unsupported file: Unexpected'
+                                ' children at deepest tree level.')
+                        offsets[leaf].append(
+                            pos + leaf_step * np.arange(k, dtype=np.int64))
+                    pos += k * leaf_step
+                else:
+                    for i in range(k):
+                        pos = visit(depth + 1, pos)
+                return pos
+
+            visit(0, 8 + 4 * n)
+        except (struct.error, TypeError, IndexError, RecursionError):
             raise ValueError(
-                'Unexpected number of levels found in tree: expected'
-                f' ({len(levels)}), found ({n}).')
+                'Invalid or unsupported file: Unable to read tree.')
+
+        # Convert to arrays with file positions
+        for i in range(n):
+            if i == leaf and i > 0:
+                x = offsets[i]
+                offsets[i] = np.concatenate(x) if x else np.zeros(0, int)
+                counts[i] = np.zeros(len(offsets[i]), int)
+            offsets[i] = start + np.array(offsets[i], dtype=np.int64)
 
-        # Go!
-        return TreeNode._read(pfile, handle, reader, levels, sizes)
+        return TreeIndex(e == '<', sizes, offsets, counts)
 
     @staticmethod
-    def _read(parent, handle, reader, levels, sizes, depth=0):
+    def from_arrays(arrays, prefix):
         """
-        Recursively reads a node and its children.
-
-        Arguments:
-
-        ``parent``
-            The parent node to the one being read. For the root object,
-            ``parent`` is the :class:`PatchMasterFile`.
-        ``handle``
-            A file handle, open at the record contents.
-        ``reader``
-            A :class:`Reader` object using the handle.
-        ``levels``
-            A list of classes to use for each level. The current level is
-            ``levels[depth]``.
-        ``sizes``
-            A list of record contents sizes. The current record size is
-            ``sizes[depth]``.
-        ``depth``
-            The current level being read.
+        Creates an index from a dict of arrays, as returned by
+        :meth:`arrays`.
+        """
+        sizes = arrays[f'{prefix}.sizes']
+        return TreeIndex(
+            arrays[f'{prefix}.endian'][0],
+            sizes,
+            [arrays[f'{prefix}.offsets.{i}'] for i in range(len(sizes))],
+            [arrays[f'{prefix}.counts.{i}'] for i in range(len(sizes))],
+        )
 
+    def node(self, parent, handle, reader, levels, depth, i):
+        """
+        Creates and returns the ``i``-th node at the given ``depth``, with
+        the given ``parent``, using the classes in ``levels``.
         """
-        # Create node
         node = levels[depth](parent)
-
-        # Read properties
-        pos = handle.tell()
+        handle.seek(int(self.offsets[depth][i]))
         node._read_properties(handle, reader)
-
-        # Add kids
-        handle.seek(pos + sizes[depth])
-        n = reader.read1('i')
-        for i in range(n):
-            node._children.append(TreeNode._read(
-                node, handle, reader, levels, sizes, depth + 1))
-
-        # Finalize and return
+        if depth + 1 < len(self.sizes):
+            a = int(self.firsts[depth][i])
+            node._children = _NodeList(
+                self, node, handle, reader, levels, depth + 1, a,
+                a + int(self.counts[depth][i]))
         node._read_finalize()
         return node
 
-    def _read_properties(self, handle, reader):
+    def records(self, handle, depth, fields, a=0, b=None):
         """
-        Reads information from the file ``handle``, open at this node's record
-        start, and sets any properties not relating to the node's children.
+        Reads selected fields from records ``a`` to ``b`` (exclusive) at the
+        given ``depth``, and returns them as a numpy structured array.
 
-        For arguments meanings, see :meth:`_read`.
+        Fields are specified as a list of tuples ``(name, offset, format)``,
+        where ``format`` is a numpy type string, e.g. ``'S32'`` or ``'f8'``.
         """
-        pass
+        e = '<' if self.is_little_endian else '>'
+        dtype = np.dtype({
+            'names': [x[0] for x in fields],
+            'formats': [e + x[2] for x in fields],
+            'offsets': [x[1] for x in fields],
+        })
+        offsets = self.offsets[depth][a:b]
+        if len(offsets) == 0:
+            return np.zeros(0, dtype)
+        m = np.memmap(handle, np.uint8, 'r')
+        x = m[offsets[:, None] + np.arange(dtype.itemsize)]
+        return np.ascontiguousarray(x).view(dtype)[:, 0]
 
-    def _read_finalize(self):
+
+class _NodeList:
+    """
+    A read-only sequence of the children of a :class:`TreeNode`, which creates
+    each child when it is first accessed.
+    """
+    def __init__(self, index, parent, handle, reader, levels, depth, a, b):
+        self._index = index
+        self._parent = parent
+        self._handle = handle
+        self._reader = reader
+        self._levels = levels
+        self._depth = depth
+        self._a = a
+        self._nodes = [None] * (b - a)
+
+    def __getitem__(self, key):
+        if isinstance(key, slice):
+            return [self[i] for i in range(*key.indices(len(self._nodes)))]
+        node = self._nodes[key]     # Raises IndexError or TypeError
+        if node is None:
+            key = key if key >= 0 else key + len(self._nodes)
+            node = self._nodes[key] = self._index.node(
+                self._parent, self._handle, self._reader, self._levels,
+                self._depth, self._a + key)
+        return node
+
+    def __iter__(self):
+        for i in range(len(self._nodes)):
+            yield self[i]
+
+    def __len__(self):
+        return len(self._nodes)
+
+    def records(self, fields):
         """
-        Performs any initialization actions that require children to have
-        already been set.
+        Reads fields from the records of all nodes in this list, without
+        creating any nodes. See :meth:`TreeIndex.records`.
         """
-        pass
+        return self._index.records(
+            self._handle, self._depth, fields, self._a,
+            self._a + len(self._nodes))
 
 
 #
@@ -564,11 +798,20 @@ class Group(TreeNode):
         for n=0, the second for n=1, etc.).
         """
         i = 0
-        for series in (self.complete_series() if complete_only else self):
-            if series.label() == label:
-                if i == n:
-                    return series
-                i += 1
+        if complete_only:
+            for series in self.complete_series():
+                if series.label() == label:
+                    if i == n:
+                        return series
+                    i += 1
+        else:
+            # Search labels in the index, so that only one series is created
+            labels = self._children.records([('label', 4, 'S32')])['label']
+            for j, x in enumerate(labels):
+                if _decode(x) == label:
+                    if i == n:
+                        return self[j]
+                    i += 1
         raise ValueError('Unable to find the requested series.')
 
 
@@ -2908,6 +3151,9 @@ class AmplifierStateRecord(TreeNode):
 # Encoding for text parts of files
 _ENC = 'latin-1'
 
+# Version of the cached index file format
+_INDEX_VERSION = 1
+
 # Time offset since 1990, utc
 _tz = datetime.timezone.utc
 _ts_1990 = datetime.datetime(1990, 1, 1, tzinfo=_tz).timestamp()
@@ -2915,3 +3161,14 @@ _ts_1990 = datetime.datetime(1990, 1, 1, tzinfo=_tz).timestamp()
 _data_types = (np.int16, np.int32, np.float32, np.float64)
 _data_sizes = (2, 4, 4, 8)
 
+
+def _decode(b):
+    """
+    Decodes a string read with :meth:`TreeIndex.records`, in the same way as
+    :meth:`EndianAwareReader.str`.
+    """
+    b = bytes(b).decode(_ENC)
+    try:
+        return b[:b.index('\x00')]
+    except ValueError:
+        return b
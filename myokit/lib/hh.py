@@ -270,7 +270,9 @@ class HHModel:
         # sequence of state values and current is a single current value. If _t
         # is a numpy array of times, states is a sequence of arrays, and
         # current is a numpy array. If no current variable is known current is
-        # always None.
+        # always None. All arguments can be numpy arrays that broadcast against
+        # each other, in which case states and current have the broadcast
+        # shape.
         #
         f = []
         args = ['_y0', '_t'] + [i.uname() for i in self._inputs]
@@ -295,12 +297,9 @@ class HHModel:
             tau = w.ex(myokit.Name(tau))
             k = str(k)
             f.append(
-                '_y[' + k + '] = ' + state.uname() + ' = '
-                + inf + ' + (_y0[' + k + '] - ' + inf
-                + ') * numpy.exp(-_t / ' + tau + ')')
-            f.append(
-                '_y[' + k + '][_t == 0] = ' + state.uname() + '[_t == 0] = '
-                + '_y0[' + k + ']')
+                '_y[' + k + '] = ' + state.uname() + ' = numpy.where(_t == 0, '
+                + '_y0[' + k + '], ' + inf + ' + (_y0[' + k + '] - ' + inf
+                + ') * numpy.exp(-_t / ' + tau + '))')
 
         # Add current calculation
         if self._current is not None:
@@ -455,12 +454,12 @@ class HHModel:
 
         The returned function has the signature::
 
-            f(y0, t, p1, p2, p3, ..., V) --> (states, current)
+            f(y0, t, V, p1, p2, p3, ...) --> (states, current)
 
         where ``y0`` is a sequence containing the state values at time 0, where
         ``t`` is a scalar or numpy array of times at which to evaluate, where
-        ``p1, p2, p3, ...`` are the model parameters, and where ``V`` is the
-        membrane potential.
+        ``V`` is the membrane potential, and where ``p1, p2, p3, ...`` are the
+        model parameters.
 
         The function output is always a tuple ``(states, current)``. If ``t``
         is a single time, then ``states`` will be a list of values (one per
@@ -468,6 +467,13 @@ class HHModel:
         variable was specified). If ``t`` is a numpy array of times then
         ``states`` will be a list of numpy arrays, and current will be a numpy
         array (or ``None`` if no current variable was specified).
+
+        The entries of ``y0``, ``t``, ``V`` and the parameters can also be
+        numpy arrays that broadcast against each other, in which case every
+        state and the current are arrays with the broadcast shape. For example,
+        passing arrays of shape ``(n, 1)`` for the initial states, membrane
+        potential and parameters, and an array of shape ``(m, )`` for ``t``,
+        results in arrays of shape ``(n, m)``.
         """
         return self._function
 
@@ -839,6 +845,164 @@ class AnalyticalSimulation:
         self._state = np.array(states[:, -1], copy=True)
         self._time = tnext
 
+    def run_batch(self, parameters, duration, log_interval=0.01,
+                  log_times=None, states=None, protocols=None):
+        """
+        Runs a simulation for ``duration`` time units, for a whole population
+        of parameter vectors, initial states, and/or protocols at once.
+
+        Each member of the population starts from the current simulation time,
+        and uses the current state, parameters, and protocol or membrane
+        potential, unless these are given as arguments. In contrast to
+        :meth:`run()`, the simulation time and state are *not* updated.
+
+        The protocol steps of all members are merged, after which all members
+        are evaluated together with a single call to the model's
+        :meth:`HHModel.function()` per step. As a result, families of
+        activation or inactivation protocols can be simulated with a handful of
+        numpy operations.
+
+        Arguments:
+
+        ``parameters``
+            An array of shape ``(n, len(self.parameters()))`` where each row
+            contains a parameter vector, or ``None`` to use the current
+            parameters for all members.
+        ``duration``
+            The number of time units to simulate.
+        ``log_interval``
+            The time between logged points.
+        ``log_times``
+            A pre-defined sequence of times to log at. If set, ``log_interval``
+            will be ignored.
+        ``states``
+            An optional array of shape ``(n, len(self.state()))`` where each
+            row contains an initial state.
+        ``protocols``
+            An optional sequence of ``n`` :class:`myokit.Protocol` objects, or
+            ``None`` to use this simulation's protocol or membrane potential
+            for all members.
+
+        All arguments that are given must describe the same number of members
+        ``n``.
+
+        For models with a current variable, this method returns a tuple
+        ``(states, currents)`` where ``states`` is an array of shape
+        ``(n, n_states, n_times)`` and ``currents`` has shape
+        ``(n, n_times)``. For models without a current variable, only
+        ``states`` is returned.
+        """
+        # Check arguments
+        duration = float(duration)
+        if duration < 0:
+            raise ValueError('Duration must be non-negative.')
+        log_interval = float(log_interval)
+        if log_interval <= 0:
+            raise ValueError('Log interval must be greater than zero.')
+
+        # Check log_times
+        if log_times is None:
+            log_times = self._time + np.arange(0, duration, log_interval)
+        log_times = np.asarray(log_times, dtype=float)
+
+        # Check population
+        sizes = set()
+        if parameters is None:
+            parameters = self._parameters.reshape((1, -1))
+        else:
+            parameters = np.array(parameters, dtype=float, ndmin=2)
+            if parameters.shape[1:] != self._parameters.shape:
+                raise ValueError('Illegal parameter array shape.')
+            sizes.add(len(parameters))
+        if states is None:
+            states = self._state.reshape((1, -1))
+        else:
+            states = np.array(states, dtype=float, ndmin=2)
+            if states.shape[1:] != self._state.shape:
+                raise ValueError('Illegal state array shape.')
+            sizes.add(len(states))
+        if protocols is None:
+            protocols = [self._protocol]
+        else:
+            protocols = list(protocols)
+            for p in protocols:
+                if not isinstance(p, myokit.Protocol):
+                    raise ValueError(
+                        'Protocols must be myokit.Protocol objects.')
+            sizes.add(len(protocols))
+        if len(sizes) > 1:
+            raise ValueError(
+                'The parameters, states and protocols must all describe the'
+                ' same number of members.')
+        n = sizes.pop() if sizes else 1
+
+        # Get the step boundaries and membrane potentials of every distinct
+        # protocol object
+        tfinal = self._time + duration
+        steps, index, seen = [], [], {}
+        for protocol in protocols:
+            try:
+                index.append(seen[id(protocol)])
+                continue
+            except KeyError:
+                seen[id(protocol)] = len(steps)
+                index.append(len(steps))
+            if protocol is None:
+                steps.append(([self._time], [self._membrane_potential]))
+                continue
+            pacing = myokit.PacingSystem(protocol)
+            vm = pacing.advance(self._time)
+            times, vms = [self._time], [vm]
+            while True:
+                tnext = pacing.next_time()
+                if tnext >= tfinal:
+                    break
+                vm = pacing.advance(tnext)
+                times.append(tnext)
+                vms.append(vm)
+            steps.append((times, vms))
+
+        # Merge steps, and get the membrane potential of every member during
+        # every merged step
+        times = np.unique(np.concatenate([t for t, v in steps] + [[tfinal]]))
+        vms = np.empty((len(times) - 1, len(steps)))
+        for i, (t, v) in enumerate(steps):
+            vms[:, i] = np.asarray(v)[
+                np.searchsorted(t, times[:-1], side='right') - 1]
+        vms = np.broadcast_to(vms[:, index], (len(times) - 1, n))
+
+        # Propagate all members through the protocol together, evaluating the
+        # logged times and the end of each step in a single call. For sorted
+        # log times, the times in each step are selected with a slice.
+        ordered = np.all(log_times[1:] >= log_times[:-1])
+        y = np.array(np.broadcast_to(states, (n, len(self._state))).T)
+        p = np.broadcast_to(parameters, (n, len(self._parameters))).T
+        p = [x.reshape((n, 1)) for x in p]
+        shape = (n, len(log_times))
+        x_out = np.zeros((n, len(self._state), len(log_times)))
+        i_out = np.zeros(shape) if self._has_current else None
+        for k in range(len(times) - 1):
+            # Without a protocol, all times are used, as in run()
+            t0, t1 = times[k], times[k + 1]
+            if len(times) == 2:
+                sel = slice(None)
+            elif ordered:
+                sel = slice(*np.searchsorted(log_times, (t0, t1)))
+            else:
+                sel = np.logical_and(log_times >= t0, log_times < t1)
+            t = np.append(log_times[sel] - t0, t1 - t0)
+            x, i = self._function(
+                y.reshape(y.shape + (1, )), t, vms[k].reshape((n, 1)), *p)
+            x = np.stack([np.broadcast_to(xj, (n, len(t))) for xj in x], 1)
+            x_out[:, :, sel] = x[:, :, :-1]
+            if self._has_current:
+                i_out[:, sel] = np.broadcast_to(i, (n, len(t)))[:, :-1]
+            y = x[:, :, -1].T
+
+        if self._has_current:
+            return x_out, i_out
+        return x_out
+
     def set_constant(self, variable, value):
         """
         Updates a single parameter to a new value.
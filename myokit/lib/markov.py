@@ -363,32 +363,39 @@ class LinearModel:
         del T
 
         #
-        # Create function to create parametrisable matrices
+        # Create function to create parametrisable matrices, and a batch
+        # version that accepts arrays as inputs and returns stacked matrices
+        # with leading dimensions ``shape``.
         #
-        self._model.reserve_unique_names('A', 'B', 'n', 'numpy')
+        self._model.reserve_unique_names('A', 'B', 'n', 'numpy', 'shape')
         writer = myokit.numpy_writer()
         w = writer.ex
-        head = 'def matrix_function('
-        head += ','.join([w(p.lhs()) for p in self._inputs])
-        head += '):'
-        body = []
-        body.append('A = numpy.zeros((n, n))')
+        args = ','.join([w(p.lhs()) for p in self._inputs])
         zero = myokit.Number(0)
-        for i, row in enumerate(A):
-            for j, e in enumerate(row):
+        for batch in (False, True):
+            name = 'batch_matrix_function' if batch else 'matrix_function'
+            shape = 'shape + ' if batch else ''
+            pre = '...,' if batch else ''
+            head = 'def ' + name + '(' + ('shape,' if batch else '')
+            head += args + '):'
+            body = []
+            body.append('A = numpy.zeros(' + shape + '(n, n))')
+            for i, row in enumerate(A):
+                for j, e in enumerate(row):
+                    if e != zero:
+                        body.append('A[' + pre + str(i) + ',' + str(j)
+                                    + '] = ' + w(e))
+            body.append('B = numpy.zeros(' + shape + '(n, ))')
+            for j, e in enumerate(B):
                 if e != zero:
-                    body.append('A[' + str(i) + ',' + str(j) + '] = ' + w(e))
-        body.append('B = numpy.zeros(n)')
-        for j, e in enumerate(B):
-            if e != zero:
-                body.append('B[' + str(j) + '] = ' + w(e))
-        body.append('return A, B')
-        code = head + '\n' + '\n'.join(['    ' + line for line in body])
-        globl = {'numpy': np, 'n': n}
-        local = {}
+                    body.append('B[' + pre + str(j) + '] = ' + w(e))
+            body.append('return A, B')
+            code = head + '\n' + '\n'.join(['    ' + line for line in body])
+            globl = {'numpy': np, 'n': n}
+            local = {}
 
-        exec(code, globl, local)
-        self._matrix_function = local['matrix_function']
+            exec(code, globl, local)
+            setattr(self, '_' + name, local[name])
 
         #
         # Create function to return list of transition rates
@@ -516,6 +523,50 @@ class LinearModel:
         # Create and return LinearModel
         return LinearModel(model, states, parameters, current, vm)
 
+    def batch_matrices(self, membrane_potentials=None, parameters=None):
+        """
+        Calculates the matrices ``A`` and ``B`` returned by :meth:`matrices`
+        for every combination of a set of parameter vectors and a set of
+        membrane potentials, using a single evaluation of numpy expressions.
+
+        Arguments:
+
+        ``membrane_potentials``
+            A sequence of ``n_voltages`` values to use for the membrane
+            potential, or ``None`` to use only the value from the original
+            :class:`myokit.Model`.
+        ``parameters``
+            An array of shape ``(n_params, len(self.parameters()))``, where
+            each row contains a parameter vector given in the order the
+            parameters were originally specified in. If ``None``, only the
+            default parameter values are used.
+
+        Returns a tuple ``(A, B)``, where ``A`` is an array of shape
+        ``(n_params, n_voltages, n_states, n_states)`` and ``B`` has shape
+        ``(n_params, n_voltages, n_states)``.
+        """
+        if membrane_potentials is None:
+            vm = np.array([self._default_inputs[-1]], dtype=float)
+        else:
+            vm = np.array(membrane_potentials, dtype=float).reshape((-1, ))
+        if parameters is None:
+            parameters = np.array([self._default_inputs[:-1]], dtype=float)
+        else:
+            parameters = np.array(parameters, dtype=float)
+            if parameters.ndim != 2 or (
+                    parameters.shape[1] != len(self._parameters)):
+                raise ValueError(
+                    'Illegal parameter array shape: (n, '
+                    + str(len(self._parameters)) + ') required, '
+                    + str(parameters.shape) + ' provided.')
+
+        # Pass in parameters as columns, and voltages as a row, so that all
+        # expressions broadcast to shape (n_params, n_voltages)
+        shape = (len(parameters), len(vm))
+        inputs = [parameters[:, i:i + 1] for i in range(len(self._parameters))]
+        inputs.append(vm.reshape((1, -1)))
+        return self._batch_matrix_function(shape, *inputs)
+
     def matrices(self, membrane_potential=None, parameters=None):
         """
         For a given value of the ``membrane_potential`` and a list of values
@@ -969,6 +1020,116 @@ class AnalyticalSimulation:
         self._state = np.array(states[:, -1], copy=True)
         self._time = tnext
 
+    def run_batch(
+            self, parameters, duration, log_interval=0.01, log_times=None):
+        """
+        Runs a simulation for ``duration`` time units, for a whole set of
+        parameter vectors at once.
+
+        Each simulation starts from the current simulation time and state,
+        and uses this simulation's protocol or membrane potential. In contrast
+        to :meth:`run()`, the simulation time and state are *not* updated.
+
+        The matrices for all combinations of parameters and membrane
+        potentials are calculated with :meth:`LinearModel.batch_matrices`,
+        after which their eigenvalue decompositions are calculated at once.
+        All parameter vectors are then propagated through each step of the
+        protocol together, so that the number of numpy operations depends on
+        the number of steps in the protocol, but not on the number of
+        parameter vectors.
+
+        Arguments:
+
+        ``parameters``
+            An array of shape ``(n_params, len(self.parameters()))``, where
+            each row contains a parameter vector.
+        ``duration``
+            The number of time units to simulate.
+        ``log_interval``
+            The time between logged points.
+        ``log_times``
+            A pre-defined sequence of times to log at. If set, ``log_interval``
+            will be ignored.
+
+        For models with a current variable, this method returns a tuple
+        ``(states, currents)`` where ``states`` is an array of shape
+        ``(n_params, n_states, n_times)`` and ``currents`` has shape
+        ``(n_params, n_times)``. For models without a current variable, only
+        ``states`` is returned.
+        """
+        # Check arguments
+        duration = float(duration)
+        if duration < 0:
+            raise ValueError('Duration must be non-negative.')
+        log_interval = float(log_interval)
+        if log_interval <= 0:
+            raise ValueError('Log interval must be greater than zero.')
+
+        # Check log_times
+        if log_times is None:
+            log_times = self._time + np.arange(0, duration, log_interval)
+        log_times = np.asarray(log_times, dtype=float)
+
+        # Get a list of tuples (start, end, membrane potential)
+        tfinal = self._time + duration
+        if self._protocol is None:
+            steps = [(self._time, tfinal, self._membrane_potential)]
+        else:
+            steps = []
+            pacing = myokit.PacingSystem(self._protocol)
+            vm = pacing.advance(self._time)
+            time = self._time
+            while time < tfinal:
+                tnext = min(tfinal, pacing.next_time())
+                steps.append((time, tnext, vm))
+                vm = pacing.advance(tnext)
+                time = tnext
+
+        # Calculate all matrices and eigenvalue decompositions
+        voltages = sorted(set([vm for t0, t1, vm in steps]))
+        A, B = self._model.batch_matrices(voltages, parameters)
+        E, P = np.linalg.eig(A)
+        PI = np.linalg.inv(P)
+        voltages = dict([(vm, i) for i, vm in enumerate(voltages)])
+
+        # Propagate all states through the protocol. For sorted log times, the
+        # times in each step are selected with a slice, which is much faster
+        # than a boolean mask.
+        ordered = np.all(log_times[1:] >= log_times[:-1])
+        n_params, n = len(A), len(self._state)
+        states = np.zeros((n_params, n, len(log_times)))
+        currents = np.zeros((n_params, len(log_times)))
+        x = np.tile(self._state, (n_params, 1))
+        for k, (t0, t1, vm) in enumerate(steps):
+            i = voltages[vm]
+            Ei, Pi = E[:, i], P[:, i]
+            y0 = np.matmul(PI[:, i], x[:, :, None])[:, :, 0]
+
+            # Evaluate states and currents at the logged times. Without a
+            # protocol, all times are used, as in run().
+            if self._protocol is None:
+                select = slice(None)
+            elif ordered:
+                select = slice(*np.searchsorted(log_times, (t0, t1)))
+            else:
+                select = np.logical_and(log_times >= t0, log_times < t1)
+            dt = log_times[select] - t0
+            y = np.exp(Ei[:, :, None] * dt)
+            y *= y0[:, :, None]
+            states[:, :, select] = np.real(np.matmul(Pi, y))
+            if self._has_current:
+                currents[:, select] = np.matmul(
+                    B[:, i, None, :], states[:, :, select])[:, 0]
+
+            # Calculate states at the end of the step
+            if k + 1 < len(steps):
+                x = np.real(np.matmul(
+                    Pi, (y0 * np.exp(Ei * (t1 - t0)))[:, :, None]))[:, :, 0]
+
+        if self._has_current:
+            return states, currents
+        return states
+
     def set_constant(self, variable, value):
         """
         Updates a single parameter to a new value.
@@ -1101,6 +1262,11 @@ class DiscreteSimulation:
     finite number of channels.
 
     Simulations are run using the "Direct method" proposed by Gillespie [1].
+    Where possible, this is done with a compiled back-end that selects
+    transitions using a Fenwick tree over the transition propensities. As an
+    approximate but faster alternative, the back-end can use fixed-step
+    tau-leaping [2] (see :meth:`set_tau_leaping`). If the back-end cannot be
+    compiled, a slower Python implementation of the direct method is used.
 
     Each simulation object maintains an internal state consisting of
 
@@ -1145,6 +1311,10 @@ class DiscreteSimulation:
         stochastic time evolution of coupled chemical reactions
         The Journal of Computational Physics, 22, 403-434.
 
+    [2] Gillespie (2001) Approximate accelerated stochastic simulation of
+        chemically reacting systems.
+        The Journal of Chemical Physics, 115, 1716-1733.
+
     Arguments:
 
     ``model``
@@ -1199,6 +1369,9 @@ class DiscreteSimulation:
         # Set simulation time
         self._time = 0
 
+        # Time between leaps, or None for the exact method
+        self._tau = None
+
         # If protocol was given, create pacing system, update vm
         self._pacing = None
         if self._protocol:
@@ -1371,6 +1544,14 @@ class DiscreteSimulation:
                 raise ValueError(
                     'Invalid log: missing entry for <' + str(key) + '>.')
 
+        # Simulate with the compiled back-end, if available
+        if self._run_native(duration, log):
+            return log
+        if self._tau is not None:  # pragma: no cover
+            raise RuntimeError(
+                'Tau-leaping requires a compiled back-end, which could not be'
+                ' created.')
+
         if self._protocol is None:
             # Simulate with fixed V
             self._run(duration, log)
@@ -1391,9 +1572,208 @@ class DiscreteSimulation:
         # Return
         return log
 
+    def run_batch(self, runs, duration, log_interval=0.01, log_times=None,
+                  threads=None):
+        """
+        Runs ``runs`` independent realisations of a simulation for
+        ``duration`` time units, using the compiled back-end.
+
+        Each realisation starts from the current simulation time and state,
+        and uses this simulation's protocol or membrane potential. In contrast
+        to :meth:`run()`, the simulation time and state are *not* updated.
+
+        Every realisation uses its own random number stream, derived from
+        numpy's global random number generator, so that results do not depend
+        on the number of threads and can be reproduced by calling
+        ``numpy.random.seed()``.
+
+        Arguments:
+
+        ``runs``
+            The number of realisations to simulate.
+        ``duration``
+            The number of time units to simulate.
+        ``log_interval``
+            The time between logged points.
+        ``log_times``
+            A pre-defined non-decreasing sequence of times to log at. If set,
+            ``log_interval`` will be ignored.
+        ``threads``
+            The number of threads to use, or ``None`` to use one thread per
+            CPU.
+
+        For models with a current variable, this method returns a tuple
+        ``(states, currents)`` where ``states`` is an integer array of shape
+        ``(runs, n_states, n_times)`` with the number of channels in each
+        state, and ``currents`` has shape ``(runs, n_times)``. For models
+        without a current variable, only ``states`` is returned.
+        """
+        import concurrent.futures
+        from myokit._sim.ssa import NativeSSA
+
+        # Check arguments
+        runs = int(runs)
+        if runs < 1:
+            raise ValueError('The number of runs must be at least 1.')
+        duration = float(duration)
+        if duration < 0:
+            raise ValueError('Duration must be non-negative.')
+        log_interval = float(log_interval)
+        if log_interval <= 0:
+            raise ValueError('Log interval must be greater than zero.')
+
+        # Check log_times
+        if log_times is None:
+            log_times = self._time + np.arange(0, duration, log_interval)
+        log_times = np.ascontiguousarray(log_times, dtype=float)
+        if np.any(log_times[1:] < log_times[:-1]):
+            raise ValueError('Log times must be non-decreasing.')
+        if NativeSSA._get_instance() is None:   # pragma: no cover
+            raise RuntimeError(
+                'Unable to compile the back-end: ' + str(NativeSSA._message))
+
+        # Get protocol steps and transition rates
+        pacing = None
+        vm = self._membrane_potential
+        if self._protocol is not None:
+            pacing = myokit.PacingSystem(self._protocol)
+            vm = pacing.advance(self._time)
+        times, vms, vm = self._steps(self._time + duration, pacing, vm)
+        transitions, rates = self._transitions(vms)
+
+        # Run all realisations
+        state = np.array(self._state, dtype=np.int64)
+        seeds = NativeSSA.seeds(runs)
+        tau = self._tau or 0
+
+        def run(i):
+            return NativeSSA.run(
+                state.copy(), transitions, times, rates, seeds[i], log_times,
+                tau=tau)[0]
+
+        nthreads = min(runs, myokit.tools.thread_count(threads))
+        if nthreads == 1:
+            logged = [run(i) for i in range(runs)]
+        else:
+            with concurrent.futures.ThreadPoolExecutor(nthreads) as pool:
+                logged = list(pool.map(run, range(runs)))
+        states = np.stack(logged).transpose(0, 2, 1)
+
+        # Calculate currents
+        if self._model.current() is None:
+            return states
+        return states, self._currents(times, vms, log_times, states)
+
+    def _run_native(self, duration, log):
+        """
+        Runs a simulation with the compiled back-end, and appends the results
+        to ``log``. Returns ``False`` if the back-end is not available.
+        """
+        from myokit._sim.ssa import NativeSSA
+        if NativeSSA._get_instance() is None:
+            return False
+
+        # Get protocol steps and transition rates, update pacing
+        tfinal = self._time + duration
+        times, vms, vm = self._steps(
+            tfinal, self._pacing, self._membrane_potential)
+        transitions, rates = self._transitions(vms)
+
+        # Run
+        state = np.array(self._state, dtype=np.int64)
+        rng = NativeSSA.seeds(1)[0]
+        logged, t, x = NativeSSA.run(
+            state, transitions, times, rates, rng, events=True,
+            tau=self._tau or 0)
+
+        # Log times, membrane potentials, states, and current
+        log.time().extend(t)
+        k = np.searchsorted(times, t, side='right') - 1
+        log[self._model._membrane_potential].extend(np.array(vms)[k])
+        for i, key in enumerate(self._model.states()):
+            log[key].extend(x[:, i])
+        c = self._model.current()
+        if c is not None:
+            log[c].extend(self._currents(times, vms, t, x.T[None, :, :])[0])
+
+        # Update state, time, and membrane potential
+        self._state = list(state)
+        self._time = tfinal
+        if self._pacing is not None:
+            self._membrane_potential = vm
+            self._cached_rates = None
+            self._cached_matrix = None
+        return True
+
+    def _steps(self, tfinal, pacing, vm):
+        """
+        Returns a tuple ``(times, vms, vm)`` where ``times`` contains the
+        boundaries of the protocol steps from the current time to ``tfinal``,
+        ``vms`` contains the membrane potential during each step, and ``vm``
+        is the membrane potential at ``tfinal``.
+
+        If a ``pacing`` system is given it is advanced to ``tfinal``, otherwise
+        the membrane potential ``vm`` is used throughout.
+        """
+        times = [self._time]
+        vms = []
+        if pacing is None:
+            if self._time < tfinal:
+                times.append(tfinal)
+                vms.append(vm)
+        else:
+            time = self._time
+            while time < tfinal:
+                tnext = min(tfinal, pacing.next_time())
+                times.append(tnext)
+                vms.append(vm)
+                vm = pacing.advance(tnext)
+                time = tnext
+        return np.array(times), vms, vm
+
+    def _transitions(self, vms):
+        """
+        Returns a tuple ``(transitions, rates)``, where ``transitions`` is an
+        array of shape ``(2, m)`` with the source and target state of each
+        transition, and ``rates`` is an array of shape ``(len(vms), m)`` with
+        the transition rates at every membrane potential in ``vms``.
+        """
+        rates = self._model.rates(self._membrane_potential, self._parameters)
+        transitions = np.ascontiguousarray(
+            np.array([(i, j) for i, j, r in rates], dtype=np.int64).T)
+        cache = {}
+        for vm in vms:
+            if vm not in cache:
+                cache[vm] = [r for i, j, r in self._model.rates(
+                    vm, self._parameters)]
+        rates = np.array([cache[vm] for vm in vms], dtype=float)
+        return transitions, rates.reshape((len(vms), transitions.shape[1]))
+
+    def _currents(self, times, vms, log_times, states):
+        """
+        Calculates the currents for an array of ``states`` of shape
+        ``(runs, n_states, n_times)``, logged at ``log_times`` during the
+        protocol steps given by ``times`` and ``vms``.
+        """
+        currents = np.zeros((states.shape[0], len(log_times)))
+        if len(vms) == 0:
+            return currents
+        k = np.clip(
+            np.searchsorted(times, log_times, side='right') - 1,
+            0, len(vms) - 1)
+        x = states / self._nchannels
+        cache = {}
+        for i, vm in enumerate(vms):
+            if vm not in cache:
+                cache[vm] = self._model.matrices(vm, self._parameters)[1]
+            sel = k == i
+            currents[:, sel] = np.einsum('j,rjt->rt', cache[vm], x[:, :, sel])
+        return currents
+
     def _run(self, duration, log):
         """
-        Runs a simulation with the current membrane potential.
+        Runs a simulation with the current membrane potential, using a Python
+        implementation of the direct method.
         """
         # Get logging lists
         log_time = log.time()
@@ -1465,10 +1845,11 @@ class DiscreteSimulation:
         # Note that for large tau, the estimates of the probability that
         # something changes may become inaccurate (and > 1)
         # I didn't see this in testing...
+        # The compiled back-end (see myokit/_sim/ssa.c) uses the same rule.
         tau = (self._time + duration) - t
         lambdas *= tau
         for i, r in enumerate(lambdas):
-            if np.random.uniform(0, 1) < r:
+            if np.random.uniform(0, 1) < r and state[SI[i]] > 0:
                 # Perform transition
                 state[SI[i]] -= 1
                 state[SJ[i]] += 1
@@ -1560,12 +1941,39 @@ class DiscreteSimulation:
                 + str(self._nchannels) + '.')
         self._state = list(state)
 
+    def set_tau_leaping(self, tau=None):
+        """
+        Enables tau-leaping with a fixed time ``tau`` between leaps, or
+        restores the default exact simulation if ``tau`` is ``None``.
+
+        In each leap, the number of channels leaving every state is drawn from
+        a binomial distribution, based on the number of channels in that
+        state at the start of the leap, and is then divided over the possible
+        transitions. This is much faster than the exact method for large
+        numbers of channels, but only accurate if ``tau`` is small compared to
+        the time scales of the model.
+
+        Tau-leaping requires the compiled back-end.
+        """
+        if tau is not None:
+            tau = float(tau)
+            if not tau > 0:
+                raise ValueError('The time between leaps must be positive.')
+        self._tau = tau
+
     def state(self):
         """
         Returns the current simulation state.
         """
         return list(self._state)
 
+    def tau_leaping(self):
+        """
+        Returns the time between leaps used for tau-leaping, or ``None`` if
+        the exact method is used.
+        """
+        return self._tau
+
 
 class MarkovModel:
     """
@@ -6,10 +6,15 @@
 #
 import ast
 import io
+import os
 import re
 import sys
 import traceback
 
+# Converted and compiled templates, as a dict mapping absolute paths to tuples
+# (modification time, size, script, code).
+_cache = {}
+
 
 class TemplateEngine:
     """
@@ -56,8 +61,8 @@ class TemplateEngine:
                 'Second argument passed to process() must be dict'
                 ' (variable_name : value)')
 
-        # Convert script, any exceptions are thrown as PypeErrors
-        script = self._convert(filename)
+        # Convert and compile script, any exceptions are thrown as PypeErrors
+        script, code = self._compile(filename)
 
         # Get or create output stream
         stdout = self.stream if self.stream else io.StringIO()
@@ -73,7 +78,7 @@ class TemplateEngine:
                 syserr = sys.stderr
                 sys.stdout = stdout
                 sys.stderr = stderr
-                exec(script, variables)
+                exec(code, variables)
             except Exception:
                 error = sys.exc_info()
             finally:
@@ -138,6 +143,33 @@ class TemplateEngine:
         # Custom stream? Then don't interfere. If not, return stream contents.
         return None if self.stream else stdout.getvalue()
 
+    def _compile(self, filename):
+        """
+        Converts and compiles the template at ``filename``, and returns a tuple
+        ``(script, code)`` containing the Python source and compiled code.
+
+        Results are cached, and reused for as long as the template's
+        modification time and size are unchanged.
+        """
+        path = os.path.abspath(filename)
+        stat = os.stat(path)
+        try:
+            mtime, size, script, code = _cache[path]
+            if mtime == stat.st_mtime_ns and size == stat.st_size:
+                return script, code
+        except KeyError:
+            pass
+
+        script = self._convert(path)
+        try:
+            code = compile(script, '<string>', 'exec')
+        except SyntaxError:
+            # Don't cache, but let process() report the error
+            _cache.pop(path, None)
+            return script, script
+        _cache[path] = (stat.st_mtime_ns, stat.st_size, script, code)
+        return script, code
+
     def _convert(self, source):
         """
         Translates a pype file to a python file
@@ -0,0 +1,190 @@
+#!/usr/bin/env python3
+#
+# Generates patchmaster-synthetic.dat, a small HEKA PatchMaster bundle used in
+# the tests. Run this script from any directory to regenerate the file.
+#
+# The file contains:
+#  - Group "Cell 1", with a complete series "IV" (3 sweeps) and a series "IV"
+#    that was aborted after 2 out of 3 sweeps.
+#  - Group "Cell 2", with a complete series "IV" (3 sweeps).
+#
+# Each sweep has a single trace "Imon", stored as 16-bit integers, where the
+# n-th sample of sweep k in series j of group i has the value
+#   1000 * i + 100 * j + 10 * k + n (times 1e-12 A).
+#
+# All series use the same stimulus: a step from -80 mV to -20, -10, or 0 mV.
+#
+# Only the fields read by myokit.formats.heka are set; everything else is 0.
+#
+# This file is part of Myokit.
+# See http://myokit.org for copyright, sharing, and licensing details.
+#
+import os
+import struct
+
+import numpy as np
+
+# Time, in seconds since 1990
+T0 = 1e9
+
+# Stimulus segments (value, value increment per sweep, duration), and number
+# of sweeps
+SEGMENTS = ((-0.08, 0, 0.01), (-0.02, 0.01, 0.02), (-0.08, 0, 0.01))
+N_SWEEPS = 3
+
+# Sampling interval, and samples per sweep
+DT = 1e-3
+N_SAMPLES = 40
+
+# Groups, with a list of (series label, number of sweeps recorded)
+GROUPS = (
+    ('Cell 1', (('IV', 3), ('IV', 2))),
+    ('Cell 2', (('IV', 3), )),
+)
+
+
+def record(size, *fields):
+    """
+    Returns a record of ``size`` bytes, with fields ``(offset, form, value)``.
+    """
+    b = bytearray(size)
+    for offset, form, value in fields:
+        if isinstance(value, str):
+            value = value.encode('latin-1')
+        struct.pack_into('<' + form, b, offset, value)
+    return bytes(b)
+
+
+def tree(sizes, root):
+    """
+    Returns a (little-endian) tree, with the given record ``sizes`` per level,
+    and the given ``root`` node, where each node is a tuple
+    ``(record, children)``.
+    """
+    def node(x):
+        data, children = x
+        return (data + struct.pack('<i', len(children))
+                + b''.join(node(c) for c in children))
+
+    n = len(sizes)
+    return b'eerT' + struct.pack(f'<i{n}i', n, *sizes) + node(root)
+
+
+def generate(path):
+    """ Writes the synthetic file to ``path``. """
+
+    # Raw data, stored directly after the bundle header
+    raw = []
+    pos = 256
+
+    # Pulsed tree: PulsedFile, Group, Series, Sweep, Trace
+    groups = []
+    for i, (glabel, series) in enumerate(GROUPS):
+        gseries = []
+        for j, (slabel, n_sweeps) in enumerate(series):
+            sweeps = []
+            for k in range(n_sweeps):
+                data = 1000 * i + 100 * j + 10 * k + np.arange(N_SAMPLES)
+                raw.append(data.astype('<i2').tobytes())
+                trace = record(
+                    512,
+                    (4, '32s', 'Imon'),         # TrLabel
+                    (40, 'i', pos),             # TrData
+                    (44, 'i', N_SAMPLES),       # TrDataPoints
+                    (72, 'd', 1e-12),           # TrDataScaler
+                    (96, '8s', 'A'),            # TrYUnit
+                    (104, 'd', DT),             # TrXInterval
+                    (120, '8s', 's'),           # TrXUnit
+                    (152, 'd', 5e6),            # TrPipetteResistance
+                    (168, 'd', 2e9),            # TrSealResistance
+                    (176, 'd', 2e-11),          # TrCSlow
+                    (184, 'd', 1e-7),           # TrGSeries
+                    (192, 'd', 5e6),            # TrRsValue
+                )
+                pos += len(raw[-1])
+                sweep = record(
+                    288,
+                    (4, '32s', f'Sweep {k + 1}'),   # SwLabel
+                    (40, 'i', 1),                   # SwStimCount
+                    (48, 'd', T0 + 60 * j + k),     # SwTime
+                )
+                sweeps.append((sweep, [(trace, [])]))
+            s = record(
+                1408,
+                (4, '32s', slabel),         # SeLabel
+                (124, 'i', 472),            # SeAmplStateOffset
+                (136, 'd', T0 + 60 * j),    # SeTime
+                (472 + 8, 'd', 1e10),       # sCurrentGain
+                (472 + 88, 'd', 1e-7),      # sGSeries
+            )
+            gseries.append((s, sweeps))
+        g = record(
+            144,
+            (4, '32s', glabel),     # GrLabel
+            (116, 'i', i + 1),      # GrExperimentNumber
+        )
+        groups.append((g, gseries))
+    root = record(
+        640,
+        (8, '32s', 'v2x90.2'),  # RoVersionName
+        (520, 'd', T0),         # RoStartTime
+    )
+    pul = tree((640, 144, 1408, 288, 512), (root, groups))
+
+    # Stimulus tree: StimulusFile, Stimulus, StimulusChannel, Segment
+    segments = []
+    for v, dv, d in SEGMENTS:
+        segments.append((record(
+            80,
+            (4, 'b', 0),    # seClass: Constant
+            (5, 'b', 1),    # seStoreKind: Stored
+            (8, 'd', v),    # seVoltage
+            (20, 'd', 1),   # seDeltaVFactor
+            (28, 'd', dv),  # seDeltaVIncrement
+            (36, 'd', d),   # seDuration
+            (48, 'd', 1),   # seDeltaTFactor
+        ), []))
+    channel = record(
+        400,
+        (25, 'b', 1),       # chAmplMode: Voltage clamp
+        (40, '8s', 'V'),    # chDacUnit
+        (48, 'd', -0.08),   # chHolding
+        (76, '?', True),    # chStimToDacID: UseStimScale
+    )
+    stimulus = record(
+        248,
+        (4, '32s', 'IV'),       # stEntryName
+        (112, 'd', DT),         # stSampleInterval
+        (120, 'd', 0.1),        # stSweepInterval
+        (144, 'i', N_SWEEPS),   # stNumberSweeps
+    )
+    root = record(584, (8, '32s', 'v2x90.2'))
+    pgf = tree(
+        (584, 248, 400, 80), (root, [(stimulus, [(channel, segments)])]))
+
+    # Bundle header, followed by the raw data and the trees
+    raw = b''.join(raw)
+    items = (('.dat', 256, len(raw)),
+             ('.pul', 256 + len(raw), len(pul)),
+             ('.pgf', 256 + len(raw) + len(pul), len(pgf)))
+    fields = [
+        (0, '8s', 'DAT2'),      # oSignature
+        (8, '32s', 'v2x90.2'),  # oVersion
+        (40, 'd', T0),          # oTime
+        (48, 'i', len(items)),  # oItems
+        (52, '?', True),        # oIsLittleEndian
+    ]
+    for i, (ext, start, size) in enumerate(items):
+        fields.append((64 + 16 * i, 'i', start))
+        fields.append((68 + 16 * i, 'i', size))
+        fields.append((72 + 16 * i, '8s', ext))
+    with open(path, 'wb') as f:
+        f.write(record(256, *fields))
+        f.write(raw)
+        f.write(pul)
+        f.write(pgf)
+
+
+if __name__ == '__main__':
+    generate(os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                          'patchmaster-synthetic.dat'))
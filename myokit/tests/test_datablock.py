@@ -141,6 +141,19 @@ class DataBlock1dTest(unittest.TestCase):
         b = os.path.join(DIR_DATA, 'cv1d.zip')
         b = myokit.DataBlock1d.load(b)
         self.assertAlmostEqual(b.cv('membrane.V'), 5.95272837350686004e+01)
+        self.assertAlmostEqual(b.cv('membrane.V', border=0), 61.5106861026695)
+
+        # Threshold is used to detect activation
+        time = np.linspace(0, 10, 101)
+        d = myokit.DataLog(time='time')
+        d['time'] = time
+        for i in range(6):
+            d['x', i] = np.minimum(0, -85 + 20 * np.maximum(0, time - i))
+        b2 = myokit.DataBlock1d.from_log(d)
+        self.assertAlmostEqual(
+            b2.cv('x', threshold=-80, border=0, length=1, time_multiplier=1),
+            1)
+        self.assertEqual(b2.cv('x', threshold=10, border=0), 0)
 
         # Invalid border argument
         # Negative
@@ -438,6 +451,90 @@ class DataBlock1dTest(unittest.TestCase):
         b = myokit.DataBlock1d.load(path, p)
         self.assertIsNone(b)
 
+    def test_save_frames(self):
+        # Test saving and loading in frame-based format.
+
+        t = np.arange(200) * 0.1
+        b = myokit.DataBlock1d(5, t)
+        b.set0d('pace', (t % 1) < 0.2)
+        b.set1d('x', np.sin(np.outer(t, np.arange(5))))
+        b.set1d('y', np.cos(np.outer(t, np.arange(5))))
+        with TemporaryDirectory() as d:
+            path = d.path('block.frames')
+            b.save_frames(path)
+            c = myokit.DataBlock1d.load(path)
+            self.assertEqual(c.shape(), b.shape())
+            self.assertTrue(np.all(c.time() == b.time()))
+            self.assertTrue(np.all(c.get0d('pace') == b.get0d('pace')))
+            self.assertTrue(np.all(c.get1d('x') == b.get1d('x')))
+            self.assertTrue(np.all(c.get1d('y') == b.get1d('y')))
+
+            # Load part, with memory mapping
+            c = myokit.DataBlock1d.load_frames(
+                path, names=['y'], a=3, b=5, mmap=True)
+            self.assertEqual(c.shape(), (20, 5))
+            self.assertEqual(list(c.keys0d()), [])
+            self.assertEqual(list(c.keys1d()), ['y'])
+            self.assertTrue(np.all(c.get1d('y') == b.get1d('y')[30:50]))
+            self.assertRaisesRegex(
+                KeyError, 'not found', myokit.DataBlock1d.load_frames, path,
+                names=['z'])
+
+            # Load as 2d block
+            c = myokit.DataBlock2d.load(path)
+            self.assertEqual(c.shape(), (200, 1, 5))
+            self.assertTrue(np.all(c.get2d('x')[:, 0, :] == b.get1d('x')))
+
+            # Append from a log
+            path = d.path('log.frames')
+            e = b.to_log()
+            with myokit.DataBlockWriter(path, myokit.SINGLE_PRECISION) as w:
+                w.append_log(e.itrim(0, 50))
+                w.append_log(e.itrim(50, 200))
+                self.assertEqual(w.length(), 200)
+            c = myokit.DataBlock1d.load(path)
+            self.assertEqual(c.get1d('x').dtype, np.float32)
+            self.assertTrue(np.all(c.time() == b.time()))
+            self.assertTrue(np.allclose(c.get1d('x'), b.get1d('x')))
+
+    def test_save_chunked(self):
+        # Test saving and loading in chunked format.
+
+        t = np.arange(200) * 0.1
+        b = myokit.DataBlock1d(5, t)
+        b.set0d('pace', (t % 1) < 0.2)
+        b.set1d('x', np.sin(np.outer(t, np.arange(5))))
+        b.set1d('y', np.cos(np.outer(t, np.arange(5))))
+        with TemporaryDirectory() as d:
+            path = d.path('block.chunked')
+            b.save_chunked(path, chunk_size=16, transform='xor')
+            c = myokit.DataBlock1d.load(path)
+            self.assertEqual(c.shape(), b.shape())
+            self.assertTrue(np.all(c.time() == b.time()))
+            self.assertTrue(np.all(c.get0d('pace') == b.get0d('pace')))
+            self.assertTrue(np.all(c.get1d('x') == b.get1d('x')))
+            self.assertTrue(np.all(c.get1d('y') == b.get1d('y')))
+
+            # Load part
+            c = myokit.DataBlock1d.load_chunked(path, names=['y'], a=3, b=5)
+            self.assertEqual(c.shape(), (20, 5))
+            self.assertEqual(list(c.keys0d()), [])
+            self.assertEqual(list(c.keys1d()), ['y'])
+            self.assertTrue(np.all(c.get1d('y') == b.get1d('y')[30:50]))
+            self.assertRaisesRegex(
+                KeyError, 'not found', myokit.DataBlock1d.load_chunked, path,
+                names=['z'])
+
+            # Load as 2d block
+            c = myokit.DataBlock2d.load(path)
+            self.assertEqual(c.shape(), (200, 1, 5))
+
+            # Load 2d block as 1d block
+            b.block2d().save_chunked(path)
+            self.assertRaisesRegex(
+                myokit.DataBlockReadError, 'does not contain a DataBlock1d',
+                myokit.DataBlock1d.load, path)
+
     def test_remove0d(self):
         # Test remove0d().
 
@@ -784,6 +881,53 @@ class DataBlock2dTest(unittest.TestCase):
         self.assertTrue(np.all(c[1] == t1))
         self.assertTrue(np.all(c[2] == t2))
 
+    def test_colors_array(self):
+        # Test rendering to a single array, and iterating over frames
+
+        b = myokit.DataBlock2d(3, 2, [1, 2, 3, 4, 5])
+        x = np.random.RandomState(1).normal(size=(5, 2, 3))
+        b.set2d('x', x)
+        for cmap in myokit.ColorMap.names():
+            c = b.colors('x', colormap=cmap, multiplier=2)
+            a = b.colors_array('x', colormap=cmap, multiplier=2)
+            self.assertEqual(a.shape, (5, 4, 6, 3))
+            self.assertEqual(a.dtype, np.uint8)
+            self.assertTrue(np.all(a == np.array(c)))
+            i = [f.copy() for f in b.iter_colors(
+                'x', colormap=cmap, multiplier=2)]
+            self.assertTrue(np.all(a == np.array(i)))
+
+        # Frames agree with calling the colormap directly
+        cmap = myokit.ColorMap.get('viridis')
+        lower, upper = np.min(x), np.max(x)
+        for frame, y in zip(b.colors('x', colormap='viridis'), x):
+            z = cmap(y.reshape(6), lower, upper, alpha=False, rgb=True)
+            self.assertTrue(np.all(frame.reshape(18) == z))
+
+        # Rendering in batches
+        rbs = myokit._datablock.RENDER_BATCH_SIZE
+        try:
+            myokit._datablock.RENDER_BATCH_SIZE = 12
+            c = b.colors_array('x', colormap='traditional', multiplier=3)
+            d = list(b.iter_colors('x', colormap='traditional'))
+        finally:
+            myokit._datablock.RENDER_BATCH_SIZE = rbs
+        self.assertTrue(np.all(
+            c == b.colors_array('x', colormap='traditional', multiplier=3)))
+        self.assertEqual(len(d), 5)
+
+        # Preallocated output
+        out = np.zeros((5, 2, 3, 3), dtype=np.uint8)
+        a = b.colors_array('x', colormap='gray', out=out)
+        self.assertIs(a, out)
+        self.assertTrue(np.all(a == np.array(b.colors('x', 'gray'))))
+        self.assertRaisesRegex(
+            ValueError, 'shape', b.colors_array, 'x', out=out[:4])
+        self.assertRaisesRegex(
+            ValueError, 'shape', b.colors_array, 'x', out=out.astype(int))
+        self.assertRaisesRegex(
+            ValueError, 'shape', b.colors_array, 'x', multiplier=2, out=out)
+
     def test_colors_multiplier(self):
         # Test using the multiplier argument in colors
 
@@ -1269,6 +1413,68 @@ class DataBlock2dTest(unittest.TestCase):
         self.assertAlmostEqual(e[1], -0.5 + np.sqrt(3) / 2j)
         self.assertAlmostEqual(e[2], 1)
 
+    def test_eigenvalues_batched(self):
+        # Test calculating eigenvalues in batches and in parallel
+
+        r = np.random.RandomState(1)
+        x = r.normal(size=(20, 4, 4))
+        x[:10] += x[:10].transpose((0, 2, 1))
+        b = myokit.DataBlock2d(4, 4, np.arange(20))
+        b.set2d('x', x)
+        e = [np.linalg.eigvals(y) for y in x]
+        d = [y[np.argmax(np.abs(y))] for y in e]
+        m = [y[np.argmax(np.real(y))] for y in e]
+
+        batch = myokit._datablock.EIGEN_BATCH_SIZE
+        try:
+            myokit._datablock.EIGEN_BATCH_SIZE = 48
+            for threads in (1, 3):
+                self.assertTrue(np.all(
+                    b.eigenvalues('x', threads=threads) == e))
+                self.assertTrue(np.all(
+                    b.dominant_eigenvalues('x', threads=threads) == d))
+                self.assertTrue(np.all(
+                    b.largest_eigenvalues('x', threads=threads) == m))
+        finally:
+            myokit._datablock.EIGEN_BATCH_SIZE = batch
+
+        # Real results for real eigenvalues
+        c = myokit.DataBlock2d(4, 4, np.arange(10))
+        c.set2d('x', x[:10])
+        self.assertFalse(np.iscomplexobj(c.eigenvalues('x')))
+        self.assertFalse(np.iscomplexobj(c.dominant_eigenvalues('x')))
+
+        # Empty block
+        c = myokit.DataBlock2d(4, 4, [])
+        c.set2d('x', np.zeros((0, 4, 4)))
+        self.assertEqual(len(c.eigenvalues('x')), 0)
+
+    def test_eigenvalues_power_iteration(self):
+        # Test estimating dominant eigenvalues with power iteration
+
+        # Well separated, real eigenvalues
+        r = np.random.RandomState(1)
+        q = r.normal(size=(5, 5)) + 5 * np.eye(5)
+        qi = np.linalg.inv(q)
+        x = np.array([(q * [-100 - i, -1, -2, -3, 4]) @ qi for i in range(6)])
+        b = myokit.DataBlock2d(5, 5, np.arange(6))
+        b.set2d('x', x)
+        e = b.dominant_eigenvalues('x', power_iteration=True)
+        self.assertFalse(np.iscomplexobj(e))
+        self.assertTrue(np.allclose(e, -100 - np.arange(6), rtol=1e-8))
+
+        # Complex dominant eigenvalues and zero matrices use LAPACK
+        x[2] = 0
+        x[3] = 0
+        x[3, :2, :2] = [[0, -5], [5, 0]]
+        b.set2d('x', x)
+        e = b.dominant_eigenvalues('x', power_iteration=True, threads=2)
+        self.assertTrue(np.iscomplexobj(e))
+        self.assertEqual(e[2], 0)
+        self.assertAlmostEqual(abs(e[3]), 5)
+        self.assertAlmostEqual(e[3].real, 0)
+        self.assertAlmostEqual(e[4], -104)
+
     def test_largest_eigenvalues(self):
         # Test the largest_eigenvalues method.
 
@@ -1374,6 +1580,128 @@ class DataBlock2dTest(unittest.TestCase):
         b = myokit.DataBlock2d.load(path, p)
         self.assertIsNone(b)
 
+    def test_save_frames(self):
+        # Test saving and loading in frame-based format.
+
+        t = np.arange(50) * 0.5
+        b = myokit.DataBlock2d(4, 3, t)
+        b.set0d('pace', t > 10)
+        x = np.random.default_rng(1).normal(size=(50, 3, 4)).cumsum(axis=0)
+        b.set2d('x', x)
+        b.set2d('y', -x)
+        with TemporaryDirectory() as d:
+            path = d.path('block.frames')
+            b.save_frames(path)
+            c = myokit.DataBlock2d.load(path)
+            self.assertEqual(c.shape(), b.shape())
+            self.assertTrue(np.all(c.time() == b.time()))
+            self.assertTrue(np.all(c.get0d('pace') == b.get0d('pace')))
+            self.assertTrue(np.all(c.get2d('x') == x))
+            self.assertTrue(np.all(c.get2d('y') == -x))
+
+            # Frames are aligned
+            head = myokit._datablock._frames_header(
+                'DataBlock2d', (3, 4), ['pace'], ['x', 'y'], 'd')
+            self.assertEqual(head['record_size'] % 64, 0)
+            self.assertTrue(all(o % 64 == 0 for k, o in head['columns'][2:]))
+
+            # Load a time window, with memory mapping
+            c = myokit.DataBlock2d.load_frames(path, a=12.1, b=20, mmap=True)
+            self.assertEqual(c.shape(), (15, 3, 4))
+            self.assertTrue(np.all(c.get2d('x') == x[25:40]))
+            self.assertTrue(np.shares_memory(c.get2d('x'), c.get2d('x')[3]))
+            self.assertFalse(c.get2d('x').flags.writeable)
+            c = myokit.DataBlock2d.load_frames(path, a=100)
+            self.assertEqual(c.shape(), (0, 3, 4))
+
+            # Incomplete frames at the end are ignored
+            with open(path, 'rb') as f:
+                data = f.read()
+            path2 = d.path('cut.frames')
+            with open(path2, 'wb') as f:
+                f.write(data[:-1])
+            c = myokit.DataBlock2d.load(path2)
+            self.assertEqual(c.shape(), (49, 3, 4))
+            self.assertTrue(np.all(c.get2d('x') == x[:49]))
+
+            # Bad files
+            with open(path2, 'wb') as f:
+                f.write(data[:20])
+            self.assertRaisesRegex(
+                myokit.DataBlockReadError, 'format',
+                myokit.DataBlock2d.load_frames, path2)
+            with open(path2, 'wb') as f:
+                f.write(data[:16] + bytes(8))
+            self.assertRaisesRegex(
+                myokit.DataBlockReadError, 'version',
+                myokit.DataBlock2d.load_frames, path2)
+            with open(path2, 'wb') as f:
+                f.write(data[:20] + bytes([3, 0, 0, 0]) + b'abc')
+            self.assertRaisesRegex(
+                myokit.DataBlockReadError, 'header',
+                myokit.DataBlock2d.load_frames, path2)
+            self.assertRaisesRegex(
+                myokit.DataBlockReadError, 'DataBlock1d',
+                myokit.DataBlock1d.load_frames, path)
+
+            # Write frame by frame from a log
+            path = d.path('log.frames')
+            e = b.to_log()
+            with myokit.DataBlockWriter(path) as w:
+                for i in range(0, 50, 7):
+                    w.append_log(e.itrim(i, i + 7))
+                    w.flush()
+                    c = myokit.DataBlock2d.load(path)
+                    self.assertEqual(c.shape(), (min(50, i + 7), 3, 4))
+            c = myokit.DataBlock2d.load(path)
+            self.assertTrue(np.all(c.time() == t))
+            self.assertTrue(np.all(c.get2d('x') == x))
+            self.assertTrue(np.all(c.get2d('y') == -x))
+
+            # Writer errors
+            w = myokit.DataBlockWriter(path)
+            self.assertRaisesRegex(ValueError, 'needed', w.append, [1])
+            self.assertRaisesRegex(
+                ValueError, '1d or 2d', w.append, [1], None,
+                {'x': np.zeros((1, 2, 2, 2))})
+            self.assertRaisesRegex(
+                ValueError, 'sequence', w.append, [[1]])
+            w.append([1, 2], {'a': [3, 4]}, {'x': np.zeros((2, 2, 2))})
+            self.assertRaisesRegex(
+                ValueError, 'non-decreasing', w.append, [1.5],
+                {'a': [3]}, {'x': np.zeros((1, 2, 2))})
+            self.assertRaisesRegex(
+                ValueError, 'same variables', w.append, [3],
+                {'b': [3]}, {'x': np.zeros((1, 2, 2))})
+            w.close()
+            w.close()
+            c = myokit.DataBlock2d.load(path)
+            self.assertEqual(c.shape(), (2, 2, 2))
+            self.assertTrue(np.all(c.get0d('a') == [3, 4]))
+
+    def test_save_chunked(self):
+        # Test saving and loading in chunked format.
+
+        t = np.arange(50) * 0.5
+        b = myokit.DataBlock2d(4, 3, t)
+        b.set0d('pace', t > 10)
+        x = np.random.default_rng(1).normal(size=(50, 3, 4)).cumsum(axis=0)
+        b.set2d('x', x)
+        with TemporaryDirectory() as d:
+            path = d.path('block.chunked')
+            b.save_chunked(path, chunk_size=7, codec='lzma', threads=3)
+            c = myokit.DataBlock2d.load(path)
+            self.assertEqual(c.shape(), b.shape())
+            self.assertTrue(np.all(c.time() == b.time()))
+            self.assertTrue(np.all(c.get0d('pace') == b.get0d('pace')))
+            self.assertTrue(np.all(c.get2d('x') == x))
+
+            # Load a time window
+            c = myokit.DataBlock2d.load_chunked(path, a=12.1)
+            self.assertEqual(c.shape(), (25, 3, 4))
+            self.assertTrue(np.all(c.get2d('x') == x[25:]))
+            self.assertEqual(list(c.keys0d()), ['pace'])
+
     def test_save_frame_csv(self):
         # Test the save_frame_csv() method.
 
@@ -1595,6 +1923,39 @@ class ColorMapTest(unittest.TestCase):
         self.assertIsInstance(myokit.ColorMap.get('red'), myokit.ColorMap)
         self.assertRaises(KeyError, myokit.ColorMap.get, 'michael')
 
+    def test_lut(self):
+        # Test lookup tables
+
+        # Continuous colormap
+        m = myokit.ColorMap.get('red')
+        t = m.lut(6)
+        self.assertEqual(t.shape, (6, 3))
+        self.assertEqual(t.dtype, np.uint8)
+        self.assertFalse(t.flags.writeable)
+        x = m(np.linspace(0, 1, 6), 0, 1, alpha=False, rgb=True)
+        self.assertTrue(np.all(t.reshape(18) == x))
+        self.assertTrue(np.all(t[:, 0] == 255))
+        self.assertIs(t, myokit.ColorMap.get('red').lut(6))
+        self.assertEqual(m.lut(4, alpha=True).shape, (4, 4))
+
+        # Tabulated colormap
+        m = myokit.ColorMap.get('inferno')
+        t = m.lut(len(m._VALUES))
+        self.assertTrue(np.all(t == m._VALUES))
+
+        # Apply to arrays of any shape
+        x = np.linspace(-1, 2, 24).reshape((2, 3, 4))
+        for name in myokit.ColorMap.names():
+            m = myokit.ColorMap.get(name)
+            a = m.apply(x, 0, 1)
+            self.assertEqual(a.shape, (2, 3, 4, 3))
+            b = m(x.reshape(24), 0, 1, alpha=False, rgb=True)
+            d = np.abs(a.reshape(72).astype(int) - b)
+            self.assertLessEqual(np.max(d), 1)
+            a = m.apply(x, 0, 1, alpha=True, rgb=False)
+            self.assertEqual(a.shape, (2, 3, 4, 4))
+            self.assertTrue(np.all(m.apply(x, 1, 1) == m.lut()[0]))
+
     def test_names(self):
         names = list(myokit.ColorMap.names())
         self.assertIn('red', names)
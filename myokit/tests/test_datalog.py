@@ -116,7 +116,7 @@ class DataLogTest(unittest.TestCase):
         for v1, v2 in zip(d1.values(), d2.values()):
             self.assertEqual(v1, v2)
             self.assertTrue(v1 is v2)   # Constructor clone is not deep!
-            self.assertEqual(type(v2), array.array)
+            self.assertEqual(type(v2), myokit.DataColumn)
         self.assertIn('yes', d2.meta)
         self.assertEqual(d2.meta['yes'], 'no')
         for k in d2:
@@ -131,7 +131,7 @@ class DataLogTest(unittest.TestCase):
         for v1, v2 in zip(d1.values(), d2.values()):
             self.assertEqual(v1, v2)
             self.assertFalse(v1 is v2)
-            self.assertEqual(type(v2), array.array)
+            self.assertEqual(type(v2), myokit.DataColumn)
         self.assertIn('yes', d2.meta)
         self.assertEqual(d2.meta['yes'], 'no')
         self.assertEqual(d2.cmeta['ica.Ca_i']['unit'], '[mM]')
@@ -148,6 +148,124 @@ class DataLogTest(unittest.TestCase):
         self.assertEqual(d2.meta['yes'], 'no')
         self.assertEqual(d2.cmeta['ica.Ca_i']['unit'], '[mM]')
 
+    def test_data_column(self):
+        # Test the DataColumn storage class
+
+        # Appending and reading
+        c = myokit.DataColumn()
+        self.assertEqual(c.typecode, 'd')
+        self.assertEqual(len(c), 0)
+        for i in range(100):
+            c.append(i)
+        self.assertEqual(len(c), 100)
+        self.assertEqual(c[3], 3)
+        self.assertIsInstance(c[3], float)
+        self.assertEqual(c[-1], 99)
+        self.assertEqual(c, list(range(100)))
+        self.assertEqual(c, array.array('d', range(100)))
+        self.assertNotEqual(c, list(range(99)))
+        self.assertNotEqual(c, 'hello')
+        self.assertEqual(list(c), list(range(100)))
+        self.assertEqual(c.tolist(), list(range(100)))
+
+        # Views don't copy, and don't stop the column from growing
+        x = np.asarray(c)
+        self.assertIsInstance(x, np.ndarray)
+        self.assertTrue(np.shares_memory(x, np.asarray(c)))
+        y = c[10:20]
+        self.assertIsInstance(y, np.ndarray)
+        self.assertTrue(np.shares_memory(y, x))
+        for i in range(1000):
+            c.append(100 + i)
+        self.assertEqual(len(c), 1100)
+        self.assertEqual(list(x), list(range(100)))
+        self.assertEqual(list(y), list(range(10, 20)))
+        self.assertEqual(list(np.asarray(c)), list(range(1100)))
+
+        # Extending, setting, copying
+        c = myokit.DataColumn('f', [1, 2, 3])
+        self.assertEqual(c.typecode, 'f')
+        self.assertEqual(np.asarray(c).dtype, np.float32)
+        c.append(4)
+        c.extend([5, 6])
+        c.extend(x for x in [7, 8])
+        c.extend(c)
+        self.assertEqual(c, [1, 2, 3, 4, 5, 6, 7, 8] * 2)
+        c[0] = 10
+        self.assertEqual(c[0], 10)
+        d = c.copy()
+        d[0] = 1
+        self.assertEqual(c[0], 10)
+        self.assertEqual(d.typecode, 'f')
+        self.assertEqual(repr(myokit.DataColumn('d', [1, 2])),
+                         "DataColumn('d', [1.0, 2.0])")
+        self.assertRaisesRegex(ValueError, 'Typecode', myokit.DataColumn, 'i')
+
+        # Clearing doesn't affect views
+        x = np.asarray(c)
+        c.clear()
+        self.assertEqual(len(c), 0)
+        c.append(3)
+        self.assertEqual(c, [3])
+        self.assertEqual(list(x), [10] + list(range(2, 9)) + list(range(1, 9)))
+
+        # Logs created for simulations use data columns
+        m, p, _ = myokit.load(os.path.join(DIR_DATA, 'lr-1991.mmt'))
+        s = myokit.Simulation1d(m, p, ncells=2)
+        d = s.run(10, log=['engine.time', 'membrane.V'])
+        self.assertIsInstance(d.time(), myokit.DataColumn)
+        self.assertIsInstance(d['0.membrane.V'], myokit.DataColumn)
+
+        # npview is zero-copy, and the log can still be extended afterwards
+        e = d.npview()
+        self.assertTrue(np.shares_memory(e.time(), np.asarray(d.time())))
+        n = len(d.time())
+        d = s.run(10, log=d)
+        self.assertEqual(len(d.time()), 2 * n)
+        self.assertEqual(len(e.time()), n)
+        d.validate()
+
+        # Trimming returns appendable copies, or read-only views on request
+        f = d.itrim(2, 5)
+        self.assertIsInstance(f.time(), myokit.DataColumn)
+        self.assertEqual(list(f.time()), list(d.time()[2:5]))
+        self.assertFalse(np.shares_memory(
+            np.asarray(f.time()), np.asarray(d.time())))
+        f.time()[0] = -1
+        self.assertNotEqual(d.time()[2], -1)
+        f = s.run(1, log=d.itrim(0, 5))
+        self.assertGreater(len(f.time()), 5)
+        f.validate()
+        f = d.itrim(2, 5, view=True)
+        self.assertEqual(list(f.time()), list(d.time()[2:5]))
+        self.assertTrue(np.shares_memory(f.time(), np.asarray(d.time())))
+        self.assertFalse(f.time().flags.writeable)
+        f = d.trim(d.time()[2], d.time()[5], adjust=True)
+        self.assertIsInstance(f.time(), myokit.DataColumn)
+        self.assertEqual(f.time()[0], 0)
+        self.assertNotEqual(d.time()[2], 0)
+        f = d.trim_left(d.time()[2], adjust=True)
+        self.assertEqual(f.time()[0], 0)
+        self.assertNotEqual(d.time()[2], 0)
+        f1, f2 = d.isplit(3)
+        self.assertEqual(len(f1.time()) + len(f2.time()), 2 * n)
+        self.assertIsInstance(f2.time(), myokit.DataColumn)
+        f1, f2 = d.isplit(3, view=True)
+        self.assertFalse(f2.time().flags.writeable)
+        f = d.itrim_left(3, view=True)
+        self.assertFalse(f.time().flags.writeable)
+        f = d.itrim_right(3, view=True)
+        self.assertFalse(f.time().flags.writeable)
+        self.assertIsInstance(d.itrim_right(3).time(), myokit.DataColumn)
+
+        # Extending and cloning create new data columns
+        f = d.extend(s.run(10, log=['engine.time', 'membrane.V']))
+        self.assertIsInstance(f.time(), myokit.DataColumn)
+        self.assertEqual(len(f.time()), 3 * n)
+        f = d.clone()
+        self.assertIsInstance(f.time(), myokit.DataColumn)
+        self.assertEqual(f.time(), d.time())
+
     def test_extend(self):
         # Test the extend function.
 
@@ -297,6 +415,16 @@ class DataLogTest(unittest.TestCase):
         self.assertTrue(np.all(d2['1.x'] == d['x'][30:60]))
         self.assertTrue(np.all(d2['2.x'] == d['x'][60:90]))
 
+        # Test with periods of unequal length
+        d = myokit.DataLog(time='time')
+        d['time'] = [0, 1, 2, 5, 6, 10, 11, 12]
+        d['x'] = [1, 2, 3, 4, 5, 6, 7, 8]
+        d2 = d.fold(5, discard_remainder=False)
+        self.assertEqual(list(d2['time']), [0, 1, 2])
+        self.assertEqual(list(d2['0.x']), [1, 2, 3])
+        self.assertEqual(list(d2['1.x']), [4, 5])
+        self.assertEqual(list(d2['2.x']), [6, 7, 8])
+
     def test_has_nan(self):
         # Test the has_nan() method, which checks if the _final_ value in any
         # field is NaN.
@@ -408,6 +536,17 @@ class DataLogTest(unittest.TestCase):
         self.assertRaises(ValueError, d.interpolate_at, 'v', 1)
         self.assertRaises(ValueError, d.interpolate_at, 'v', 5)
 
+        # Multiple times at once
+        d = myokit.DataLog(time='t')
+        d['t'] = [0, 1, 2, 3]
+        d['v'] = [0, 10, 30, 60]
+        x = d.interpolate_at('v', [0, 0.5, 3, 1, 1.5, 2, 2.5])
+        self.assertIsInstance(x, np.ndarray)
+        self.assertEqual(list(x), [0, 5, 60, 10, 20, 30, 45])
+        self.assertEqual(len(d.interpolate_at('v', [])), 0)
+        self.assertRaises(ValueError, d.interpolate_at, 'v', [0, 3.1])
+        self.assertRaises(ValueError, d.interpolate_at, 'v', [-1, 3])
+
     def test_itrim(self):
         # Test the itrim() method.
 
@@ -591,6 +730,97 @@ class DataLogTest(unittest.TestCase):
         self.assertRaisesRegex(
             myokit.DataLogReadError, 'larger data', myokit.DataLog.load, path)
 
+    def test_load_csv_blocks(self):
+        # Test reading and writing csv files in small blocks, using several
+        # threads, and with the native and Python parsers.
+        import myokit._datalog
+        from myokit._sim import csvio
+
+        d = myokit.DataLog(time='t')
+        d['t'] = np.arange(1000) * 0.1
+        d['x'] = np.random.uniform(-1, 1, 1000)
+        d['y'] = d['x'] * 1e-300
+        size = myokit._datalog.CSV_BLOCK_SIZE
+        try:
+            myokit._datalog.CSV_BLOCK_SIZE = 100
+            with TemporaryDirectory() as td:
+                fname = td.path('test.csv')
+                for precision in (None, myokit.DOUBLE_PRECISION):
+                    d.save_csv(fname, precision=precision, threads=3)
+                    e = myokit.DataLog.load_csv(fname, threads=3)
+                    self.assertEqual(e.time_key(), 't')
+                    for k in d:
+                        self.assertIsInstance(e[k], array.array)
+                        self.assertTrue(np.all(d[k] == e[k]))
+
+                # Single precision
+                d.save_csv(fname, precision=myokit.SINGLE_PRECISION)
+                e = myokit.DataLog.load_csv(
+                    fname, precision=myokit.SINGLE_PRECISION)
+                self.assertEqual(e['x'].typecode, 'f')
+                self.assertTrue(np.all(np.abs(d['x'] - e['x']) < 1e-6))
+
+                # Old mac line endings, comments, and blank lines spread
+                # over block boundaries
+                with open(fname, 'wb') as f:
+                    f.write(b'# Comment\r"t","x"\r')
+                    for i in range(100):
+                        f.write(str(i).encode() + b', ' + str(2 * i).encode())
+                        f.write(b';\r\n\n# Comment\r' if i % 3 else b'\r')
+                e = myokit.DataLog.load_csv(fname)
+                self.assertEqual(list(e['t']), list(range(100)))
+                self.assertEqual(list(e['x']), list(range(0, 200, 2)))
+
+                # Errors report the row number
+                with open(fname, 'w') as f:
+                    f.write('"t","x"\n')
+                    for i in range(100):
+                        f.write(str(i) + ',' + str(i) + '\n\n')
+                    f.write('100,1,2\n')
+                self.assertRaisesRegex(
+                    myokit.DataLogReadError,
+                    'line 101.*row 101. Expecting 2, found 3',
+                    myokit.DataLog.load_csv, fname)
+                with open(fname, 'w') as f:
+                    f.write('"t","x"\n')
+                    for i in range(100):
+                        f.write(str(i) + ',' + str(i) + '\n')
+                    f.write('100,x\n')
+                self.assertRaisesRegex(
+                    myokit.DataLogReadError, 'line 101.*convert',
+                    myokit.DataLog.load_csv, fname)
+        finally:
+            myokit._datalog.CSV_BLOCK_SIZE = size
+
+        # Python and native parsers return the same result
+        data = b'1, 2\n\n  3 ,4e5;\r\n# x\n5,-inf;;\r7,nan'
+        x, e1, f1 = csvio.NativeCSV.parse(data, 2)
+        y, e2, f2 = csvio.parse_rows(data, 2)
+        self.assertEqual(e1, csvio.CSV_OK)
+        self.assertEqual((e1, f1), (e2, f2))
+        self.assertTrue(np.array_equal(x, np.array(y), equal_nan=True))
+        for data in (b'1,2\n3', b'1,2\n3,4,5', b'1,2\n3,x', b'1,\n',
+                     b'1,2 3', b'1,0x1', b'1,nan(1)', b'1,1__0', b'1,_1'):
+            x, e1, f1 = csvio.NativeCSV.parse(data, 2)
+            y, e2, f2 = csvio.parse_rows(data, 2)
+            self.assertNotEqual(e1, csvio.CSV_OK)
+            self.assertEqual((e1, f1), (e2, f2))
+            self.assertTrue(np.array_equal(x, np.array(y)))
+
+        # Rows that strtod can't read are passed to float()
+        data = ('1_000,2\n3,\u00a04\u00a0\n\u0665, 6\n\x1c# x\n'
+                '\x1c\n7,+Infinity\n8,1e1_0').encode('utf-8')
+        x, e1, f1 = csvio.NativeCSV.parse(data, 2)
+        y, e2, f2 = csvio.parse_rows(data, 2)
+        self.assertEqual(e1, csvio.CSV_OK)
+        self.assertEqual((e1, f1), (e2, f2))
+        self.assertTrue(np.array_equal(x, np.array(y)))
+        self.assertEqual(list(x[0]), [1000, 3, 5, 7, 8])
+        self.assertEqual(list(x[1]), [2, 4, 6, float('inf'), 1e10])
+        x, e1, f1 = csvio.NativeCSV.parse(data + b'\n9,1_\n10,10', 2)
+        self.assertEqual((e1, f1), (csvio.CSV_NOT_A_FLOAT, 2))
+        self.assertEqual(list(x[0]), [1000, 3, 5, 7, 8])
+
     def test_load_meta(self):
         # Tests error handling in meta data loading.
 
@@ -1716,6 +1946,221 @@ class DataLogTest(unittest.TestCase):
             self.assertTrue(np.all(e.time() == d.time()))
             self.assertTrue(np.all(e.time() == d['c.d']))
 
+    def test_save_uncompressed(self):
+        # Test saving in the uncompressed binary format, and memory mapping.
+
+        d = myokit.DataLog(time='c.d')
+        d['a.b'] = np.arange(0, 101, dtype=np.float32)
+        d['c.d'] = np.sqrt(np.arange(0, 101) * 1.2)
+        d['0.e.f'] = np.arange(101) * 1.0
+        d['1.e.f'] = np.arange(101) * 2.0
+        d.meta['one'] = 1
+        d.cmeta['a.b']['two'] = 2
+
+        with TemporaryDirectory() as td:
+            fname = td.path('test.bin')
+            for precision, tc in ((myokit.DOUBLE_PRECISION, 'd'),
+                                  (myokit.SINGLE_PRECISION, 'f')):
+                d.save(fname, precision=precision, compressed=False)
+                with open(fname, 'rb') as f:
+                    self.assertEqual(f.read(14), b'MYOKIT-DATALOG')
+
+                # Load into arrays
+                e = myokit.DataLog.load(fname)
+                self.assertEqual(list(e.keys()), list(d.keys()))
+                self.assertEqual(e.time_key(), 'c.d')
+                for k, v in d.items():
+                    self.assertIsInstance(e[k], array.array)
+                    self.assertEqual(e[k].typecode, tc)
+                    self.assertTrue(np.all(
+                        np.array(e[k]) == np.array(v, dtype=tc)))
+                self.assertEqual(e.meta['one'], '1')
+                self.assertEqual(e.cmeta['a.b']['two'], '2')
+
+                # Memory map
+                e = myokit.DataLog.load(fname, mmap=True)
+                self.assertEqual(list(e.keys()), list(d.keys()))
+                self.assertEqual(e.time_key(), 'c.d')
+                for k, v in d.items():
+                    self.assertIsInstance(e[k], np.memmap)
+                    self.assertEqual(e[k].dtype, np.dtype(tc))
+                    self.assertTrue(np.all(e[k] == np.array(v, dtype=tc)))
+                self.assertEqual(e.meta['one'], '1')
+                self.assertEqual(e.cmeta['a.b']['two'], '2')
+                self.assertRaises(ValueError, e['a.b'].__setitem__, 0, 1)
+                x = e['e.f', 1]
+                del e
+                self.assertEqual(x[3], 6)
+                del x
+
+            # Empty log
+            d = myokit.DataLog()
+            d['x'] = []
+            d.save(fname, compressed=False)
+            e = myokit.DataLog.load(fname, mmap=True)
+            self.assertEqual(len(e['x']), 0)
+            self.assertIsNone(e.time_key())
+            e = myokit.DataLog.load(fname)
+            self.assertEqual(len(e['x']), 0)
+
+            # Progress reporter
+            p = TestReporter()
+            d.save(fname, compressed=False)
+            e = myokit.DataLog.load(fname, progress=p)
+            self.assertTrue(p.entered and p.exited and p.updated)
+            self.assertIsNone(myokit.DataLog.load(
+                fname, progress=CancellingReporter(0)))
+
+            # Memory map is ignored for compressed files
+            d.save(fname)
+            e = myokit.DataLog.load(fname, mmap=True)
+            self.assertIsInstance(e['x'], array.array)
+
+            # Load errors
+            def header(**kwargs):
+                h = {'length': 1, 'dtype': 'd', 'time': None,
+                     'columns': [['x', 0]], 'meta': None}
+                h.update(kwargs)
+                h = json.dumps(h).encode('utf-8')
+                with open(fname, 'wb') as f:
+                    f.write(b'MYOKIT-DATALOG\x00\x00')
+                    f.write(kwargs.get('version', 1).to_bytes(4, 'little'))
+                    f.write(len(h).to_bytes(4, 'little'))
+                    f.write(h)
+                    f.write(bytes(200))
+
+            def error(message):
+                self.assertRaisesRegex(
+                    myokit.DataLogReadError, message, myokit.DataLog.load,
+                    fname)
+
+            header()
+            self.assertEqual(list(myokit.DataLog.load(fname)['x']), [0])
+            header(version=2)
+            error('Unsupported log file version')
+            header(columns=None)
+            error('Invalid log file header')
+            header(length=-1)
+            error('Invalid data size')
+            header(dtype='i')
+            error('Invalid data type')
+            header(length=100)
+            error('larger data')
+            with open(fname, 'wb') as f:
+                f.write(b'MYOKIT-DATALOG\x00\x00\x01')
+            error('log file format')
+
+    def test_save_chunked(self):
+        # Test saving in the chunked format, and loading parts of it.
+
+        d = myokit.DataLog(time='engine.time')
+        d['engine.time'] = np.arange(1000) * 0.5
+        d['0.membrane.V'] = np.sin(d['engine.time'])
+        d['1.membrane.V'] = np.cos(d['engine.time'])
+        d['engine.pace'] = [float(i % 7 == 0) for i in range(1000)]
+        d.meta['one'] = 1
+        d.cmeta['engine.time']['unit'] = 'ms'
+
+        with TemporaryDirectory() as td:
+            fname = td.path('test.chunked')
+
+            # All codecs and transforms
+            for codec in ('zlib', 'lzma', 'bz2', 'none'):
+                for transform in ('shuffle', 'xor', 'none'):
+                    d.save_chunked(
+                        fname, chunk_size=64, codec=codec,
+                        transform=transform, threads=2)
+                    e = myokit.DataLog.load(fname)
+                    self.assertEqual(list(e.keys()), list(d.keys()))
+                    self.assertEqual(e.time_key(), 'engine.time')
+                    for k, v in d.items():
+                        self.assertTrue(np.all(e[k] == np.asarray(v)))
+                    self.assertEqual(e.meta['one'], '1')
+                    self.assertEqual(e.cmeta['engine.time']['unit'], 'ms')
+
+            # Single precision, automatic chunk size
+            d.save_chunked(fname, precision=myokit.SINGLE_PRECISION)
+            e = myokit.DataLog.load_chunked(fname)
+            self.assertEqual(e['0.membrane.V'].dtype, np.float32)
+            self.assertTrue(np.all(
+                e['1.membrane.V'] == d['1.membrane.V'].astype(np.float32)))
+
+            # Selected keys and time interval
+            d.save_chunked(fname, chunk_size=100, transform='xor')
+            e = myokit.DataLog.load_chunked(
+                fname, keys=['0.membrane.V'], a=120, b=260.2)
+            self.assertEqual(list(e.keys()), ['engine.time', '0.membrane.V'])
+            f = d.trim(120, 260.2)
+            self.assertTrue(np.all(e.time() == f.time()))
+            self.assertTrue(np.all(e['0.membrane.V'] == f['0.membrane.V']))
+            self.assertNotIn('unit', e.cmeta['0.membrane.V'])
+            self.assertEqual(e.cmeta['engine.time']['unit'], 'ms')
+            e = myokit.DataLog.load_chunked(fname, a=490)
+            self.assertEqual(list(e.time()), [490, 490.5, 491, 491.5, 492,
+                                              492.5, 493, 493.5, 494, 494.5,
+                                              495, 495.5, 496, 496.5, 497,
+                                              497.5, 498, 498.5, 499, 499.5])
+            e = myokit.DataLog.load_chunked(fname, a=600, b=700)
+            self.assertEqual(e.length(), 0)
+
+            # Chunks are read in windows of `threads` chunks
+            d.save_chunked(fname, chunk_size=7)
+            for threads in (1, 3, 200):
+                for i, j in ((0, 1000), (5, 995), (14, 15), (500, 500)):
+                    e = myokit.DataLog.load_chunked(
+                        fname, a=i / 2, b=j / 2, threads=threads)
+                    self.assertEqual(e.length(), j - i)
+                    for k, v in d.items():
+                        self.assertTrue(np.all(e[k] == np.asarray(v)[i:j]))
+            self.assertRaisesRegex(
+                KeyError, 'not found', myokit.DataLog.load_chunked, fname,
+                keys=['x'])
+
+            # Interval requires time key
+            d.set_time_key(None)
+            d.save_chunked(fname)
+            self.assertRaisesRegex(
+                ValueError, 'time key', myokit.DataLog.load_chunked, fname,
+                a=3)
+
+            # Bad arguments
+            self.assertRaisesRegex(
+                ValueError, 'Unknown codec', d.save_chunked, fname,
+                codec='x')
+            self.assertRaisesRegex(
+                ValueError, 'Unknown transform', d.save_chunked, fname,
+                transform='x')
+            self.assertRaisesRegex(
+                ValueError, 'Chunk size', d.save_chunked, fname,
+                chunk_size=0)
+
+            # Not a log
+            b = myokit.DataBlock1d(2, [1, 2, 3])
+            b.save_chunked(fname)
+            self.assertRaisesRegex(
+                myokit.DataLogReadError, 'does not contain a DataLog',
+                myokit.DataLog.load, fname)
+
+            # Corrupt files
+            d.save_chunked(fname)
+            with open(fname, 'rb') as f:
+                data = f.read()
+            with open(fname, 'wb') as f:
+                f.write(data[:24] + b'\xff' + data[25:])
+            self.assertRaisesRegex(
+                myokit.DataLogReadError, 'decompress',
+                myokit.DataLog.load, fname)
+            with open(fname, 'wb') as f:
+                f.write(data[:16] + b'\x02' + data[17:])
+            self.assertRaisesRegex(
+                myokit.DataLogReadError, 'version',
+                myokit.DataLog.load, fname)
+            with open(fname, 'wb') as f:
+                f.write(data[:-10] + data[-8:])
+            self.assertRaisesRegex(
+                myokit.DataLogReadError, 'index',
+                myokit.DataLog.load, fname)
+
     def test_save_csv(self):
         # Test saving as csv.
 
@@ -1696,6 +1696,135 @@ class SolvableOrderTest(DepTest):
             self.assertEqual(v1, v2)
 
 
+class CacheTest(DepTest):
+    """
+    Tests caching of dependency analysis results.
+    """
+
+    def test_cache(self):
+        # Results are cached, but can be modified by the caller
+        m = self.m.clone()
+        self.assertEqual(len(m._cache), 0)
+        a = m.map_shallow_dependencies()
+        b = m.map_shallow_dependencies()
+        self.assertEqual(a, b)
+        self.assertIsNot(a, b)
+        self.assertEqual(len(m._cache), 1)
+        x = m.get('ina.INa').lhs()
+        a[x].clear()
+        self.assertEqual(m.map_shallow_dependencies()[x], b[x])
+        self.assertNotEqual(len(b[x]), 0)
+
+        d1 = m.map_deep_dependencies()
+        d2 = m.map_deep_dependencies(collapse=True)
+        self.assertNotEqual(d1, d2)
+        self.assertEqual(m.map_deep_dependencies(), d1)
+        o = m.solvable_order()
+        o['ina'].clear()
+        self.assertNotEqual(len(m.solvable_order()['ina']), 0)
+        self.assertEqual(len(m._cache), 4)
+
+        # Changing initial values and validating doesn't reset the cache
+        m.set_initial_values(m.initial_values(as_floats=True))
+        m.get('ina.m').set_initial_value(0.5)
+        m.validate()
+        self.assertEqual(len(m._cache), 4)
+
+        # Reordering states resets only results that list states
+        m.map_shallow_dependencies(omit_states=False)
+        self.assertEqual(len(m._cache), 5)
+        states = list(m.states())
+        m.reorder_state(states[1:] + states[:1])
+        self.assertEqual(len(m._cache), 4)
+        keys = list(m.map_shallow_dependencies(omit_states=False).keys())
+        self.assertEqual(keys[-1], myokit.Name(states[0]))
+
+        # Changes to equations reset the cache
+        v = m.get('ina.INa')
+        v.set_rhs('ina.gNa * (membrane.V - ina.ENa)')
+        self.assertEqual(len(m._cache), 0)
+        self.assertNotIn(
+            m.get('ina.m').lhs(), m.map_shallow_dependencies()[v.lhs()])
+        eqs = [eq for eq in m.solvable_order()['ina'] if eq.lhs == v.lhs()]
+        self.assertEqual(eqs[0].rhs, v.rhs())
+
+        # Adding or removing components and variables resets the cache
+        m.solvable_order()
+        c = m.add_component('new')
+        self.assertEqual(len(m._cache), 0)
+        m.solvable_order()
+        w = c.add_variable('w')
+        self.assertEqual(len(m._cache), 0)
+        w.set_rhs(1)
+        m.solvable_order()
+        c.remove_variable(w)
+        self.assertEqual(len(m._cache), 0)
+        m.solvable_order()
+        m.remove_component(c)
+        self.assertEqual(len(m._cache), 0)
+
+        # Renaming, promoting, and binding reset the cache
+        for f in (lambda: v.rename('INa2'), lambda: v.promote(0),
+                  lambda: v.demote(), lambda: v.set_binding('x'),
+                  lambda: v.set_binding(None)):
+            m.solvable_order()
+            f()
+            self.assertEqual(len(m._cache), 0)
+
+        # Cyclical dependencies are not cached
+        v.set_rhs('ina.INa2')
+        self.assertRaises(
+            myokit.CyclicalDependencyError, m.map_deep_dependencies)
+        self.assertEqual(len(m._cache), 1)
+
+    def test_cache_clone(self):
+        # Clones share cached results, translated to their own variables
+        m1 = self.m.clone()
+        args = [
+            dict(), dict(collapse=True, omit_states=False),
+            dict(filter_encompassed=True)]
+        for kwargs in args:
+            m1.map_deep_dependencies(**kwargs)
+        m1.map_shallow_dependencies(omit_constants=True)
+        o1 = m1.solvable_order()
+
+        m2 = m1.clone()
+        self.assertEqual(len(m2._cache), len(m1._cache))
+        for a, b in zip(m2.solvable_order().values(), o1.values()):
+            self.assertEqual([str(x) for x in a], [str(x) for x in b])
+            for eq in a:
+                self.assertIs(eq.lhs.var().model(), m2)
+                self.assertIs(eq.rhs, eq.lhs.var().rhs())
+
+        def names(deps):
+            return {str(k): set(str(x) for x in v) for k, v in deps.items()}
+
+        for kwargs in args:
+            d1 = m1.map_deep_dependencies(**kwargs)
+            d2 = m2.map_deep_dependencies(**kwargs)
+            self.assertEqual(names(d1), names(d2))
+            for k, v in d2.items():
+                self.assertIs(k.var().model(), m2)
+                for x in v:
+                    self.assertIs(x.var().model(), m2)
+        d1 = m1.map_shallow_dependencies(omit_constants=True)
+        d2 = m2.map_shallow_dependencies(omit_constants=True)
+        self.assertEqual(names(d1), names(d2))
+
+        # Cached results are the same as newly calculated ones
+        m3 = m1.clone()
+        m3._reset_cache()
+        self.assertEqual(len(m3._cache), 0)
+        self.assertEqual(names(m3.map_deep_dependencies()),
+                         names(m2.map_deep_dependencies()))
+
+        # Changes to the clone don't affect the original
+        n = len(m1._cache)
+        m2.get('ina.INa').set_rhs(3)
+        self.assertEqual(len(m2._cache), 0)
+        self.assertEqual(len(m1._cache), n)
+
+
 if __name__ == '__main__':
     print('Add -v for more debug output')
     import sys
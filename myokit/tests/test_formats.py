@@ -6,12 +6,17 @@
 # See http://myokit.org for copyright, sharing, and licensing details.
 #
 import os
+import shutil
 import unittest
 
+import numpy as np
+
 import myokit
 import myokit.formats
+import myokit.formats.axon
+import myokit.formats.wcp
 
-from myokit.tests import TemporaryDirectory
+from myokit.tests import TemporaryDirectory, DIR_FORMATS, WarningCollector
 
 
 class FormatsTest(unittest.TestCase):
@@ -235,5 +240,142 @@ class EWriterTest(unittest.TestCase):
             'dada')
 
 
+class ConvertDataTest(unittest.TestCase):
+    """ Test batch conversion of data files. """
+
+    def test_convert_data(self):
+        # Test converting files and directories
+
+        abf = os.path.join(DIR_FORMATS, 'abf-v1.abf')
+        wcp = os.path.join(DIR_FORMATS, 'wcp-file.wcp')
+        with TemporaryDirectory() as d:
+            # Create a source directory with a subdirectory and a bad file
+            src = d.path('src')
+            os.makedirs(os.path.join(src, 'sub'))
+            shutil.copy(abf, os.path.join(src, 'a.abf'))
+            shutil.copy(wcp, os.path.join(src, 'sub', 'b.wcp'))
+            with open(os.path.join(src, 'c.abf'), 'w') as f:
+                f.write('Not an abf file')
+            with open(os.path.join(src, 'd.txt'), 'w') as f:
+                f.write('Ignored')
+
+            # Convert single file
+            out = d.path('out1')
+            r = myokit.formats.convert_data([abf], out, processes=1)
+            self.assertIsInstance(r, myokit.formats.ConversionReport)
+            path = os.path.join(out, 'abf-v1.abf.bin')
+            self.assertEqual(r.converted(), [(abf, [path])])
+            self.assertEqual(r.errors(), [])
+            self.assertEqual(r.bytes_read(), os.path.getsize(abf))
+            self.assertEqual(r.bytes_written(), os.path.getsize(path))
+            self.assertGreater(r.time(), 0)
+            self.assertGreater(r.files_per_second(), 0)
+            self.assertGreater(r.megabytes_per_second(), 0)
+            self.assertIn('Converted 1 file ', str(r))
+
+            # Result can be memory-mapped, and matches the source log
+            x = myokit.formats.axon.AbfFile(abf).log()
+            y = myokit.DataLog.load(path, mmap=True)
+            self.assertIsInstance(y['time'], np.memmap)
+            self.assertEqual(list(x.keys()), list(y.keys()))
+            for k, v in x.items():
+                self.assertTrue(np.all(v == y[k]))
+
+            # Convert directory, with and without recursion
+            out = d.path('out2')
+            r = myokit.formats.convert_data([src], out, processes=1)
+            self.assertEqual(len(r.converted()), 1)
+            self.assertEqual(len(r.errors()), 1)
+            self.assertEqual(r.errors()[0][0], os.path.join(src, 'c.abf'))
+            self.assertIn('Error converting', str(r))
+
+            out = d.path('out3')
+            r = myokit.formats.convert_data(
+                [src], out, join_sweeps=True, use_names=True,
+                include_da=False, precision=myokit.SINGLE_PRECISION,
+                recursive=True, processes=2)
+            self.assertEqual(len(r.converted()), 2)
+            self.assertEqual(len(r.errors()), 1)
+            self.assertIn('Converted 2 files ', str(r))
+            path = os.path.join(out, 'sub', 'b.wcp.bin')
+            self.assertEqual(r.converted()[1][1], [path])
+            x = myokit.formats.wcp.WcpFile(wcp).log(
+                join_sweeps=True, use_names=True, include_da=False)
+            y = myokit.DataLog.load(path)
+            self.assertEqual(list(x.keys()), list(y.keys()))
+            for k, v in x.items():
+                self.assertTrue(np.all(
+                    np.array(v, dtype=np.float32) == np.array(y[k])))
+
+            # Missing source
+            self.assertRaisesRegex(
+                FileNotFoundError, 'not found', myokit.formats.convert_data,
+                [d.path('nope')], out)
+
+    def test_convert_data_names(self):
+        # Test output names, and sources that would overwrite each other
+
+        abf = os.path.join(DIR_FORMATS, 'abf-v1.abf')
+        wcp = os.path.join(DIR_FORMATS, 'wcp-file.wcp')
+        with TemporaryDirectory() as d:
+            # Files with the same name but a different extension
+            src = d.path('src')
+            os.makedirs(os.path.join(src, 'sub'))
+            shutil.copy(abf, os.path.join(src, 'a.abf'))
+            shutil.copy(wcp, os.path.join(src, 'a.wcp'))
+            shutil.copy(abf, os.path.join(src, 'sub', 'a.abf'))
+            out = d.path('out')
+            r = myokit.formats.convert_data(
+                [src], out, recursive=True, processes=1)
+            self.assertEqual(r.errors(), [])
+            self.assertEqual([x[1] for x in r.converted()], [
+                [os.path.join(out, 'a.abf.bin')],
+                [os.path.join(out, 'a.wcp.bin')],
+                [os.path.join(out, 'sub', 'a.abf.bin')],
+            ])
+
+            # Sources with the same name
+            a1 = os.path.join(src, 'a.abf')
+            a2 = os.path.join(src, 'sub', 'a.abf')
+            self.assertRaisesRegex(
+                ValueError, 'would both be written',
+                myokit.formats.convert_data, [a1, a2], out)
+            self.assertRaisesRegex(
+                ValueError, 'would both be written',
+                myokit.formats.convert_data, [src, a1], out)
+
+    def test_convert_data_patchmaster(self):
+        # Test converting PatchMaster files
+
+        pm = os.path.join(DIR_FORMATS, 'patchmaster-synthetic.dat')
+        with TemporaryDirectory() as d:
+            src = d.path('src')
+            os.makedirs(src)
+            shutil.copy(pm, os.path.join(src, 'a.dat'))
+            with open(os.path.join(src, 'b.dat'), 'w') as f:
+                f.write('1 2 3\n')
+
+            # Aborted series are skipped, .dat files from other programs are
+            # ignored
+            out = d.path('out')
+            with WarningCollector():
+                r = myokit.formats.convert_data([src], out, processes=1)
+            self.assertEqual(r.errors(), [])
+            paths = [os.path.join(out, f'a.dat-{i}-0.bin') for i in (0, 1)]
+            self.assertEqual(
+                r.converted(), [(os.path.join(src, 'a.dat'), paths)])
+            x = myokit.DataLog.load(paths[1])
+            self.assertEqual(len(x.time()), 40)
+            self.assertTrue(np.allclose(
+                x['2.0.channel'], (1020 + np.arange(40)) * 1e-12))
+
+            # Unless explicitly given
+            b = os.path.join(src, 'b.dat')
+            r = myokit.formats.convert_data([b], out, processes=1)
+            self.assertEqual(r.converted(), [])
+            self.assertEqual(len(r.errors()), 1)
+            self.assertIn('Not a HEKA PatchMaster file', r.errors()[0][1])
+
+
 if __name__ == '__main__':
     unittest.main()
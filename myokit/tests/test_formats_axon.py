@@ -621,6 +621,57 @@ class AbfTest(unittest.TestCase):
         self.assertEqual(e[3].duration(), 0.4)
         self.assertEqual(len(e), 37 * 3)
 
+    def test_lazy_data(self):
+        # Test lazy access and streaming of A/D data
+
+        path = os.path.join(DIR_FORMATS, 'abf-v2.abf')
+        abf = axon.AbfFile(path)
+
+        # Raw integer data is kept as a memory map, values are converted
+        c = abf[3][0]
+        self.assertIsInstance(c._data, np.memmap)
+        self.assertEqual(c._data.dtype, np.dtype('i2'))
+        v = c.values()
+        self.assertNotIsInstance(v, np.memmap)
+        self.assertEqual(v.dtype, np.dtype('f'))
+        self.assertTrue(np.all(v == c.values()))
+        self.assertFalse(v is c.values())
+
+        # Channel blocks
+        blocks = list(c.blocks(1000))
+        self.assertEqual(len(blocks), -(-len(v) // 1000))
+        self.assertTrue(all(len(x) <= 1000 for x, y in blocks))
+        self.assertTrue(np.all(np.concatenate([x for x, y in blocks])
+                               == c.times()))
+        self.assertTrue(np.all(np.concatenate([y for x, y in blocks]) == v))
+        self.assertEqual(len(list(c.blocks())), 1)
+        self.assertRaisesRegex(ValueError, 'at least 1', next, c.blocks(-1))
+
+        # File blocks
+        n = len(v)
+        sweeps = [[] for s in abf]
+        for i, t, values in abf.iter_blocks(block_size=200):
+            self.assertEqual(len(values), 1)
+            self.assertLessEqual(len(t), 200)
+            sweeps[i].append((t, values[0]))
+        for sweep, blocks in zip(abf, sweeps):
+            self.assertEqual(len(blocks), -(-n // 200))
+            t, v0 = [np.concatenate(x) for x in zip(*blocks)]
+            self.assertTrue(np.all(t == sweep[0].times()))
+            self.assertTrue(np.all(v0 == sweep[0].values()))
+
+        # Selected channels, by index or name
+        blocks = list(abf.iter_blocks(['IN 0', 0]))
+        self.assertEqual(len(blocks), len(abf))
+        self.assertEqual(len(blocks[5][2]), 2)
+        self.assertTrue(np.all(blocks[5][2][0] == abf[5][0].values()))
+        self.assertTrue(np.all(blocks[5][2][1] == abf[5][0].values()))
+        self.assertEqual(len(list(abf.iter_blocks([]))), 0)
+        self.assertRaises(IndexError, next, abf.iter_blocks([1]))
+        self.assertRaises(KeyError, next, abf.iter_blocks(['nope']))
+        self.assertRaisesRegex(
+            ValueError, 'at least 1', next, abf.iter_blocks(block_size=-1))
+
     def test_matplotlib_figure(self):
         # Test figure drawing method (doesn't inspect output).
         # Select matplotlib backend that doesn't require a screen
@@ -0,0 +1,233 @@
+#!/usr/bin/env python3
+#
+# Tests the HEKA PatchMaster format module.
+#
+# The data file used here is generated by
+# ``myokit/tests/data/formats/patchmaster-synthetic.py``.
+#
+# This file is part of Myokit.
+# See http://myokit.org for copyright, sharing, and licensing details.
+#
+import os
+import shutil
+import unittest
+import warnings
+
+import numpy as np
+
+import myokit
+import myokit.formats.heka as heka
+
+from myokit.tests import DIR_FORMATS, TemporaryDirectory
+
+
+PATH = os.path.join(DIR_FORMATS, 'patchmaster-synthetic.dat')
+
+
+def load(path=PATH, cache_index=False):
+    """ Opens a PatchMaster file, ignoring the "reading is new" warning. """
+    with warnings.catch_warnings():
+        warnings.filterwarnings('ignore', 'PatchMaster file reading is new')
+        return heka.PatchMasterFile(path, cache_index=cache_index)
+
+
+class PatchMasterFileTest(unittest.TestCase):
+    """ Tests reading a PatchMaster file. """
+
+    def test_contents(self):
+        # Test reading groups, series, sweeps, and traces
+
+        with load() as f:
+            self.assertEqual(f.filename(), 'patchmaster-synthetic.dat')
+            self.assertEqual(f.version(), 'v2x90.2')
+            self.assertEqual(len(f), 2)
+            self.assertEqual([g.label() for g in f], ['Cell 1', 'Cell 2'])
+            self.assertEqual([g.number() for g in f], [1, 2])
+            self.assertEqual([len(g) for g in f], [2, 1])
+            self.assertIsNone(f.amplifier_tree())
+
+            # Series and stimulus
+            s = f[0][0]
+            self.assertEqual(s.label(), 'IV')
+            self.assertIs(s.parent(), f[0])
+            self.assertEqual(len(s), 3)
+            self.assertEqual(s.channel_names(), ['Imon'])
+            self.assertEqual(s.channel_units(), [myokit.units.A])
+            self.assertEqual(s.stimulus().label(), 'IV')
+            self.assertIs(s.stimulus(), f.stimulus_tree()[0])
+            self.assertEqual(s.amplifier_state().current_gain(), 10)
+
+            # Traces
+            t = s[2][0]
+            self.assertEqual(t.label(), 'Imon')
+            self.assertEqual(len(t), 40)
+            self.assertTrue(np.allclose(t.times(), np.arange(40) * 1e-3))
+            self.assertTrue(np.allclose(
+                t.values(), (20 + np.arange(40)) * 1e-12))
+            t = f[1][0][1][0]
+            self.assertTrue(np.allclose(
+                t.values(), (1010 + np.arange(40)) * 1e-12))
+
+            # SweepSource interface
+            d = s.log(join_sweeps=True)
+            self.assertEqual(list(d.keys()), ['time', '0.channel', '0.da'])
+            self.assertEqual(len(d.time()), 120)
+            self.assertTrue(np.allclose(
+                d['0.da'][40:60], np.array([-0.08] * 10 + [-0.01] * 10)))
+            p = s.da_protocol()
+            self.assertEqual(len(p.events()), 9)
+            self.assertEqual(p.events()[4].level(), -10)
+
+    def test_complete_series(self):
+        # Test detection of aborted series
+
+        with load() as f:
+            g = f[0]
+            self.assertTrue(g[0].is_complete())
+            self.assertFalse(g[1].is_complete())
+            self.assertIn('partial: 2 out of 3', str(g[1]))
+            self.assertEqual(list(g.complete_series()), [g[0]])
+            self.assertEqual(len(list(f[1].complete_series())), 1)
+
+            # Find series by label
+            self.assertIs(g.series('IV'), g[0])
+            self.assertIs(g.series('IV', 1), g[1])
+            self.assertIs(g.series('IV', complete_only=True), g[0])
+            self.assertRaisesRegex(
+                ValueError, 'Unable to find', g.series, 'IV', 1, True)
+            self.assertRaisesRegex(
+                ValueError, 'Unable to find', g.series, 'Act')
+
+    def test_lazy_nodes(self):
+        # Test that nodes are created only when first accessed
+
+        with load() as f:
+            groups = f._pulsed_tree._children
+            self.assertIsInstance(groups, heka._patchmaster._NodeList)
+            self.assertEqual(groups._nodes, [None, None])
+
+            # Looking up a group by label creates only that group
+            g = f.group('Cell 2')
+            self.assertEqual(g.label(), 'Cell 2')
+            self.assertEqual(groups._nodes, [None, g])
+            self.assertIs(f[1], g)
+            self.assertIs(f[-1], g)
+            self.assertRaisesRegex(KeyError, 'not found', f.group, 'Cell 3')
+            self.assertEqual(groups._nodes, [None, g])
+
+            # Looking up a series by label creates only that series
+            g = f[0]
+            s = g.series('IV', 1)
+            self.assertEqual(g._children._nodes, [None, s])
+
+            # Slices, iteration, and bad indices
+            self.assertEqual(f[:], [f[0], f[1]])
+            self.assertEqual(f[::-1], [f[1], f[0]])
+            self.assertEqual(list(f), [f[0], f[1]])
+            self.assertRaises(IndexError, lambda: f[2])
+            self.assertRaises(TypeError, lambda: f['Cell 1'])
+
+            # Fields can be read without creating nodes
+            x = g._children.records([('label', 4, 'S32')])
+            self.assertEqual(list(x['label']), [b'IV', b'IV'])
+            self.assertEqual(g._children._nodes, [None, s])
+
+            # Sweeps are created with their series, but only the traces of
+            # the first sweep are created
+            self.assertEqual(s[1]._children._nodes, [None])
+            t = s[1][0]
+            self.assertEqual(s[1]._children._nodes, [t])
+
+    def test_tree_index(self):
+        # Test creating and storing a tree index
+
+        with open(PATH, 'rb') as f:
+            f.seek(256 + 8 * 40 * 2)
+            index = heka.TreeIndex.create(f)
+        self.assertTrue(index.is_little_endian)
+        self.assertEqual(index.sizes, (640, 144, 1408, 288, 512))
+        self.assertEqual([len(x) for x in index.offsets], [1, 2, 3, 8, 8])
+        self.assertEqual(list(index.counts[1]), [2, 1])
+        self.assertEqual(list(index.counts[2]), [3, 2, 3])
+        self.assertEqual(list(index.firsts[2]), [0, 3, 5])
+
+        # Store and restore
+        arrays = index.arrays('.pul')
+        index2 = heka.TreeIndex.from_arrays(arrays, '.pul')
+        self.assertEqual(index2.sizes, index.sizes)
+        for a, b in zip(index.offsets, index2.offsets):
+            self.assertTrue(np.all(a == b))
+
+        # Inconsistent indices
+        self.assertRaisesRegex(
+            ValueError, 'Invalid tree index', heka.TreeIndex,
+            True, index.sizes, index.offsets[:-1], index.counts)
+        self.assertRaisesRegex(
+            ValueError, 'Invalid tree index', heka.TreeIndex,
+            True, index.sizes, index.offsets,
+            index.counts[:1] + [index.counts[1] + 1] + index.counts[2:])
+
+        # Not a tree
+        with open(PATH, 'rb') as f:
+            self.assertRaisesRegex(
+                ValueError, 'Unable to read tree', heka.TreeIndex.create, f)
+
+    def test_cache_index(self):
+        # Test caching the index
+
+        with TemporaryDirectory() as d:
+            path = d.path('test.dat')
+            shutil.copy(PATH, path)
+
+            # No index is written by default
+            with load(path) as f:
+                index_path = f.index_path()
+                self.assertEqual(index_path, path + '.myokit-index.npz')
+            self.assertFalse(os.path.exists(index_path))
+
+            # Index is written, and used when reopening
+            with load(path, cache_index=True) as f:
+                x = f[1][0][2][0].values()
+            self.assertTrue(os.path.isfile(index_path))
+            create = heka.TreeIndex.create
+            try:
+                heka.TreeIndex.create = None
+                with load(path, cache_index=True) as f:
+                    self.assertTrue(np.all(f[1][0][2][0].values() == x))
+            finally:
+                heka.TreeIndex.create = create
+
+            # Index is ignored and replaced if the file's time has changed
+            mtime = os.stat(index_path).st_mtime_ns
+            st = os.stat(path)
+            os.utime(path, ns=(st.st_atime_ns, st.st_mtime_ns + 10**9))
+            with load(path, cache_index=True) as f:
+                self.assertTrue(np.all(f[1][0][2][0].values() == x))
+            self.assertNotEqual(os.stat(index_path).st_mtime_ns, mtime)
+            try:
+                heka.TreeIndex.create = None
+                with load(path, cache_index=True) as f:
+                    self.assertEqual(len(f), 2)
+            finally:
+                heka.TreeIndex.create = create
+
+            # Or if the file's size has changed
+            with open(path, 'ab') as f:
+                f.write(b'\x00' * 8)
+            os.utime(path, ns=(st.st_atime_ns, st.st_mtime_ns + 10**9))
+            with load(path, cache_index=True) as f:
+                self.assertTrue(np.all(f[1][0][2][0].values() == x))
+            with np.load(index_path) as i:
+                self.assertEqual(i['meta'][1], os.path.getsize(path))
+
+            # Invalid index files are ignored and replaced
+            with open(index_path, 'wb') as f:
+                f.write(b'Not an index')
+            with load(path, cache_index=True) as f:
+                self.assertTrue(np.all(f[1][0][2][0].values() == x))
+            with load(path, cache_index=True) as f:
+                self.assertEqual(len(f), 2)
+
+
+if __name__ == '__main__':
+    unittest.main()
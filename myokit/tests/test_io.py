@@ -78,6 +78,116 @@ class LoadSaveMmtTest(unittest.TestCase):
             d2 = m2.meta['desc']
             self.assertEqual(d2, dr)
 
+    def test_load_model_cache(self):
+        # Test loading models via the binary cache
+        code = """
+            [[model]]
+            name: test
+            desc: \"\"\"
+                A model with
+                several lines\"\"\"
+            boltz(x, a) = 1 / (1 + exp(x / a))
+            c.x = 0.5
+            c.y = 1 + c.p
+
+            [engine]
+            time = 0 [ms] bind time
+                in [ms]
+            pace = 0 bind pace
+            u = 3 [mV]
+                desc: Unused
+                in [mV]
+
+            [c]
+            use engine.time as t
+            dot(x) = (boltz(q, 2) - x) / tau
+                tau = 1 / (1 + t) + b
+                    a = 5
+                    b = -0 + a
+            dot(y) = 1 - y + engine.pace
+            p = 3 label ploop
+            q = if(x > 1 and p != 2, piecewise(x < 0, 1, x < 1, x, 2), 1e-6)
+        """
+        code = '\n'.join(x[12:] for x in code.splitlines()[1:])
+        m1 = myokit.parse_model(code)
+        self.assertTrue(m1.has_parse_info())
+        self.assertEqual(len(m1.warnings()), 1)
+
+        with TemporaryDirectory() as d:
+            path = d.path('model.mmt')
+            cache = d.path('cache')
+            with open(path, 'w') as f:
+                f.write(code)
+
+            # First load stores model, second load uses cache
+            self.assertFalse(os.path.exists(cache))
+            m2 = myokit.load_model(path, cache=cache)
+            self.assertTrue(m2.has_parse_info())
+            self.assertEqual(len(os.listdir(cache)), 1)
+            m3 = myokit.load_model(path, cache=cache)
+            self.assertFalse(m3.has_parse_info())
+            self.assertEqual(len(os.listdir(cache)), 1)
+            for m in (m2, m3):
+                self.assertTrue(m.is_valid())
+                self.assertEqual(m.code(), m1.code())
+                self.assertTrue(m.is_similar(m1, True))
+                self.assertEqual(
+                    [str(x) for x in m.warnings()],
+                    [str(x) for x in m1.warnings()])
+                self.assertEqual(
+                    [v.uname() for v in m.variables(deep=True)],
+                    [v.uname() for v in m1.variables(deep=True)])
+                self.assertEqual(
+                    list(m.user_functions()), list(m1.user_functions()))
+                self.assertEqual(m.label('ploop').qname(), 'c.p')
+                self.assertEqual(m.binding('pace').qname(), 'engine.pace')
+                self.assertEqual(m.get('c').alias_for(m.time()), 't')
+                self.assertEqual(m.get('c.x.tau.b').rhs().code(), '-0 + a')
+                self.assertEqual(
+                    m.get('c.y').initial_value().code(), '1 + c.p')
+                self.assertEqual(m.get('engine.u').meta['desc'], 'Unused')
+                self.assertEqual(
+                    m.get('c.y').rhs().eval(), m1.get('c.y').rhs().eval())
+                m.validate()
+                self.assertEqual(m.code(), m1.code())
+
+            # Changed files are stored separately
+            with open(path, 'a') as f:
+                f.write('r = 2\n')
+            m4 = myokit.load_model(path, cache=cache)
+            self.assertTrue(m4.has_parse_info())
+            self.assertEqual(len(os.listdir(cache)), 2)
+            self.assertEqual(myokit.load_model(path, cache=cache).code(),
+                             m4.code())
+
+            # Invalid cache files are ignored, and replaced
+            with open(path, 'r') as f:
+                entry = myokit._model_cache.cache_path(f.read(), cache)
+            with open(entry, 'wb') as f:
+                f.write(b'Not a model')
+            m5 = myokit.load_model(path, cache=cache)
+            self.assertTrue(m5.has_parse_info())
+            self.assertFalse(myokit.load_model(path, cache=cache)
+                             .has_parse_info())
+
+            # Errors are not cached
+            with open(path, 'a') as f:
+                f.write('r = 3\n')
+            self.assertRaises(
+                myokit.ParseError, myokit.load_model, path, cache)
+            self.assertEqual(len(os.listdir(cache)), 2)
+
+            # Files with a protocol
+            path = d.path('model-and-protocol.mmt')
+            with open(path, 'w') as f:
+                f.write(code)
+                f.write('\n[[protocol]]\n0 0 1 1000 0\n')
+            m6 = myokit.load_model(path, cache=cache)
+            self.assertEqual(m6.code(), m1.code())
+            m7 = myokit.load_model(path, cache=cache)
+            self.assertFalse(m7.has_parse_info())
+            self.assertEqual(m7.code(), m1.code())
+
     def test_load_partial(self):
         # Test loading of partial files.
         mpath = os.path.join(DIR_DATA, 'beeler-1977-model.mmt')
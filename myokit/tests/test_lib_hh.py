@@ -916,6 +916,77 @@ class AnalyticalSimulationTest(unittest.TestCase):
         e = np.abs(d1['binding.I'] - d2['binding.I'])
         self.assertLess(np.max(e), 2e-4)
 
+    def test_run_batch(self):
+        # Test running a population of simulations at once
+
+        fname = os.path.join(DIR_DATA, 'lr-1991-fitting.mmt')
+        model = myokit.load_model(fname)
+        m = hh.HHModel.from_component(model.get('ina'))
+        keys = m.states()
+
+        # The model function broadcasts over states, times and inputs
+        f = m.function()
+        y0 = np.array(m.default_state()).reshape((3, 1, 1))
+        v = np.array([-40, -20]).reshape((2, 1))
+        x, i = f(y0, np.array([0, 1, 2]), v, *m.default_parameters())
+        self.assertEqual(np.array(x).shape, (3, 2, 3))
+        self.assertEqual(i.shape, (2, 3))
+        x1, i1 = f(m.default_state(), 1, -20, *m.default_parameters())
+        self.assertEqual(x[0][1, 1], x1[0])
+        self.assertEqual(i[1, 1], i1)
+
+        # Family of step protocols, compared with separate simulations
+        vs = [-60, -40, -20, 0]
+        ps = [myokit.pacing.steptrain([v], -80, 5, 5) for v in vs]
+        times = np.arange(0, 20, 0.5)
+        s = hh.AnalyticalSimulation(m)
+        states, currents = s.run_batch(None, 20, log_times=times, protocols=ps)
+        self.assertEqual(states.shape, (4, 3, 40))
+        self.assertEqual(currents.shape, (4, 40))
+        for j, p in enumerate(ps):
+            d = hh.AnalyticalSimulation(m, p).run(20, log_times=times)
+            self.assertTrue(np.allclose(states[j], [d[k] for k in keys]))
+            self.assertTrue(np.allclose(currents[j], d['ina.INa']))
+
+        # Parameters and states, compared with separate simulations
+        s = hh.AnalyticalSimulation(m, ps[2])
+        s.pre(20)
+        parameters = np.array([s.parameters()] * 3)
+        parameters[:, 0] *= [0.5, 1, 2]
+        y0 = [s.state(), s.state(), [0.5, 0.5, 0.5]]
+        states, currents = s.run_batch(parameters, 12, states=y0)
+        self.assertEqual(states.shape, (3, 3, 1200))
+        for j in range(3):
+            s.reset()
+            s.set_parameters(parameters[j])
+            s.set_state(y0[j])
+            d = s.run(12)
+            self.assertTrue(np.allclose(states[j], [d[k] for k in keys]))
+            self.assertTrue(np.allclose(currents[j], d['ina.INa']))
+
+        # Simulation state is unchanged, unsorted log times are supported
+        s.reset()
+        self.assertEqual(s._time, 0)
+        states = s.run_batch(None, 10, log_times=[9, 1, 5])[0]
+        d = s.run(10, log_times=np.array([1, 5, 9]))
+        self.assertTrue(np.allclose(
+            states[0][:, [1, 2, 0]], [d[k] for k in keys]))
+
+        # Bad arguments
+        self.assertRaisesRegex(
+            ValueError, 'negative', s.run_batch, None, -1)
+        self.assertRaisesRegex(
+            ValueError, 'greater than zero', s.run_batch, None, 1, 0)
+        self.assertRaisesRegex(
+            ValueError, 'parameter array', s.run_batch, [[1, 2]], 1)
+        self.assertRaisesRegex(
+            ValueError, 'state array', s.run_batch, None, 1, states=[[1]])
+        self.assertRaisesRegex(
+            ValueError, 'Protocol', s.run_batch, None, 1, protocols=[1])
+        self.assertRaisesRegex(
+            ValueError, 'same number', s.run_batch, parameters, 1,
+            states=y0[:2])
+
     def test_tau_overflow(self):
         # Overflows leading to tau=0 should still report current
         # https://github.com/myokit/myokit/issues/1059
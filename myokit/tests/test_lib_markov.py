@@ -258,6 +258,39 @@ class LinearModelTest(unittest.TestCase):
         # Requires 21 parameters
         self.assertRaises(ValueError, m.matrices, -20, range(3))
 
+    def test_linear_model_batch_matrices(self):
+        # Test calculating matrices for several parameters and voltages
+
+        fname = os.path.join(DIR_DATA, 'clancy-1999-fitting.mmt')
+        model = myokit.load_model(fname)
+        m = markov.LinearModel.from_component(model.get('ina'))
+
+        # Test against matrices()
+        p = np.array(m.default_parameters())
+        p = np.array([p, p * 1.1, p * 0.9])
+        v = [-80, -20, 0, 40]
+        A, B = m.batch_matrices(v, p)
+        self.assertEqual(A.shape, (3, 4, 6, 6))
+        self.assertEqual(B.shape, (3, 4, 6))
+        for i, x in enumerate(p):
+            for j, y in enumerate(v):
+                a, b = m.matrices(y, x)
+                self.assertTrue(np.allclose(A[i, j], a, rtol=1e-14))
+                self.assertTrue(np.allclose(B[i, j], b, rtol=1e-14))
+
+        # Test defaults
+        A, B = m.batch_matrices()
+        a, b = m.matrices()
+        self.assertEqual(A.shape, (1, 1, 6, 6))
+        self.assertTrue(np.allclose(A[0, 0], a, rtol=1e-14))
+        self.assertTrue(np.allclose(B[0, 0], b, rtol=1e-14))
+
+        # Requires 21 parameters per row
+        self.assertRaisesRegex(
+            ValueError, 'parameter array', m.batch_matrices, v, range(21))
+        self.assertRaisesRegex(
+            ValueError, 'parameter array', m.batch_matrices, v, [range(3)])
+
     def test_linear_model_steady_state_1(self):
         # Test finding the steady-state of the Clancy model
 
@@ -453,6 +486,71 @@ class AnalyticalSimulationTest(unittest.TestCase):
         self.assertIs(d, e)
         self.assertTrue(len(d['engine.time']) > n)
 
+    def test_run_batch(self):
+        # Test running simulations for several parameter vectors at once
+
+        fname = os.path.join(DIR_DATA, 'clancy-1999-fitting.mmt')
+        model = myokit.load_model(fname)
+        m = markov.LinearModel.from_component(model.get('ina'))
+        p = np.array(m.default_parameters())
+        r = np.random.default_rng(1)
+        ps = p * r.uniform(0.8, 1.2, size=(4, len(p)))
+
+        def compare(s, ps, duration, **kwargs):
+            # Compare run_batch() with run()
+            state, time = s.state(), s._time
+            x, i = s.run_batch(ps, duration, **kwargs)
+            self.assertEqual(state, s.state())
+            self.assertEqual(time, s._time)
+            for k, p in enumerate(ps):
+                s.set_parameters(p)
+                s.set_state(state)
+                s._time = time
+                if s._protocol:
+                    s._pacing = myokit.PacingSystem(s._protocol)
+                    s._membrane_potential = s._pacing.advance(time)
+                d = s.run(duration, **kwargs)
+                y = np.array([d[v] for v in m.states()])
+                self.assertEqual(x[k].shape, y.shape)
+                self.assertTrue(np.allclose(x[k], y, rtol=0, atol=1e-12))
+                self.assertTrue(np.allclose(
+                    i[k], d[m.current()], rtol=1e-9, atol=1e-12))
+            return x, i
+
+        # Without a protocol
+        s = markov.AnalyticalSimulation(m)
+        s.set_membrane_potential(-20)
+        x, i = compare(s, ps, 10, log_interval=0.5)
+        self.assertEqual(x.shape, (4, 6, 20))
+        self.assertEqual(i.shape, (4, 20))
+
+        # With a step protocol, starting halfway through
+        v = np.arange(-100, 41, 20)
+        p = myokit.pacing.steptrain(v, -80, 100, 5, 0)
+        s = markov.AnalyticalSimulation(m, p)
+        with WarningCollector():
+            s.run(50)
+            compare(s, ps, 500, log_interval=0.1)
+            t = np.array([50, 100, 100.5, 101, 105, 300])
+            compare(s, ps, 500, log_times=t)
+
+            # Unordered log times
+            x1, i1 = s.run_batch(ps, 500, log_times=[50, 101, 300, 100.5])
+            x2, i2 = s.run_batch(ps, 500, log_times=[50, 100.5, 101, 300])
+            self.assertTrue(np.all(x1[:, :, [0, 3, 1, 2]] == x2))
+            self.assertTrue(np.all(i1[:, [0, 3, 1, 2]] == i2))
+
+        # Without a current
+        model.get('ina').remove_variable(model.get('ina.i'))
+        m = markov.LinearModel.from_component(model.get('ina'))
+        s = markov.AnalyticalSimulation(m)
+        self.assertEqual(s.run_batch(ps, 1).shape, (4, 6, 100))
+
+        # Bad arguments
+        self.assertRaisesRegex(ValueError, 'Duration', s.run_batch, ps, -1)
+        self.assertRaisesRegex(
+            ValueError, 'Log interval', s.run_batch, ps, 1, log_interval=0)
+
     def test_analytical_simulation_properties(self):
         # Test basic get/set methods of analytical simulation.
 
@@ -573,6 +671,14 @@ class DiscreteSimulationTest(unittest.TestCase):
     def test_basics(self):
         # Test the DiscreteSimulation class, running, resetting etc..
 
+        # The outcomes checked below depend on the random numbers drawn, so
+        # this test uses the Python implementation. The compiled back-end is
+        # tested in test_end_of_step and test_run_logging.
+        from myokit._sim import ssa
+        self.addCleanup(
+            setattr, ssa.NativeSSA, '_instance', ssa.NativeSSA._instance)
+        ssa.NativeSSA._instance = False
+
         # Create a simulation
         fname = os.path.join(DIR_DATA, 'clancy-1999-fitting.mmt')
         model = myokit.load_model(fname)
@@ -746,6 +852,163 @@ class DiscreteSimulationTest(unittest.TestCase):
         self.assertRaisesRegex(
             ValueError, 'must equal 1', s.discretize_state, [0.5, 0.6])
 
+        # Tau leaping
+        self.assertIsNone(s.tau_leaping())
+        s.set_tau_leaping(0.1)
+        self.assertEqual(s.tau_leaping(), 0.1)
+        s.set_tau_leaping(None)
+        self.assertIsNone(s.tau_leaping())
+        self.assertRaisesRegex(
+            ValueError, 'positive', s.set_tau_leaping, 0)
+
+    def test_run_logging(self):
+        # Test the events logged by run(), with and without tau leaping
+
+        fname = os.path.join(DIR_DATA, 'clancy-1999-fitting.mmt')
+        model = myokit.load_model(fname)
+        m = markov.LinearModel.from_component(model.get('ina'))
+        p = myokit.pacing.steptrain([-20], -120, 2, 3, 0)
+        np.random.seed(1)
+        s = markov.DiscreteSimulation(m, p, nchannels=200)
+
+        for tau in (None, 0.01):
+            s.reset()
+            s.set_tau_leaping(tau)
+            d = s.run(5)
+            t = np.array(d.time())
+            self.assertEqual(t[0], 0)
+            self.assertTrue(np.all(t[1:] >= t[:-1]))
+            self.assertTrue(t[-1] < 5)
+            self.assertEqual(s._time, 5)
+
+            # States sum to the number of channels. With tau-leaping, the
+            # last logged state is the final state. Without, transitions made
+            # in the final brute-force step are not logged.
+            x = np.array([d[k] for k in m.states()])
+            self.assertTrue(np.all(np.sum(x, axis=0) == 200))
+            self.assertEqual(sum(s.state()), 200)
+            if tau is not None:
+                self.assertEqual(list(x[:, -1]), s.state())
+
+            # Membrane potential and current follow the protocol
+            v = np.array(d['membrane.V'])
+            self.assertTrue(np.all(v[t < 2] == -120))
+            self.assertTrue(np.all(v[t >= 2] == -20))
+            for vm in (-120, -20):
+                B = m.matrices(vm)[1]
+                self.assertTrue(np.allclose(
+                    np.array(d['ina.i'])[v == vm], B.dot(x[:, v == vm]) / 200))
+
+        # Python implementation, used if the back-end can't be compiled
+        from myokit._sim import ssa
+        s.set_tau_leaping(None)
+        s.reset()
+        instance = ssa.NativeSSA._instance
+        try:
+            ssa.NativeSSA._instance = False
+            d = s.run(5)
+        finally:
+            ssa.NativeSSA._instance = instance
+        self.assertEqual(s._time, 5)
+        x = np.array([d[k] for k in m.states()])
+        self.assertTrue(np.all(np.sum(x, axis=0) == 200))
+        self.assertEqual(len(d['ina.i']), len(d.time()))
+
+    def test_end_of_step(self):
+        # Test that both back-ends end each step with a single brute-force
+        # step, in which transitions happen with probability rate * dt.
+
+        fname = os.path.join(DIR_DATA, 'clancy-1999-fitting.mmt')
+        model = myokit.load_model(fname)
+        m = markov.LinearModel.from_component(model.get('ina'))
+        p = myokit.pacing.steptrain([-140, 100], -80, 10, 150, 0)
+
+        def changed(seeds):
+            # Count how often a short run after a long pre-pacing step changes
+            # the state of a single channel
+            n = 0
+            for seed in seeds:
+                np.random.seed(seed)
+                s = markov.DiscreteSimulation(m, p)
+                s.pre(160)
+                state = s.state()
+                s.run(15)
+                n += int(state != s.state())
+            return n
+
+        # With the exact direct method, the state hardly ever changes in the
+        # first part of the holding step. The brute-force final step makes it
+        # change in roughly half the runs, in both back-ends.
+        from myokit._sim import ssa
+        seeds = range(1, 41)
+        n1 = changed(seeds)
+        instance = ssa.NativeSSA._instance
+        try:
+            ssa.NativeSSA._instance = False
+            n2 = changed(seeds)
+        finally:
+            ssa.NativeSSA._instance = instance
+        self.assertGreater(n1, 8)
+        self.assertLess(n1, 32)
+        self.assertGreater(n2, 8)
+        self.assertLess(n2, 32)
+
+    def test_run_batch(self):
+        # Test running many realisations at once
+
+        fname = os.path.join(DIR_DATA, 'clancy-1999-fitting.mmt')
+        model = myokit.load_model(fname)
+        m = markov.LinearModel.from_component(model.get('ina'))
+        p = myokit.pacing.steptrain([-20], -120, 5, 5, 0)
+        np.random.seed(1)
+        s = markov.DiscreteSimulation(m, p, nchannels=1000)
+        s.set_state(s.discretize_state(m.steady_state(-120)))
+        times = np.array([2, 6, 8, 9.9])
+
+        # Compare the mean with an analytical simulation
+        a = markov.AnalyticalSimulation(m, p)
+        a.set_state(np.array(s.state()) / 1000)
+        d = a.run(10, log_times=times)
+        x = np.array([d[k] for k in m.states()])
+        states, currents = s.run_batch(100, 10, log_times=times)
+        self.assertEqual(states.shape, (100, 6, 4))
+        self.assertEqual(currents.shape, (100, 4))
+        self.assertTrue(np.all(np.sum(states, axis=1) == 1000))
+        self.assertLess(np.max(np.abs(
+            np.mean(states, axis=0) / 1000 - x)), 0.01)
+        self.assertLess(np.max(np.abs(
+            np.mean(currents, axis=0) - d['ina.i'])), 10)
+
+        # Same for tau-leaping, with a small step size
+        s.set_tau_leaping(0.001)
+        states = s.run_batch(100, 10, log_times=times)[0]
+        self.assertTrue(np.all(np.sum(states, axis=1) == 1000))
+        self.assertLess(np.max(np.abs(
+            np.mean(states, axis=0) / 1000 - x)), 0.01)
+        s.set_tau_leaping(None)
+
+        # Simulation state is unchanged
+        self.assertEqual(s._time, 0)
+        self.assertEqual(s.state(), s.discretize_state(m.steady_state(-120)))
+
+        # Results don't depend on the number of threads
+        np.random.seed(2)
+        x1 = s.run_batch(3, 10, log_interval=1, threads=1)[0]
+        np.random.seed(2)
+        x2 = s.run_batch(3, 10, log_interval=1, threads=3)[0]
+        self.assertEqual(x1.shape, (3, 6, 10))
+        self.assertTrue(np.all(x1 == x2))
+        self.assertFalse(np.all(x1[0] == x1[1]))
+
+        # Bad arguments
+        self.assertRaisesRegex(ValueError, 'at least 1', s.run_batch, 0, 1)
+        self.assertRaisesRegex(ValueError, 'negative', s.run_batch, 1, -1)
+        self.assertRaisesRegex(
+            ValueError, 'greater than zero', s.run_batch, 1, 1, 0)
+        self.assertRaisesRegex(
+            ValueError, 'non-decreasing', s.run_batch, 1, 1,
+            log_times=[1, 0])
+
 
 class MarkovFunctionsTest(unittest.TestCase):
     """
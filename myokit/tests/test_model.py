@@ -8,13 +8,16 @@
 # This file is part of Myokit.
 # See http://myokit.org for copyright, sharing, and licensing details.
 #
+import os
 import pickle
 import re
 import unittest
 
+import numpy as np
+
 import myokit
 
-from myokit.tests import TemporaryDirectory, WarningCollector
+from myokit.tests import DIR_DATA, TemporaryDirectory, WarningCollector
 
 
 class ModelTest(unittest.TestCase):
@@ -337,6 +340,30 @@ class ModelTest(unittest.TestCase):
         self.assertEqual(m2.get('c.s').initial_value().code(),
                          '1 [g] + c.z / 2 [1/g]')
 
+        # Test sub-expressions without references are shared, but references
+        # are to the clone's variables
+        p.set_rhs('(1 + exp(3)) * c.z - p')
+        m2 = m1.clone()
+        p2 = m2.get('c.p')
+        e1, e2 = p.rhs(), p2.rhs()
+        self.assertEqual(e1.code(), e2.code())
+        self.assertIsNot(e1, e2)
+        self.assertIs(e1[0][0], e2[0][0])
+        self.assertIsNot(e1[0][1], e2[0][1])
+        self.assertIs(e2[0][1].var(), m2.get('c.z'))
+        self.assertIs(e2[1].var(), p2)
+        self.assertIs(m2.get('c.z').rhs(), z.rhs())
+        self.assertEqual(set(p2.refs_to()), set([m2.get('c.z')]))
+        self.assertEqual(set(p2.refs_to(True)), set([p2]))
+        self.assertIs(m2.get('c.r').initial_value().var(), m2.get('c.z'))
+
+        # Changes to the clone don't affect the original
+        m2.get('c.z').set_rhs(4)
+        p2.set_rhs('2 * c.z')
+        self.assertEqual(z.rhs(), myokit.Number(123))
+        self.assertEqual(p.rhs().code(), '(1 + exp(3)) * c.z - c.p')
+        self.assertEqual(set(z.refs_by()), set([p]))
+
     def test_code(self):
         # Test :meth:`Model.code()`.
 
@@ -511,6 +538,123 @@ class ModelTest(unittest.TestCase):
         nan = model.evaluate_derivatives(ignore_errors=True)[2]
         self.assertNotEqual(nan, nan)   # x != x is a nan test...
 
+    def test_evaluate_derivatives_compiled(self):
+        # Test the compiled function used by Model.evaluate_derivatives().
+        m = myokit.load_model(os.path.join(DIR_DATA, 'lr-1991.mmt'))
+        y = np.array(m.initial_values(True)) * 1.01
+        inputs = {'time': 3, 'pace': 1}
+
+        def expected(*args, **kwargs):
+            # Evaluate without the compiled function
+            m._cached_evaluator = False
+            try:
+                return m.evaluate_derivatives(*args, **kwargs)
+            finally:
+                m._cached_evaluator = None
+
+        # Results are the same as with Expression.eval()
+        x = m.evaluate_derivatives()
+        self.assertIsNotNone(m._cached_evaluator)
+        self.assertEqual(x, expected())
+        self.assertEqual(m.evaluate_derivatives(y), expected(y))
+        self.assertEqual(
+            m.evaluate_derivatives(y, inputs), expected(y, inputs))
+
+        # Single precision doesn't use the compiled function
+        self.assertRaisesRegex(
+            myokit.NumericalError, 'overflow', m.evaluate_derivatives,
+            precision=myokit.SINGLE_PRECISION)
+
+        # Function is cached, and discarded after changes
+        f = m._evaluator()
+        self.assertIs(f, m._evaluator())
+        v = m.get('ica.Ca_i')
+        v.set_rhs('-1e-4 * ica.ICa + 0.07 * (1e-4 - ica.Ca_i)')
+        self.assertIsNone(m._cached_evaluator)
+        self.assertEqual(m.evaluate_derivatives(y), expected(y))
+        m.reorder_state(list(m.states())[::-1])
+        self.assertIsNone(m._cached_evaluator)
+        y = y[::-1]
+        self.assertEqual(m.evaluate_derivatives(y), expected(y))
+        m.get('membrane.i_ion').promote(0)
+        self.assertIsNone(m._cached_evaluator)
+        self.assertEqual(len(m.evaluate_derivatives()), 9)
+
+        # Errors are reported as before
+        v.set_rhs('1 / (ica.Ca_i - ica.Ca_i)')
+        self.assertRaisesRegex(
+            myokit.NumericalError, r'1 / \(ica.Ca_i - ica.Ca_i\)',
+            m.evaluate_derivatives)
+        x = m.evaluate_derivatives(ignore_errors=True)
+        self.assertTrue(np.isnan(x[v.index()]))
+
+        # If the function can't be created, eval() is used
+        v.set_rhs('0.07 * (1e-4 - ica.Ca_i)')
+        m._create_evaluator = lambda: 1 / 0
+        x = m.evaluate_derivatives()
+        self.assertIs(m._cached_evaluator, False)
+        self.assertEqual(x, expected())
+
+    def test_pyfunc_rhs(self):
+        # Test Model.pyfunc_rhs().
+        model = myokit.Model('m')
+        component = model.add_component('c')
+        t = component.add_variable('time')
+        t.set_binding('time')
+        t.set_rhs(0)
+        p = component.add_variable('pace')
+        p.set_binding('pace')
+        p.set_rhs(3)
+        a = component.add_variable('a')
+        b = component.add_variable('b')
+        c = component.add_variable('c')
+        d = component.add_variable('d')
+        a.promote(1)
+        a.set_rhs('exp(b + 1) + exp(b + 1) / 2')
+        b.promote(2)
+        b.set_rhs('2 * b + pace')
+        c.promote(3)
+        c.set_rhs('b + d + time')
+        d.set_rhs('1 * c')
+        model.validate()
+        f = model.pyfunc_rhs()
+
+        # Single state, compared with evaluate_derivatives
+        y = model.initial_values(True)
+        self.assertTrue(np.allclose(f(y), model.evaluate_derivatives()))
+        self.assertEqual(f(y).shape, (3, ))
+
+        # Arrays of states, with scalar and array inputs
+        r = np.random.default_rng(1)
+        ys = r.uniform(0, 2, (5, 4, 3))
+        ts = r.uniform(0, 2, (5, 4))
+        dy = f(ys, {'time': ts, 'pace': 1.5})
+        self.assertEqual(dy.shape, (5, 4, 3))
+        for i in range(5):
+            for j in range(4):
+                x = model.evaluate_derivatives(
+                    ys[i, j], inputs={'time': ts[i, j], 'pace': 1.5})
+                self.assertTrue(np.allclose(dy[i, j], x))
+
+        # Inputs broadcast over states
+        dy = f(y, {'time': ts})
+        self.assertEqual(dy.shape, (5, 4, 3))
+        self.assertTrue(np.allclose(dy[:, :, 2], y[1] + y[2] + ts))
+
+        # Wrong shape
+        self.assertRaisesRegex(
+            ValueError, 'last axis', f, np.zeros((4, 2)))
+
+        # Larger model with shared subexpressions
+        m = myokit.load_model(os.path.join(DIR_DATA, 'lr-1991.mmt'))
+        f = m.pyfunc_rhs()
+        y0 = np.array(m.initial_values(True))
+        ys = y0 * r.uniform(0.9, 1.1, (10, len(y0)))
+        dy = f(ys, {'time': 1, 'pace': 0})
+        for y, x in zip(ys, dy):
+            e = m.evaluate_derivatives(y, inputs={'time': 1, 'pace': 0})
+            self.assertTrue(np.allclose(x, e))
+
     def test_format_state(self):
         # Test Model.format_state()
 
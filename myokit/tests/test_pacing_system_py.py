@@ -7,6 +7,8 @@
 #
 import unittest
 
+import numpy as np
+
 import myokit
 
 
@@ -107,6 +109,53 @@ class EventBasedPacingPythonTest(unittest.TestCase):
         self.assertEqual(s.time(), 1)
         self.assertEqual(s.pace(), 1)
 
+    def test_advance_multiple(self):
+        # Test advancing to a sequence of times at once
+
+        p = myokit.Protocol()
+        p.schedule(2, 10, 100, 1000, 2)
+        p.schedule(3, 50, 20, 500, 0)
+        p.schedule(-1, 1005, 2)
+        t = np.linspace(0, 3000, 30001)
+
+        s1 = myokit.PacingSystem(p)
+        v1 = [s1.advance(x) for x in t]
+        s2 = myokit.PacingSystem(p)
+        v2 = s2.advance(t)
+        self.assertIsInstance(v2, np.ndarray)
+        self.assertTrue(np.all(v2 == v1))
+        self.assertEqual(s2.time(), 3000)
+        self.assertEqual(s2.pace(), s1.pace())
+        self.assertEqual(s2.next_time(), s1.next_time())
+
+        # Can continue after advancing
+        self.assertEqual(s2.advance(3050), 3)
+        self.assertEqual(list(s2.advance([3060, 3070, 3080])), [3, 0, 0])
+        self.assertEqual(len(s2.advance([])), 0)
+
+        # Advancing in chunks, some of which start during an event, gives
+        # the same result as advancing one step at a time
+        s3 = myokit.PacingSystem(p)
+        v3 = np.concatenate([s3.advance(x) for x in np.array_split(t, 293)])
+        self.assertTrue(np.all(v3 == v1))
+        s3 = myokit.PacingSystem(p)
+        s3.advance(15)
+        self.assertEqual(s3.pace(), 2)
+        self.assertEqual(list(s3.advance([15, 30, 50, 70])), [2, 2, 3, 0])
+        self.assertEqual(s3.next_time(), 550)
+
+        # Times must be non-decreasing, and not in the past
+        self.assertRaisesRegex(
+            ValueError, 'non-decreasing', s2.advance, [3090, 3085])
+        self.assertRaisesRegex(
+            ValueError, 'cannot be before', s2.advance, [10, 3085])
+
+        # Starting from a negative time
+        s = myokit.PacingSystem(p, initial_time=-100)
+        self.assertTrue(np.all(s.advance(t - 100) == [
+            myokit.PacingSystem(p).advance(x) if x >= 0 else 0
+            for x in t - 100]))
+
 
 if __name__ == '__main__':
     unittest.main()
@@ -8,6 +8,8 @@
 import pickle
 import unittest
 
+import numpy as np
+
 import myokit
 
 from myokit.tests import WarningCollector
@@ -420,9 +422,28 @@ class ProtocolTest(unittest.TestCase):
         v = [0, 0, 2, 2, 2, 0, 0, 0, 0, 2, 0, 0, 0]
         self.assertEqual(v, p.value_at_times(t))
 
+        # Numpy arrays in, numpy arrays out
+        x = p.value_at_times(np.array(t))
+        self.assertIsInstance(x, np.ndarray)
+        self.assertTrue(np.all(x == v))
+        self.assertIsInstance(p.log_for_times(np.array(t))['pace'], np.ndarray)
+
+        # Overlapping recurring events: the level at each time is the same as
+        # when advancing a pacing system one step at a time
+        p = myokit.Protocol()
+        p.schedule(1, 47.5, 17, 94.6, 4)
+        p.schedule(2, 88.9, 30.2, 158.2, 3)
+        p.schedule(3, 115.8, 18.2, 139.1, 2)
+        t = np.linspace(0, 1000, 10001)
+        s = myokit.PacingSystem(p)
+        self.assertTrue(np.all(
+            p.value_at_times(t) == [s.advance(x) for x in t]))
+        self.assertEqual(p.value_at_times([115.8, 116]), [3, 3])
+
         # Empty times
         d = p.log_for_times([])
         self.assertEqual(len(p.value_at_times([])), 0)
+        self.assertIsInstance(p.value_at_times(np.array([])), np.ndarray)
 
         # Decreasing times
         self.assertRaisesRegex(
@@ -8,6 +8,8 @@
 import unittest
 import pickle
 
+import numpy as np
+
 import myokit
 
 
@@ -75,6 +77,16 @@ class TimeSeriesProtocolTest(unittest.TestCase):
         test(6, 10.5)
         test(5.5, 10.25)
 
+        # Multiple times at once
+        t = np.array([-1, 0, 1, 2, 3, 4, 5, 7, 8, 1.5, 1.75, 6, 5.5])
+        v = pacing.pace(t)
+        self.assertIsInstance(v, np.ndarray)
+        self.assertEqual(list(v), [pacing.pace(x) for x in t])
+
+        # Single point
+        pacing = myokit.TimeSeriesProtocol([1], [3])
+        self.assertEqual(list(pacing.pace([0, 1, 2])), [3, 3, 3])
+
 
 if __name__ == '__main__':
     import warnings
@@ -54,6 +54,35 @@ class PypeTest(unittest.TestCase):
             # OSError from inside pype
             self.e("""Hello<?open('file.txt', 'r')?>yes""", {}, 'No such file')
 
+    def test_cache(self):
+        # Test that converted templates are cached, until they change.
+
+        with TemporaryDirectory() as d:
+            path = d.path('template')
+            with open(path, 'w') as f:
+                f.write('Hello <?= name ?>')
+            e = myokit.pype.TemplateEngine()
+            self.assertEqual(e.process(path, {'name': 'Bert'}), 'Hello Bert')
+            script, code = myokit.pype._cache[path][2:]
+            self.assertEqual(e.process(path, {'name': 'Ernie'}), 'Hello Ernie')
+            self.assertIs(myokit.pype._cache[path][3], code)
+
+            # Changing the file invalidates the cache
+            with open(path, 'w') as f:
+                f.write('Goodbye <?= name ?>!')
+            self.assertEqual(
+                e.process(path, {'name': 'Ernie'}), 'Goodbye Ernie!')
+            self.assertIsNot(myokit.pype._cache[path][3], code)
+
+            # Scripts with syntax errors are not cached
+            with open(path, 'w') as f:
+                f.write('Hello <?if?>')
+            with myokit.tools.capture():
+                self.assertRaises(
+                    myokit.pype.PypeError, e.process, path, {})
+            self.assertIn('SyntaxError', e.error_details())
+            self.assertNotIn(path, myokit.pype._cache)
+
     def e(self, template, args, expected_error=None):
         """
         Runs a template, if an error is expected it checks if it's the right
@@ -92,6 +92,140 @@ class Simulation1dTest(unittest.TestCase):
         s.set_time(100)
         self.assertEqual(s.time(), 100)
 
+    def test_diffusion_schemes(self):
+        # Test the explicit and implicit diffusion schemes
+
+        m, p, _ = myokit.load(os.path.join(DIR_DATA, 'lr-1991.mmt'))
+        n = 10
+        s = myokit.Simulation1d(m, p, ncells=n, rl=True)
+        self.assertEqual(s.diffusion_scheme(), 'explicit')
+
+        def activation_time(scheme, dt):
+            s.reset()
+            s.set_diffusion_scheme(scheme)
+            s.set_step_size(dt)
+            d = s.run(20, log=['engine.time', 'membrane.V'], log_interval=0.1)
+            d = d.npview()
+            v = d['membrane.V', n - 1]
+            self.assertTrue(np.all(np.isfinite(v)))
+            return d.time()[np.argmax(v > -20)]
+
+        # All schemes agree for small step sizes
+        ta = activation_time('explicit', 0.001)
+        self.assertGreater(ta, 0)
+        tb = activation_time('backward-euler', 0.001)
+        self.assertEqual(s.diffusion_scheme(), 'backward-euler')
+        tc = activation_time('crank-nicolson', 0.001)
+        self.assertEqual(s.diffusion_scheme(), 'crank-nicolson')
+        self.assertAlmostEqual(ta, tb, delta=0.11)
+        self.assertAlmostEqual(ta, tc, delta=0.11)
+
+        # Implicit schemes remain stable for larger step sizes
+        self.assertAlmostEqual(
+            ta, activation_time('crank-nicolson', 0.05), delta=1)
+
+        # Unknown scheme
+        self.assertRaisesRegex(
+            ValueError, 'Unknown diffusion', s.set_diffusion_scheme, 'x')
+
+        # Implicit schemes require a linear dependence on the current
+        m2 = m.clone()
+        x = m2.get('membrane').add_variable('i_input')
+        x.set_rhs(0)
+        m2.binding('diffusion_current').set_binding(None)
+        x.set_binding('diffusion_current')
+        m2.get('membrane.i_diff').set_rhs('i_input^2')
+        s = myokit.Simulation1d(m2, p, ncells=n)
+        s.set_diffusion_scheme('explicit')
+        self.assertRaisesRegex(
+            ValueError, 'linearly', s.set_diffusion_scheme, 'crank-nicolson')
+
+    def test_fields(self):
+        # Test per-cell parameters and junction conductances
+
+        m, p, _ = myokit.load(os.path.join(DIR_DATA, 'lr-1991.mmt'))
+        n = 10
+        s = myokit.Simulation1d(m, p, ncells=n)
+        log = ['engine.time', 'membrane.V']
+
+        def run():
+            s.reset()
+            return s.run(20, log=log, log_interval=0.1).npview()
+
+        def activation_times(d):
+            return [d.time()[np.argmax(d['membrane.V', i] > -20)]
+                    for i in range(n)]
+
+        d0 = run()
+
+        # Fields equal to the defaults give the same result
+        s.set_field('ina.gNa', [16] * n)
+        s.set_conductance_field([10] * (n - 1))
+        self.assertIsNone(s.conductance())
+        d1 = run()
+        for i in range(n):
+            self.assertTrue(np.all(d0['membrane.V', i] == d1['membrane.V', i]))
+
+        # Lower sodium conductance in some cells slows propagation
+        s.set_field(m.get('ina.gNa'), [16] * 5 + [8] * 5)
+        t0 = activation_times(d0)
+        t1 = activation_times(run())
+        self.assertEqual(t0[:3], t1[:3])
+        self.assertGreater(t1[-1], t0[-1])
+        s.remove_field('ina.gNa')
+        self.assertEqual(activation_times(run()), t0)
+
+        # Removing a field that isn't set does nothing
+        s.remove_field(m.get('ina.gNa'))
+        self.assertRaises(KeyError, s.remove_field, 'ina.gX')
+
+        # A zero conductance blocks propagation
+        s.set_conductance_field([10] * 4 + [0] + [10] * 4)
+        d2 = run()
+        self.assertGreater(np.max(d2['membrane.V', 4]), 0)
+        self.assertLess(np.max(d2['membrane.V', 5]), -50)
+        s.set_conductance(10)
+        self.assertEqual(s.conductance(), 10)
+        self.assertEqual(activation_times(run()), t0)
+
+        # Invalid fields
+        self.assertRaisesRegex(
+            ValueError, 'length', s.set_field, 'ina.gNa', [1] * (n - 1))
+        self.assertRaisesRegex(
+            ValueError, 'constants', s.set_field, 'membrane.V', [1] * n)
+        self.assertRaisesRegex(
+            ValueError, 'Bound', s.set_field, 'membrane.i_diff', [1] * n)
+        self.assertRaisesRegex(
+            ValueError, 'length', s.set_conductance_field, [1] * n)
+        self.assertRaisesRegex(
+            ValueError, 'negative', s.set_conductance_field, [-1] * (n - 1))
+        self.assertRaisesRegex(
+            ValueError, 'sequence of numbers', s.set_field, 'ina.gNa',
+            [1] * (n - 1) + ['x'])
+        self.assertRaisesRegex(
+            ValueError, 'sequence of numbers', s.set_field, 'ina.gNa',
+            [1] * (n - 1) + [None])
+        self.assertRaisesRegex(
+            ValueError, 'sequence of numbers', s.set_field, 'ina.gNa', 1)
+        self.assertRaisesRegex(
+            ValueError, 'sequence of numbers', s.set_conductance_field,
+            [[1, 2]] * (n - 1))
+
+        # Fields affecting dV/di_diff work with implicit schemes
+        m2 = m.clone()
+        c = m2.get('membrane').add_variable('C')
+        c.set_rhs(1)
+        m2.get('membrane.V').set_rhs('-(i_ion + i_stim + i_diff) / C')
+        s = myokit.Simulation1d(m2, p, ncells=n)
+        s.set_field('membrane.C', [1] * 5 + [2] * 5)
+        s.set_step_size(0.001)
+        ta = activation_times(run())
+        s.set_diffusion_scheme('backward-euler')
+        tb = activation_times(run())
+        self.assertGreater(ta[-1], t0[-1])
+        for a, b in zip(ta, tb):
+            self.assertAlmostEqual(a, b, delta=0.11)
+
     def test_initial_value_expressions(self):
         # Test if initial value expressions are converted to floats
         m = myokit.parse_model('''
@@ -0,0 +1,179 @@
+#!/usr/bin/env python3
+#
+# Tests the Simulation1dCVODES class.
+#
+# This file is part of Myokit.
+# See http://myokit.org for copyright, sharing, and licensing details.
+#
+import os
+import unittest
+
+import numpy as np
+
+import myokit
+
+from myokit.tests import DIR_DATA, CancellingReporter
+
+
+class Simulation1dCVODESTest(unittest.TestCase):
+    """
+    Test the CVODES-based 1d simulation.
+    """
+
+    @classmethod
+    def setUpClass(cls):
+        cls.m, cls.p, _ = myokit.load(os.path.join(DIR_DATA, 'lr-1991.mmt'))
+        cls.s = myokit.Simulation1dCVODES(cls.m, cls.p, ncells=5)
+
+    def test_basic(self):
+        # Test basic usage.
+        m, p, s = self.m, self.p, self.s
+        s.reset()
+        s.set_time(0)
+
+        x0 = m.initial_values(True)
+        self.assertEqual(s.time(), 0)
+        self.assertEqual(s.state(0), x0)
+        self.assertEqual(s.default_state(0), x0)
+        d = s.run(5, log_interval=1)
+        self.assertEqual(s.time(), 5)
+        self.assertNotEqual(s.state(0), x0)
+        self.assertEqual(s.default_state(0), x0)
+        self.assertEqual(list(d.time()), [0, 1, 2, 3, 4])
+        self.assertIn('4.membrane.V', d)
+        self.assertGreater(s.last_number_of_steps(), 0)
+        self.assertGreater(s.last_number_of_evaluations(), 0)
+
+        # Test full state getting and reset
+        self.assertEqual(s.default_state(), x0 * 5)
+        self.assertNotEqual(s.state(), x0 * 5)
+        s.reset()
+        self.assertEqual(s.state(), s.default_state())
+
+        # Test pre updates the default state.
+        s.pre(1)
+        self.assertNotEqual(s.default_state(0), x0)
+        s.set_default_state(x0)
+        s.reset()
+
+        # Simulation time can't be negative
+        self.assertRaises(ValueError, s.run, -1)
+
+        # Log interval must be positive
+        self.assertRaisesRegex(
+            ValueError, 'Log interval', s.run, 1, log_interval=0)
+
+        # Number of cells must be >0
+        self.assertRaisesRegex(
+            ValueError, 'number of cells', myokit.Simulation1dCVODES, m, p, 0)
+
+        # Model must have a membrane potential
+        m2 = m.clone()
+        m2.get('membrane.V').set_label(None)
+        self.assertRaisesRegex(
+            ValueError, 'membrane_potential',
+            myokit.Simulation1dCVODES, m2, p, 5)
+
+        # Model must have a diffusion current
+        m2 = m.clone()
+        m2.binding('diffusion_current').set_binding(None)
+        self.assertRaisesRegex(
+            ValueError, 'diffusion_current',
+            myokit.Simulation1dCVODES, m2, p, 5)
+
+        # Test setting conductance
+        s.set_conductance(10)
+        self.assertEqual(s.conductance(), 10)
+        self.assertRaises(ValueError, s.set_conductance, -1)
+
+        # Test setting paced cells
+        s.set_paced_cells(1)
+        self.assertEqual(s.paced_cells(), 1)
+        self.assertRaises(ValueError, s.set_paced_cells, -1)
+        s.set_paced_cells()
+
+        # Test setting tolerances
+        self.assertRaises(ValueError, s.set_tolerance, 0, 1e-4)
+        self.assertRaises(ValueError, s.set_tolerance, 1e-6, 0)
+
+        # Test setting states
+        self.assertRaisesRegex(ValueError, 'Wrong size', s.set_state, [1, 2])
+        self.assertRaisesRegex(ValueError, 'out of range', s.state, 5)
+        x1 = [float(i) for i in range(len(x0))]
+        s.set_state(x1, 2)
+        self.assertEqual(s.state(2), x1)
+        self.assertEqual(s.state(1), x0)
+        s.set_state(x0)
+        self.assertEqual(s.state(), x0 * 5)
+
+    def test_against_simulation(self):
+        # A single cell should match a single cell CVODES simulation
+        s1 = myokit.Simulation1dCVODES(self.m, self.p, ncells=1)
+        s1.set_tolerance(1e-8, 1e-8)
+        d1 = s1.run(600, log=['engine.time', 'engine.pace', 'membrane.V'],
+                    log_interval=1).npview()
+
+        s2 = myokit.Simulation(self.m, self.p)
+        s2.set_tolerance(1e-8, 1e-8)
+        d2 = s2.run(600, log=['engine.time', 'engine.pace', 'membrane.V'],
+                    log_interval=1).npview()
+
+        self.assertTrue(np.all(d1.time() == d2.time()))
+        self.assertTrue(np.all(d1['engine.pace'] == d2['engine.pace']))
+        self.assertLess(
+            np.max(np.abs(d1['membrane.V', 0] - d2['membrane.V'])), 1e-3)
+
+    def test_against_simulation_1d(self):
+        # Activation times should match a fixed-step simulation with a very
+        # small step size.
+        ncells = 10
+        log = ['engine.time', 'membrane.V']
+        s1 = myokit.Simulation1dCVODES(self.m, self.p, ncells=ncells)
+        s1.set_tolerance(1e-8, 1e-8)
+        d1 = s1.run(20, log=log, log_interval=0.01).npview()
+
+        s2 = myokit.Simulation1d(self.m, self.p, ncells=ncells)
+        s2.set_step_size(0.001)
+        d2 = s2.run(20, log=log, log_interval=0.01).npview()
+
+        for i in range(ncells):
+            t1 = d1.time()[np.argmax(d1['membrane.V', i] > -20)]
+            t2 = d2.time()[np.argmax(d2['membrane.V', i] > -20)]
+            self.assertAlmostEqual(t1, t2, delta=0.05)
+
+    def test_evaluation_count(self):
+        # Updating the models for logging doesn't count as an evaluation, so
+        # the number of evaluations doesn't depend on the log interval.
+        s = self.s
+        s.reset()
+        s.run(20, log_interval=1)
+        n1, e1 = s.last_number_of_steps(), s.last_number_of_evaluations()
+        s.reset()
+        d = s.run(20, log_interval=0.01)
+        n2, e2 = s.last_number_of_steps(), s.last_number_of_evaluations()
+        self.assertEqual(len(d.time()), 2000)
+        self.assertEqual(n1, n2)
+        self.assertEqual(e1, e2)
+        self.assertLess(e2, 2000)
+
+    def test_with_progress_reporter(self):
+        # Test running with a progress reporter.
+        s = self.s
+        s.reset()
+        with myokit.tools.capture() as c:
+            s.run(110, progress=myokit.ProgressPrinter())
+        c = c.text().splitlines()
+        self.assertTrue(len(c) > 0)
+
+        # Not a progress reporter
+        self.assertRaisesRegex(
+            ValueError, 'ProgressReporter', s.run, 5, progress=12)
+
+        # Cancel from reporter
+        self.assertRaises(
+            myokit.SimulationCancelledError, s.run, 1,
+            progress=CancellingReporter(0))
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -726,6 +726,73 @@ class SimulationTest(unittest.TestCase):
         with WarningCollector() as w:
             self.assertNotEqual(self.sim.eval_derivatives(), d1)
 
+    def test_evaluate_derivatives_batch(self):
+        # Test :meth:`Simulation.evaluate_derivatives_batch()`.
+
+        m = myokit.Model()
+        z = m.add_component('z')
+        z.add_variable('t', rhs=0, binding='time')
+        z.add_variable('a', rhs=1, binding='pace')
+        z.add_variable('d', rhs=8, binding='evaluations')
+        z.add_variable('e', rhs=12, binding='realtime')
+        z.add_variable('f', rhs=100)
+        z.add_variable('p', rhs='p+t+a+d+e+f', initial_value=0)
+        z.add_variable('q', rhs='p + q', initial_value=1)
+        sim = myokit.Simulation(m)
+
+        # Without inputs, compared with evaluate_derivatives
+        states = np.array([[0, 1], [1, 2], [3, 5]])
+        dy = sim.evaluate_derivatives_batch(states)
+        self.assertEqual(dy.shape, (3, 2))
+        for y, x in zip(states, dy):
+            self.assertEqual(list(x), sim.evaluate_derivatives(list(y)))
+
+        # With changed constant and inputs
+        sim.set_constant('z.f', 0)
+        d = {'time': np.array([1, 2, 3]), 'evaluations': 3, 'pace': 2}
+        dy = sim.evaluate_derivatives_batch(states, d)
+        for i, (y, x) in enumerate(zip(states, dy)):
+            e = {'time': i + 1, 'evaluations': 3, 'pace': 2}
+            self.assertEqual(list(x), sim.evaluate_derivatives(list(y), e))
+
+        # Empty batch
+        self.assertEqual(
+            sim.evaluate_derivatives_batch(np.zeros((0, 2))).shape, (0, 2))
+
+        # Wrong states or inputs
+        self.assertRaisesRegex(
+            ValueError, 'array of shape', sim.evaluate_derivatives_batch,
+            [1, 2])
+        self.assertRaisesRegex(
+            ValueError, 'array of shape', sim.evaluate_derivatives_batch,
+            np.zeros((3, 3)))
+        self.assertRaisesRegex(
+            ValueError, 'Unknown binding or', sim.evaluate_derivatives_batch,
+            states, {'toime': 1})
+
+        # Bad arguments to the compiled method
+        f = sim._sim.evaluate_derivatives_batch
+        x = np.array(states, dtype=float)
+        out = np.empty(x.shape)
+        bound = np.zeros((3, 4))
+        lits = list(sim._literals.values())
+        pars = list(sim._parameters.values())
+        self.assertRaisesRegex(
+            ValueError, 'literal values', f, 1, bound, lits + [1.0], pars, x,
+            out)
+        self.assertRaisesRegex(
+            ValueError, 'parameter values', f, 1, bound, lits, pars + [1.0],
+            x, out)
+        self.assertRaisesRegex(
+            TypeError, 'must be a list', f, 1, bound, tuple(lits), pars, x,
+            out)
+        self.assertRaisesRegex(
+            TypeError, 'not a float', f, 1, bound, [1] * len(lits), pars, x,
+            out)
+        self.assertRaisesRegex(
+            ValueError, 'buffer sizes', f, 1, bound, lits, pars, x,
+            np.empty((2, 2)))
+
     def test_sensitivities_initial(self):
         # Test setting initial sensitivity values.
 
@@ -309,6 +309,15 @@ class ToolsTest(unittest.TestCase):
             # But we can ignore the exception
             myokit.tools.rmtree(path, silent=True)
 
+    def test_thread_count(self):
+        # Test choosing the number of threads
+
+        self.assertEqual(myokit.tools.thread_count(), os.cpu_count() or 1)
+        self.assertEqual(myokit.tools.thread_count(3), 3)
+        self.assertEqual(myokit.tools.thread_count('2'), 2)
+        self.assertEqual(myokit.tools.thread_count(0), 1)
+        self.assertEqual(myokit.tools.thread_count(-2), 1)
+
 
 if __name__ == '__main__':
     unittest.main()
@@ -472,6 +472,17 @@ def natural_sort_key(s):
         for text in _natural_sort_regex.split(s)]
 
 
+def thread_count(threads=None):
+    """
+    Returns the number of threads to use for a task that accepts an optional
+    ``threads`` argument: ``threads`` (but at least 1) if given, or the number
+    of CPUs if ``threads`` is ``None``.
+    """
+    if threads is None:
+        return os.cpu_count() or 1
+    return max(1, int(threads))
+
+
 def rmtree(path, silent=False):
     """
     Version of ``shutil.rmtree`` that handles Windows "access denied" errors